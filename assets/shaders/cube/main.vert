@@ -1,9 +1,11 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform Uniform {
-    mat4 mtx;
-} ubo;
+// The cube's whole transform, camera included
+layout(push_constant) uniform Draw {
+    mat4 model;
+    uint material;
+} draw;
 
 layout(location = 0) in vec3 in_pos;
 layout(location = 1) in vec3 in_color;
@@ -11,7 +13,7 @@ layout(location = 1) in vec3 in_color;
 layout(location = 0) out vec3 out_color;
 
 void main() {
-    gl_Position = ubo.mtx * vec4(in_pos, 1.0);
+    gl_Position = draw.model * vec4(in_pos, 1.0);
 
     out_color = in_color;
 }
@@ -0,0 +1,19 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(push_constant) uniform Draw {
+    mat4 model;
+    uint material;
+} draw;
+
+layout(location = 0) in vec3 in_color;
+
+layout(location = 0) out vec4 out_color;
+
+// The material's low three bits pick red, green and blue
+void main() {
+    out_color = vec4(float(draw.material & 1u),
+                     float((draw.material >> 1) & 1u),
+                     float((draw.material >> 2) & 1u),
+                     1.0);
+}
@@ -1,6 +1,7 @@
 #!/usr/bin/perl -w
 
 use strict;
+use File::Find;
 
 my $M_RUN = 0;
 my $M_TEST = 1;
@@ -33,6 +34,19 @@ for (@pkgs) {
 }
 # link math.h
 $flags .= " -lm";
+# submit thread (vk_submit.c)
+$flags .= " -lpthread";
+
+# Compile any shader whose SPIR-V is missing or older than its source, the
+# same way recompile-shaders.sh does
+find(sub {
+    return unless /\.(vert|frag|comp)$/;
+    return if -e "$_.spv" && -M "$_.spv" <= -M $_;
+
+    print "glslc -o $File::Find::name.spv $File::Find::name\n";
+    system("glslc -o $_.spv $_") == 0
+        or die "Couldn't compile $File::Find::name\n";
+}, "assets");
 
 my @files;
 push @files, <src/*.c>;
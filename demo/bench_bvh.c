@@ -0,0 +1,126 @@
+#include "../src/camera.h"
+#include "../src/cull.h"
+#include "../src/bvh.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#define BOX_CT 1000000
+#define FRUSTUM_QUERIES 100
+#define RAY_QUERIES 1000000
+#define WORLD_SIZE 1024.0f
+#define MAX_BOX_SIZE 4.0f
+
+// Returns the elapsed time in floating-point seconds
+double get_elapsed(struct timespec *s_time);
+
+static float rand_range(float min, float max)
+{
+	return min + (max - min) * ((float) rand() / (float) RAND_MAX);
+}
+
+int main() {
+	struct AabbArray aabbs;
+	cull_aabbs_create(BOX_CT, &aabbs);
+
+	srand(0);
+	for (size_t i = 0; i < BOX_CT; i++) {
+		vec3 min, max;
+		for (int j = 0; j < 3; j++) {
+			min[j] = rand_range(-WORLD_SIZE, WORLD_SIZE);
+			max[j] = min[j] + rand_range(0.0f, MAX_BOX_SIZE);
+		}
+
+		cull_aabbs_set(&aabbs, i, min, max);
+	}
+
+	struct timespec s_time;
+	double elapsed;
+
+	// Build
+	struct Bvh bvh;
+	clock_gettime(CLOCK_MONOTONIC, &s_time);
+	bvh_build(&aabbs, &bvh);
+	elapsed = get_elapsed(&s_time);
+	printf("Build: %.1f ms for %d boxes (%u nodes)\n",
+	       elapsed * 1000.0, BOX_CT, bvh.node_ct);
+
+	// Refit after nudging every box
+	for (size_t i = 0; i < BOX_CT; i++) {
+		float dx = rand_range(-1.0f, 1.0f);
+		aabbs.min_x[i] += dx;
+		aabbs.max_x[i] += dx;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &s_time);
+	bvh_refit(&bvh, &aabbs);
+	elapsed = get_elapsed(&s_time);
+	printf("Refit: %.1f ms\n", elapsed * 1000.0);
+
+	// Frustum queries, against culling every box
+	uint32_t *visible = malloc(sizeof(visible[0]) * BOX_CT);
+	double tree_total = 0.0;
+	double linear_total = 0.0;
+	size_t visible_ct = 0;
+
+	for (int i = 0; i < FRUSTUM_QUERIES; i++) {
+		struct FlyCamera cam = cam_fly_new(0.0, 0.0, 0.0,
+						   i * 0.1f, 0.0f,
+						   0.0, 0.0);
+		mat4 view_proj;
+		cam_fly_mat(&cam, 1920, 1080, view_proj);
+
+		vec4 planes[6];
+		cam_frustum_planes(view_proj, planes);
+
+		clock_gettime(CLOCK_MONOTONIC, &s_time);
+		visible_ct = bvh_query_frustum(&bvh, &aabbs, planes, visible);
+		tree_total += get_elapsed(&s_time);
+
+		clock_gettime(CLOCK_MONOTONIC, &s_time);
+		cull_aabbs(&aabbs, planes, visible);
+		linear_total += get_elapsed(&s_time);
+	}
+
+	printf("Frustum (BVH):    %.3f ms per query (%zu visible)\n",
+	       tree_total / FRUSTUM_QUERIES * 1000.0, visible_ct);
+	printf("Frustum (linear): %.3f ms per query\n",
+	       linear_total / FRUSTUM_QUERIES * 1000.0);
+
+	// Picking rays from cameras scattered around the world
+	size_t hit_ct = 0;
+	clock_gettime(CLOCK_MONOTONIC, &s_time);
+	for (int i = 0; i < RAY_QUERIES; i++) {
+		struct FlyCamera cam = cam_fly_new(
+			rand_range(-WORLD_SIZE, WORLD_SIZE),
+			rand_range(-WORLD_SIZE, WORLD_SIZE),
+			rand_range(-WORLD_SIZE, WORLD_SIZE),
+			rand_range(-M_PI, M_PI), rand_range(-1.5f, 1.5f),
+			0.0, 0.0);
+
+		if (bvh_pick_fly(&bvh, &aabbs, &cam, NULL) != BVH_NO_HIT) {
+			hit_ct++;
+		}
+	}
+	elapsed = get_elapsed(&s_time);
+
+	printf("Rays: %.2f M rays/s (%zu of %d hit)\n",
+	       RAY_QUERIES / elapsed / 1000000.0, hit_ct, RAY_QUERIES);
+
+	free(visible);
+	bvh_destroy(bvh);
+	cull_aabbs_destroy(aabbs);
+
+	return 0;
+}
+
+double get_elapsed(struct timespec *s_time) {
+	struct timespec e_time;
+	clock_gettime(CLOCK_MONOTONIC, &e_time);
+
+	double secs = e_time.tv_sec - s_time->tv_sec;
+	double subsec = (e_time.tv_nsec - s_time->tv_nsec) / 1000000000.0f;
+
+	return secs + subsec;
+}
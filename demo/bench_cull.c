@@ -0,0 +1,127 @@
+#include "../src/camera.h"
+#include "../src/cull.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#define BOX_CT 1000000
+#define ITERATIONS 100
+#define WORLD_SIZE 1024.0f
+#define MAX_BOX_SIZE 4.0f
+
+// Returns the elapsed time in floating-point seconds
+double get_elapsed(struct timespec *s_time);
+
+static float rand_range(float min, float max)
+{
+	return min + (max - min) * ((float) rand() / (float) RAND_MAX);
+}
+
+/*
+ * The straightforward way to do it, for comparison: boxes stored one after
+ * another, tested one at a time.
+ */
+struct Box {
+	vec3 min;
+	vec3 max;
+};
+
+static size_t cull_naive(struct Box *boxes, size_t ct, vec4 planes[6],
+			 uint32_t *dest)
+{
+	size_t out = 0;
+	for (size_t i = 0; i < ct; i++) {
+		int inside = 1;
+		for (int p = 0; p < 6 && inside; p++) {
+			vec3 corner;
+			for (int j = 0; j < 3; j++) {
+				corner[j] = planes[p][j] >= 0.0f
+					? boxes[i].max[j] : boxes[i].min[j];
+			}
+
+			float dist = (corner[0] * planes[p][0]
+				      + corner[1] * planes[p][1])
+				+ (corner[2] * planes[p][2] + planes[p][3]);
+			inside = dist >= 0.0f;
+		}
+
+		if (inside) dest[out++] = i;
+	}
+
+	return out;
+}
+
+int main() {
+	struct AabbArray aabbs;
+	cull_aabbs_create(BOX_CT, &aabbs);
+
+	struct Box *boxes = malloc(sizeof(boxes[0]) * BOX_CT);
+
+	srand(0);
+	for (size_t i = 0; i < BOX_CT; i++) {
+		struct Box b;
+		for (int j = 0; j < 3; j++) {
+			b.min[j] = rand_range(-WORLD_SIZE, WORLD_SIZE);
+			b.max[j] = b.min[j] + rand_range(0.0f, MAX_BOX_SIZE);
+		}
+
+		boxes[i] = b;
+		cull_aabbs_set(&aabbs, i, b.min, b.max);
+	}
+
+	uint32_t *visible = malloc(sizeof(visible[0]) * BOX_CT);
+
+	printf("Culling %d boxes, %d at a time\n", BOX_CT, cull_width());
+
+	double soa_total = 0.0;
+	double naive_total = 0.0;
+	size_t visible_ct = 0;
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		// Spin the camera around so each iteration sees something different
+		struct FlyCamera cam = cam_fly_new(0.0, 0.0, 0.0,
+						   i * 0.1f, 0.0f,
+						   0.0, 0.0);
+		mat4 view_proj;
+		cam_fly_mat(&cam, 1920, 1080, view_proj);
+
+		vec4 planes[6];
+		cam_frustum_planes(view_proj, planes);
+
+		struct timespec s_time;
+		clock_gettime(CLOCK_MONOTONIC, &s_time);
+		visible_ct = cull_aabbs(&aabbs, planes, visible);
+		soa_total += get_elapsed(&s_time);
+
+		clock_gettime(CLOCK_MONOTONIC, &s_time);
+		size_t naive_ct = cull_naive(boxes, BOX_CT, planes, visible);
+		naive_total += get_elapsed(&s_time);
+
+		if (naive_ct != visible_ct) {
+			printf("Mismatch: %zu vs %zu visible\n",
+			       visible_ct, naive_ct);
+			return 1;
+		}
+	}
+
+	printf("SoA:   %.3f ms per cull\n", soa_total / ITERATIONS * 1000.0);
+	printf("Naive: %.3f ms per cull\n", naive_total / ITERATIONS * 1000.0);
+	printf("(%zu visible in the last frame)\n", visible_ct);
+
+	free(visible);
+	free(boxes);
+	cull_aabbs_destroy(aabbs);
+
+	return 0;
+}
+
+double get_elapsed(struct timespec *s_time) {
+	struct timespec e_time;
+	clock_gettime(CLOCK_MONOTONIC, &e_time);
+
+	double secs = e_time.tv_sec - s_time->tv_sec;
+	double subsec = (e_time.tv_nsec - s_time->tv_nsec) / 1000000000.0f;
+
+	return secs + subsec;
+}
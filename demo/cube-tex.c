@@ -2,6 +2,7 @@
 #include "../src/vk_tools.h"
 #include "../src/vk_window.h"
 #include "../src/vk_pipe.h"
+#include "../src/vk_pipe_cache.h"
 #include "../src/vk_cbuf.h"
 #include "../src/vk_sync.h"
 #include "../src/vk_buffer.h"
@@ -9,6 +10,8 @@
 #include "../src/vk_uniform.h"
 #include "../src/vk_rpass.h"
 #include "../src/vk_image.h"
+#include "../src/vk_barrier.h"
+#include "../src/vk_mips.h"
 #include "../src/vk_sync_pool.h"
 #include "../src/camera.h"
 
@@ -19,8 +22,7 @@
 #include <math.h>
 #include <unistd.h>
 
-// Initialize STB image loader
-#define STB_IMAGE_IMPLEMENTATION
+// stb_image's definitions are in src/texture.c
 #include <stb/stb_image.h>
 
 #define TEXTURE_W 1024
@@ -256,38 +258,70 @@ int main()
 
 	buffer_write(texture_staging, texture_size, texture_data);
 
-	// Texture
+	// Texture, with a full mip chain if the format allows generating one
+	VkFormat texture_fmt = VK_FORMAT_R8G8B8A8_SRGB;
+	VkImageUsageFlags texture_usage = mip_gen_usage(phys_dev, texture_fmt);
+	uint32_t mip_ct = texture_usage != 0
+		? image_mip_ct(TEXTURE_W, TEXTURE_H) : 1;
+
 	struct Image texture;
-	image_create(device, queue_fam, mem_props,
-		     VK_FORMAT_R8G8B8A8_SRGB,
-		     VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		     VK_IMAGE_ASPECT_COLOR_BIT,
-		     VK_SAMPLE_COUNT_1_BIT,
-		     TEXTURE_W, TEXTURE_H,
-		     &texture);
-
-	image_transition(device, queue, cpool,
-			 texture.handle, VK_IMAGE_ASPECT_COLOR_BIT,
-			 0,
-			 VK_ACCESS_TRANSFER_WRITE_BIT,
-			 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-			 VK_PIPELINE_STAGE_TRANSFER_BIT,
-			 VK_IMAGE_LAYOUT_UNDEFINED,
-			 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-	copy_buffer_image(device, queue, cpool,
-			  VK_IMAGE_ASPECT_COLOR_BIT, TEXTURE_W, TEXTURE_H,
-			  texture_staging.handle, texture.handle);
-
-	image_transition(device, queue, cpool,
-			 texture.handle, VK_IMAGE_ASPECT_COLOR_BIT,
-			 VK_ACCESS_TRANSFER_WRITE_BIT,
-			 VK_ACCESS_SHADER_READ_BIT,
-			 VK_PIPELINE_STAGE_TRANSFER_BIT,
-			 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-			 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	image_create_mips(device, queue_fam, mem_props,
+			  texture_fmt,
+			  texture_usage
+			  | VK_IMAGE_USAGE_SAMPLED_BIT
+			  | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			  VK_IMAGE_ASPECT_COLOR_BIT,
+			  VK_SAMPLE_COUNT_1_BIT,
+			  TEXTURE_W, TEXTURE_H,
+			  mip_ct,
+			  &texture);
+
+	// Upload in one submission: transition, copy, generate mips
+	struct Sync2 s2;
+	struct Sync2 *sync2 = sync2_load(phys_dev, device, &s2) == 0
+		? &s2 : NULL;
+
+	struct BarrierBatch barriers;
+	barrier_batch_create(sync2, &barriers);
+
+	VkCommandBuffer upload_cbuf;
+	cbuf_begin_one_time(device, cpool, &upload_cbuf);
+
+	barrier_batch_image(&barriers,
+			    texture.handle, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1,
+			    0,
+			    VK_ACCESS_TRANSFER_WRITE_BIT,
+			    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			    VK_PIPELINE_STAGE_TRANSFER_BIT,
+			    VK_IMAGE_LAYOUT_UNDEFINED,
+			    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	barrier_batch_record(&barriers, upload_cbuf);
+
+	copy_buffer_image_cmd(upload_cbuf,
+			      VK_IMAGE_ASPECT_COLOR_BIT, TEXTURE_W, TEXTURE_H,
+			      texture_staging.handle, texture.handle);
+
+	// Pipelines go through a cache kept in bin/, so later runs skip
+	// compiling them from SPIR-V
+	struct PipeCache pcache;
+	pipe_cache_create(phys_dev, device, "bin/cube-tex-pipelines.cache",
+			  &pcache);
+
+	struct MipGen mip_gen;
+	mip_gen_create(phys_dev, pcache.handle, &mip_gen);
+	mip_gen_record(device, &mip_gen, upload_cbuf,
+		       texture.handle, texture_fmt,
+		       TEXTURE_W, TEXTURE_H, mip_ct,
+		       VK_ACCESS_SHADER_READ_BIT,
+		       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	res = vkEndCommandBuffer(upload_cbuf);
+	assert(res == VK_SUCCESS);
+	submit_syncless(device, queue, cpool, upload_cbuf);
+
+	mip_gen_destroy(device, mip_gen);
 
 	// Sampler
 	VkSamplerCreateInfo sampler_info = {0};
@@ -305,7 +339,7 @@ int main()
 	sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 	sampler_info.mipLodBias = 0.0f;
 	sampler_info.minLod = 0.0f;
-	sampler_info.maxLod = 0.0f;
+	sampler_info.maxLod = (float) mip_ct;
 
 	VkSampler sampler;
 	res = vkCreateSampler(device, &sampler_info, NULL, &sampler);
@@ -366,7 +400,7 @@ int main()
 	}
 		     
 	VkPipelineLayout layout;
-	create_layout(device, set_ct, set_layouts, &layout);
+	create_layout(device, set_ct, set_layouts, 0, NULL, &layout);
 
 	// Shaders
 	FILE *fp;
@@ -408,6 +442,7 @@ int main()
 	// Pipeline
 	VkPipeline pipel = NULL;
 	create_pipel(device,
+		     pcache.handle,
 		     2,
 		     shtages,
 		     layout,
@@ -563,6 +598,11 @@ int main()
 	vkDestroyPipeline(device, pipel, NULL);
 	vkDestroyPipelineLayout(device, layout, NULL);
 
+	if (pipe_cache_save(phys_dev, device, &pcache) != 0) {
+		printf("Couldn't save the pipeline cache\n");
+	}
+	pipe_cache_destroy(device, pcache);
+
 	buffer_destroy(uniform_buf);
 	buffer_destroy(texture_staging);
 	
@@ -2,11 +2,11 @@
 #include "../src/vk_tools.h"
 #include "../src/vk_window.h"
 #include "../src/vk_pipe.h"
+#include "../src/vk_pipe_cache.h"
 #include "../src/vk_cbuf.h"
 #include "../src/vk_sync.h"
 #include "../src/vk_buffer.h"
 #include "../src/vk_vertex.h"
-#include "../src/vk_uniform.h"
 #include "../src/vk_rpass.h"
 #include "../src/vk_sync_pool.h"
 #include "../src/camera.h"
@@ -17,6 +17,7 @@
 #include <string.h>
 #include <math.h>
 #include <unistd.h>
+#include <inttypes.h>
 
 #define MAX_FRAMES_IN_FLIGHT 4
 
@@ -198,44 +199,20 @@ int main()
 		    staging_buf.handle,
 		    ibuf.handle);
 
-	// Uniform buffer
+	// The camera matrix is pushed with every draw, so there's no uniform
+	// buffer for frames in flight to share
 	struct OrbitCamera cam = cam_orbit_new(0.0f, 0.0f);
-	mat4 uniform_data = {0};
-	uint32_t uniform_size = sizeof(uniform_data);
-	struct Buffer uniform_buf;
-	buffer_create(device, mem_props, uniform_size,
-		      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		      &uniform_buf);
-
-	// Descriptor pool
-	VkDescriptorPool dpool;
-	create_descriptor_pool(device, MAX_FRAMES_IN_FLIGHT, MAX_FRAMES_IN_FLIGHT, &dpool);
+	struct DrawPush push = {0};
+	uint32_t first_index = 0;
 
 	// Synchronization primitives
 	VkSemaphore *image_avail_sems = malloc(sizeof(image_avail_sems[0]) * MAX_FRAMES_IN_FLIGHT);
 	VkSemaphore *render_done_sems = malloc(sizeof(render_done_sems[0]) * MAX_FRAMES_IN_FLIGHT);
 	VkFence *swapchain_fences = malloc(sizeof(swapchain_fences[0]) * win.image_ct);
 
-	// Sets (one for each frame in flight)
-	uint32_t desc_ct = 1;
-	VkDescriptorType desc_types[] = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER};
-	VkDescriptorBufferInfo desc_buffers[] = {{.buffer = uniform_buf.handle,
-						  .offset = 0,
-						  .range = uniform_size}};
-	VkDescriptorImageInfo desc_images[] = {NULL};
-	VkShaderStageFlags desc_stages[] = {VK_SHADER_STAGE_VERTEX_BIT};
-	struct Set *sets = malloc(sizeof(sets[0]) * MAX_FRAMES_IN_FLIGHT);
-
 	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		create_sem(device, &image_avail_sems[i]);
 		create_sem(device, &render_done_sems[i]);
-
-		set_create(device, dpool,
-			   desc_ct, desc_types,
-			   desc_buffers, desc_images, desc_stages,
-			   &sets[i]);
 	}
 
 	for (int i = 0; i < win.image_ct; i++) {
@@ -243,8 +220,11 @@ int main()
 	}
 
 	// Pipeline layout
+	VkPushConstantRange push_range;
+	draw_push_range(&push_range);
+
 	VkPipelineLayout layout;
-	create_layout(device, 1, &sets[0].layout, &layout);
+	create_layout(device, 0, NULL, 1, &push_range, &layout);
 
 	// Shaders
 	FILE *fp;
@@ -283,9 +263,16 @@ int main()
 	create_shtage(fs_mod, VK_SHADER_STAGE_FRAGMENT_BIT, &fs_stage);
 	VkPipelineShaderStageCreateInfo shtages[] = {vs_stage, fs_stage};
 
+	// Pipelines go through a cache kept in bin/, so later runs skip
+	// compiling them from SPIR-V
+	struct PipeCache pcache;
+	pipe_cache_create(phys_dev, device, "bin/cube-pipelines.cache",
+			  &pcache);
+
 	// Pipeline
 	VkPipeline pipel = NULL;
 	create_pipel(device,
+		     pcache.handle,
 		     2,
 		     shtages,
 		     layout,
@@ -346,9 +333,9 @@ int main()
 		VkSemaphore image_avail_sem = image_avail_sems[sync_set_idx];
 		VkSemaphore render_done_sem = render_done_sems[sync_set_idx];
 
-		// Update uniform buffer
-		cam_orbit_mat(&cam, swidth, sheight, mouse_x, mouse_y, uniform_data);
-		buffer_write(uniform_buf, uniform_size, uniform_data);
+		// Update the pushed matrix
+		cam_orbit_mat(&cam, swidth, sheight, mouse_x, mouse_y,
+			      push.model);
 
 		// Acquire image
 		uint32_t image_idx;
@@ -379,21 +366,27 @@ int main()
 		// Set swapchain fence
 		swapchain_fences[image_idx] = render_done_fence;
 
-		// Create command buffer
-		create_cbuf(device,
-			    cpool,
-			    rpass, clear_ct, clears,
-			    fb,
-			    swidth,
-			    sheight,
-			    layout,
-			    pipel,
-			    1,
-			    &sets[sync_set_idx].handle,
-			    vbuf.handle,
-			    ibuf.handle,
-			    index_count,
-			    &cbuf);
+		// Record command buffer
+		cbuf_begin_one_time(device, cpool, &cbuf);
+
+		VkRenderPassBeginInfo rpass_info = {0};
+		rpass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		rpass_info.renderPass = rpass;
+		rpass_info.framebuffer = fb;
+		rpass_info.renderArea.extent.width = swidth;
+		rpass_info.renderArea.extent.height = sheight;
+		rpass_info.clearValueCount = clear_ct;
+		rpass_info.pClearValues = clears;
+
+		vkCmdBeginRenderPass(cbuf, &rpass_info,
+				     VK_SUBPASS_CONTENTS_INLINE);
+		cbuf_draw_ranges_pushed(cbuf, swidth, sheight, layout, pipel,
+					0, NULL, vbuf.handle, ibuf.handle,
+					1, &first_index, &index_count, &push);
+		vkCmdEndRenderPass(cbuf);
+
+		res = vkEndCommandBuffer(cbuf);
+		assert(res == VK_SUCCESS);
 
 		cbufs[sync_set_idx] = cbuf;
 
@@ -425,6 +418,12 @@ int main()
 	double elapsed = get_elapsed(&s_time);
 	printf("%d frames in %.4f secs --> %.4f FPS\n", f_count, elapsed, (double) f_count / elapsed);
 	printf("Avg. delta: %.4f ms\n", elapsed / (double) f_count * 1000.0f);
+	printf("GPU stalls: %" PRIu64 " of %" PRIu64 " frames, %.4f ms avg, %.4f ms max\n",
+	       sync_pool.stats.stall_ct, sync_pool.stats.acquire_ct,
+	       sync_pool.stats.stall_ct > 0
+	       ? sync_pool.stats.stall_secs / sync_pool.stats.stall_ct * 1000.0
+	       : 0.0,
+	       sync_pool.stats.max_stall_secs * 1000.0);
 
 	res = vkQueueWaitIdle(queue);
 	assert(res == VK_SUCCESS);
@@ -438,17 +437,16 @@ int main()
 	vkDestroyPipeline(device, pipel, NULL);
 	vkDestroyPipelineLayout(device, layout, NULL);
 
-	buffer_destroy(uniform_buf);
+	if (pipe_cache_save(phys_dev, device, &pcache) != 0) {
+		printf("Couldn't save the pipeline cache\n");
+	}
+	pipe_cache_destroy(device, pcache);
 
 	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		vkDestroySemaphore(device, image_avail_sems[i], NULL);
 		vkDestroySemaphore(device, render_done_sems[i], NULL);
-
-		set_destroy(device, sets[i]);
 	}
 
-	vkDestroyDescriptorPool(device, dpool, NULL);
-
 	buffer_destroy(vbuf);
 	buffer_destroy(ibuf);
 	buffer_destroy(staging_buf);
@@ -2,6 +2,8 @@
 #include "../src/vk_tools.h"
 #include "../src/vk_window.h"
 #include "../src/vk_pipe.h"
+#include "../src/vk_pipe_cache.h"
+#include "../src/vk_pipe_build.h"
 #include "../src/vk_cbuf.h"
 #include "../src/vk_sync.h"
 #include "../src/vk_buffer.h"
@@ -126,77 +128,6 @@ int main() {
 	VkCommandPool cpool;
 	create_cpool(device, queue_fam, &cpool);
 
-	// Read OBJ
-	FILE *obj_fp = fopen("assets/models/bunny.obj", "r");
-	assert(obj_fp != NULL);
-    
-	size_t vertex_ct, index_ct;
-	obj_load(obj_fp, &vertex_ct, &index_ct, NULL, NULL);
-
-	printf("Vertex, index count: [%lu, %lu]\n", vertex_ct, index_ct);
-
-	uint32_t *indices = malloc(sizeof(indices[0]) * index_ct);
-	struct ObjVertex *obj_vtxs = malloc(sizeof(obj_vtxs[0]) * vertex_ct);
-	struct Vertex3PosNormal *vertices = malloc(sizeof(vertices[0]) * vertex_ct);
-
-	obj_load(obj_fp, &vertex_ct, &index_ct, obj_vtxs, indices);
-
-	fclose(obj_fp);
-
-	obj_vertex_to_vertex_3_pos_normal_list(vertices, obj_vtxs, vertex_ct);
-
-	// Buffers
-	VkDeviceSize vertices_size = sizeof(vertices[0]) * vertex_ct;
-
-	VkDeviceSize indices_size = sizeof(indices[0]) * index_ct;
-
-	// Staging
-	struct Buffer staging_buf;
-	buffer_create(device,
-		      mem_props,
-		      vertices_size > indices_size ? vertices_size : indices_size,
-		      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		      &staging_buf);
-
-	// Vertex
-	buffer_write(staging_buf, vertices_size, (void *) vertices);
-
-	struct Buffer vbuf;
-	buffer_create(device,
-		      mem_props,
-		      vertices_size,
-		      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		      &vbuf);
-
-	// Copy staging to vertex
-	copy_buffer_buffer(device,
-			   queue,
-			   cpool,
-			   vertices_size,
-			   staging_buf.handle,
-			   vbuf.handle);
-
-	// Index buffer
-	buffer_write(staging_buf, indices_size, (void *) indices);
-
-	struct Buffer ibuf;
-	buffer_create(device,
-		      mem_props,
-		      vertices_size,
-		      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		      &ibuf);
-
-	// Copy staging to index
-	copy_buffer_buffer(device,
-			   queue,
-			   cpool,
-			   indices_size,
-			   staging_buf.handle,
-			   ibuf.handle);
-
 	// Uniform buffer
 	struct OrbitCamera cam = cam_orbit_new(0.0f, 0.0f);
 	mat4 uniform_data = {0};
@@ -243,7 +174,7 @@ int main() {
 
 	// Pipeline layout
 	VkPipelineLayout layout;
-	create_layout(device, 1, &sets[0].layout, &layout);
+	create_layout(device, 1, &sets[0].layout, 0, NULL, &layout);
 
 	// Shaders
 	FILE *fp;
@@ -280,20 +211,106 @@ int main() {
 	VkPipelineShaderStageCreateInfo fs_stage;
 	create_shtage(vs_mod, VK_SHADER_STAGE_VERTEX_BIT, &vs_stage);
 	create_shtage(fs_mod, VK_SHADER_STAGE_FRAGMENT_BIT, &fs_stage);
-	VkPipelineShaderStageCreateInfo shtages[] = {vs_stage, fs_stage};
-
-	// Pipeline
-	VkPipeline pipel = NULL;
-	create_pipel(device,
-		     2,
-		     shtages,
-		     layout,
-		     VERTEX_3_POS_COLOR_BINDING_CT,
-		     VERTEX_3_POS_COLOR_BINDINGS,
-		     VERTEX_3_POS_COLOR_ATTRIBUTE_CT,
-		     VERTEX_3_POS_COLOR_ATTRIBUTES,
-		     rpass, 1, SAMPLES,
-		     &pipel);
+
+	// Pipelines go through a cache kept in bin/, so later runs skip
+	// compiling them from SPIR-V
+	struct PipeCache pcache;
+	pipe_cache_create(phys_dev, device, "bin/msaa-pipelines.cache",
+			  &pcache);
+
+	// Pipeline (compiled on a worker thread while the model loads)
+	struct PipeBuild *pipe_build = malloc(sizeof(*pipe_build));
+	pipe_build_create(device, pcache.handle, 1, pipe_build);
+
+	struct PipeDesc pipel_desc = {0};
+	pipel_desc.shtage_ct = 2;
+	pipel_desc.shtages[0] = vs_stage;
+	pipel_desc.shtages[1] = fs_stage;
+	pipel_desc.layout = layout;
+	pipel_desc.binding_ct = VERTEX_3_POS_COLOR_BINDING_CT;
+	pipel_desc.binding_descs = VERTEX_3_POS_COLOR_BINDINGS;
+	pipel_desc.attr_ct = VERTEX_3_POS_COLOR_ATTRIBUTE_CT;
+	pipel_desc.attr_descs = VERTEX_3_POS_COLOR_ATTRIBUTES;
+	pipel_desc.rpass = rpass;
+	pipel_desc.has_depth = 1;
+	pipel_desc.samples = SAMPLES;
+	uint32_t pipel_id = pipe_build_submit(pipe_build, &pipel_desc);
+
+	// Read OBJ
+	FILE *obj_fp = fopen("assets/models/bunny.obj", "r");
+	assert(obj_fp != NULL);
+    
+	size_t vertex_ct, index_ct;
+	obj_load(obj_fp, &vertex_ct, &index_ct, NULL, NULL);
+
+	printf("Vertex, index count: [%lu, %lu]\n", vertex_ct, index_ct);
+
+	uint32_t *indices = malloc(sizeof(indices[0]) * index_ct);
+	struct ObjVertex *obj_vtxs = malloc(sizeof(obj_vtxs[0]) * vertex_ct);
+	struct Vertex3PosNormal *vertices = malloc(sizeof(vertices[0]) * vertex_ct);
+
+	obj_load(obj_fp, &vertex_ct, &index_ct, obj_vtxs, indices);
+
+	fclose(obj_fp);
+
+	obj_vertex_to_vertex_3_pos_normal_list(vertices, obj_vtxs, vertex_ct);
+
+	// Buffers
+	VkDeviceSize vertices_size = sizeof(vertices[0]) * vertex_ct;
+
+	VkDeviceSize indices_size = sizeof(indices[0]) * index_ct;
+
+	// Staging
+	struct Buffer staging_buf;
+	buffer_create(device,
+		      mem_props,
+		      vertices_size > indices_size ? vertices_size : indices_size,
+		      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &staging_buf);
+
+	// Vertex
+	buffer_write(staging_buf, vertices_size, (void *) vertices);
+
+	struct Buffer vbuf;
+	buffer_create(device,
+		      mem_props,
+		      vertices_size,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		      &vbuf);
+
+	// Copy staging to vertex
+	copy_buffer_buffer(device,
+			   queue,
+			   cpool,
+			   vertices_size,
+			   staging_buf.handle,
+			   vbuf.handle);
+
+	// Index buffer
+	buffer_write(staging_buf, indices_size, (void *) indices);
+
+	struct Buffer ibuf;
+	buffer_create(device,
+		      mem_props,
+		      vertices_size,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		      &ibuf);
+
+	// Copy staging to index
+	copy_buffer_buffer(device,
+			   queue,
+			   cpool,
+			   indices_size,
+			   staging_buf.handle,
+			   ibuf.handle);
+
+	// Pipeline is needed from here on
+	VkPipeline pipel = pipe_build_wait(pipe_build, pipel_id);
+	pipe_build_destroy(pipe_build);
+	free(pipe_build);
 
 	// Clear values
 	VkClearValue clears[] = {{0.0f, 0.0f, 0.0f, 0.0f},
@@ -466,6 +483,11 @@ int main() {
 	vkDestroyPipeline(device, pipel, NULL);
 	vkDestroyPipelineLayout(device, layout, NULL);
 
+	if (pipe_cache_save(phys_dev, device, &pcache) != 0) {
+		printf("Couldn't save the pipeline cache\n");
+	}
+	pipe_cache_destroy(device, pcache);
+
 	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		vkDestroySemaphore(device, image_avail_sems[i], NULL);
 		vkDestroySemaphore(device, render_done_sems[i], NULL);
@@ -2,6 +2,8 @@
 #include "../src/vk_tools.h"
 #include "../src/vk_window.h"
 #include "../src/vk_pipe.h"
+#include "../src/vk_pipe_cache.h"
+#include "../src/vk_pipe_build.h"
 #include "../src/vk_cbuf.h"
 #include "../src/vk_sync.h"
 #include "../src/vk_buffer.h"
@@ -12,6 +14,7 @@
 #include "../src/vk_sync_pool.h"
 #include "../src/camera.h"
 #include "../src/obj.h"
+#include "../src/lod.h"
 
 #include <stdlib.h>
 #include <assert.h>
@@ -109,77 +112,6 @@ int main() {
 	VkCommandPool cpool;
 	create_cpool(device, queue_fam, &cpool);
 
-	// Read OBJ
-	FILE *obj_fp = fopen("assets/models/bunny.obj", "r");
-	assert(obj_fp != NULL);
-    
-	size_t vertex_ct, index_ct;
-	obj_load(obj_fp, &vertex_ct, &index_ct, NULL, NULL);
-
-	printf("Vertex, index count: [%lu, %lu]\n", vertex_ct, index_ct);
-
-	uint32_t *indices = malloc(sizeof(indices[0]) * index_ct);
-	struct ObjVertex *obj_vtxs = malloc(sizeof(obj_vtxs[0]) * vertex_ct);
-	struct Vertex3PosNormal *vertices = malloc(sizeof(vertices[0]) * vertex_ct);
-
-	obj_load(obj_fp, &vertex_ct, &index_ct, obj_vtxs, indices);
-
-	fclose(obj_fp);
-
-	obj_vertex_to_vertex_3_pos_normal_list(vertices, obj_vtxs, vertex_ct);
-
-	// Buffers
-	VkDeviceSize vertices_size = sizeof(vertices[0]) * vertex_ct;
-
-	VkDeviceSize indices_size = sizeof(indices[0]) * index_ct;
-
-	// Staging
-	struct Buffer staging_buf;
-	buffer_create(device,
-		      mem_props,
-		      vertices_size > indices_size ? vertices_size : indices_size,
-		      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		      &staging_buf);
-
-	// Vertex
-	buffer_write(staging_buf, vertices_size, (void *) vertices);
-
-	struct Buffer vbuf;
-	buffer_create(device,
-		      mem_props,
-		      vertices_size,
-		      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		      &vbuf);
-
-	// Copy staging to vertex
-	copy_buffer_buffer(device,
-			   queue,
-			   cpool,
-			   vertices_size,
-			   staging_buf.handle,
-			   vbuf.handle);
-
-	// Index buffer
-	buffer_write(staging_buf, indices_size, (void *) indices);
-
-	struct Buffer ibuf;
-	buffer_create(device,
-		      mem_props,
-		      vertices_size,
-		      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		      &ibuf);
-
-	// Copy staging to index
-	copy_buffer_buffer(device,
-			   queue,
-			   cpool,
-			   indices_size,
-			   staging_buf.handle,
-			   ibuf.handle);
-
 	// Uniform buffer
 	struct OrbitCamera cam = cam_orbit_new(0.0f, 0.0f);
 	mat4 uniform_data = {0};
@@ -226,7 +158,7 @@ int main() {
 
 	// Pipeline layout
 	VkPipelineLayout layout;
-	create_layout(device, 1, &sets[0].layout, &layout);
+	create_layout(device, 1, &sets[0].layout, 0, NULL, &layout);
 
 	// Shaders
 	FILE *fp;
@@ -263,20 +195,115 @@ int main() {
 	VkPipelineShaderStageCreateInfo fs_stage;
 	create_shtage(vs_mod, VK_SHADER_STAGE_VERTEX_BIT, &vs_stage);
 	create_shtage(fs_mod, VK_SHADER_STAGE_FRAGMENT_BIT, &fs_stage);
-	VkPipelineShaderStageCreateInfo shtages[] = {vs_stage, fs_stage};
-
-	// Pipeline
-	VkPipeline pipel = NULL;
-	create_pipel(device,
-		     2,
-		     shtages,
-		     layout,
-		     VERTEX_3_POS_COLOR_BINDING_CT,
-		     VERTEX_3_POS_COLOR_BINDINGS,
-		     VERTEX_3_POS_COLOR_ATTRIBUTE_CT,
-		     VERTEX_3_POS_COLOR_ATTRIBUTES,
-		     rpass, 1, VK_SAMPLE_COUNT_1_BIT,
-		     &pipel);
+
+	// Pipelines go through a cache kept in bin/, so later runs skip
+	// compiling them from SPIR-V
+	struct PipeCache pcache;
+	pipe_cache_create(phys_dev, device, "bin/obj-pipelines.cache",
+			  &pcache);
+
+	// Pipeline (compiled on a worker thread while the model loads)
+	struct PipeBuild *pipe_build = malloc(sizeof(*pipe_build));
+	pipe_build_create(device, pcache.handle, 1, pipe_build);
+
+	struct PipeDesc pipel_desc = {0};
+	pipel_desc.shtage_ct = 2;
+	pipel_desc.shtages[0] = vs_stage;
+	pipel_desc.shtages[1] = fs_stage;
+	pipel_desc.layout = layout;
+	pipel_desc.binding_ct = VERTEX_3_POS_COLOR_BINDING_CT;
+	pipel_desc.binding_descs = VERTEX_3_POS_COLOR_BINDINGS;
+	pipel_desc.attr_ct = VERTEX_3_POS_COLOR_ATTRIBUTE_CT;
+	pipel_desc.attr_descs = VERTEX_3_POS_COLOR_ATTRIBUTES;
+	pipel_desc.rpass = rpass;
+	pipel_desc.has_depth = 1;
+	pipel_desc.samples = VK_SAMPLE_COUNT_1_BIT;
+	uint32_t pipel_id = pipe_build_submit(pipe_build, &pipel_desc);
+
+	// Read OBJ
+	FILE *obj_fp = fopen("assets/models/bunny.obj", "r");
+	assert(obj_fp != NULL);
+    
+	size_t vertex_ct, index_ct;
+	obj_load(obj_fp, &vertex_ct, &index_ct, NULL, NULL);
+
+	printf("Vertex, index count: [%lu, %lu]\n", vertex_ct, index_ct);
+
+	uint32_t *indices = malloc(sizeof(indices[0]) * index_ct);
+	struct ObjVertex *obj_vtxs = malloc(sizeof(obj_vtxs[0]) * vertex_ct);
+	struct Vertex3PosNormal *vertices = malloc(sizeof(vertices[0]) * vertex_ct);
+
+	obj_load(obj_fp, &vertex_ct, &index_ct, obj_vtxs, indices);
+
+	fclose(obj_fp);
+
+	obj_vertex_to_vertex_3_pos_normal_list(vertices, obj_vtxs, vertex_ct);
+
+	// LODs (all share the vertex buffer, and go in a single index buffer)
+	struct LodChain lods;
+	lod_chain_create(obj_vtxs, vertex_ct, indices, index_ct, 6, 0.5f, &lods);
+
+	for (int i = 0; i < lods.lod_ct; i++) {
+		printf("LOD %d: %u indices, error %f\n",
+		       i, lods.counts[i], lods.errors[i]);
+	}
+
+	// Buffers
+	VkDeviceSize vertices_size = sizeof(vertices[0]) * vertex_ct;
+
+	VkDeviceSize indices_size = sizeof(lods.indices[0]) * lods.index_ct;
+
+	// Staging
+	struct Buffer staging_buf;
+	buffer_create(device,
+		      mem_props,
+		      vertices_size > indices_size ? vertices_size : indices_size,
+		      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &staging_buf);
+
+	// Vertex
+	buffer_write(staging_buf, vertices_size, (void *) vertices);
+
+	struct Buffer vbuf;
+	buffer_create(device,
+		      mem_props,
+		      vertices_size,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		      &vbuf);
+
+	// Copy staging to vertex
+	copy_buffer_buffer(device,
+			   queue,
+			   cpool,
+			   vertices_size,
+			   staging_buf.handle,
+			   vbuf.handle);
+
+	// Index buffer
+	buffer_write(staging_buf, indices_size, (void *) lods.indices);
+
+	struct Buffer ibuf;
+	buffer_create(device,
+		      mem_props,
+		      indices_size,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		      &ibuf);
+
+	// Copy staging to index
+	copy_buffer_buffer(device,
+			   queue,
+			   cpool,
+			   indices_size,
+			   staging_buf.handle,
+			   ibuf.handle);
+
+	// Pipeline is needed from here on
+	VkPipeline pipel = pipe_build_wait(pipe_build, pipel_id);
+	pipe_build_destroy(pipe_build);
+	free(pipe_build);
 
 	// Clear values
 	VkClearValue clears[] = {{0.0f, 0.0f, 0.0f, 0.0f},
@@ -348,6 +375,11 @@ int main() {
 		cam_orbit_mat(&cam, swidth, sheight, mouse_x, mouse_y, uniform_data);
 		buffer_write(uniform_buf, uniform_size, uniform_data);
 
+		// Pick a LOD based on how far away the model is
+		vec3 model_center = {0.0f, 0.0f, 0.0f};
+		uint32_t lod = lod_select_orbit(&lods, &cam, model_center,
+						LOD_DEFAULT_ERROR);
+
 		// Acquire image
 		uint32_t image_idx;
 		VkFramebuffer fb;
@@ -378,18 +410,18 @@ int main() {
 		swapchain_fences[image_idx] = render_done_fence;
 
 		// Create command buffer
-		create_cbuf(device,
-			    cpool,
-			    rpass,
-			    clear_ct, clears,
-			    fb,
-			    swidth, sheight,
-			    layout, pipel,
-			    1, &sets[sync_set_idx].handle,
-			    vbuf.handle,
-			    ibuf.handle,
-			    index_ct,
-			    &cbuf);
+		create_cbuf_range(device,
+				  cpool,
+				  rpass,
+				  clear_ct, clears,
+				  fb,
+				  swidth, sheight,
+				  layout, pipel,
+				  1, &sets[sync_set_idx].handle,
+				  vbuf.handle,
+				  ibuf.handle,
+				  lods.offsets[lod], lods.counts[lod],
+				  &cbuf);
 
 		cbufs[sync_set_idx] = cbuf;
 
@@ -435,6 +467,11 @@ int main() {
 	vkDestroyPipeline(device, pipel, NULL);
 	vkDestroyPipelineLayout(device, layout, NULL);
 
+	if (pipe_cache_save(phys_dev, device, &pcache) != 0) {
+		printf("Couldn't save the pipeline cache\n");
+	}
+	pipe_cache_destroy(device, pcache);
+
 	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		vkDestroySemaphore(device, image_avail_sems[i], NULL);
 		vkDestroySemaphore(device, render_done_sems[i], NULL);
@@ -449,6 +486,8 @@ int main() {
 	buffer_destroy(staging_buf);
 	buffer_destroy(uniform_buf);
 
+	lod_chain_destroy(lods);
+
 	vkDestroyRenderPass(device, rpass, NULL);
 
 	vkDestroySurfaceKHR(instance, surface, NULL);
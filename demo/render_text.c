@@ -1,6 +1,7 @@
 #include "../src/glfwtools.h"
 #include "../src/vk_tools.h"
 #include "../src/vk_pipe.h"
+#include "../src/vk_pipe_cache.h"
 #include "../src/vk_cbuf.h"
 #include "../src/vk_sync.h"
 #include "../src/vk_buffer.h"
@@ -155,7 +156,7 @@ int main()
 
 	// Pipeline layout
 	VkPipelineLayout layout;
-	create_layout(device, 0, NULL, &layout);
+	create_layout(device, 0, NULL, 0, NULL, &layout);
 
 	// Shaders
 	FILE *fp;
@@ -194,9 +195,16 @@ int main()
 	create_shtage(fs_mod, VK_SHADER_STAGE_FRAGMENT_BIT, &fs_stage);
 	VkPipelineShaderStageCreateInfo shtages[] = {vs_stage, fs_stage};
 
+	// Pipelines go through a cache kept in bin/, so later runs skip
+	// compiling them from SPIR-V
+	struct PipeCache pcache;
+	pipe_cache_create(phys_dev, device, "bin/render_text-pipelines.cache",
+			  &pcache);
+
 	// Pipeline
 	VkPipeline pipel = NULL;
 	create_pipel(device,
+		     pcache.handle,
 		     2, shtages,
 		     layout,
 		     VERTEX_2_POS_COLOR_BINDING_CT, VERTEX_2_POS_COLOR_BINDINGS,
@@ -281,6 +289,11 @@ int main()
 	vkDestroyPipeline(device, pipel, NULL);
 	vkDestroyPipelineLayout(device, layout, NULL);
 
+	if (pipe_cache_save(phys_dev, device, &pcache) != 0) {
+		printf("Couldn't save the pipeline cache\n");
+	}
+	pipe_cache_destroy(device, pcache);
+
 	buffer_destroy(vbuf);
 	buffer_destroy(ibuf);
 	buffer_destroy(staging_buf);
@@ -2,11 +2,14 @@
 #include "../src/vk_tools.h"
 #include "../src/vk_window.h"
 #include "../src/vk_pipe.h"
+#include "../src/vk_pipe_cache.h"
 #include "../src/vk_cbuf.h"
 #include "../src/vk_sync.h"
 #include "../src/vk_buffer.h"
 #include "../src/vk_vertex.h"
 #include "../src/vk_image.h"
+#include "../src/vk_texture.h"
+#include "../src/vk_tex_stream.h"
 #include "../src/vk_uniform.h"
 #include "../src/vk_rpass.h"
 #include "../src/vk_sync_pool.h"
@@ -17,13 +20,9 @@
 #include <string.h>
 #include <stdio.h>
 
-// Initialize STB image loader
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb/stb_image.h>
-
-#define TEXTURE_W 1024
-#define TEXTURE_H 1024
 #define MAX_FRAMES_IN_FLIGHT 4
+// Staging memory for textures being streamed in
+#define TEXTURE_RING_SIZE (64 * 1024 * 1024)
 
 // Returns the elapsed time in floating-point seconds
 double get_elapsed(struct timespec *s_time);
@@ -150,60 +149,19 @@ int main() {
 			   staging_buf.handle,
 			   ibuf.handle);
 
-	// Load texture
-	int texture_w, texture_h, texture_channels;
-	unsigned char *texture_data = stbi_load("assets/images/texture.png",
-					      &texture_w, &texture_h,
-					      &texture_channels, 0);
-	assert(texture_w == TEXTURE_W);
-	assert(texture_h == TEXTURE_H);
-	assert(texture_channels == 4);
-	printf("Width, height, channels: %d, %d, %d\n",
-	       texture_w, texture_h, texture_channels);
-	uint32_t texture_size = texture_w * texture_h * texture_channels;
-
-	// Copy to staging buffer for texture
-	struct Buffer texture_staging;
-	buffer_create(device, mem_props,
-		      texture_size,
-		      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		      &texture_staging);
-
-	buffer_write(texture_staging, texture_size, texture_data);
-
-	// Texture
-	struct Image texture;
-	image_create(device, queue_fam, mem_props,
-		     VK_FORMAT_R8G8B8A8_SRGB,
-		     VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		     VK_IMAGE_ASPECT_COLOR_BIT,
-		     VK_SAMPLE_COUNT_1_BIT,
-		     TEXTURE_W, TEXTURE_H,
-		     &texture);
-
-	image_transition(device, queue, cpool,
-			 texture.handle, VK_IMAGE_ASPECT_COLOR_BIT,
-			 0,
-			 VK_ACCESS_TRANSFER_WRITE_BIT,
-			 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-			 VK_PIPELINE_STAGE_TRANSFER_BIT,
-			 VK_IMAGE_LAYOUT_UNDEFINED,
-			 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-	copy_buffer_image(device, queue, cpool,
-			  VK_IMAGE_ASPECT_COLOR_BIT, TEXTURE_W, TEXTURE_H,
-			  texture_staging.handle, texture.handle);
-
-	image_transition(device, queue, cpool,
-			 texture.handle, VK_IMAGE_ASPECT_COLOR_BIT,
-			 VK_ACCESS_TRANSFER_WRITE_BIT,
-			 VK_ACCESS_SHADER_READ_BIT,
-			 VK_PIPELINE_STAGE_TRANSFER_BIT,
-			 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-			 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	// Stream the texture in, block-compressed if the device can sample it.
+	// The PNG is only encoded the first time, after that it's read from the
+	// cache in bin/. Until it's uploaded, frames sample a placeholder.
+	VkFormat texture_fmt = texture_bc_supported(phys_dev)
+		? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_R8G8B8A8_SRGB;
+
+	struct TexStream stream;
+	tex_stream_create(device, queue_fam, queue, mem_props,
+			  TEXTURE_RING_SIZE, "bin", &stream);
+
+	uint32_t texture_id = tex_stream_request(&stream,
+						 "assets/images/texture.png",
+						 texture_fmt);
 
 	// Sampler
 	VkSamplerCreateInfo sampler_info = {0};
@@ -221,15 +179,18 @@ int main() {
 	sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 	sampler_info.mipLodBias = 0.0f;
 	sampler_info.minLod = 0.0f;
-	sampler_info.maxLod = 0.0f;
+	// The texture's level count isn't known until it's loaded
+	sampler_info.maxLod = VK_LOD_CLAMP_NONE;
 
 	VkSampler sampler;
 	res = vkCreateSampler(device, &sampler_info, NULL, &sampler);
 	assert(res == VK_SUCCESS);
 
-	// Set
+	// Sets, one for every frame in flight, so each can be pointed at the
+	// texture once it's resident without touching one the GPU is using
 	VkDescriptorPool dpool;
-	create_descriptor_pool(device, 1, 1, &dpool);
+	create_descriptor_pool(device, MAX_FRAMES_IN_FLIGHT, MAX_FRAMES_IN_FLIGHT,
+			       &dpool);
 	
 	struct Set set;
 	VkDescriptorType desc_types[] =
@@ -237,17 +198,31 @@ int main() {
 	VkDescriptorBufferInfo desc_buffers[] = {NULL};
 	VkDescriptorImageInfo desc_images[] =
 		{{.sampler = sampler,
-		  .imageView = texture.view,
+		  .imageView = tex_stream_view(&stream, texture_id),
 		  .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}};
 	VkShaderStageFlags desc_stages[] = {VK_SHADER_STAGE_FRAGMENT_BIT};
 
 	set_create(device, dpool,
 		   1, desc_types, desc_buffers, desc_images, desc_stages,
 		   &set);
+
+	VkDescriptorSet desc_sets[MAX_FRAMES_IN_FLIGHT];
+	VkImageView desc_views[MAX_FRAMES_IN_FLIGHT];
+	desc_sets[0] = set.handle;
+	desc_views[0] = desc_images[0].imageView;
+
+	for (int i = 1; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		allocate_descriptor_set(device, dpool, set.layout,
+					&desc_sets[i]);
+		write_descriptor_image(device, desc_sets[i], 0,
+				       sampler, desc_images[0].imageView,
+				       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		desc_views[i] = desc_images[0].imageView;
+	}
 		
 	// Pipeline layout
 	VkPipelineLayout layout;
-	create_layout(device, 1, &set.layout, &layout);
+	create_layout(device, 1, &set.layout, 0, NULL, &layout);
 
 	// Shaders
 	FILE *fp;
@@ -286,9 +261,16 @@ int main() {
 	create_shtage(fs_mod, VK_SHADER_STAGE_FRAGMENT_BIT, &fs_stage);
 	VkPipelineShaderStageCreateInfo shtages[] = {vs_stage, fs_stage};
 
+	// Pipelines go through a cache kept in bin/, so later runs skip
+	// compiling them from SPIR-V
+	struct PipeCache pcache;
+	pipe_cache_create(phys_dev, device, "bin/texture-pipelines.cache",
+			  &pcache);
+
 	// Pipeline
 	VkPipeline pipel = NULL;
 	create_pipel(device,
+		     pcache.handle,
 		     2,
 		     shtages,
 		     layout,
@@ -363,6 +345,22 @@ int main() {
 		VkSemaphore image_avail_sem = image_avail_sems[sync_set_idx];
 		VkSemaphore render_done_sem = render_done_sems[sync_set_idx];
 
+		// Upload whatever has been decoded, and once the texture is
+		// resident, switch this frame's set over to it (the fence
+		// above means the GPU is done with the set)
+		if (tex_stream_update(&stream) > 0) {
+			printf("Texture resident after %.4f secs\n",
+			       get_elapsed(&s_time));
+		}
+
+		VkImageView view = tex_stream_view(&stream, texture_id);
+		if (desc_views[sync_set_idx] != view) {
+			write_descriptor_image(device, desc_sets[sync_set_idx], 0,
+					       sampler, view,
+					       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			desc_views[sync_set_idx] = view;
+		}
+
 		// Acquire image
 		uint32_t image_idx;
 		VkFramebuffer fb;
@@ -398,7 +396,7 @@ int main() {
 			    fb,
 			    swidth, sheight,
 			    layout, pipel,
-			    1, &set.handle,
+			    1, &desc_sets[sync_set_idx],
 			    vbuf.handle, ibuf.handle, index_count,
 			    &cbuf);
 
@@ -444,6 +442,11 @@ int main() {
 	vkDestroyPipeline(device, pipel, NULL);
 	vkDestroyPipelineLayout(device, layout, NULL);
 
+	if (pipe_cache_save(phys_dev, device, &pcache) != 0) {
+		printf("Couldn't save the pipeline cache\n");
+	}
+	pipe_cache_destroy(device, pcache);
+
 	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		vkDestroySemaphore(device, image_avail_sems[i], NULL);
 		vkDestroySemaphore(device, render_done_sems[i], NULL);
@@ -452,14 +455,13 @@ int main() {
 	set_destroy(device, set);
 
 	vkDestroySampler(device, sampler, NULL);
-	image_destroy(device, texture);
+	tex_stream_destroy(&stream);
 
 	vkDestroyDescriptorPool(device, dpool, NULL);
     
 	buffer_destroy(vbuf);
 	buffer_destroy(ibuf);
 	buffer_destroy(staging_buf);
-	buffer_destroy(texture_staging);
 
 	vkDestroyRenderPass(device, rpass, NULL);
 
@@ -471,8 +473,6 @@ int main() {
 
 	glfw_cleanup(gwin);
 
-	stbi_image_free(texture_data);
-
 	return 0;
 }
 
@@ -2,6 +2,7 @@
 #include "../src/vk_tools.h"
 #include "../src/vk_window.h"
 #include "../src/vk_pipe.h"
+#include "../src/vk_pipe_cache.h"
 #include "../src/vk_cbuf.h"
 #include "../src/vk_sync.h"
 #include "../src/vk_buffer.h"
@@ -142,7 +143,7 @@ int main() {
 
 	// Pipeline layout
 	VkPipelineLayout layout;
-	create_layout(device, 0, NULL, &layout);
+	create_layout(device, 0, NULL, 0, NULL, &layout);
 
 	// Shaders
 	FILE *fp;
@@ -181,9 +182,16 @@ int main() {
 	create_shtage(fs_mod, VK_SHADER_STAGE_FRAGMENT_BIT, &fs_stage);
 	VkPipelineShaderStageCreateInfo shtages[] = {vs_stage, fs_stage};
 
+	// Pipelines go through a cache kept in bin/, so later runs skip
+	// compiling them from SPIR-V
+	struct PipeCache pcache;
+	pipe_cache_create(phys_dev, device, "bin/triangle-pipelines.cache",
+			  &pcache);
+
 	// Pipeline
 	VkPipeline pipel = NULL;
 	create_pipel(device,
+		     pcache.handle,
 		     2,
 		     shtages,
 		     layout,
@@ -344,6 +352,11 @@ int main() {
 	vkDestroyPipeline(device, pipel, NULL);
 	vkDestroyPipelineLayout(device, layout, NULL);
 
+	if (pipe_cache_save(phys_dev, device, &pcache) != 0) {
+		printf("Couldn't save the pipeline cache\n");
+	}
+	pipe_cache_destroy(device, pcache);
+
 	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		vkDestroySemaphore(device, image_avail_sems[i], NULL);
 		vkDestroySemaphore(device, render_done_sems[i], NULL);
@@ -2,15 +2,24 @@
 #include "../src/vk_tools.h"
 #include "../src/vk_window.h"
 #include "../src/vk_pipe.h"
+#include "../src/vk_pipe_cache.h"
+#include "../src/vk_pipe_build.h"
 #include "../src/vk_cbuf.h"
 #include "../src/vk_sync.h"
 #include "../src/vk_buffer.h"
 #include "../src/vk_vertex.h"
 #include "../src/vk_uniform.h"
+#include "../src/vk_desc.h"
 #include "../src/vk_rpass.h"
 #include "../src/vk_image.h"
-#include "../src/vk_sync_pool.h"
+#include "../src/vk_frame.h"
+#include "../src/vk_delete.h"
 #include "../src/camera.h"
+#include "../src/cull.h"
+#include "../src/vk_hiz.h"
+#include "../src/vk_dyn_render.h"
+#include "../src/vk_graph.h"
+#include "../src/latency.h"
 
 #include <stdlib.h>
 #include <assert.h>
@@ -24,6 +33,8 @@
  */
 #define MAX_FRAMES_IN_FLIGHT 4
 #define DEPTH_FMT VK_FORMAT_D32_SFLOAT
+// Chunks are culled as a whole
+#define CHUNK_SIZE 16
 
 /*
  * STRUCTS
@@ -36,6 +47,15 @@ struct Mesh {
 	uint32_t *indices;
 };
 
+// Index ranges within a Mesh, one for each chunk of the world, and the bounds
+// of each chunk.
+struct Chunks {
+	uint32_t ct;
+	uint32_t *first_indices;
+	uint32_t *index_cts;
+	struct AabbArray bounds;
+};
+
 // Indexed [z * width * height + y * width + x].
 struct VoxelWorld {
 	// x
@@ -48,12 +68,37 @@ struct VoxelWorld {
 	unsigned char *data;
 };
 
+// What the "chunks" pass of the frame graph draws. Filled in every frame.
+struct ChunkDraw {
+	uint32_t width;
+	uint32_t height;
+	VkPipelineLayout layout;
+	VkPipeline pipel;
+	VkDescriptorSet *set;
+	VkBuffer vbuf;
+	VkBuffer ibuf;
+	uint32_t range_ct;
+	uint32_t *first_indices;
+	uint32_t *index_cts;
+};
+
+// What the "hiz" pass builds the depth pyramid with
+struct HizBuild {
+	struct HiZ *hiz;
+	uint32_t readback_idx;
+	uint64_t frame;
+	vec4 *view_proj;
+};
+
 /*
  * FUNCTIONS
  */
 
+// Cubes are grouped by chunk, so each chunk can be drawn on its own.
+//
 // Mallocs.
-void voxel_world_to_mesh(struct VoxelWorld *world, struct Mesh *mesh);
+void voxel_world_to_mesh(struct VoxelWorld *world,
+			 struct Mesh *mesh, struct Chunks *chunks);
 
 // Example:
 // "000|111\n"
@@ -77,7 +122,16 @@ void gen_cube_mesh(float x, float y, float z, uint32_t idx_off,
 // Returns the elapsed time in floating-point seconds
 double get_elapsed(struct timespec *s_time);
 
-int main()
+// DeletionFn for a struct HiZ
+void destroy_hiz(VkDevice device, void *data);
+
+// GraphRecordFn drawing a struct ChunkDraw
+void record_chunks(VkCommandBuffer cbuf, void *data);
+
+// GraphRecordFn building the depth pyramid from a struct HizBuild
+void record_hiz(VkCommandBuffer cbuf, void *data);
+
+int main(int argc, char *argv[])
 {
 	// Used for error checking on VK functions throughout
 	VkResult res;
@@ -118,16 +172,22 @@ int main()
 	VkPhysicalDeviceMemoryProperties mem_props;
 	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
 
-	// Get queue family
-	uint32_t queue_fam = get_queue_fam(phys_dev);
+	// Get queue families (transfer is separate from graphics if the device
+	// allows it)
+	struct QueueFams fams;
+	get_queue_fams(phys_dev, &fams);
+	uint32_t queue_fam = fams.graphics;
+	printf("Queue families: graphics %u, transfer %u, compute %u\n",
+	       fams.graphics, fams.transfer, fams.compute);
 
 	// Create device
 	VkDevice device;
-	create_device(phys_dev, queue_fam, &device);
+	create_device_queues(phys_dev, fams, &device);
 
-	// Get queue
-	VkQueue queue;
-	get_queue(device, queue_fam, &queue);
+	// Get queues
+	struct Queues queues;
+	get_queues(device, fams, &queues);
+	VkQueue queue = queues.graphics;
 
 	// Surface
 	VkSurfaceKHR surface;
@@ -135,35 +195,81 @@ int main()
 	uint32_t swidth, sheight;
 	get_dims(phys_dev, surface, &swidth, &sheight);
 
-	// Render pass
-	VkRenderPass rpass;
-	rpass_with_depth(device, SW_FORMAT, VK_FORMAT_D32_SFLOAT, &rpass);
+	// Render straight to the swapchain views where the device allows it,
+	// otherwise through a render pass and framebuffers
+	struct DynRender dr;
+	int use_dyn_render = dyn_render_load(phys_dev, device, &dr) == 0;
+	printf("Rendering with %s\n",
+	       use_dyn_render ? "dynamic rendering" : "render passes");
+
+	VkRenderPass rpass = VK_NULL_HANDLE;
+	if (!use_dyn_render) {
+		rpass_with_sampled_depth(device, SW_FORMAT, DEPTH_FMT, &rpass);
+	}
 
 	// Depth buffer
 	struct Image depth_image;
 	image_create(device, queue_fam, mem_props,
 		     DEPTH_FMT,
-		     VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		     VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+		     | VK_IMAGE_USAGE_SAMPLED_BIT,
 		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		     VK_IMAGE_ASPECT_DEPTH_BIT,
 		     VK_SAMPLE_COUNT_1_BIT,
 		     swidth, sheight,
 		     &depth_image);
 
-	// Window
+	// Every pipeline goes through a cache kept in bin/, so later runs skip
+	// compiling them from SPIR-V
+	struct PipeCache pcache_disk;
+	pipe_cache_create(phys_dev, device, "bin/voxel-pipelines.cache",
+			  &pcache_disk);
+	VkPipelineCache pcache = pcache_disk.handle;
+
+	// Depth pyramid, for occlusion culling
+	struct HiZ hiz;
+	hiz_create(device, pcache, mem_props, queue_fam, depth_image.view,
+		   swidth, sheight, MAX_FRAMES_IN_FLIGHT, &hiz);
+
+	// Window, with the present policy named on the command line
+	struct SwapchainConfig sw_config = SWAPCHAIN_CONFIG_DEFAULT;
+	if (argc > 1) {
+		if (strcmp(argv[1], "throughput") == 0) {
+			sw_config.policy = PRESENT_POLICY_THROUGHPUT;
+		} else if (strcmp(argv[1], "latency") == 0) {
+			sw_config.policy = PRESENT_POLICY_LOW_LATENCY;
+		} else if (strcmp(argv[1], "adaptive") == 0) {
+			sw_config.policy = PRESENT_POLICY_ADAPTIVE_VSYNC;
+		} else if (strcmp(argv[1], "vsync") == 0) {
+			sw_config.policy = PRESENT_POLICY_VSYNC;
+		} else {
+			printf("Usage: %s [throughput|latency|adaptive|vsync] "
+			       "[image count]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (argc > 2) sw_config.image_ct = atoi(argv[2]);
+
 	struct Window win;
-	window_create(gwin, phys_dev, instance, device,
-		      surface,
-		      queue_fam, queue,
-		      rpass,
-		      1, &depth_image.view,
-		      swidth, sheight,
-		      &win);
+	window_create_config(gwin, phys_dev, instance, device,
+			     surface,
+			     queue_fam, queue,
+			     rpass,
+			     1, &depth_image.view,
+			     swidth, sheight,
+			     sw_config,
+			     &win);
+	printf("Present mode: %s, %u images\n",
+	       present_mode_name(win.present_mode), win.image_ct);
 
 	// Command pool
 	VkCommandPool cpool;
 	create_cpool(device, queue_fam, &cpool);
 
+	// For uploads
+	VkCommandPool xfer_cpool;
+	create_cpool(device, fams.transfer, &xfer_cpool);
+
 	// Buffers
 	struct VoxelWorld world;
 	/*
@@ -182,7 +288,14 @@ int main()
 	}
 
 	struct Mesh mesh;
-	voxel_world_to_mesh(&world, &mesh);
+	struct Chunks chunks;
+	voxel_world_to_mesh(&world, &mesh, &chunks);
+
+	// Scratch space for culling
+	uint32_t *visible = malloc(sizeof(visible[0]) * chunks.ct);
+	uint32_t *draw_firsts = malloc(sizeof(draw_firsts[0]) * chunks.ct);
+	uint32_t *draw_cts = malloc(sizeof(draw_cts[0]) * chunks.ct);
+	uint64_t total_drawn = 0;
 
 	printf("Vertices: %d\n", mesh.vertex_ct);
 	printf("Indices: %d\n", mesh.index_ct);
@@ -210,12 +323,14 @@ int main()
 		      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		      &vbuf);
 
-	// Copy staging to vertex
-	copy_buffer_buffer(device,
-			   queue,
-			   cpool,
-			   vertices_size,
-			   staging_buf.handle,vbuf.handle);
+	// Copy staging to vertex, on the transfer queue
+	copy_buffer_buffer_owned(device,
+				 queues.transfer, xfer_cpool, fams.transfer,
+				 queue, cpool, queue_fam,
+				 VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+				 VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+				 vertices_size,
+				 staging_buf.handle, vbuf.handle);
 
 	// Index buffer
 	buffer_write(staging_buf, indices_size, (void *) mesh.indices);
@@ -229,11 +344,13 @@ int main()
 		      &ibuf);
 
 	// Copy staging to index
-	copy_buffer_buffer(device,
-			   queue,
-			   cpool,
-			   indices_size,
-			   staging_buf.handle,ibuf.handle);
+	copy_buffer_buffer_owned(device,
+				 queues.transfer, xfer_cpool, fams.transfer,
+				 queue, cpool, queue_fam,
+				 VK_ACCESS_INDEX_READ_BIT,
+				 VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+				 indices_size,
+				 staging_buf.handle, ibuf.handle);
 
 	// Uniform buffer
 	double mouse_x, mouse_y;
@@ -250,42 +367,46 @@ int main()
 		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 		      &uniform_buf);
 
-	// Descriptor pool
-	VkDescriptorPool dpool;
-	create_descriptor_pool(device, MAX_FRAMES_IN_FLIGHT, MAX_FRAMES_IN_FLIGHT, &dpool);
+	// Descriptor sets are allocated fresh every frame, from pools that are
+	// reset whole once the frame that used them is done
+	struct LayoutCache layouts;
+	layout_cache_create(&layouts);
+
+	struct DescAllocator descs;
+	desc_alloc_create(MAX_FRAMES_IN_FLIGHT, DESC_ALLOC_DEFAULT_SETS, &descs);
 
 	// Synchronization primitives
 	VkSemaphore *image_avail_sems = malloc(sizeof(image_avail_sems[0]) * MAX_FRAMES_IN_FLIGHT);
 	VkSemaphore *render_done_sems = malloc(sizeof(render_done_sems[0]) * MAX_FRAMES_IN_FLIGHT);
-	VkFence *swapchain_fences = malloc(sizeof(swapchain_fences[0]) * win.image_ct);
-
-	// Sets (one for each frame in flight)
-	uint32_t desc_ct = 1;
-	VkDescriptorType desc_types[] = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER};
-	VkDescriptorBufferInfo desc_buffers[] = {{.buffer = uniform_buf.handle,
-						  .offset = 0,
-						  .range = uniform_size}};
-	VkDescriptorImageInfo desc_images[] = {NULL};
-	VkShaderStageFlags desc_stages[] = {VK_SHADER_STAGE_VERTEX_BIT};
-	struct Set *sets = malloc(sizeof(sets[0]) * MAX_FRAMES_IN_FLIGHT);
 
 	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		create_sem(device, &image_avail_sems[i]);
 		create_sem(device, &render_done_sems[i]);
-
-		set_create(device, dpool,
-			   desc_ct, desc_types,
-			   desc_buffers, desc_images, desc_stages,
-			   &sets[i]);
 	}
 
-	for (int i = 0; i < win.image_ct; i++) {
-		swapchain_fences[i] = NULL;
-	}
+	// Set layout, shared by every frame's set
+	VkDescriptorSetLayoutBinding set_binding;
+	create_descriptor_binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				  VK_SHADER_STAGE_VERTEX_BIT, &set_binding);
+	VkDescriptorSetLayout set_layout = layout_cache_get(device, &layouts,
+							    1, &set_binding);
+
+	// Every frame's set is written from the same packed descriptors, in
+	// one templated call
+	VkDescriptorType set_type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	size_t set_offset = 0;
+	VkDescriptorUpdateTemplate set_tmpl;
+	desc_template_create(device, set_layout, 1, &set_type, &set_offset,
+			     &set_tmpl);
+
+	VkDescriptorBufferInfo set_ubo = {0};
+	set_ubo.buffer = uniform_buf.handle;
+	set_ubo.offset = 0;
+	set_ubo.range = uniform_size;
 
 	// Pipeline layout
 	VkPipelineLayout layout;
-	create_layout(device, 1, &sets[0].layout, &layout);
+	create_layout(device, 1, &set_layout, 0, NULL, &layout);
 
 	// Shaders
 	FILE *fp;
@@ -322,24 +443,34 @@ int main()
 	VkPipelineShaderStageCreateInfo fs_stage;
 	create_shtage(vs_mod, VK_SHADER_STAGE_VERTEX_BIT, &vs_stage);
 	create_shtage(fs_mod, VK_SHADER_STAGE_FRAGMENT_BIT, &fs_stage);
-	VkPipelineShaderStageCreateInfo shtages[] = {vs_stage, fs_stage};
 
 	// Pipeline
-	VkPipeline pipel = NULL;
-	create_pipel(device,
-		     2,
-		     shtages,
-		     layout,
-		     VERTEX_3_POS_COLOR_BINDING_CT,
-		     VERTEX_3_POS_COLOR_BINDINGS,
-		     VERTEX_3_POS_COLOR_ATTRIBUTE_CT,
-		     VERTEX_3_POS_COLOR_ATTRIBUTES,
-		     rpass, 1, VK_SAMPLE_COUNT_1_BIT,
-		     &pipel);
-
-	// Cleanup shader modules
-	vkDestroyShaderModule(device, vs_mod, NULL);
-	vkDestroyShaderModule(device, fs_mod, NULL);
+	struct timespec pipel_time;
+	clock_gettime(CLOCK_MONOTONIC, &pipel_time);
+
+	// Compiled on worker threads while the rest of startup carries on
+	struct PipeBuild *pipe_build = malloc(sizeof(*pipe_build));
+	pipe_build_create(device, pcache, 0, pipe_build);
+
+	struct PipeDesc pipel_desc = {0};
+	pipel_desc.shtage_ct = 2;
+	pipel_desc.shtages[0] = vs_stage;
+	pipel_desc.shtages[1] = fs_stage;
+	pipel_desc.layout = layout;
+	pipel_desc.binding_ct = VERTEX_3_POS_COLOR_BINDING_CT;
+	pipel_desc.binding_descs = VERTEX_3_POS_COLOR_BINDINGS;
+	pipel_desc.attr_ct = VERTEX_3_POS_COLOR_ATTRIBUTE_CT;
+	pipel_desc.attr_descs = VERTEX_3_POS_COLOR_ATTRIBUTES;
+	pipel_desc.samples = VK_SAMPLE_COUNT_1_BIT;
+	if (use_dyn_render) {
+		pipel_desc.rpass = VK_NULL_HANDLE;
+		pipel_desc.color_fmt = SW_FORMAT;
+		pipel_desc.depth_fmt = DEPTH_FMT;
+	} else {
+		pipel_desc.rpass = rpass;
+		pipel_desc.has_depth = 1;
+	}
+	uint32_t pipel_id = pipe_build_submit(pipe_build, &pipel_desc);
 
 	// Command buffers (one for every frame in flight)
 	VkCommandBuffer *cbufs = malloc(sizeof(cbufs[0])
@@ -354,9 +485,70 @@ int main()
 				 {1.0f, 0}};	
 	uint32_t clear_ct = ARRAY_SIZE(clears);
 
-	// SyncPool struct (handles render-done fences)
-	struct SyncPool sync_pool;
-	sync_pool_create(device, MAX_FRAMES_IN_FLIGHT, &sync_pool);
+	// Frame scheduler (one timeline semaphore for all frames in flight)
+	struct FrameScheduler sched;
+	frame_sched_create(device, MAX_FRAMES_IN_FLIGHT, &sched);
+
+	// Input-to-render latency
+	struct LatencyTracker latency;
+	latency_create(MAX_FRAMES_IN_FLIGHT, &latency);
+
+	// Resources replaced while frames using them may still be in flight
+	struct DeletionQueue deletions;
+	deletion_queue_create(&deletions);
+
+	// Frame graph, for the dynamic rendering path: draw the chunks, build
+	// the depth pyramid from their depth, then present. The swapchain
+	// image (and the depth image, on resize) change, so they're set again
+	// every frame.
+	struct RenderGraph graph;
+	struct ChunkDraw chunk_draw = {0};
+	struct HizBuild hiz_build = {0};
+	uint32_t sw_res = 0;
+	uint32_t depth_res = 0;
+	if (use_dyn_render) {
+		graph_create(&graph);
+
+		sw_res = graph_import(&graph, VK_NULL_HANDLE, VK_NULL_HANDLE,
+				      VK_IMAGE_ASPECT_COLOR_BIT,
+				      swidth, sheight,
+				      VK_IMAGE_LAYOUT_UNDEFINED,
+				      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				      0);
+		// The last HiZ build may still be reading the depth
+		depth_res = graph_import(&graph,
+					 depth_image.handle, depth_image.view,
+					 VK_IMAGE_ASPECT_DEPTH_BIT,
+					 swidth, sheight,
+					 VK_IMAGE_LAYOUT_UNDEFINED,
+					 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					 0);
+
+		uint32_t pass = graph_pass(&graph, "chunks",
+					   record_chunks, &chunk_draw);
+		graph_pass_color(&graph, pass, sw_res, &clears[0]);
+		graph_pass_depth(&graph, pass, depth_res, &clears[1]);
+
+		pass = graph_pass(&graph, "hiz", record_hiz, &hiz_build);
+		graph_pass_use(&graph, pass, depth_res, GRAPH_USAGE_SAMPLED);
+
+		pass = graph_pass(&graph, "present", NULL, NULL);
+		graph_pass_use(&graph, pass, sw_res, GRAPH_USAGE_PRESENT);
+
+		graph_compile(&graph);
+		graph_realize(device, mem_props, queue_fam, &graph);
+	}
+
+	// Pipeline is needed from here on
+	VkPipeline pipel = pipe_build_wait(pipe_build, pipel_id);
+	pipe_build_destroy(pipe_build);
+	free(pipe_build);
+
+	printf("Pipeline ready after %.3f ms (%zu bytes of cache loaded)\n",
+	       get_elapsed(&pipel_time) * 1000.0, pcache_disk.loaded_size);
+
+	vkDestroyShaderModule(device, vs_mod, NULL);
+	vkDestroyShaderModule(device, fs_mod, NULL);
 
 	// Timing
 	struct timespec s_time;
@@ -373,35 +565,55 @@ int main()
 	while (!glfwWindowShouldClose(gwin)) {
 		// Maybe recreate
 		if (must_recreate_swapchain) {
-			res = vkQueueWaitIdle(queue);
-			assert(res == VK_SUCCESS);
-			
 			get_dims(phys_dev, surface, &swidth, &sheight);
 
-			image_destroy(device, depth_image);
+			// The old ones (and the old swapchain) go once the last
+			// frame using them is done, rather than draining the
+			// queue here
+			deletion_queue_push_fn(&deletions, sched.frame,
+					       destroy_hiz, sizeof(hiz), &hiz);
+			deletion_queue_push_image(&deletions, sched.frame,
+						  depth_image);
 			image_create(device, queue_fam, mem_props,
 				     DEPTH_FMT,
-				     VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+				     VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+				     | VK_IMAGE_USAGE_SAMPLED_BIT,
 				     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 				     VK_IMAGE_ASPECT_DEPTH_BIT,
 				     VK_SAMPLE_COUNT_1_BIT,
 				     swidth, sheight,
 				     &depth_image);
+			hiz_create(device, pcache, mem_props, queue_fam,
+				   depth_image.view,
+				   swidth, sheight, MAX_FRAMES_IN_FLIGHT, &hiz);
 
-			window_recreate_swapchain(&win,
-						  1, &depth_image.view,
-						  swidth, sheight);
+			window_recreate_swapchain_deferred(&win,
+							   &deletions, sched.frame,
+							   1, &depth_image.view,
+							   swidth, sheight);
 
 			must_recreate_swapchain = 0;
 		}
 		
-		glfwPollEvents();
-
-		// Choose sync primitives
-		VkFence render_done_fence;
+		// Wait for the frame that last used this slot
 		uint32_t sync_set_idx;
-		sync_pool_acquire(device, &sync_pool,
-				  &render_done_fence, &sync_set_idx);
+		uint64_t frame = frame_sched_begin(device, &sched,
+						   &sync_set_idx);
+
+		uint64_t completed = frame_sched_completed(device, &sched);
+		latency_complete(&latency, completed);
+		deletion_queue_collect(device, &deletions, completed);
+
+		// The slot's last frame is done, so its sets can go
+		desc_alloc_begin(device, &descs, sync_set_idx);
+
+		VkDescriptorSet frame_set;
+		desc_alloc_get(device, &descs, set_layout, &frame_set);
+		desc_template_write(device, set_tmpl, frame_set, &set_ubo);
+
+		// Sample input only after waiting, so it's as fresh as possible
+		glfwPollEvents();
+		latency_input(&latency, frame);
 		
 		VkSemaphore image_avail_sem = image_avail_sems[sync_set_idx];
 		VkSemaphore render_done_sem = render_done_sems[sync_set_idx];
@@ -417,12 +629,33 @@ int main()
 		
 		buffer_write(uniform_buf, uniform_size, uniform_data);
 
+		// Cull chunks outside the view, then chunks hidden behind the
+		// depth of the latest finished frame
+		vec4 planes[6];
+		cam_frustum_planes(uniform_data, planes);
+		size_t visible_ct = cull_aabbs(&chunks.bounds, planes, visible);
+		visible_ct = hiz_cull_aabbs(&hiz, completed, &chunks.bounds,
+					    visible_ct, visible);
+
+		for (size_t i = 0; i < visible_ct; i++) {
+			draw_firsts[i] = chunks.first_indices[visible[i]];
+			draw_cts[i] = chunks.index_cts[visible[i]];
+		}
+		total_drawn += visible_ct;
+
 		// Acquire image
 		uint32_t image_idx;
 		VkFramebuffer fb;
-		int ac_res = window_acquire(&win, image_avail_sem, &image_idx, &fb);
+		double acquire_start = latency_now();
+		int ac_res = window_try_acquire(&win, image_avail_sem,
+						&image_idx, &fb);
+		latency_acquire(&latency, latency_now() - acquire_start);
 
 		if (ac_res != 0) {
+			// Nothing was acquired, but the frame still has to be
+			// retired so later waits on it return
+			frame_sched_submit(queue, &sched, VK_NULL_HANDLE,
+					   VK_NULL_HANDLE, VK_NULL_HANDLE);
 			must_recreate_swapchain = 1;
 			continue;
 		}
@@ -433,40 +666,62 @@ int main()
 			vkFreeCommandBuffers(device, cpool, 1, &cbuf);
 		}
 
-		// Wait for swapchain fence
-		VkFence swapchain_fence = swapchain_fences[image_idx];
-		if (swapchain_fence != NULL) {
-			res = vkWaitForFences(device, 1, &swapchain_fence, VK_TRUE, UINT64_MAX);
-			assert(res == VK_SUCCESS);
+		// Record command buffer: draw the visible chunks, then build the
+		// depth pyramid from the result
+		cbuf_begin_one_time(device, cpool, &cbuf);
+
+		if (use_dyn_render) {
+			chunk_draw.width = swidth;
+			chunk_draw.height = sheight;
+			chunk_draw.layout = layout;
+			chunk_draw.pipel = pipel;
+			chunk_draw.set = &frame_set;
+			chunk_draw.vbuf = vbuf.handle;
+			chunk_draw.ibuf = ibuf.handle;
+			chunk_draw.range_ct = visible_ct;
+			chunk_draw.first_indices = draw_firsts;
+			chunk_draw.index_cts = draw_cts;
+
+			hiz_build.hiz = &hiz;
+			hiz_build.readback_idx = sync_set_idx;
+			hiz_build.frame = frame;
+			hiz_build.view_proj = uniform_data;
+
+			graph_set_import(&graph, sw_res,
+					 win.images[image_idx],
+					 win.views[image_idx],
+					 swidth, sheight);
+			graph_set_import(&graph, depth_res,
+					 depth_image.handle, depth_image.view,
+					 swidth, sheight);
+
+			graph_execute(&graph, &dr, cbuf);
+		} else {
+			cbuf_record_ranges(cbuf,
+					   rpass, clear_ct, clears,
+					   fb,
+					   swidth,
+					   sheight,
+					   layout,
+					   pipel,
+					   1,
+					   &frame_set,
+					   vbuf.handle,
+					   ibuf.handle,
+					   visible_ct, draw_firsts, draw_cts);
+
+			hiz_record(&hiz, cbuf, sync_set_idx, frame,
+				   uniform_data);
 		}
 
-		res = vkResetFences(device, 1, &render_done_fence);
+		res = vkEndCommandBuffer(cbuf);
 		assert(res == VK_SUCCESS);
 
-		// Set swapchain fence
-		swapchain_fences[image_idx] = render_done_fence;
-
-		// Create command buffer
-		create_cbuf(device,
-			    cpool,
-			    rpass, clear_ct, clears,
-			    fb,
-			    swidth,
-			    sheight,
-			    layout,
-			    pipel,
-			    1,
-			    &sets[sync_set_idx].handle,
-			    vbuf.handle,
-			    ibuf.handle,
-			    mesh.index_ct,
-			    &cbuf);
-
 		cbufs[sync_set_idx] = cbuf;
 
 		// Submit
-		submit_synced(queue, image_avail_sem, render_done_sem,
-			      render_done_fence, cbuf);
+		frame_sched_submit(queue, &sched, image_avail_sem,
+				   render_done_sem, cbuf);
 
 		// Present
 		VkPresentInfoKHR present_info = {0};
@@ -479,7 +734,8 @@ int main()
 
 		res = vkQueuePresentKHR(queue, &present_info);
 
-		if (res == VK_ERROR_OUT_OF_DATE_KHR) {
+		if (res == VK_ERROR_OUT_OF_DATE_KHR
+		    || res == VK_SUBOPTIMAL_KHR) {
 			must_recreate_swapchain = 1;
 		} else {
 			assert(res == VK_SUCCESS);
@@ -492,36 +748,59 @@ int main()
 	double elapsed = get_elapsed(&s_time);
 	printf("%d frames in %.4f secs --> %.4f FPS\n", f_count, elapsed, (double) f_count / elapsed);
 	printf("Avg. delta: %.4f ms\n", elapsed / (double) f_count * 1000.0f);
-
-	res = vkQueueWaitIdle(queue);
-	assert(res == VK_SUCCESS);
-
+	printf("%s: input to render done %.3f ms avg, %.3f ms max; "
+	       "acquire %.3f ms avg\n",
+	       present_mode_name(win.present_mode),
+	       latency_avg(&latency) * 1000.0, latency.max_secs * 1000.0,
+	       latency_acquire_avg(&latency) * 1000.0);
+	printf("Avg. chunks drawn: %.1f of %u\n",
+	       (double) total_drawn / (double) f_count, chunks.ct);
+
+	frame_sched_wait_idle(device, &sched);
+
+	deletion_queue_destroy(device, deletions);
+	if (use_dyn_render) graph_destroy(device, graph);
+	hiz_destroy(device, hiz);
 	image_destroy(device, depth_image);
 	vkDestroyCommandPool(device, cpool, NULL);
+	vkDestroyCommandPool(device, xfer_cpool, NULL);
 
 	window_cleanup(&win);
 
-	sync_pool_destroy(device, sync_pool);
+	frame_sched_destroy(device, sched);
+	latency_destroy(latency);
 
 	vkDestroyPipeline(device, pipel, NULL);
 	vkDestroyPipelineLayout(device, layout, NULL);
 
+	if (pipe_cache_save(phys_dev, device, &pcache_disk) != 0) {
+		printf("Couldn't save the pipeline cache\n");
+	}
+	pipe_cache_destroy(device, pcache_disk);
+
 	buffer_destroy(uniform_buf);
 
 	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		vkDestroySemaphore(device, image_avail_sems[i], NULL);
 		vkDestroySemaphore(device, render_done_sems[i], NULL);
-
-		set_destroy(device, sets[i]);
 	}
 
-	vkDestroyDescriptorPool(device, dpool, NULL);
+	vkDestroyDescriptorUpdateTemplate(device, set_tmpl, NULL);
+	desc_alloc_destroy(device, descs);
+	layout_cache_destroy(device, layouts);
 
 	buffer_destroy(vbuf);
 	buffer_destroy(ibuf);
 	buffer_destroy(staging_buf);
 
-	vkDestroyRenderPass(device, rpass, NULL);
+	cull_aabbs_destroy(chunks.bounds);
+	free(chunks.first_indices);
+	free(chunks.index_cts);
+	free(visible);
+	free(draw_firsts);
+	free(draw_cts);
+
+	if (rpass != VK_NULL_HANDLE) vkDestroyRenderPass(device, rpass, NULL);
 
 	vkDestroySurfaceKHR(instance, surface, NULL);
 
@@ -534,7 +813,8 @@ int main()
 	return 0;
 }
 
-void voxel_world_to_mesh(struct VoxelWorld *world, struct Mesh *mesh)
+void voxel_world_to_mesh(struct VoxelWorld *world,
+			 struct Mesh *mesh, struct Chunks *chunks)
 {
 	int w = world->width;
 	int h = world->height;
@@ -557,23 +837,63 @@ void voxel_world_to_mesh(struct VoxelWorld *world, struct Mesh *mesh)
 	mesh->index_ct = cell_ct * cube_idx_ct;
 	mesh->indices = malloc(mesh->index_ct * sizeof(mesh->indices[0]));
 
-	// Fill
+	int chunks_x = (w + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	int chunks_y = (h + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	int chunks_z = (d + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	int max_chunk_ct = chunks_x * chunks_y * chunks_z;
+
+	chunks->ct = 0;
+	chunks->first_indices = malloc(max_chunk_ct
+				       * sizeof(chunks->first_indices[0]));
+	chunks->index_cts = malloc(max_chunk_ct * sizeof(chunks->index_cts[0]));
+	cull_aabbs_create(max_chunk_ct, &chunks->bounds);
+
+	// Fill, one chunk at a time
 	int vertex_idx = 0;
 	int index_idx = 0;
-	for (int z = 0; z < d; z++) {
-		for (int y = 0; y < h; y++) {
-			for (int x = 0; x < w; x++) {				
-				if (world->data[z * w * h + y * w + x] == 0)
-					continue;
-
-				gen_cube_mesh(x, y, z, vertex_idx, NULL, NULL,
-					      &mesh->vertices[vertex_idx],
-					      &mesh->indices[index_idx]);
-				vertex_idx += cube_vtx_ct;
-				index_idx += cube_idx_ct;
+	for (int c = 0; c < max_chunk_ct; c++) {
+		int cx = c % chunks_x;
+		int cy = c / chunks_x % chunks_y;
+		int cz = c / (chunks_x * chunks_y);
+
+		int x0 = cx * CHUNK_SIZE;
+		int y0 = cy * CHUNK_SIZE;
+		int z0 = cz * CHUNK_SIZE;
+		int x1 = x0 + CHUNK_SIZE < w ? x0 + CHUNK_SIZE : w;
+		int y1 = y0 + CHUNK_SIZE < h ? y0 + CHUNK_SIZE : h;
+		int z1 = z0 + CHUNK_SIZE < d ? z0 + CHUNK_SIZE : d;
+
+		int first_index = index_idx;
+		for (int z = z0; z < z1; z++) {
+			for (int y = y0; y < y1; y++) {
+				for (int x = x0; x < x1; x++) {
+					if (world->data[z * w * h + y * w + x] == 0)
+						continue;
+
+					gen_cube_mesh(x, y, z, vertex_idx, NULL, NULL,
+						      &mesh->vertices[vertex_idx],
+						      &mesh->indices[index_idx]);
+					vertex_idx += cube_vtx_ct;
+					index_idx += cube_idx_ct;
+				}
 			}
 		}
+
+		// Empty chunks are left out entirely
+		if (index_idx == first_index) continue;
+
+		// Cubes are centered on their coordinates
+		vec3 min = {x0 - 0.5f, y0 - 0.5f, z0 - 0.5f};
+		vec3 max = {x1 - 0.5f, y1 - 0.5f, z1 - 0.5f};
+
+		cull_aabbs_set(&chunks->bounds, chunks->ct, min, max);
+		chunks->first_indices[chunks->ct] = first_index;
+		chunks->index_cts[chunks->ct] = index_idx - first_index;
+		chunks->ct++;
 	}
+
+	chunks->bounds.ct = chunks->ct;
+	printf("Chunk count: %d\n", chunks->ct);
 }
 
 void voxel_world_from_string(char *str, struct VoxelWorld *world)
@@ -695,3 +1015,27 @@ double get_elapsed(struct timespec *s_time) {
 
 	return secs + subsec;
 }
+
+void destroy_hiz(VkDevice device, void *data)
+{
+	hiz_destroy(device, *(struct HiZ *) data);
+}
+
+void record_chunks(VkCommandBuffer cbuf, void *data)
+{
+	struct ChunkDraw *draw = data;
+
+	cbuf_draw_ranges(cbuf, draw->width, draw->height,
+			 draw->layout, draw->pipel,
+			 1, draw->set,
+			 draw->vbuf, draw->ibuf,
+			 draw->range_ct, draw->first_indices, draw->index_cts);
+}
+
+void record_hiz(VkCommandBuffer cbuf, void *data)
+{
+	struct HizBuild *build = data;
+
+	hiz_record(build->hiz, cbuf, build->readback_idx, build->frame,
+		   build->view_proj);
+}
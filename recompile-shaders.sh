@@ -4,7 +4,7 @@ use strict;
 use File::Find::Rule;
 
 my @files = File::Find::Rule->file()
-                            ->name(qr/.*\.(vert|frag)$/)
+                            ->name(qr/.*\.(vert|frag|comp)$/)
                             ->in(".");
 
 for (@files) {
@@ -0,0 +1,291 @@
+#include "bcn.h"
+
+#include <string.h>
+#include <math.h>
+
+// Interpolation weights (out of 64) for BC7's 4-bit indices
+static const int bc7_weights[16] = {
+	0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+};
+
+static float clampf(float x, float lo, float hi)
+{
+	return x < lo ? lo : (x > hi ? hi : x);
+}
+
+/*
+ * Fits a line through the texels' first <ch_ct> channels, along their
+ * principal axis, and returns the ends of the segment covering all of them.
+ */
+static void fit_endpoints(const unsigned char texels[16][4], int ch_ct,
+			  float e0[4], float e1[4])
+{
+	float mean[4] = {0};
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < ch_ct; c++) mean[c] += texels[i][c];
+	}
+	for (int c = 0; c < ch_ct; c++) mean[c] /= 16.0f;
+
+	float cov[4][4] = {{0}};
+	for (int i = 0; i < 16; i++) {
+		float d[4];
+		for (int c = 0; c < ch_ct; c++) d[c] = texels[i][c] - mean[c];
+		for (int a = 0; a < ch_ct; a++) {
+			for (int b = 0; b < ch_ct; b++) cov[a][b] += d[a] * d[b];
+		}
+	}
+
+	// Start from the covariance row of the channel that varies most, which
+	// can't be orthogonal to the principal axis
+	int widest = 0;
+	for (int c = 1; c < ch_ct; c++) {
+		if (cov[c][c] > cov[widest][widest]) widest = c;
+	}
+
+	// Every texel is the same
+	if (cov[widest][widest] == 0.0f) {
+		memcpy(e0, mean, sizeof(mean));
+		memcpy(e1, mean, sizeof(mean));
+		return;
+	}
+
+	float axis[4] = {0};
+	for (int c = 0; c < ch_ct; c++) axis[c] = cov[widest][c];
+
+	// Power iteration converges quickly enough for 16 points
+	for (int iter = 0; iter < 8; iter++) {
+		float next[4] = {0};
+		float len = 0.0f;
+		for (int a = 0; a < ch_ct; a++) {
+			for (int b = 0; b < ch_ct; b++) next[a] += cov[a][b] * axis[b];
+			if (fabsf(next[a]) > len) len = fabsf(next[a]);
+		}
+		for (int c = 0; c < ch_ct; c++) axis[c] = next[c] / len;
+	}
+
+	float t_min = 0.0f;
+	float t_max = 0.0f;
+	float axis_sq = 0.0f;
+	for (int c = 0; c < ch_ct; c++) axis_sq += axis[c] * axis[c];
+
+	for (int i = 0; i < 16; i++) {
+		float t = 0.0f;
+		for (int c = 0; c < ch_ct; c++) {
+			t += (texels[i][c] - mean[c]) * axis[c];
+		}
+		t /= axis_sq;
+		if (t < t_min) t_min = t;
+		if (t > t_max) t_max = t;
+	}
+
+	for (int c = 0; c < ch_ct; c++) {
+		e0[c] = clampf(mean[c] + t_min * axis[c], 0.0f, 255.0f);
+		e1[c] = clampf(mean[c] + t_max * axis[c], 0.0f, 255.0f);
+	}
+}
+
+static int sq_error(const unsigned char a[4], const int b[4], int ch_ct)
+{
+	int err = 0;
+	for (int c = 0; c < ch_ct; c++) {
+		int d = a[c] - b[c];
+		err += d * d;
+	}
+	return err;
+}
+
+static uint16_t pack_565(const float e[3])
+{
+	uint16_t r = (uint16_t) (e[0] * 31.0f / 255.0f + 0.5f);
+	uint16_t g = (uint16_t) (e[1] * 63.0f / 255.0f + 0.5f);
+	uint16_t b = (uint16_t) (e[2] * 31.0f / 255.0f + 0.5f);
+	return (r << 11) | (g << 5) | b;
+}
+
+static void unpack_565(uint16_t c, int out[4])
+{
+	int r = (c >> 11) & 31;
+	int g = (c >> 5) & 63;
+	int b = c & 31;
+	out[0] = (r << 3) | (r >> 2);
+	out[1] = (g << 2) | (g >> 4);
+	out[2] = (b << 3) | (b >> 2);
+	out[3] = 255;
+}
+
+void bc1_encode_block(const unsigned char texels[16][4],
+		      unsigned char out[BC1_BLOCK_SIZE])
+{
+	float e0[4];
+	float e1[4];
+	fit_endpoints(texels, 3, e0, e1);
+
+	uint16_t c0 = pack_565(e1);
+	uint16_t c1 = pack_565(e0);
+
+	// The 4-color mode needs c0 > c1. If they're equal, every index is 0.
+	if (c0 < c1) {
+		uint16_t tmp = c0;
+		c0 = c1;
+		c1 = tmp;
+	}
+
+	uint32_t indices = 0;
+	if (c0 != c1) {
+		int palette[4][4];
+		unpack_565(c0, palette[0]);
+		unpack_565(c1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+		}
+
+		for (int i = 0; i < 16; i++) {
+			uint32_t best = 0;
+			int best_err = sq_error(texels[i], palette[0], 3);
+			for (uint32_t j = 1; j < 4; j++) {
+				int err = sq_error(texels[i], palette[j], 3);
+				if (err < best_err) {
+					best = j;
+					best_err = err;
+				}
+			}
+			indices |= best << (2 * i);
+		}
+	}
+
+	out[0] = c0 & 0xff;
+	out[1] = c0 >> 8;
+	out[2] = c1 & 0xff;
+	out[3] = c1 >> 8;
+	out[4] = indices & 0xff;
+	out[5] = (indices >> 8) & 0xff;
+	out[6] = (indices >> 16) & 0xff;
+	out[7] = indices >> 24;
+}
+
+// Writes the low <ct> bits of <value> at bit <*pos>, least significant first
+static void put_bits(unsigned char *out, uint32_t *pos,
+		     uint32_t value, uint32_t ct)
+{
+	for (uint32_t i = 0; i < ct; i++) {
+		if (value & (1u << i)) out[*pos / 8] |= 1 << (*pos % 8);
+		(*pos)++;
+	}
+}
+
+/*
+ * Quantizes an endpoint to 7 bits per channel plus a shared lowest bit,
+ * picking whichever shared bit is closer.
+ */
+static void quantize_7p(const float e[4], int q[4], int *p)
+{
+	int best_err = -1;
+	for (int pbit = 0; pbit < 2; pbit++) {
+		int cand[4];
+		int err = 0;
+		for (int c = 0; c < 4; c++) {
+			int v = (int) ((e[c] - pbit) / 2.0f + 0.5f);
+			cand[c] = v < 0 ? 0 : (v > 127 ? 127 : v);
+
+			float d = e[c] - (float) ((cand[c] << 1) | pbit);
+			err += (int) (d * d);
+		}
+
+		if (best_err < 0 || err < best_err) {
+			best_err = err;
+			memcpy(q, cand, sizeof(cand));
+			*p = pbit;
+		}
+	}
+}
+
+void bc7_encode_block(const unsigned char texels[16][4],
+		      unsigned char out[BC7_BLOCK_SIZE])
+{
+	float e0[4];
+	float e1[4];
+	fit_endpoints(texels, 4, e0, e1);
+
+	int q[2][4];
+	int p[2];
+	quantize_7p(e0, q[0], &p[0]);
+	quantize_7p(e1, q[1], &p[1]);
+
+	int palette[16][4];
+	for (int c = 0; c < 4; c++) {
+		int a = (q[0][c] << 1) | p[0];
+		int b = (q[1][c] << 1) | p[1];
+		for (int j = 0; j < 16; j++) {
+			int w = bc7_weights[j];
+			palette[j][c] = ((64 - w) * a + w * b + 32) >> 6;
+		}
+	}
+
+	uint32_t indices[16];
+	for (int i = 0; i < 16; i++) {
+		uint32_t best = 0;
+		int best_err = sq_error(texels[i], palette[0], 4);
+		for (uint32_t j = 1; j < 16; j++) {
+			int err = sq_error(texels[i], palette[j], 4);
+			if (err < best_err) {
+				best = j;
+				best_err = err;
+			}
+		}
+		indices[i] = best;
+	}
+
+	// The first index is stored without its top bit, so it must be clear.
+	// The weights are symmetric, so swapping the endpoints and flipping
+	// every index gives the same texels.
+	int first = 0;
+	if (indices[0] & 8) {
+		first = 1;
+		for (int i = 0; i < 16; i++) indices[i] = 15 - indices[i];
+	}
+	int second = 1 - first;
+
+	memset(out, 0, BC7_BLOCK_SIZE);
+	uint32_t pos = 0;
+
+	// Mode 6 is 6 zero bits then a one
+	put_bits(out, &pos, 1 << 6, 7);
+	for (int c = 0; c < 4; c++) {
+		put_bits(out, &pos, q[first][c], 7);
+		put_bits(out, &pos, q[second][c], 7);
+	}
+	put_bits(out, &pos, p[first], 1);
+	put_bits(out, &pos, p[second], 1);
+
+	put_bits(out, &pos, indices[0], 3);
+	for (int i = 1; i < 16; i++) put_bits(out, &pos, indices[i], 4);
+}
+
+void bc_encode(uint32_t width, uint32_t height,
+	       const unsigned char *rgba,
+	       void (*encode_block)(const unsigned char [16][4],
+				    unsigned char *),
+	       size_t block_size,
+	       unsigned char *out)
+{
+	uint32_t block_w = (width + 3) / 4;
+	uint32_t block_h = (height + 3) / 4;
+
+	for (uint32_t by = 0; by < block_h; by++) {
+		for (uint32_t bx = 0; bx < block_w; bx++) {
+			unsigned char texels[16][4];
+			for (uint32_t i = 0; i < 16; i++) {
+				uint32_t x = bx * 4 + i % 4;
+				uint32_t y = by * 4 + i / 4;
+				if (x >= width) x = width - 1;
+				if (y >= height) y = height - 1;
+
+				memcpy(texels[i], &rgba[4 * (y * width + x)], 4);
+			}
+
+			encode_block(texels,
+				     &out[(by * block_w + bx) * block_size]);
+		}
+	}
+}
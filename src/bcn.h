@@ -0,0 +1,43 @@
+#ifndef BCN_H_
+#define BCN_H_
+
+#include <stddef.h>
+#include <inttypes.h>
+
+// Encoded size of one 4x4 block
+#define BC1_BLOCK_SIZE 8
+#define BC7_BLOCK_SIZE 16
+
+/*
+ * Encodes one 4x4 block of RGBA8 texels, row by row, as BC1.
+ *
+ * Every block uses the opaque 4-color mode, so alpha is dropped.
+ */
+void bc1_encode_block(const unsigned char texels[16][4],
+		      unsigned char out[BC1_BLOCK_SIZE]);
+
+/*
+ * Encodes one 4x4 block of RGBA8 texels, row by row, as BC7.
+ *
+ * Only mode 6 is used: one pair of RGBA endpoints with 16 interpolation steps
+ * between them. That is fast to search and handles alpha and smooth
+ * gradients well, but blocks with more than 2 distinct colors lose more than
+ * a full encoder trying every mode and partition would.
+ */
+void bc7_encode_block(const unsigned char texels[16][4],
+		      unsigned char out[BC7_BLOCK_SIZE]);
+
+/*
+ * Encodes a whole RGBA8 image with <encode_block>, like bc1_encode_block.
+ * Blocks hanging over the right or bottom edge repeat the last column or row.
+ *
+ * out: Must have room for ceil(w / 4) * ceil(h / 4) blocks of <block_size>
+ */
+void bc_encode(uint32_t width, uint32_t height,
+	       const unsigned char *rgba,
+	       void (*encode_block)(const unsigned char [16][4],
+				    unsigned char *),
+	       size_t block_size,
+	       unsigned char *out);
+
+#endif // BCN_H_
@@ -0,0 +1,437 @@
+#include "bvh.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define BIN_CT 16
+// Cost of visiting a node, relative to testing one object
+#define TRAVERSAL_COST 1.0f
+
+struct Bounds {
+	float min[3];
+	float max[3];
+};
+
+// Copy of an object's bounds that's moved around while partitioning, so the
+// build doesn't have to keep jumping around the AabbArray
+struct BuildPrim {
+	struct Bounds bounds;
+	float centroid[3];
+	uint32_t obj;
+};
+
+struct Builder {
+	struct Bvh *bvh;
+	struct BuildPrim *prims;
+};
+
+static const struct Bounds EMPTY_BOUNDS = {
+	{INFINITY, INFINITY, INFINITY},
+	{-INFINITY, -INFINITY, -INFINITY}
+};
+
+static void bounds_grow(struct Bounds *b, float min[3], float max[3])
+{
+	for (int i = 0; i < 3; i++) {
+		if (min[i] < b->min[i]) b->min[i] = min[i];
+		if (max[i] > b->max[i]) b->max[i] = max[i];
+	}
+}
+
+static void bounds_grow_object(struct Bounds *b, struct AabbArray *aabbs,
+			       uint32_t obj)
+{
+	float min[3] = {aabbs->min_x[obj], aabbs->min_y[obj], aabbs->min_z[obj]};
+	float max[3] = {aabbs->max_x[obj], aabbs->max_y[obj], aabbs->max_z[obj]};
+	bounds_grow(b, min, max);
+}
+
+// Half the surface area, which is all the SAH needs
+static float bounds_area(struct Bounds *b)
+{
+	if (b->min[0] > b->max[0]) return 0.0f;
+
+	float x = b->max[0] - b->min[0];
+	float y = b->max[1] - b->min[1];
+	float z = b->max[2] - b->min[2];
+
+	return x * y + y * z + z * x;
+}
+
+static void set_node_bounds(struct BvhNode *node, struct Bounds *b)
+{
+	for (int i = 0; i < 3; i++) {
+		node->min[i] = b->min[i];
+		node->max[i] = b->max[i];
+	}
+}
+
+/*
+ * Picks where to split the objects of a node along <axis>. Returns the bin
+ * index the right half starts at, or 0 if not splitting is cheaper.
+ */
+static int find_split(struct Builder *b, uint32_t first, uint32_t ct,
+		      int axis, float cmin, float cmax, float node_area)
+{
+	struct Bounds bins[BIN_CT];
+	uint32_t counts[BIN_CT] = {0};
+	for (int i = 0; i < BIN_CT; i++) bins[i] = EMPTY_BOUNDS;
+
+	float scale = BIN_CT / (cmax - cmin);
+	for (uint32_t i = first; i < first + ct; i++) {
+		struct BuildPrim *prim = &b->prims[i];
+		int bin = (prim->centroid[axis] - cmin) * scale;
+		if (bin >= BIN_CT) bin = BIN_CT - 1;
+
+		counts[bin]++;
+		bounds_grow(&bins[bin], prim->bounds.min, prim->bounds.max);
+	}
+
+	// Sweep from the right to get the cost of everything right of each split
+	float right_costs[BIN_CT];
+	struct Bounds acc = EMPTY_BOUNDS;
+	uint32_t acc_ct = 0;
+	for (int i = BIN_CT - 1; i > 0; i--) {
+		bounds_grow(&acc, bins[i].min, bins[i].max);
+		acc_ct += counts[i];
+		right_costs[i] = bounds_area(&acc) * acc_ct;
+	}
+
+	// Then from the left to find the cheapest one. Splitting costs an extra
+	// node visit on top of testing the objects in each half.
+	int best = 0;
+	float best_cost = node_area * ct;
+	if (ct > BVH_MAX_LEAF_SIZE) best_cost = INFINITY;
+
+	acc = EMPTY_BOUNDS;
+	acc_ct = 0;
+	for (int i = 1; i < BIN_CT; i++) {
+		bounds_grow(&acc, bins[i - 1].min, bins[i - 1].max);
+		acc_ct += counts[i - 1];
+		if (acc_ct == 0 || acc_ct == ct) continue;
+
+		float cost = node_area * TRAVERSAL_COST
+			+ bounds_area(&acc) * acc_ct + right_costs[i];
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+static void build_node(struct Builder *b, uint32_t node_idx,
+		       uint32_t first, uint32_t ct, int depth)
+{
+	struct Bvh *bvh = b->bvh;
+	struct BvhNode *node = &bvh->nodes[node_idx];
+	node->first = first;
+	node->ct = ct;
+	node->right = 0;
+
+	struct Bounds bounds = EMPTY_BOUNDS;
+	struct Bounds cbounds = EMPTY_BOUNDS;
+	for (uint32_t i = first; i < first + ct; i++) {
+		struct BuildPrim *prim = &b->prims[i];
+		bounds_grow(&bounds, prim->bounds.min, prim->bounds.max);
+		bounds_grow(&cbounds, prim->centroid, prim->centroid);
+	}
+	set_node_bounds(node, &bounds);
+
+	if (ct <= BVH_MIN_LEAF_SIZE || depth >= BVH_MAX_DEPTH - 1) return;
+
+	int axis = 0;
+	for (int i = 1; i < 3; i++) {
+		if (cbounds.max[i] - cbounds.min[i]
+		    > cbounds.max[axis] - cbounds.min[axis]) axis = i;
+	}
+
+	float cmin = cbounds.min[axis];
+	float cmax = cbounds.max[axis];
+
+	uint32_t mid;
+	if (cmax > cmin) {
+		int split = find_split(b, first, ct, axis, cmin, cmax,
+				       bounds_area(&bounds));
+		if (split == 0) return;
+
+		// Partition so everything left of the split comes first
+		float scale = BIN_CT / (cmax - cmin);
+		uint32_t lo = first;
+		uint32_t hi = first + ct;
+		while (lo < hi) {
+			struct BuildPrim prim = b->prims[lo];
+			int bin = (prim.centroid[axis] - cmin) * scale;
+			if (bin >= BIN_CT) bin = BIN_CT - 1;
+
+			if (bin < split) {
+				lo++;
+			} else {
+				hi--;
+				b->prims[lo] = b->prims[hi];
+				b->prims[hi] = prim;
+			}
+		}
+		mid = lo;
+	} else {
+		// All centroids in the same place, no split is better than another
+		if (ct <= BVH_MAX_LEAF_SIZE) return;
+		mid = first + ct / 2;
+	}
+
+	assert(mid > first && mid < first + ct);
+
+	uint32_t left = bvh->node_ct++;
+	assert(left == node_idx + 1);
+	build_node(b, left, first, mid - first, depth + 1);
+
+	uint32_t right = bvh->node_ct++;
+	node->right = right;
+	build_node(b, right, mid, first + ct - mid, depth + 1);
+}
+
+void bvh_build(struct AabbArray *aabbs, struct Bvh *bvh)
+{
+	uint32_t ct = aabbs->ct;
+
+	// A binary tree with ct leaves has at most 2 * ct - 1 nodes
+	bvh->nodes = malloc(sizeof(bvh->nodes[0]) * (2 * ct + 1));
+	bvh->node_ct = 1;
+
+	struct Builder b;
+	b.bvh = bvh;
+	b.prims = malloc(sizeof(b.prims[0]) * (ct + 1));
+	for (uint32_t i = 0; i < ct; i++) {
+		struct BuildPrim *prim = &b.prims[i];
+		prim->bounds = EMPTY_BOUNDS;
+		bounds_grow_object(&prim->bounds, aabbs, i);
+
+		for (int j = 0; j < 3; j++) {
+			prim->centroid[j] = (prim->bounds.min[j]
+					     + prim->bounds.max[j]) * 0.5f;
+		}
+		prim->obj = i;
+	}
+
+	build_node(&b, 0, 0, ct, 0);
+
+	bvh->object_ct = ct;
+	bvh->objects = malloc(sizeof(bvh->objects[0]) * (ct + 1));
+	for (uint32_t i = 0; i < ct; i++) bvh->objects[i] = b.prims[i].obj;
+
+	free(b.prims);
+
+	bvh->nodes = realloc(bvh->nodes, sizeof(bvh->nodes[0]) * bvh->node_ct);
+}
+
+void bvh_refit(struct Bvh *bvh, struct AabbArray *aabbs)
+{
+	assert(aabbs->ct == bvh->object_ct);
+
+	// Children always come after their parents, so going backwards visits
+	// both children before the parent
+	for (uint32_t i = bvh->node_ct; i-- > 0;) {
+		struct BvhNode *node = &bvh->nodes[i];
+		struct Bounds bounds = EMPTY_BOUNDS;
+
+		if (node->right == 0) {
+			for (uint32_t j = node->first; j < node->first + node->ct; j++) {
+				bounds_grow_object(&bounds, aabbs, bvh->objects[j]);
+			}
+		} else {
+			struct BvhNode *l = &bvh->nodes[i + 1];
+			struct BvhNode *r = &bvh->nodes[node->right];
+			bounds_grow(&bounds, l->min, l->max);
+			bounds_grow(&bounds, r->min, r->max);
+		}
+
+		set_node_bounds(node, &bounds);
+	}
+}
+
+void bvh_destroy(struct Bvh bvh)
+{
+	free(bvh.nodes);
+	free(bvh.objects);
+}
+
+// Results of testing a box against the frustum
+#define FRUSTUM_OUTSIDE 0
+#define FRUSTUM_PARTIAL 1
+#define FRUSTUM_INSIDE 2
+
+static int frustum_test(vec4 planes[6], float min[3], float max[3])
+{
+	int result = FRUSTUM_INSIDE;
+
+	for (int p = 0; p < 6; p++) {
+		// Corners furthest along and against the plane normal
+		float far = planes[p][3];
+		float near = planes[p][3];
+		for (int i = 0; i < 3; i++) {
+			if (planes[p][i] >= 0.0f) {
+				far += max[i] * planes[p][i];
+				near += min[i] * planes[p][i];
+			} else {
+				far += min[i] * planes[p][i];
+				near += max[i] * planes[p][i];
+			}
+		}
+
+		if (far < 0.0f) return FRUSTUM_OUTSIDE;
+		if (near < 0.0f) result = FRUSTUM_PARTIAL;
+	}
+
+	return result;
+}
+
+size_t bvh_query_frustum(struct Bvh *bvh, struct AabbArray *aabbs,
+			 vec4 planes[6], uint32_t *dest)
+{
+	if (bvh->object_ct == 0) return 0;
+
+	uint32_t stack[BVH_MAX_DEPTH + 1];
+	int stack_ct = 0;
+	stack[stack_ct++] = 0;
+
+	size_t out = 0;
+	while (stack_ct > 0) {
+		struct BvhNode *node = &bvh->nodes[stack[--stack_ct]];
+
+		int result = frustum_test(planes, node->min, node->max);
+		if (result == FRUSTUM_OUTSIDE) continue;
+
+		// Everything under the node is visible, no need to go further
+		if (result == FRUSTUM_INSIDE) {
+			for (uint32_t i = node->first; i < node->first + node->ct; i++) {
+				dest[out++] = bvh->objects[i];
+			}
+			continue;
+		}
+
+		if (node->right == 0) {
+			for (uint32_t i = node->first; i < node->first + node->ct; i++) {
+				uint32_t obj = bvh->objects[i];
+				float min[3] = {aabbs->min_x[obj], aabbs->min_y[obj],
+						aabbs->min_z[obj]};
+				float max[3] = {aabbs->max_x[obj], aabbs->max_y[obj],
+						aabbs->max_z[obj]};
+
+				if (frustum_test(planes, min, max) != FRUSTUM_OUTSIDE) {
+					dest[out++] = obj;
+				}
+			}
+			continue;
+		}
+
+		stack[stack_ct++] = node->right;
+		stack[stack_ct++] = node - bvh->nodes + 1;
+	}
+
+	return out;
+}
+
+/*
+ * Slab test. Returns the distance along the ray at which it enters the box,
+ * or INFINITY if it misses or the box is further than <max_t>.
+ */
+static float ray_box(float origin[3], float inv_dir[3],
+		     float min[3], float max[3], float max_t)
+{
+	float t_near = 0.0f;
+	float t_far = max_t;
+
+	for (int i = 0; i < 3; i++) {
+		float t1 = (min[i] - origin[i]) * inv_dir[i];
+		float t2 = (max[i] - origin[i]) * inv_dir[i];
+		if (t1 > t2) {
+			float tmp = t1;
+			t1 = t2;
+			t2 = tmp;
+		}
+
+		// Written so NaNs (from 0 * inf) leave the bounds alone
+		t_near = t1 > t_near ? t1 : t_near;
+		t_far = t2 < t_far ? t2 : t_far;
+	}
+
+	return t_near <= t_far ? t_near : INFINITY;
+}
+
+uint32_t bvh_raycast(struct Bvh *bvh, struct AabbArray *aabbs,
+		     vec3 origin, vec3 dir, float *t)
+{
+	if (bvh->object_ct == 0) return BVH_NO_HIT;
+
+	float inv_dir[3];
+	for (int i = 0; i < 3; i++) inv_dir[i] = 1.0f / dir[i];
+
+	uint32_t best = BVH_NO_HIT;
+	float best_t = INFINITY;
+
+	uint32_t stack[BVH_MAX_DEPTH + 1];
+	int stack_ct = 0;
+	if (ray_box(origin, inv_dir, bvh->nodes[0].min, bvh->nodes[0].max,
+		    INFINITY) != INFINITY) {
+		stack[stack_ct++] = 0;
+	}
+
+	while (stack_ct > 0) {
+		uint32_t idx = stack[--stack_ct];
+		struct BvhNode *node = &bvh->nodes[idx];
+
+		if (node->right == 0) {
+			for (uint32_t i = node->first; i < node->first + node->ct; i++) {
+				uint32_t obj = bvh->objects[i];
+				float min[3] = {aabbs->min_x[obj], aabbs->min_y[obj],
+						aabbs->min_z[obj]};
+				float max[3] = {aabbs->max_x[obj], aabbs->max_y[obj],
+						aabbs->max_z[obj]};
+
+				float hit = ray_box(origin, inv_dir, min, max, best_t);
+				if (hit < best_t) {
+					best_t = hit;
+					best = obj;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first, so further ones can be skipped once
+		// something closer has been hit
+		uint32_t l = idx + 1;
+		uint32_t r = node->right;
+		float l_t = ray_box(origin, inv_dir, bvh->nodes[l].min,
+				    bvh->nodes[l].max, best_t);
+		float r_t = ray_box(origin, inv_dir, bvh->nodes[r].min,
+				    bvh->nodes[r].max, best_t);
+
+		if (l_t > r_t) {
+			uint32_t tmp_idx = l;
+			l = r;
+			r = tmp_idx;
+
+			float tmp_t = l_t;
+			l_t = r_t;
+			r_t = tmp_t;
+		}
+
+		if (r_t != INFINITY) stack[stack_ct++] = r;
+		if (l_t != INFINITY) stack[stack_ct++] = l;
+	}
+
+	if (t != NULL) *t = best_t;
+
+	return best;
+}
+
+uint32_t bvh_pick_fly(struct Bvh *bvh, struct AabbArray *aabbs,
+		      struct FlyCamera *cam, float *t)
+{
+	vec3 dir;
+	cam_get_dir_vec(cam->yaw, cam->pitch, dir);
+
+	return bvh_raycast(bvh, aabbs, cam->pos, dir, t);
+}
@@ -0,0 +1,93 @@
+#ifndef BVH_H_
+#define BVH_H_
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include <cglm/cglm.h>
+
+#include "camera.h"
+#include "cull.h"
+
+// Nodes with this many objects or fewer are never split
+#define BVH_MIN_LEAF_SIZE 2
+// Nodes with more objects than this are always split
+#define BVH_MAX_LEAF_SIZE 16
+// Nodes this deep become leaves regardless of size, so traversal can use a
+// fixed-size stack
+#define BVH_MAX_DEPTH 64
+
+// Returned by the ray queries when nothing was hit
+#define BVH_NO_HIT UINT32_MAX
+
+/*
+ * Nodes are stored in depth-first order, so a node's left child always comes
+ * right after it, and children always come after their parents.
+ */
+struct BvhNode {
+	float min[3];
+	float max[3];
+
+	// Objects under this node are Bvh.objects[first..first + ct]
+	uint32_t first;
+	uint32_t ct;
+
+	// Index of the right child, or 0 if this is a leaf
+	uint32_t right;
+};
+
+struct Bvh {
+	uint32_t node_ct;
+	struct BvhNode *nodes;
+
+	// Object indices (into the AabbArray the BVH was built from), in the
+	// order the leaves reference them
+	uint32_t object_ct;
+	uint32_t *objects;
+};
+
+/*
+ * Builds a BVH over the boxes in <aabbs> using the surface area heuristic,
+ * with split candidates binned along the widest axis of the centroids. Mallocs.
+ */
+void bvh_build(struct AabbArray *aabbs, struct Bvh *bvh);
+
+/*
+ * Updates the node bounds after boxes in <aabbs> have moved, without changing
+ * the tree structure. Much cheaper than a rebuild, but query performance
+ * degrades if objects move far from where they were at build time.
+ *
+ * aabbs: Must contain the same objects the BVH was built from
+ */
+void bvh_refit(struct Bvh *bvh, struct AabbArray *aabbs);
+
+void bvh_destroy(struct Bvh bvh);
+
+/*
+ * Writes the indices of all boxes that are at least partially inside the
+ * frustum to <dest> and returns how many were written. Unlike cull_aabbs, the
+ * indices aren't sorted.
+ *
+ * planes: As output by cam_frustum_planes
+ * dest: Must have room for aabbs->ct indices
+ */
+size_t bvh_query_frustum(struct Bvh *bvh, struct AabbArray *aabbs,
+			 vec4 planes[6], uint32_t *dest);
+
+/*
+ * Returns the index of the first box hit by the ray, or BVH_NO_HIT.
+ *
+ * dir: Doesn't need to be normalized
+ * t: If not NULL, receives the distance to the hit along <dir>, in multiples
+ *    of its length. 0 if <origin> is inside the box.
+ */
+uint32_t bvh_raycast(struct Bvh *bvh, struct AabbArray *aabbs,
+		     vec3 origin, vec3 dir, float *t);
+
+/*
+ * Returns the index of the box the camera is looking at, or BVH_NO_HIT.
+ */
+uint32_t bvh_pick_fly(struct Bvh *bvh, struct AabbArray *aabbs,
+		      struct FlyCamera *cam, float *t);
+
+#endif // BVH_H_
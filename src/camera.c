@@ -50,6 +50,28 @@ void cam_get_dir_vec(float yaw, float pitch, vec3 dest)
 	dest[2] = sin(yaw) * cos(pitch);
 }
 
+void cam_frustum_planes(mat4 view_proj, vec4 dest[6])
+{
+	// Gribb-Hartmann, with cglm's matrices indexed as m[column][row]. The
+	// near plane assumes OpenGL's -1..1 depth range, which is a little
+	// conservative for Vulkan's 0..1.
+	for (int i = 0; i < 4; i++) {
+		dest[0][i] = view_proj[i][3] + view_proj[i][0];
+		dest[1][i] = view_proj[i][3] - view_proj[i][0];
+		dest[2][i] = view_proj[i][3] + view_proj[i][1];
+		dest[3][i] = view_proj[i][3] - view_proj[i][1];
+		dest[4][i] = view_proj[i][3] + view_proj[i][2];
+		dest[5][i] = view_proj[i][3] - view_proj[i][2];
+	}
+
+	for (int i = 0; i < 6; i++) {
+		float len = sqrtf(dest[i][0] * dest[i][0]
+				  + dest[i][1] * dest[i][1]
+				  + dest[i][2] * dest[i][2]);
+		for (int j = 0; j < 4; j++) dest[i][j] /= len;
+	}
+}
+
 void wrap(float min, float max, float *val)
 {
 	assert(max > min);
@@ -77,6 +99,14 @@ struct OrbitCamera cam_orbit_new(double x, double y)
 	return self;
 }
 
+void cam_orbit_pos(struct OrbitCamera *c, vec3 dest)
+{
+	cam_get_dir_vec(c->yaw, c->pitch, dest);
+	dest[0] *= c->distance;
+	dest[1] *= c->distance;
+	dest[2] *= c->distance;
+}
+
 void cam_orbit_mat(struct OrbitCamera *c,
 		   uint32_t swidth, uint32_t sheight,
 		   double x, double y,
@@ -91,15 +121,12 @@ void cam_orbit_mat(struct OrbitCamera *c,
 	clamp(-M_PI * 0.49f, M_PI * 0.49f, &c->pitch);
 
 	// View matrix
-	vec3 dir;
-	cam_get_dir_vec(c->yaw, c->pitch, dir);
-	dir[0] *= c->distance;
-	dir[1] *= c->distance;
-	dir[2] *= c->distance;
+	vec3 eye;
+	cam_orbit_pos(c, eye);
 
 	vec3 center = {0.0f, 0.0f, 0.0f};
 	mat4 view;
-	cam_looker(dir, center, view);
+	cam_looker(eye, center, view);
 
 	// Projection matrix
 	mat4 proj;
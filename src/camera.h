@@ -22,6 +22,15 @@ void cam_projector(uint32_t swidth, uint32_t sheight, mat4 dest);
  */
 void cam_get_dir_vec(float yaw, float pitch, vec3 dest);
 
+/*
+ * Extracts the 6 planes bounding the view frustum of a combined view and
+ * projection matrix, in the order left, right, bottom, top, near, far.
+ *
+ * Each plane is (a, b, c, d) with (a, b, c) a unit normal pointing into the
+ * frustum, so a point p is on the inside when dot(p, (a, b, c)) + d >= 0.
+ */
+void cam_frustum_planes(mat4 view_proj, vec4 dest[6]);
+
 struct MouseTracker {
 	double prev_x;
 	double prev_y;
@@ -49,6 +58,12 @@ struct OrbitCamera {
  */
 struct OrbitCamera cam_orbit_new(double x, double y);
 
+/*
+ * Outputs the position of an OrbitCamera's eye into dest. The camera always
+ * looks at the origin.
+ */
+void cam_orbit_pos(struct OrbitCamera *c, vec3 dest);
+
 /*
  * Outputs a combined view and projection matrix into dest, given screen
  * dimensions and the current mouse coordinates.
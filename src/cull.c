@@ -0,0 +1,340 @@
+#include "cull.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+// SSE is part of x86-64, AVX is checked for when culling. Nothing is built
+// with -march, so the same binary runs on any x86-64 CPU and uses AVX where
+// there is one.
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+#define CULL_SIMD
+#define CULL_AVX __attribute__((target("avx")))
+#endif
+
+// Arrays are padded to this many elements (and aligned to as many floats), so
+// the widest loads never need to worry about alignment
+#define CULL_PAD 8
+
+static float *alloc_floats(size_t ct)
+{
+	size_t padded = (ct + CULL_PAD - 1) / CULL_PAD * CULL_PAD;
+	if (padded == 0) padded = CULL_PAD;
+
+	float *mem = aligned_alloc(sizeof(float) * CULL_PAD,
+				   sizeof(float) * padded);
+	assert(mem != NULL);
+
+	return mem;
+}
+
+void cull_aabbs_create(size_t ct, struct AabbArray *aabbs)
+{
+	aabbs->ct = ct;
+	aabbs->min_x = alloc_floats(ct);
+	aabbs->min_y = alloc_floats(ct);
+	aabbs->min_z = alloc_floats(ct);
+	aabbs->max_x = alloc_floats(ct);
+	aabbs->max_y = alloc_floats(ct);
+	aabbs->max_z = alloc_floats(ct);
+}
+
+void cull_aabbs_set(struct AabbArray *aabbs, size_t idx, vec3 min, vec3 max)
+{
+	assert(idx < aabbs->ct);
+
+	aabbs->min_x[idx] = min[0];
+	aabbs->min_y[idx] = min[1];
+	aabbs->min_z[idx] = min[2];
+	aabbs->max_x[idx] = max[0];
+	aabbs->max_y[idx] = max[1];
+	aabbs->max_z[idx] = max[2];
+}
+
+void cull_aabbs_destroy(struct AabbArray aabbs)
+{
+	free(aabbs.min_x);
+	free(aabbs.min_y);
+	free(aabbs.min_z);
+	free(aabbs.max_x);
+	free(aabbs.max_y);
+	free(aabbs.max_z);
+}
+
+void cull_spheres_create(size_t ct, struct SphereArray *spheres)
+{
+	spheres->ct = ct;
+	spheres->x = alloc_floats(ct);
+	spheres->y = alloc_floats(ct);
+	spheres->z = alloc_floats(ct);
+	spheres->radius = alloc_floats(ct);
+}
+
+void cull_spheres_set(struct SphereArray *spheres, size_t idx,
+		      vec3 center, float radius)
+{
+	assert(idx < spheres->ct);
+
+	spheres->x[idx] = center[0];
+	spheres->y[idx] = center[1];
+	spheres->z[idx] = center[2];
+	spheres->radius[idx] = radius;
+}
+
+void cull_spheres_destroy(struct SphereArray spheres)
+{
+	free(spheres.x);
+	free(spheres.y);
+	free(spheres.z);
+	free(spheres.radius);
+}
+
+#ifdef CULL_SIMD
+/*
+ * Appends first + the position of every set bit in <mask> to <dest>.
+ */
+static size_t emit_mask(int mask, uint32_t first, uint32_t *dest, size_t out)
+{
+	while (mask) {
+		dest[out++] = first + __builtin_ctz(mask);
+		mask &= mask - 1;
+	}
+
+	return out;
+}
+
+static int has_avx(void)
+{
+	return __builtin_cpu_supports("avx");
+}
+
+/*
+ * The vector loops test whole vectors of objects and return how many they got
+ * through, so the scalar loop can finish the rest. The plane coefficients are
+ * broadcast once up front.
+ */
+static size_t aabbs_sse(float *px[6], float *py[6], float *pz[6],
+			vec4 planes[6], size_t ct,
+			uint32_t *dest, size_t *out)
+{
+	__m128 a[6], b[6], c[6], d[6];
+	for (int p = 0; p < 6; p++) {
+		a[p] = _mm_set1_ps(planes[p][0]);
+		b[p] = _mm_set1_ps(planes[p][1]);
+		c[p] = _mm_set1_ps(planes[p][2]);
+		d[p] = _mm_set1_ps(planes[p][3]);
+	}
+	__m128 zero = _mm_set1_ps(0.0f);
+
+	size_t i = 0;
+	for (; i + 4 <= ct; i += 4) {
+		int mask = 0xf;
+		for (int p = 0; p < 6 && mask; p++) {
+			__m128 x = _mm_mul_ps(_mm_load_ps(&px[p][i]), a[p]);
+			__m128 y = _mm_mul_ps(_mm_load_ps(&py[p][i]), b[p]);
+			__m128 z = _mm_mul_ps(_mm_load_ps(&pz[p][i]), c[p]);
+			__m128 dist = _mm_add_ps(_mm_add_ps(x, y),
+						 _mm_add_ps(z, d[p]));
+
+			mask &= _mm_movemask_ps(_mm_cmpge_ps(dist, zero));
+		}
+
+		*out = emit_mask(mask, i, dest, *out);
+	}
+
+	return i;
+}
+
+CULL_AVX
+static size_t aabbs_avx(float *px[6], float *py[6], float *pz[6],
+			vec4 planes[6], size_t ct,
+			uint32_t *dest, size_t *out)
+{
+	__m256 a[6], b[6], c[6], d[6];
+	for (int p = 0; p < 6; p++) {
+		a[p] = _mm256_set1_ps(planes[p][0]);
+		b[p] = _mm256_set1_ps(planes[p][1]);
+		c[p] = _mm256_set1_ps(planes[p][2]);
+		d[p] = _mm256_set1_ps(planes[p][3]);
+	}
+	__m256 zero = _mm256_set1_ps(0.0f);
+
+	size_t i = 0;
+	for (; i + 8 <= ct; i += 8) {
+		int mask = 0xff;
+		for (int p = 0; p < 6 && mask; p++) {
+			__m256 x = _mm256_mul_ps(_mm256_load_ps(&px[p][i]),
+						 a[p]);
+			__m256 y = _mm256_mul_ps(_mm256_load_ps(&py[p][i]),
+						 b[p]);
+			__m256 z = _mm256_mul_ps(_mm256_load_ps(&pz[p][i]),
+						 c[p]);
+			__m256 dist = _mm256_add_ps(_mm256_add_ps(x, y),
+						    _mm256_add_ps(z, d[p]));
+
+			__m256 ge = _mm256_cmp_ps(dist, zero, _CMP_GE_OQ);
+			mask &= _mm256_movemask_ps(ge);
+		}
+
+		*out = emit_mask(mask, i, dest, *out);
+	}
+
+	return i;
+}
+
+static size_t spheres_sse(struct SphereArray *spheres, vec4 planes[6],
+			  uint32_t *dest, size_t *out)
+{
+	__m128 a[6], b[6], c[6], d[6];
+	for (int p = 0; p < 6; p++) {
+		a[p] = _mm_set1_ps(planes[p][0]);
+		b[p] = _mm_set1_ps(planes[p][1]);
+		c[p] = _mm_set1_ps(planes[p][2]);
+		d[p] = _mm_set1_ps(planes[p][3]);
+	}
+
+	size_t i = 0;
+	for (; i + 4 <= spheres->ct; i += 4) {
+		__m128 x = _mm_load_ps(&spheres->x[i]);
+		__m128 y = _mm_load_ps(&spheres->y[i]);
+		__m128 z = _mm_load_ps(&spheres->z[i]);
+		__m128 neg_radius = _mm_mul_ps(_mm_load_ps(&spheres->radius[i]),
+					       _mm_set1_ps(-1.0f));
+
+		int mask = 0xf;
+		for (int p = 0; p < 6 && mask; p++) {
+			__m128 dist = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, a[p]),
+					   _mm_mul_ps(y, b[p])),
+				_mm_add_ps(_mm_mul_ps(z, c[p]), d[p]));
+
+			mask &= _mm_movemask_ps(_mm_cmpge_ps(dist, neg_radius));
+		}
+
+		*out = emit_mask(mask, i, dest, *out);
+	}
+
+	return i;
+}
+
+CULL_AVX
+static size_t spheres_avx(struct SphereArray *spheres, vec4 planes[6],
+			  uint32_t *dest, size_t *out)
+{
+	__m256 a[6], b[6], c[6], d[6];
+	for (int p = 0; p < 6; p++) {
+		a[p] = _mm256_set1_ps(planes[p][0]);
+		b[p] = _mm256_set1_ps(planes[p][1]);
+		c[p] = _mm256_set1_ps(planes[p][2]);
+		d[p] = _mm256_set1_ps(planes[p][3]);
+	}
+
+	size_t i = 0;
+	for (; i + 8 <= spheres->ct; i += 8) {
+		__m256 x = _mm256_load_ps(&spheres->x[i]);
+		__m256 y = _mm256_load_ps(&spheres->y[i]);
+		__m256 z = _mm256_load_ps(&spheres->z[i]);
+		__m256 neg_radius = _mm256_mul_ps(
+			_mm256_load_ps(&spheres->radius[i]),
+			_mm256_set1_ps(-1.0f));
+
+		int mask = 0xff;
+		for (int p = 0; p < 6 && mask; p++) {
+			__m256 dist = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(x, a[p]),
+					      _mm256_mul_ps(y, b[p])),
+				_mm256_add_ps(_mm256_mul_ps(z, c[p]), d[p]));
+
+			__m256 ge = _mm256_cmp_ps(dist, neg_radius, _CMP_GE_OQ);
+			mask &= _mm256_movemask_ps(ge);
+		}
+
+		*out = emit_mask(mask, i, dest, *out);
+	}
+
+	return i;
+}
+#endif
+
+size_t cull_aabbs(struct AabbArray *aabbs, vec4 planes[6], uint32_t *dest)
+{
+	// Only the corner furthest along each plane's normal needs testing. Which
+	// corner that is only depends on the plane, so pick the arrays up front.
+	float *px[6], *py[6], *pz[6];
+	for (int p = 0; p < 6; p++) {
+		px[p] = planes[p][0] >= 0.0f ? aabbs->max_x : aabbs->min_x;
+		py[p] = planes[p][1] >= 0.0f ? aabbs->max_y : aabbs->min_y;
+		pz[p] = planes[p][2] >= 0.0f ? aabbs->max_z : aabbs->min_z;
+	}
+
+	size_t out = 0;
+	size_t i = 0;
+
+#ifdef CULL_SIMD
+	if (has_avx()) {
+		i = aabbs_avx(px, py, pz, planes, aabbs->ct, dest, &out);
+	} else {
+		i = aabbs_sse(px, py, pz, planes, aabbs->ct, dest, &out);
+	}
+#endif
+
+	// Whatever doesn't fill a whole vector. The sums are grouped the same
+	// way as above. Nothing here is built for FMA, so neither loop can
+	// have its multiply-adds fused, and the results don't depend on where
+	// a box ends up. (Building with -mfma or -march=native could break
+	// that, since GCC fuses with -ffp-contract=fast by default.)
+	for (; i < aabbs->ct; i++) {
+		int inside = 1;
+		for (int p = 0; p < 6 && inside; p++) {
+			float dist = (px[p][i] * planes[p][0]
+				      + py[p][i] * planes[p][1])
+				+ (pz[p][i] * planes[p][2] + planes[p][3]);
+
+			inside = dist >= 0.0f;
+		}
+
+		if (inside) dest[out++] = i;
+	}
+
+	return out;
+}
+
+size_t cull_spheres(struct SphereArray *spheres, vec4 planes[6],
+		    uint32_t *dest)
+{
+	size_t out = 0;
+	size_t i = 0;
+
+#ifdef CULL_SIMD
+	if (has_avx()) {
+		i = spheres_avx(spheres, planes, dest, &out);
+	} else {
+		i = spheres_sse(spheres, planes, dest, &out);
+	}
+#endif
+
+	for (; i < spheres->ct; i++) {
+		int inside = 1;
+		for (int p = 0; p < 6 && inside; p++) {
+			float dist = (spheres->x[i] * planes[p][0]
+				      + spheres->y[i] * planes[p][1])
+				+ (spheres->z[i] * planes[p][2] + planes[p][3]);
+
+			inside = dist >= -spheres->radius[i];
+		}
+
+		if (inside) dest[out++] = i;
+	}
+
+	return out;
+}
+
+int cull_width(void)
+{
+#ifdef CULL_SIMD
+	return has_avx() ? 8 : 4;
+#else
+	return 1;
+#endif
+}
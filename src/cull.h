@@ -0,0 +1,71 @@
+#ifndef CULL_H_
+#define CULL_H_
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include <cglm/cglm.h>
+
+/*
+ * Axis-aligned bounding boxes in structure-of-arrays layout, so several boxes
+ * can be tested against a plane at once.
+ *
+ * The arrays are aligned and padded to a multiple of 8 elements.
+ */
+struct AabbArray {
+	size_t ct;
+	float *min_x, *min_y, *min_z;
+	float *max_x, *max_y, *max_z;
+};
+
+/*
+ * Bounding spheres in structure-of-arrays layout.
+ */
+struct SphereArray {
+	size_t ct;
+	float *x, *y, *z;
+	float *radius;
+};
+
+/*
+ * Allocates room for <ct> boxes. The contents are left uninitialized, fill
+ * them in with cull_aabbs_set or by writing to the arrays directly.
+ */
+void cull_aabbs_create(size_t ct, struct AabbArray *aabbs);
+
+void cull_aabbs_set(struct AabbArray *aabbs, size_t idx, vec3 min, vec3 max);
+
+void cull_aabbs_destroy(struct AabbArray aabbs);
+
+/*
+ * Allocates room for <ct> spheres, see cull_aabbs_create.
+ */
+void cull_spheres_create(size_t ct, struct SphereArray *spheres);
+
+void cull_spheres_set(struct SphereArray *spheres, size_t idx,
+		      vec3 center, float radius);
+
+void cull_spheres_destroy(struct SphereArray spheres);
+
+/*
+ * Writes the indices of all boxes that are at least partially inside the
+ * frustum to <dest> in increasing order, and returns how many were written.
+ *
+ * planes: As output by cam_frustum_planes
+ * dest: Must have room for aabbs->ct indices
+ */
+size_t cull_aabbs(struct AabbArray *aabbs, vec4 planes[6], uint32_t *dest);
+
+/*
+ * Same as cull_aabbs, but for spheres.
+ */
+size_t cull_spheres(struct SphereArray *spheres, vec4 planes[6],
+		    uint32_t *dest);
+
+/*
+ * Returns how many objects the culling functions test per iteration: 8 on
+ * x86-64 CPUs with AVX, 4 on other x86-64 CPUs (SSE) and 1 elsewhere.
+ */
+int cull_width(void);
+
+#endif // CULL_H_
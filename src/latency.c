@@ -0,0 +1,82 @@
+#include "latency.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+void latency_create(uint32_t cap, struct LatencyTracker *tracker)
+{
+	tracker->cap = cap;
+	tracker->input_times = malloc(sizeof(tracker->input_times[0]) * cap);
+	tracker->frames = malloc(sizeof(tracker->frames[0]) * cap);
+
+	// 0 is never a frame value, so marks an empty slot
+	for (uint32_t i = 0; i < cap; i++) {
+		tracker->frames[i] = 0;
+	}
+
+	tracker->sample_ct = 0;
+	tracker->total_secs = 0.0;
+	tracker->max_secs = 0.0;
+
+	tracker->acquire_ct = 0;
+	tracker->acquire_secs = 0.0;
+}
+
+void latency_destroy(struct LatencyTracker tracker)
+{
+	free(tracker.input_times);
+	free(tracker.frames);
+}
+
+void latency_input(struct LatencyTracker *tracker, uint64_t frame)
+{
+	uint32_t slot = frame % tracker->cap;
+
+	tracker->frames[slot] = frame;
+	tracker->input_times[slot] = latency_now();
+}
+
+void latency_complete(struct LatencyTracker *tracker, uint64_t completed)
+{
+	double now = latency_now();
+
+	for (uint32_t i = 0; i < tracker->cap; i++) {
+		uint64_t frame = tracker->frames[i];
+		if (frame == 0 || frame > completed) continue;
+
+		double secs = now - tracker->input_times[i];
+		tracker->sample_ct++;
+		tracker->total_secs += secs;
+		if (secs > tracker->max_secs) tracker->max_secs = secs;
+
+		tracker->frames[i] = 0;
+	}
+}
+
+void latency_acquire(struct LatencyTracker *tracker, double secs)
+{
+	tracker->acquire_ct++;
+	tracker->acquire_secs += secs;
+}
+
+double latency_avg(struct LatencyTracker *tracker)
+{
+	if (tracker->sample_ct == 0) return 0.0;
+
+	return tracker->total_secs / tracker->sample_ct;
+}
+
+double latency_acquire_avg(struct LatencyTracker *tracker)
+{
+	if (tracker->acquire_ct == 0) return 0.0;
+
+	return tracker->acquire_secs / tracker->acquire_ct;
+}
+
+double latency_now(void)
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return time.tv_sec + time.tv_nsec / 1000000000.0;
+}
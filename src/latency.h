@@ -0,0 +1,61 @@
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdint.h>
+
+/*
+ * Measures how long it takes from sampling input for a frame until that frame
+ * has finished rendering, which is the earliest it can reach the screen. Frames
+ * are identified by the timeline value they signal (see FrameScheduler).
+ *
+ * Whatever the present mode adds on top of that (a frame waiting in the FIFO
+ * queue) shows up indirectly, as later frames being held back before their
+ * input is sampled, so time spent blocked in acquire is tracked separately.
+ */
+struct LatencyTracker {
+	// Input times for frames that haven't completed yet, indexed by frame
+	// value modulo cap
+	uint32_t cap;
+	double *input_times;
+	uint64_t *frames;
+
+	uint64_t sample_ct;
+	double total_secs;
+	double max_secs;
+
+	uint64_t acquire_ct;
+	double acquire_secs;
+};
+
+/*
+ * cap: Most frames that can be in flight at once
+ */
+void latency_create(uint32_t cap, struct LatencyTracker *tracker);
+
+void latency_destroy(struct LatencyTracker tracker);
+
+/*
+ * Records that input for frame <frame> was sampled just now.
+ */
+void latency_input(struct LatencyTracker *tracker, uint64_t frame);
+
+/*
+ * Records a latency sample for every tracked frame up to and including
+ * <completed> (usually frame_sched_completed). Call as soon as possible after
+ * frames complete, since the time of this call is taken as their finish time.
+ */
+void latency_complete(struct LatencyTracker *tracker, uint64_t completed);
+
+/*
+ * Records time spent blocked acquiring a swapchain image.
+ */
+void latency_acquire(struct LatencyTracker *tracker, double secs);
+
+// Both return 0 if nothing has been recorded yet
+double latency_avg(struct LatencyTracker *tracker);
+double latency_acquire_avg(struct LatencyTracker *tracker);
+
+// Returns a monotonic timestamp in seconds
+double latency_now(void);
+
+#endif // LATENCY_H_
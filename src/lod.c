@@ -0,0 +1,439 @@
+#include "lod.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Symmetric 4x4 matrix, stored as its upper triangle:
+ * aa ab ac ad bb bc bd cc cd dd
+ */
+struct Quadric {
+	double m[10];
+};
+
+/* A candidate edge collapse, moving <src> onto <dst> */
+struct Collapse {
+	uint32_t src;
+	uint32_t dst;
+	double cost;
+};
+
+/* State shared between successive simplification passes */
+struct Simplifier {
+	struct ObjVertex *vertices;
+	size_t vertex_ct;
+
+	struct Quadric *quadrics;
+	// 1 if a vertex lies on an open boundary and must not be removed
+	unsigned char *locked;
+
+	// Current triangle list
+	uint32_t *indices;
+	size_t index_ct;
+
+	double max_cost;
+};
+
+static void quadric_add_plane(struct Quadric *q, double a, double b, double c,
+			      double d)
+{
+	q->m[0] += a * a;
+	q->m[1] += a * b;
+	q->m[2] += a * c;
+	q->m[3] += a * d;
+	q->m[4] += b * b;
+	q->m[5] += b * c;
+	q->m[6] += b * d;
+	q->m[7] += c * c;
+	q->m[8] += c * d;
+	q->m[9] += d * d;
+}
+
+static void quadric_add(struct Quadric *dest, struct Quadric *src)
+{
+	for (int i = 0; i < 10; i++) dest->m[i] += src->m[i];
+}
+
+static double quadric_eval(struct Quadric *q, float p[3])
+{
+	double x = p[0], y = p[1], z = p[2];
+	double *m = q->m;
+
+	double res = m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z
+		+ 2 * m[3] * x
+		+ m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y
+		+ m[7] * z * z + 2 * m[8] * z
+		+ m[9];
+
+	// Rounding can make this very slightly negative
+	return res > 0.0 ? res : 0.0;
+}
+
+static void tri_normal(float a[3], float b[3], float c[3], double out[3])
+{
+	double e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+	double e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+
+	out[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	out[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	out[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a;
+	uint64_t y = *(const uint64_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+static int cmp_collapse(const void *a, const void *b)
+{
+	double x = ((const struct Collapse *) a)->cost;
+	double y = ((const struct Collapse *) b)->cost;
+
+	return (x > y) - (x < y);
+}
+
+static void simplifier_init(struct Simplifier *s,
+			    struct ObjVertex *vertices, size_t vertex_ct,
+			    uint32_t *indices, size_t index_ct)
+{
+	assert(index_ct % 3 == 0);
+
+	s->vertices = vertices;
+	s->vertex_ct = vertex_ct;
+	s->quadrics = calloc(vertex_ct, sizeof(s->quadrics[0]));
+	s->locked = calloc(vertex_ct, sizeof(s->locked[0]));
+	s->indices = malloc(sizeof(s->indices[0]) * index_ct);
+	memcpy(s->indices, indices, sizeof(indices[0]) * index_ct);
+	s->index_ct = index_ct;
+	s->max_cost = 0.0;
+
+	// Every vertex gets the planes of all triangles around it
+	for (size_t i = 0; i < index_ct; i += 3) {
+		float *p0 = vertices[indices[i]].pos;
+		float *p1 = vertices[indices[i + 1]].pos;
+		float *p2 = vertices[indices[i + 2]].pos;
+
+		double n[3];
+		tri_normal(p0, p1, p2, n);
+		double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (len == 0.0) continue;
+
+		n[0] /= len;
+		n[1] /= len;
+		n[2] /= len;
+		double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+
+		for (int j = 0; j < 3; j++) {
+			quadric_add_plane(&s->quadrics[indices[i + j]],
+					  n[0], n[1], n[2], d);
+		}
+	}
+
+	// Lock boundary vertices, so open meshes keep their outline. An edge
+	// is on a boundary if only one triangle uses it.
+	size_t edge_ct = index_ct;
+	uint64_t *edges = malloc(sizeof(edges[0]) * edge_ct);
+	for (size_t i = 0; i < index_ct; i += 3) {
+		for (int j = 0; j < 3; j++) {
+			uint64_t a = indices[i + j];
+			uint64_t b = indices[i + (j + 1) % 3];
+			edges[i + j] = a < b ? (a << 32) | b : (b << 32) | a;
+		}
+	}
+	qsort(edges, edge_ct, sizeof(edges[0]), cmp_u64);
+
+	for (size_t i = 0; i < edge_ct; ) {
+		size_t j = i + 1;
+		while (j < edge_ct && edges[j] == edges[i]) j++;
+
+		if (j - i == 1) {
+			s->locked[edges[i] >> 32] = 1;
+			s->locked[edges[i] & 0xFFFFFFFF] = 1;
+		}
+
+		i = j;
+	}
+
+	free(edges);
+}
+
+static void simplifier_destroy(struct Simplifier *s)
+{
+	free(s->quadrics);
+	free(s->locked);
+	free(s->indices);
+}
+
+/*
+ * Returns 1 if moving <src> onto <dst> would flip any triangle around <src>.
+ *
+ * adj, adj_offsets: Triangles (as index offsets) around each vertex
+ */
+static int collapse_flips(struct Simplifier *s,
+			  uint32_t *adj, uint32_t *adj_offsets,
+			  uint32_t src, uint32_t dst)
+{
+	for (uint32_t i = adj_offsets[src]; i < adj_offsets[src + 1]; i++) {
+		uint32_t *tri = &s->indices[adj[i]];
+
+		// Triangles containing both vertices collapse away entirely
+		if (tri[0] == dst || tri[1] == dst || tri[2] == dst) continue;
+
+		float *before[3];
+		float *after[3];
+		for (int j = 0; j < 3; j++) {
+			before[j] = s->vertices[tri[j]].pos;
+			after[j] = tri[j] == src ? s->vertices[dst].pos
+				: before[j];
+		}
+
+		double n0[3], n1[3];
+		tri_normal(before[0], before[1], before[2], n0);
+		tri_normal(after[0], after[1], after[2], n1);
+
+		if (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0)
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Runs one pass of non-overlapping collapses, cheapest first, aiming for
+ * <target_index_ct>. Returns the number of collapses performed.
+ */
+static size_t simplifier_pass(struct Simplifier *s, size_t target_index_ct)
+{
+	size_t vertex_ct = s->vertex_ct;
+	size_t index_ct = s->index_ct;
+	uint32_t *indices = s->indices;
+
+	// Triangles around each vertex
+	uint32_t *adj_offsets = calloc(vertex_ct + 1, sizeof(adj_offsets[0]));
+	for (size_t i = 0; i < index_ct; i++) adj_offsets[indices[i] + 1]++;
+	for (size_t i = 0; i < vertex_ct; i++)
+		adj_offsets[i + 1] += adj_offsets[i];
+
+	uint32_t *adj = malloc(sizeof(adj[0]) * index_ct);
+	uint32_t *fill = malloc(sizeof(fill[0]) * vertex_ct);
+	memcpy(fill, adj_offsets, sizeof(fill[0]) * vertex_ct);
+	for (size_t i = 0; i < index_ct; i++) {
+		adj[fill[indices[i]]++] = i - i % 3;
+	}
+	free(fill);
+
+	// Unique edges
+	uint64_t *edges = malloc(sizeof(edges[0]) * index_ct);
+	for (size_t i = 0; i < index_ct; i += 3) {
+		for (int j = 0; j < 3; j++) {
+			uint64_t a = indices[i + j];
+			uint64_t b = indices[i + (j + 1) % 3];
+			edges[i + j] = a < b ? (a << 32) | b : (b << 32) | a;
+		}
+	}
+	qsort(edges, index_ct, sizeof(edges[0]), cmp_u64);
+
+	// Cheapest direction for every edge
+	struct Collapse *collapses = malloc(sizeof(collapses[0]) * index_ct);
+	size_t collapse_ct = 0;
+	for (size_t i = 0; i < index_ct; i++) {
+		if (i > 0 && edges[i] == edges[i - 1]) continue;
+
+		uint32_t a = edges[i] >> 32;
+		uint32_t b = edges[i] & 0xFFFFFFFF;
+		if (s->locked[a] && s->locked[b]) continue;
+
+		struct Quadric q = s->quadrics[a];
+		quadric_add(&q, &s->quadrics[b]);
+
+		double cost_ab = s->locked[a] ? INFINITY
+			: quadric_eval(&q, s->vertices[b].pos);
+		double cost_ba = s->locked[b] ? INFINITY
+			: quadric_eval(&q, s->vertices[a].pos);
+
+		struct Collapse c;
+		if (cost_ab <= cost_ba) {
+			c = (struct Collapse) {.src = a, .dst = b, .cost = cost_ab};
+		} else {
+			c = (struct Collapse) {.src = b, .dst = a, .cost = cost_ba};
+		}
+
+		collapses[collapse_ct++] = c;
+	}
+	free(edges);
+
+	qsort(collapses, collapse_ct, sizeof(collapses[0]), cmp_collapse);
+
+	// Each collapse removes about two triangles
+	size_t wanted = (index_ct - target_index_ct) / 6;
+	if (wanted == 0) wanted = 1;
+
+	// Vertices whose surroundings already changed this pass
+	unsigned char *touched = calloc(vertex_ct, sizeof(touched[0]));
+	uint32_t *remap = malloc(sizeof(remap[0]) * vertex_ct);
+	for (size_t i = 0; i < vertex_ct; i++) remap[i] = i;
+
+	size_t done = 0;
+	for (size_t i = 0; i < collapse_ct && done < wanted; i++) {
+		uint32_t src = collapses[i].src;
+		uint32_t dst = collapses[i].dst;
+
+		if (touched[src] || touched[dst]) continue;
+		if (collapse_flips(s, adj, adj_offsets, src, dst)) continue;
+
+		remap[src] = dst;
+		quadric_add(&s->quadrics[dst], &s->quadrics[src]);
+		if (collapses[i].cost > s->max_cost)
+			s->max_cost = collapses[i].cost;
+
+		for (uint32_t j = adj_offsets[src]; j < adj_offsets[src + 1]; j++) {
+			uint32_t *tri = &indices[adj[j]];
+			touched[tri[0]] = 1;
+			touched[tri[1]] = 1;
+			touched[tri[2]] = 1;
+		}
+
+		done++;
+	}
+
+	// Apply, dropping triangles that became degenerate
+	size_t out = 0;
+	for (size_t i = 0; i < index_ct; i += 3) {
+		uint32_t a = remap[indices[i]];
+		uint32_t b = remap[indices[i + 1]];
+		uint32_t c = remap[indices[i + 2]];
+
+		if (a == b || b == c || c == a) continue;
+
+		indices[out++] = a;
+		indices[out++] = b;
+		indices[out++] = c;
+	}
+	s->index_ct = out;
+
+	free(touched);
+	free(remap);
+	free(collapses);
+	free(adj);
+	free(adj_offsets);
+
+	return done;
+}
+
+static void simplifier_run(struct Simplifier *s, size_t target_index_ct)
+{
+	while (s->index_ct > target_index_ct) {
+		if (simplifier_pass(s, target_index_ct) == 0) break;
+	}
+}
+
+size_t lod_simplify(struct ObjVertex *vertices, size_t vertex_ct,
+		    uint32_t *indices, size_t index_ct,
+		    size_t target_index_ct,
+		    uint32_t *dest, float *error)
+{
+	struct Simplifier s;
+	simplifier_init(&s, vertices, vertex_ct, indices, index_ct);
+	simplifier_run(&s, target_index_ct);
+
+	memcpy(dest, s.indices, sizeof(dest[0]) * s.index_ct);
+	if (error != NULL) *error = sqrt(s.max_cost);
+
+	size_t out_ct = s.index_ct;
+	simplifier_destroy(&s);
+
+	return out_ct;
+}
+
+void lod_chain_create(struct ObjVertex *vertices, size_t vertex_ct,
+		      uint32_t *indices, size_t index_ct,
+		      uint32_t max_lod_ct, float ratio,
+		      struct LodChain *chain)
+{
+	assert(max_lod_ct > 0);
+	assert(ratio > 0.0f && ratio < 1.0f);
+
+	chain->offsets = malloc(sizeof(chain->offsets[0]) * max_lod_ct);
+	chain->counts = malloc(sizeof(chain->counts[0]) * max_lod_ct);
+	chain->errors = malloc(sizeof(chain->errors[0]) * max_lod_ct);
+
+	// Every LOD is smaller than the original, so this is an upper bound
+	chain->indices = malloc(sizeof(chain->indices[0]) * index_ct * max_lod_ct);
+
+	// LOD 0 is the original mesh
+	memcpy(chain->indices, indices, sizeof(indices[0]) * index_ct);
+	chain->offsets[0] = 0;
+	chain->counts[0] = index_ct;
+	chain->errors[0] = 0.0f;
+	chain->lod_ct = 1;
+	chain->index_ct = index_ct;
+
+	// Each LOD continues simplifying where the previous one stopped
+	struct Simplifier s;
+	simplifier_init(&s, vertices, vertex_ct, indices, index_ct);
+
+	while (chain->lod_ct < max_lod_ct) {
+		size_t prev_ct = s.index_ct;
+		size_t target = (size_t) (prev_ct * ratio) / 3 * 3;
+
+		simplifier_run(&s, target);
+
+		// Not worth another LOD if barely anything changed
+		if (s.index_ct == 0 || s.index_ct > prev_ct * 0.95) break;
+
+		uint32_t lod = chain->lod_ct++;
+		chain->offsets[lod] = chain->index_ct;
+		chain->counts[lod] = s.index_ct;
+		chain->errors[lod] = sqrt(s.max_cost);
+
+		memcpy(&chain->indices[chain->index_ct], s.indices,
+		       sizeof(s.indices[0]) * s.index_ct);
+		chain->index_ct += s.index_ct;
+	}
+
+	simplifier_destroy(&s);
+
+	chain->indices = realloc(chain->indices,
+				 sizeof(chain->indices[0]) * chain->index_ct);
+}
+
+void lod_chain_destroy(struct LodChain chain)
+{
+	free(chain.offsets);
+	free(chain.counts);
+	free(chain.errors);
+	free(chain.indices);
+}
+
+uint32_t lod_select(struct LodChain *chain, float distance, float max_error)
+{
+	float allowed = distance * max_error;
+
+	// Errors only grow with each LOD
+	uint32_t lod = 0;
+	while (lod + 1 < chain->lod_ct && chain->errors[lod + 1] <= allowed) {
+		lod++;
+	}
+
+	return lod;
+}
+
+uint32_t lod_select_orbit(struct LodChain *chain, struct OrbitCamera *c,
+			  vec3 center, float max_error)
+{
+	vec3 eye;
+	cam_orbit_pos(c, eye);
+
+	return lod_select(chain, glm_vec3_distance(eye, center), max_error);
+}
+
+uint32_t lod_select_fly(struct LodChain *chain, struct FlyCamera *c,
+			vec3 center, float max_error)
+{
+	return lod_select(chain, glm_vec3_distance(c->pos, center), max_error);
+}
@@ -0,0 +1,90 @@
+#ifndef LOD_H_
+#define LOD_H_
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include "obj.h"
+#include "camera.h"
+
+/*
+ * Allowed world-space error per unit of camera distance. Roughly two pixels at
+ * the default FOV and window size.
+ */
+#define LOD_DEFAULT_ERROR 0.002f
+
+/*
+ * A chain of levels of detail for one mesh.
+ *
+ * Every LOD indexes into the same (unmodified) vertex array, so only the
+ * indices differ. The indices of all LODs are stored back-to-back in
+ * <indices>, LOD 0 being the original mesh, so they can be uploaded as a single
+ * index buffer and drawn with a first index of offsets[lod].
+ */
+struct LodChain {
+	uint32_t lod_ct;
+	// Offset into <indices> and index count of each LOD
+	uint32_t *offsets;
+	uint32_t *counts;
+	// World-space error of each LOD (0 for LOD 0)
+	float *errors;
+
+	uint32_t index_ct;
+	uint32_t *indices;
+};
+
+/*
+ * Simplifies a mesh by collapsing edges in order of quadric error, until at
+ * most <target_index_ct> indices remain or no further collapses are possible.
+ *
+ * Vertices are never moved, each collapse merges one vertex into another
+ * existing one, so the output indexes into the original vertex array.
+ * Vertices on open boundaries are never removed.
+ *
+ * dest: Must have room for index_ct indices (can be the same as <indices>)
+ * error: If not NULL, will be set to the world-space error of the result
+ *
+ * Returns the number of indices written to dest.
+ */
+size_t lod_simplify(struct ObjVertex *vertices, size_t vertex_ct,
+		    uint32_t *indices, size_t index_ct,
+		    size_t target_index_ct,
+		    uint32_t *dest, float *error);
+
+/*
+ * Generates a LodChain from the output of obj_load. Mallocs.
+ *
+ * Each LOD aims for <ratio> times the index count of the previous one. Stops
+ * early once a LOD can't be simplified any further.
+ *
+ * max_lod_ct: Maximum number of LODs, including the original mesh
+ * ratio: Should be in 0..1, 0.5 is a reasonable value
+ */
+void lod_chain_create(struct ObjVertex *vertices, size_t vertex_ct,
+		      uint32_t *indices, size_t index_ct,
+		      uint32_t max_lod_ct, float ratio,
+		      struct LodChain *chain);
+
+void lod_chain_destroy(struct LodChain chain);
+
+/*
+ * Returns the coarsest LOD whose error is acceptable when viewed from
+ * <distance>.
+ *
+ * max_error: Allowed error per unit of distance, like LOD_DEFAULT_ERROR
+ */
+uint32_t lod_select(struct LodChain *chain, float distance, float max_error);
+
+/*
+ * Same, but using the distance between an OrbitCamera and <center>.
+ */
+uint32_t lod_select_orbit(struct LodChain *chain, struct OrbitCamera *c,
+			  vec3 center, float max_error);
+
+/*
+ * Same, but using the distance between a FlyCamera and <center>.
+ */
+uint32_t lod_select_fly(struct LodChain *chain, struct FlyCamera *c,
+			vec3 center, float max_error);
+
+#endif // LOD_H_
@@ -0,0 +1,215 @@
+#include "meshlet.h"
+#include "camera.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Marks a vertex that isn't part of the current meshlet
+#define NO_LOCAL_IDX 0xFF
+
+/*
+ * Fills in the bounding sphere and normal cone of a finished meshlet.
+ */
+static void meshlet_bounds(struct ObjVertex *vertices, struct MeshletSet *set,
+			   struct Meshlet *m)
+{
+	uint32_t *m_vertices = &set->vertices[m->vertex_offset];
+	uint8_t *m_triangles = &set->triangles[m->triangle_offset * 3];
+
+	// Sphere around the center of the bounding box
+	vec3 min = {INFINITY, INFINITY, INFINITY};
+	vec3 max = {-INFINITY, -INFINITY, -INFINITY};
+	for (uint32_t i = 0; i < m->vertex_ct; i++) {
+		float *p = vertices[m_vertices[i]].pos;
+		for (int j = 0; j < 3; j++) {
+			if (p[j] < min[j]) min[j] = p[j];
+			if (p[j] > max[j]) max[j] = p[j];
+		}
+	}
+
+	for (int j = 0; j < 3; j++) m->center[j] = (min[j] + max[j]) * 0.5f;
+
+	m->radius = 0.0f;
+	for (uint32_t i = 0; i < m->vertex_ct; i++) {
+		float dist = glm_vec3_distance(m->center,
+					       vertices[m_vertices[i]].pos);
+		if (dist > m->radius) m->radius = dist;
+	}
+
+	// Triangle normals
+	vec3 *normals = malloc(sizeof(normals[0]) * m->triangle_ct);
+	vec3 axis = {0.0f, 0.0f, 0.0f};
+	for (uint32_t i = 0; i < m->triangle_ct; i++) {
+		float *a = vertices[m_vertices[m_triangles[i * 3]]].pos;
+		float *b = vertices[m_vertices[m_triangles[i * 3 + 1]]].pos;
+		float *c = vertices[m_vertices[m_triangles[i * 3 + 2]]].pos;
+
+		vec3 e1, e2;
+		glm_vec3_sub(b, a, e1);
+		glm_vec3_sub(c, a, e2);
+		glm_vec3_cross(e1, e2, normals[i]);
+		glm_vec3_normalize(normals[i]);
+
+		glm_vec3_add(axis, normals[i], axis);
+	}
+	glm_vec3_normalize(axis);
+
+	// Widest angle between the axis and any normal
+	float min_dot = 1.0f;
+	for (uint32_t i = 0; i < m->triangle_ct; i++) {
+		// Degenerate triangles don't face anywhere
+		if (glm_vec3_dot(normals[i], normals[i]) == 0.0f) continue;
+
+		float d = glm_vec3_dot(axis, normals[i]);
+		if (d < min_dot) min_dot = d;
+	}
+	free(normals);
+
+	memcpy(m->cone_axis, axis, sizeof(m->cone_axis));
+
+	// Cones wider than about 85 degrees can hardly ever be culled
+	if (min_dot <= 0.1f) m->cone_cutoff = 1.0f;
+	else m->cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+}
+
+void meshlet_build(struct ObjVertex *vertices, size_t vertex_ct,
+		   uint32_t *indices, size_t index_ct,
+		   struct MeshletSet *set)
+{
+	assert(index_ct % 3 == 0);
+
+	size_t triangle_ct = index_ct / 3;
+
+	// Upper bounds, shrunk at the end
+	set->meshlets = malloc(sizeof(set->meshlets[0]) * (triangle_ct + 1));
+	set->vertices = malloc(sizeof(set->vertices[0]) * index_ct);
+	set->triangles = malloc(sizeof(set->triangles[0]) * index_ct);
+	set->meshlet_ct = 0;
+	set->vertex_ct = 0;
+	set->triangle_ct = 0;
+
+	// Position of each vertex within the current meshlet
+	uint8_t *local_idxs = malloc(sizeof(local_idxs[0]) * vertex_ct);
+	memset(local_idxs, NO_LOCAL_IDX, sizeof(local_idxs[0]) * vertex_ct);
+
+	struct Meshlet cur = {0};
+
+	for (size_t i = 0; i < index_ct; i += 3) {
+		uint32_t *tri = &indices[i];
+
+		uint32_t new_ct = 0;
+		for (int j = 0; j < 3; j++) {
+			int seen = local_idxs[tri[j]] != NO_LOCAL_IDX;
+			for (int k = 0; k < j; k++) {
+				if (tri[k] == tri[j]) seen = 1;
+			}
+			if (!seen) new_ct++;
+		}
+
+		// Start a new meshlet if this triangle doesn't fit
+		if (cur.vertex_ct + new_ct > MESHLET_MAX_VERTICES
+		    || cur.triangle_ct + 1 > MESHLET_MAX_TRIANGLES) {
+			meshlet_bounds(vertices, set, &cur);
+			set->meshlets[set->meshlet_ct++] = cur;
+
+			for (uint32_t j = 0; j < cur.vertex_ct; j++) {
+				local_idxs[set->vertices[cur.vertex_offset + j]]
+					= NO_LOCAL_IDX;
+			}
+
+			cur = (struct Meshlet) {0};
+			cur.vertex_offset = set->vertex_ct;
+			cur.triangle_offset = set->triangle_ct;
+		}
+
+		for (int j = 0; j < 3; j++) {
+			uint32_t v = tri[j];
+			if (local_idxs[v] == NO_LOCAL_IDX) {
+				local_idxs[v] = cur.vertex_ct++;
+				set->vertices[set->vertex_ct++] = v;
+			}
+
+			set->triangles[set->triangle_ct * 3 + j] = local_idxs[v];
+		}
+
+		set->triangle_ct++;
+		cur.triangle_ct++;
+	}
+
+	if (cur.triangle_ct > 0) {
+		meshlet_bounds(vertices, set, &cur);
+		set->meshlets[set->meshlet_ct++] = cur;
+	}
+
+	free(local_idxs);
+
+	set->meshlets = realloc(set->meshlets,
+				sizeof(set->meshlets[0]) * (set->meshlet_ct + 1));
+	set->vertices = realloc(set->vertices,
+				sizeof(set->vertices[0]) * (set->vertex_ct + 1));
+}
+
+void meshlet_set_destroy(struct MeshletSet set)
+{
+	free(set.meshlets);
+	free(set.vertices);
+	free(set.triangles);
+}
+
+int meshlet_is_backfacing(struct Meshlet *m, vec3 eye)
+{
+	if (m->cone_cutoff >= 1.0f) return 0;
+
+	vec3 to_center;
+	glm_vec3_sub(m->center, eye, to_center);
+
+	return glm_vec3_dot(to_center, m->cone_axis)
+		>= m->cone_cutoff * glm_vec3_norm(to_center) + m->radius;
+}
+
+static int sphere_outside(vec4 planes[6], float center[3], float radius)
+{
+	for (int i = 0; i < 6; i++) {
+		float dist = planes[i][0] * center[0]
+			+ planes[i][1] * center[1]
+			+ planes[i][2] * center[2]
+			+ planes[i][3];
+
+		if (dist < -radius) return 1;
+	}
+
+	return 0;
+}
+
+int meshlet_is_offscreen(struct Meshlet *m, mat4 view_proj)
+{
+	vec4 planes[6];
+	cam_frustum_planes(view_proj, planes);
+
+	return sphere_outside(planes, m->center, m->radius);
+}
+
+size_t meshlet_cull(struct MeshletSet *set, vec3 eye, mat4 view_proj,
+		    uint32_t *dest)
+{
+	vec4 planes[6];
+	cam_frustum_planes(view_proj, planes);
+
+	size_t out = 0;
+	for (uint32_t i = 0; i < set->meshlet_ct; i++) {
+		struct Meshlet *m = &set->meshlets[i];
+
+		if (meshlet_is_backfacing(m, eye)) continue;
+		if (sphere_outside(planes, m->center, m->radius)) continue;
+
+		uint32_t *m_vertices = &set->vertices[m->vertex_offset];
+		uint8_t *m_triangles = &set->triangles[m->triangle_offset * 3];
+		for (uint32_t j = 0; j < m->triangle_ct * 3; j++) {
+			dest[out++] = m_vertices[m_triangles[j]];
+		}
+	}
+
+	return out;
+}
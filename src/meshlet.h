@@ -0,0 +1,89 @@
+#ifndef MESHLET_H_
+#define MESHLET_H_
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include <cglm/cglm.h>
+
+#include "obj.h"
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+/*
+ * A small cluster of triangles, along with the bounds used to cull it.
+ *
+ * The cone contains the normals of all triangles in the meshlet. If
+ * cone_cutoff is 1 the normals are too spread out for the cone to be useful,
+ * and the meshlet is never considered back-facing.
+ */
+struct Meshlet {
+	// Into MeshletSet.vertices
+	uint32_t vertex_offset;
+	uint32_t vertex_ct;
+	// Into MeshletSet.triangles, in triangles (not bytes)
+	uint32_t triangle_offset;
+	uint32_t triangle_ct;
+
+	// Bounding sphere
+	float center[3];
+	float radius;
+
+	// Normal cone
+	float cone_axis[3];
+	float cone_cutoff;
+};
+
+/*
+ * All the meshlets of a mesh.
+ *
+ * Each meshlet references up to MESHLET_MAX_VERTICES entries of <vertices>,
+ * which are indices into the original vertex array. Triangles are stored as 3
+ * bytes each, indexing into the meshlet's own slice of <vertices>.
+ */
+struct MeshletSet {
+	uint32_t meshlet_ct;
+	struct Meshlet *meshlets;
+
+	uint32_t vertex_ct;
+	uint32_t *vertices;
+
+	uint32_t triangle_ct;
+	uint8_t *triangles;
+};
+
+/*
+ * Splits the output of obj_load into meshlets. Mallocs.
+ *
+ * Triangles are grouped in the order they appear in <indices>, so the index
+ * buffer should already have decent locality (OBJ files usually do).
+ */
+void meshlet_build(struct ObjVertex *vertices, size_t vertex_ct,
+		   uint32_t *indices, size_t index_ct,
+		   struct MeshletSet *set);
+
+void meshlet_set_destroy(struct MeshletSet set);
+
+/*
+ * Returns 1 if every triangle in the meshlet faces away from <eye>.
+ */
+int meshlet_is_backfacing(struct Meshlet *m, vec3 eye);
+
+/*
+ * Returns 1 if the meshlet's bounding sphere is completely outside the view
+ * frustum of <view_proj>.
+ */
+int meshlet_is_offscreen(struct Meshlet *m, mat4 view_proj);
+
+/*
+ * Writes the triangles of all meshlets that are neither back-facing nor
+ * off-screen to <dest> as a regular index list (indexing the original vertex
+ * array), and returns how many indices were written.
+ *
+ * dest: Must have room for 3 * set->triangle_ct indices
+ */
+size_t meshlet_cull(struct MeshletSet *set, vec3 eye, mat4 view_proj,
+		    uint32_t *dest);
+
+#endif // MESHLET_H_
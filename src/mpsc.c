@@ -0,0 +1,86 @@
+#include "mpsc.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+void mpsc_create(size_t cap, size_t item_size, struct Mpsc *q)
+{
+	assert(cap > 0 && (cap & (cap - 1)) == 0);
+
+	q->cap = cap;
+	q->item_size = item_size;
+	q->seqs = malloc(sizeof(q->seqs[0]) * cap);
+	q->items = malloc(item_size * cap);
+
+	// Slot i is free for whoever claims position i
+	for (size_t i = 0; i < cap; i++) {
+		atomic_init(&q->seqs[i], i);
+	}
+
+	atomic_init(&q->tail, 0);
+	q->head = 0;
+}
+
+void mpsc_destroy(struct Mpsc q)
+{
+	free((void *) q.seqs);
+	free(q.items);
+}
+
+int mpsc_push(struct Mpsc *q, const void *item)
+{
+	size_t mask = q->cap - 1;
+	size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+	while (1) {
+		size_t seq = atomic_load_explicit(&q->seqs[pos & mask],
+						  memory_order_acquire);
+		intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+		if (diff == 0) {
+			// Our turn, if nobody else claims it first
+			if (atomic_compare_exchange_weak_explicit(
+				    &q->tail, &pos, pos + 1,
+				    memory_order_relaxed,
+				    memory_order_relaxed)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// The consumer hasn't freed this slot from last lap
+			return 1;
+		} else {
+			// Another producer got here first
+			pos = atomic_load_explicit(&q->tail,
+						   memory_order_relaxed);
+		}
+	}
+
+	memcpy(&q->items[(pos & mask) * q->item_size], item, q->item_size);
+	atomic_store_explicit(&q->seqs[pos & mask], pos + 1,
+			      memory_order_release);
+
+	return 0;
+}
+
+int mpsc_pop(struct Mpsc *q, void *item)
+{
+	size_t mask = q->cap - 1;
+	size_t pos = q->head;
+
+	size_t seq = atomic_load_explicit(&q->seqs[pos & mask],
+					  memory_order_acquire);
+
+	// Not published yet
+	if ((intptr_t) seq - (intptr_t) (pos + 1) < 0) return 1;
+
+	memcpy(item, &q->items[(pos & mask) * q->item_size], q->item_size);
+
+	// Free for the producer one lap ahead
+	atomic_store_explicit(&q->seqs[pos & mask], pos + q->cap,
+			      memory_order_release);
+	q->head = pos + 1;
+
+	return 0;
+}
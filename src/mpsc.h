@@ -0,0 +1,56 @@
+#ifndef MPSC_H_
+#define MPSC_H_
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Keeps the producer and consumer positions on separate cache lines
+#define MPSC_CACHE_LINE 64
+
+/*
+ * A bounded, lock-free queue that any number of threads can push to, but only
+ * one thread can pop from. Items are fixed-size and copied in and out.
+ *
+ * Each slot has a sequence number saying whose turn it is: producers claim a
+ * position by advancing the tail with a compare-and-swap, write the item, then
+ * publish it by bumping the slot's sequence; the consumer waits for that
+ * before reading, and bumps it again to hand the slot back to producers one
+ * lap later.
+ */
+struct Mpsc {
+	size_t cap;
+	size_t item_size;
+
+	_Atomic size_t *seqs;
+	unsigned char *items;
+
+	_Atomic size_t tail;
+	char pad[MPSC_CACHE_LINE];
+	size_t head;
+};
+
+/*
+ * Creates a queue. Mallocs.
+ *
+ * cap: How many items fit at once. Must be a power of two.
+ */
+void mpsc_create(size_t cap, size_t item_size, struct Mpsc *q);
+
+void mpsc_destroy(struct Mpsc q);
+
+/*
+ * Copies <item> into the queue. Safe to call from any thread.
+ *
+ * Returns 0 on success, or 1 if the queue was full.
+ */
+int mpsc_push(struct Mpsc *q, const void *item);
+
+/*
+ * Copies the oldest item into <item> and removes it. Only one thread may pop
+ * from a queue.
+ *
+ * Returns 0 on success, or 1 if the queue was empty.
+ */
+int mpsc_pop(struct Mpsc *q, void *item);
+
+#endif // MPSC_H_
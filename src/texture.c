@@ -0,0 +1,624 @@
+#include "texture.h"
+#include "bcn.h"
+#include "vk_image.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The only translation unit with stb_image's definitions
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#define KTX2_HEADER_SIZE 80
+#define KTX2_LEVEL_INDEX_SIZE 24
+
+static const unsigned char ktx2_id[12] = {
+	0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n'
+};
+
+#define DDS_HEADER_SIZE 128
+#define DDS_DX10_HEADER_SIZE 20
+
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+#define DDSCAPS2_CUBEMAP 0x200
+
+// Data format descriptor values (Khronos Data Format Specification)
+#define DF_MODEL_RGBSDA 1
+#define DF_MODEL_BC1A 128
+#define DF_MODEL_BC3 130
+#define DF_MODEL_BC7 134
+#define DF_PRIMARIES_BT709 1
+#define DF_TRANSFER_LINEAR 1
+#define DF_TRANSFER_SRGB 2
+#define DF_CHANNEL_ALPHA 15
+#define DF_CHANNEL_BC1A_ALPHAPRESENT 1
+#define DF_SAMPLE_LINEAR 0x10
+
+struct DfSample {
+	uint32_t bit_offset;
+	uint32_t bit_length;
+	uint32_t channel;
+};
+
+struct FormatInfo {
+	VkFormat format;
+	// Texels per block side, and bytes per block
+	uint32_t block_dim;
+	uint32_t block_size;
+	int srgb;
+	// DXGI_FORMAT, for DDS files with a DX10 header
+	uint32_t dxgi;
+
+	uint32_t model;
+	uint32_t sample_ct;
+	struct DfSample samples[4];
+};
+
+static const struct FormatInfo formats[] = {
+	{VK_FORMAT_R8G8B8A8_UNORM, 1, 4, 0, 28, DF_MODEL_RGBSDA, 4,
+	 {{0, 8, 0}, {8, 8, 1}, {16, 8, 2}, {24, 8, DF_CHANNEL_ALPHA}}},
+	{VK_FORMAT_R8G8B8A8_SRGB, 1, 4, 1, 29, DF_MODEL_RGBSDA, 4,
+	 {{0, 8, 0}, {8, 8, 1}, {16, 8, 2}, {24, 8, DF_CHANNEL_ALPHA}}},
+	{VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 8, 0, 0, DF_MODEL_BC1A, 1,
+	 {{0, 64, 0}}},
+	{VK_FORMAT_BC1_RGB_SRGB_BLOCK, 4, 8, 1, 0, DF_MODEL_BC1A, 1,
+	 {{0, 64, 0}}},
+	{VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 8, 0, 71, DF_MODEL_BC1A, 1,
+	 {{0, 64, DF_CHANNEL_BC1A_ALPHAPRESENT}}},
+	{VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 4, 8, 1, 72, DF_MODEL_BC1A, 1,
+	 {{0, 64, DF_CHANNEL_BC1A_ALPHAPRESENT}}},
+	{VK_FORMAT_BC3_UNORM_BLOCK, 4, 16, 0, 77, DF_MODEL_BC3, 2,
+	 {{0, 64, DF_CHANNEL_ALPHA}, {64, 64, 0}}},
+	{VK_FORMAT_BC3_SRGB_BLOCK, 4, 16, 1, 78, DF_MODEL_BC3, 2,
+	 {{0, 64, DF_CHANNEL_ALPHA}, {64, 64, 0}}},
+	{VK_FORMAT_BC7_UNORM_BLOCK, 4, 16, 0, 98, DF_MODEL_BC7, 1,
+	 {{0, 128, 0}}},
+	{VK_FORMAT_BC7_SRGB_BLOCK, 4, 16, 1, 99, DF_MODEL_BC7, 1,
+	 {{0, 128, 0}}},
+};
+
+static const struct FormatInfo *format_info(VkFormat format)
+{
+	for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+		if (formats[i].format == format) return &formats[i];
+	}
+	return NULL;
+}
+
+static const struct FormatInfo *dxgi_format_info(uint32_t dxgi)
+{
+	for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+		if (formats[i].dxgi != 0 && formats[i].dxgi == dxgi) {
+			return &formats[i];
+		}
+	}
+	return NULL;
+}
+
+static uint32_t level_dim(uint32_t size, uint32_t level)
+{
+	size >>= level;
+	return size == 0 ? 1 : size;
+}
+
+size_t texture_level_size(VkFormat format, uint32_t width, uint32_t height)
+{
+	const struct FormatInfo *info = format_info(format);
+	if (info == NULL) return 0;
+
+	size_t blocks_w = (width + info->block_dim - 1) / info->block_dim;
+	size_t blocks_h = (height + info->block_dim - 1) / info->block_dim;
+	return blocks_w * blocks_h * info->block_size;
+}
+
+// Fills in the level offsets and sizes, and allocates <data>
+static void texture_alloc(VkFormat format,
+			  uint32_t width, uint32_t height, uint32_t level_ct,
+			  struct Texture *tex)
+{
+	assert(level_ct >= 1 && level_ct <= TEXTURE_MAX_LEVELS);
+
+	tex->format = format;
+	tex->width = width;
+	tex->height = height;
+	tex->level_ct = level_ct;
+
+	tex->size = 0;
+	for (uint32_t i = 0; i < level_ct; i++) {
+		tex->offsets[i] = tex->size;
+		tex->sizes[i] = texture_level_size(format,
+						   level_dim(width, i),
+						   level_dim(height, i));
+		tex->size += tex->sizes[i];
+	}
+
+	tex->data = malloc(tex->size);
+}
+
+// Reads a whole file. Returns NULL if it can't be read.
+static unsigned char *read_file(FILE *fp, size_t *size)
+{
+	if (fp == NULL) return NULL;
+
+	if (fseek(fp, 0, SEEK_END) != 0) return NULL;
+	long end = ftell(fp);
+	if (end < 0) return NULL;
+	rewind(fp);
+
+	*size = end;
+	unsigned char *buf = malloc(*size);
+	if (fread(buf, 1, *size, fp) != *size) {
+		free(buf);
+		return NULL;
+	}
+
+	return buf;
+}
+
+// Files are little-endian, as is every platform this runs on
+static uint32_t read_u32(const unsigned char *buf, size_t offset)
+{
+	uint32_t v;
+	memcpy(&v, &buf[offset], sizeof(v));
+	return v;
+}
+
+static uint64_t read_u64(const unsigned char *buf, size_t offset)
+{
+	uint64_t v;
+	memcpy(&v, &buf[offset], sizeof(v));
+	return v;
+}
+
+static void write_u32(FILE *fp, uint32_t v)
+{
+	fwrite(&v, sizeof(v), 1, fp);
+}
+
+static void write_u64(FILE *fp, uint64_t v)
+{
+	fwrite(&v, sizeof(v), 1, fp);
+}
+
+int texture_load_ktx2(FILE *fp, struct Texture *tex)
+{
+	size_t file_size;
+	unsigned char *buf = read_file(fp, &file_size);
+	if (buf == NULL) return 1;
+
+	if (file_size < KTX2_HEADER_SIZE
+	    || memcmp(buf, ktx2_id, sizeof(ktx2_id)) != 0) {
+		free(buf);
+		return 1;
+	}
+
+	VkFormat format = read_u32(buf, 12);
+	uint32_t width = read_u32(buf, 20);
+	uint32_t height = read_u32(buf, 24);
+	uint32_t depth = read_u32(buf, 28);
+	uint32_t layer_ct = read_u32(buf, 32);
+	uint32_t face_ct = read_u32(buf, 36);
+	uint32_t level_ct = read_u32(buf, 40);
+	uint32_t supercompression = read_u32(buf, 44);
+
+	// 0 levels asks the loader to generate them, which is up to the caller
+	if (level_ct == 0) level_ct = 1;
+
+	if (format_info(format) == NULL
+	    || width == 0 || height == 0 || depth > 1
+	    || layer_ct > 1 || face_ct != 1
+	    || level_ct > TEXTURE_MAX_LEVELS
+	    || level_ct > image_mip_ct(width, height)
+	    || supercompression != 0
+	    || file_size < KTX2_HEADER_SIZE + level_ct * KTX2_LEVEL_INDEX_SIZE) {
+		free(buf);
+		return 1;
+	}
+
+	texture_alloc(format, width, height, level_ct, tex);
+
+	for (uint32_t i = 0; i < level_ct; i++) {
+		size_t entry = KTX2_HEADER_SIZE + i * KTX2_LEVEL_INDEX_SIZE;
+		uint64_t offset = read_u64(buf, entry);
+		uint64_t length = read_u64(buf, entry + 8);
+
+		if (length != tex->sizes[i]
+		    || offset > file_size || length > file_size - offset) {
+			texture_destroy(*tex);
+			free(buf);
+			return 1;
+		}
+
+		memcpy(&tex->data[tex->offsets[i]], &buf[offset], length);
+	}
+
+	free(buf);
+	return 0;
+}
+
+int texture_load_dds(FILE *fp, struct Texture *tex)
+{
+	size_t file_size;
+	unsigned char *buf = read_file(fp, &file_size);
+	if (buf == NULL) return 1;
+
+	if (file_size < DDS_HEADER_SIZE
+	    || memcmp(buf, "DDS ", 4) != 0
+	    || read_u32(buf, 4) != 124) {
+		free(buf);
+		return 1;
+	}
+
+	uint32_t flags = read_u32(buf, 8);
+	uint32_t height = read_u32(buf, 12);
+	uint32_t width = read_u32(buf, 16);
+	uint32_t level_ct = read_u32(buf, 28);
+	uint32_t pf_flags = read_u32(buf, 80);
+	uint32_t four_cc = read_u32(buf, 84);
+	uint32_t caps2 = read_u32(buf, 112);
+
+	if (!(flags & DDSD_MIPMAPCOUNT) || level_ct == 0) level_ct = 1;
+
+	const struct FormatInfo *info = NULL;
+	size_t data_offset = DDS_HEADER_SIZE;
+
+	if ((pf_flags & DDPF_FOURCC) && memcmp(&buf[84], "DX10", 4) == 0) {
+		data_offset += DDS_DX10_HEADER_SIZE;
+		if (file_size < data_offset) {
+			free(buf);
+			return 1;
+		}
+
+		uint32_t array_size = read_u32(buf, 140);
+		if (array_size <= 1) info = dxgi_format_info(read_u32(buf, 128));
+	} else if (pf_flags & DDPF_FOURCC) {
+		if (memcmp(&four_cc, "DXT1", 4) == 0) {
+			info = format_info(VK_FORMAT_BC1_RGBA_UNORM_BLOCK);
+		} else if (memcmp(&four_cc, "DXT5", 4) == 0) {
+			info = format_info(VK_FORMAT_BC3_UNORM_BLOCK);
+		}
+	} else if ((pf_flags & DDPF_RGB)
+		   && read_u32(buf, 88) == 32
+		   && read_u32(buf, 92) == 0x000000ff
+		   && read_u32(buf, 96) == 0x0000ff00
+		   && read_u32(buf, 100) == 0x00ff0000) {
+		info = format_info(VK_FORMAT_R8G8B8A8_UNORM);
+	}
+
+	if (info == NULL
+	    || width == 0 || height == 0
+	    || (caps2 & DDSCAPS2_CUBEMAP)
+	    || level_ct > TEXTURE_MAX_LEVELS
+	    || level_ct > image_mip_ct(width, height)) {
+		free(buf);
+		return 1;
+	}
+
+	texture_alloc(info->format, width, height, level_ct, tex);
+
+	// Levels are packed one after the other, largest first, just like ours
+	if (file_size - data_offset < tex->size) {
+		texture_destroy(*tex);
+		free(buf);
+		return 1;
+	}
+	memcpy(tex->data, &buf[data_offset], tex->size);
+
+	free(buf);
+	return 0;
+}
+
+// KTX2 requires a data format descriptor, even if we ignore it when reading
+static void write_dfd(FILE *fp, const struct FormatInfo *info)
+{
+	uint32_t block_size = 24 + 16 * info->sample_ct;
+	write_u32(fp, 4 + block_size);
+
+	// Vendor Khronos, basic descriptor type, version 1.3
+	write_u32(fp, 0);
+	write_u32(fp, 2 | (block_size << 16));
+	write_u32(fp, info->model
+		  | (DF_PRIMARIES_BT709 << 8)
+		  | ((info->srgb ? DF_TRANSFER_SRGB : DF_TRANSFER_LINEAR) << 16));
+	uint32_t dim = info->block_dim - 1;
+	write_u32(fp, dim | (dim << 8));
+	write_u32(fp, info->block_size);
+	write_u32(fp, 0);
+
+	for (uint32_t i = 0; i < info->sample_ct; i++) {
+		const struct DfSample *s = &info->samples[i];
+
+		// Alpha is never sRGB encoded
+		uint32_t channel = s->channel;
+		if (info->srgb && channel == DF_CHANNEL_ALPHA) {
+			channel |= DF_SAMPLE_LINEAR;
+		}
+
+		write_u32(fp, s->bit_offset
+			  | ((s->bit_length - 1) << 16)
+			  | (channel << 24));
+		write_u32(fp, 0);
+		write_u32(fp, 0);
+		write_u32(fp, info->block_dim == 1 ? 255 : UINT32_MAX);
+	}
+}
+
+static size_t align_up(size_t offset, size_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+void texture_write_ktx2(FILE *fp, struct Texture tex)
+{
+	const struct FormatInfo *info = format_info(tex.format);
+	assert(info != NULL);
+
+	size_t dfd_offset = KTX2_HEADER_SIZE
+		+ tex.level_ct * KTX2_LEVEL_INDEX_SIZE;
+	size_t dfd_size = 4 + 24 + 16 * info->sample_ct;
+
+	// Levels are stored smallest first, each aligned to the block size
+	// (which is a multiple of 4 for every supported format)
+	size_t file_offsets[TEXTURE_MAX_LEVELS];
+	size_t end = dfd_offset + dfd_size;
+	for (uint32_t i = tex.level_ct; i-- > 0;) {
+		file_offsets[i] = align_up(end, info->block_size);
+		end = file_offsets[i] + tex.sizes[i];
+	}
+
+	rewind(fp);
+	fwrite(ktx2_id, sizeof(ktx2_id), 1, fp);
+	write_u32(fp, tex.format);
+	write_u32(fp, 1);
+	write_u32(fp, tex.width);
+	write_u32(fp, tex.height);
+	write_u32(fp, 0);
+	write_u32(fp, 0);
+	write_u32(fp, 1);
+	write_u32(fp, tex.level_ct);
+	write_u32(fp, 0);
+
+	// No key/value data or supercompression global data
+	write_u32(fp, dfd_offset);
+	write_u32(fp, dfd_size);
+	write_u32(fp, 0);
+	write_u32(fp, 0);
+	write_u64(fp, 0);
+	write_u64(fp, 0);
+
+	for (uint32_t i = 0; i < tex.level_ct; i++) {
+		write_u64(fp, file_offsets[i]);
+		write_u64(fp, tex.sizes[i]);
+		write_u64(fp, tex.sizes[i]);
+	}
+
+	write_dfd(fp, info);
+
+	size_t pos = dfd_offset + dfd_size;
+	for (uint32_t i = tex.level_ct; i-- > 0;) {
+		for (; pos < file_offsets[i]; pos++) fputc(0, fp);
+
+		fwrite(&tex.data[tex.offsets[i]], 1, tex.sizes[i], fp);
+		pos += tex.sizes[i];
+	}
+}
+
+static float srgb_to_linear(float c)
+{
+	return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linear_to_srgb(float c)
+{
+	return c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+}
+
+/*
+ * Averages each 2x2 block of <src> into one texel of <dst>. With odd sizes the
+ * last row or column is dropped, and 1-texel sides are repeated.
+ */
+static void downsample(uint32_t src_w, uint32_t src_h,
+		       const unsigned char *src,
+		       uint32_t dst_w, uint32_t dst_h,
+		       unsigned char *dst,
+		       const float *to_linear, int srgb)
+{
+	for (uint32_t y = 0; y < dst_h; y++) {
+		for (uint32_t x = 0; x < dst_w; x++) {
+			uint32_t x0 = 2 * x < src_w ? 2 * x : src_w - 1;
+			uint32_t y0 = 2 * y < src_h ? 2 * y : src_h - 1;
+			uint32_t x1 = x0 + 1 < src_w ? x0 + 1 : x0;
+			uint32_t y1 = y0 + 1 < src_h ? y0 + 1 : y0;
+
+			const unsigned char *t[4] = {
+				&src[4 * (y0 * src_w + x0)],
+				&src[4 * (y0 * src_w + x1)],
+				&src[4 * (y1 * src_w + x0)],
+				&src[4 * (y1 * src_w + x1)],
+			};
+
+			unsigned char *out = &dst[4 * (y * dst_w + x)];
+			for (int c = 0; c < 4; c++) {
+				// Alpha is linear either way
+				int lin = srgb && c < 3;
+
+				float sum = 0.0f;
+				for (int i = 0; i < 4; i++) {
+					sum += lin ? to_linear[t[i][c]]
+						: t[i][c] / 255.0f;
+				}
+				float avg = sum / 4.0f;
+				if (lin) avg = linear_to_srgb(avg);
+
+				out[c] = (unsigned char) (avg * 255.0f + 0.5f);
+			}
+		}
+	}
+}
+
+void texture_encode(VkFormat format,
+		    uint32_t width, uint32_t height,
+		    const unsigned char *rgba,
+		    struct Texture *tex)
+{
+	const struct FormatInfo *info = format_info(format);
+	assert(info != NULL);
+
+	void (*encode_block)(const unsigned char [16][4], unsigned char *);
+	if (info->model == DF_MODEL_BC1A) encode_block = bc1_encode_block;
+	else if (info->model == DF_MODEL_BC7) encode_block = bc7_encode_block;
+	else if (info->model == DF_MODEL_RGBSDA) encode_block = NULL;
+	else {
+		fprintf(stderr, "Format %d can't be encoded\n", format);
+		abort();
+	}
+
+	uint32_t level_ct = image_mip_ct(width, height);
+
+	texture_alloc(format, width, height, level_ct, tex);
+
+	float to_linear[256];
+	for (int i = 0; i < 256; i++) to_linear[i] = srgb_to_linear(i / 255.0f);
+
+	// Each level is built from the uncompressed level above it
+	unsigned char *level = malloc(4 * (size_t) width * height);
+	memcpy(level, rgba, 4 * (size_t) width * height);
+	unsigned char *next = malloc(4 * (size_t) width * height);
+
+	for (uint32_t i = 0; i < level_ct; i++) {
+		uint32_t w = level_dim(width, i);
+		uint32_t h = level_dim(height, i);
+
+		unsigned char *dst = &tex->data[tex->offsets[i]];
+		if (encode_block != NULL) {
+			bc_encode(w, h, level, encode_block, info->block_size,
+				  dst);
+		} else {
+			memcpy(dst, level, tex->sizes[i]);
+		}
+
+		if (i + 1 < level_ct) {
+			downsample(w, h, level,
+				   level_dim(width, i + 1),
+				   level_dim(height, i + 1),
+				   next,
+				   to_linear, info->srgb);
+
+			unsigned char *tmp = level;
+			level = next;
+			next = tmp;
+		}
+	}
+
+	free(level);
+	free(next);
+}
+
+static int has_ext(const char *path, const char *ext)
+{
+	const char *dot = strrchr(path, '.');
+	return dot != NULL && strcasecmp(dot, ext) == 0;
+}
+
+/*
+ * <cache_dir>/<path with / replaced by _>.<format>.ktx2, so sources with the
+ * same name in different directories don't collide.
+ */
+static void cache_path(const char *cache_dir, const char *path,
+		       VkFormat format, char *out, size_t out_size)
+{
+	int len = snprintf(out, out_size, "%s/", cache_dir);
+	assert(len > 0 && (size_t) len < out_size);
+
+	size_t i = len;
+	for (const char *c = path; *c != '\0' && i < out_size - 1; c++) {
+		out[i++] = *c == '/' ? '_' : *c;
+	}
+	out[i] = '\0';
+
+	len = snprintf(&out[i], out_size - i, ".%d.ktx2", format);
+	assert(len > 0 && (size_t) len < out_size - i);
+}
+
+// Returns 1 if <cached> exists and is at least as new as <src>
+static int cache_fresh(const char *src, const char *cached)
+{
+	struct stat src_st;
+	struct stat cached_st;
+	if (stat(src, &src_st) != 0 || stat(cached, &cached_st) != 0) return 0;
+
+	return cached_st.st_mtime >= src_st.st_mtime;
+}
+
+static int load_file(const char *path,
+		     int (*load)(FILE *, struct Texture *),
+		     struct Texture *tex)
+{
+	FILE *fp = fopen(path, "rb");
+	if (fp == NULL) return 1;
+
+	int res = load(fp, tex);
+	fclose(fp);
+
+	return res;
+}
+
+int texture_load(const char *path, VkFormat format, const char *cache_dir,
+		 struct Texture *tex)
+{
+	if (has_ext(path, ".ktx2")) return load_file(path, texture_load_ktx2, tex);
+	if (has_ext(path, ".dds")) return load_file(path, texture_load_dds, tex);
+
+	char cached[PATH_MAX];
+	if (cache_dir != NULL) {
+		cache_path(cache_dir, path, format, cached, sizeof(cached));
+
+		if (cache_fresh(path, cached)
+		    && load_file(cached, texture_load_ktx2, tex) == 0) {
+			if (tex->format == format) return 0;
+			texture_destroy(*tex);
+		}
+	}
+
+	int width, height, channels;
+	unsigned char *rgba = stbi_load(path, &width, &height, &channels, 4);
+	if (rgba == NULL) return 1;
+
+	texture_encode(format, width, height, rgba, tex);
+	stbi_image_free(rgba);
+
+	// Not being able to cache is only slower next time. Write elsewhere
+	// first so a partly written file is never picked up, under a name of
+	// its own since other threads or processes may be caching it too.
+	if (cache_dir != NULL) {
+		char tmp[PATH_MAX + 8];
+		snprintf(tmp, sizeof(tmp), "%s.XXXXXX", cached);
+
+		int fd = mkstemp(tmp);
+		FILE *fp = fd < 0 ? NULL : fdopen(fd, "wb");
+		if (fp != NULL) {
+			texture_write_ktx2(fp, *tex);
+			int err = ferror(fp);
+			if (fclose(fp) == 0 && !err) rename(tmp, cached);
+			else remove(tmp);
+		} else if (fd >= 0) {
+			close(fd);
+			remove(tmp);
+		}
+	}
+
+	return 0;
+}
+
+void texture_destroy(struct Texture tex)
+{
+	free(tex.data);
+}
@@ -0,0 +1,90 @@
+#ifndef TEXTURE_H_
+#define TEXTURE_H_
+
+#include <stddef.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <vulkan/vulkan.h>
+
+// Most mip levels a Texture can hold (enough for 32768x32768)
+#define TEXTURE_MAX_LEVELS 16
+
+/*
+ * Texels of every mip level of a 2D texture, in a format that can be copied
+ * straight into a VkImage of <format>.
+ *
+ * Supported formats are R8G8B8A8, BC1, BC3 and BC7, each UNORM or SRGB.
+ */
+struct Texture {
+	VkFormat format;
+	uint32_t width;
+	uint32_t height;
+
+	uint32_t level_ct;
+	// Offset into <data> and size of each level, level 0 first
+	size_t offsets[TEXTURE_MAX_LEVELS];
+	size_t sizes[TEXTURE_MAX_LEVELS];
+
+	size_t size;
+	unsigned char *data;
+};
+
+/*
+ * Returns the size in bytes of one <width> x <height> level, or 0 if the
+ * format isn't supported.
+ */
+size_t texture_level_size(VkFormat format, uint32_t width, uint32_t height);
+
+/*
+ * Reads a KTX2 file with a supported format, one layer, one face and no
+ * supercompression.
+ *
+ * Returns 0 on success, or 1 if the file is invalid or not supported.
+ */
+int texture_load_ktx2(FILE *fp, struct Texture *tex);
+
+/*
+ * Reads a DDS file holding DXT1, DXT5 or 32-bit RGBA texels, or any supported
+ * format through the DX10 header. Cube maps and arrays aren't supported.
+ *
+ * Returns 0 on success, or 1 if the file is invalid or not supported.
+ */
+int texture_load_dds(FILE *fp, struct Texture *tex);
+
+/*
+ * Writes a texture as KTX2, so texture_load_ktx2 (or any other KTX2 reader)
+ * can load it back.
+ */
+void texture_write_ktx2(FILE *fp, struct Texture tex);
+
+/*
+ * Builds a full mip chain from RGBA8 texels, box filtering each level from
+ * the one above it (in linear space for SRGB formats), and encodes every level
+ * to <format>. BC1 and BC7 are encoded on the CPU with bcn.h, R8G8B8A8 is
+ * stored as it is. BC3 can't be encoded.
+ */
+void texture_encode(VkFormat format,
+		    uint32_t width, uint32_t height,
+		    const unsigned char *rgba,
+		    struct Texture *tex);
+
+/*
+ * Loads a texture from <path>.
+ *
+ * KTX2 and DDS files (by extension) are loaded as they are, with whatever
+ * format and mip levels they hold. Any other image stb_image can read, like
+ * PNG or JPEG, is decoded and passed through texture_encode with <format>.
+ *
+ * Encoding is slow, so if <cache_dir> isn't NULL, encoded textures are written
+ * there as KTX2 and reused by later loads of the same source and format, as
+ * long as the source isn't newer than the cached file.
+ *
+ * Returns 0 on success, or 1 if the file can't be read or decoded.
+ */
+int texture_load(const char *path, VkFormat format, const char *cache_dir,
+		 struct Texture *tex);
+
+void texture_destroy(struct Texture tex);
+
+#endif // TEXTURE_H_
@@ -0,0 +1,181 @@
+#include "vk_barrier.h"
+#include "vk_tools.h"
+
+#include <assert.h>
+
+int sync2_supported(VkPhysicalDevice phys_dev)
+{
+	char *exts[] = {
+		VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME
+	};
+	if (check_dev_exts(phys_dev, ARRAY_SIZE(exts), exts) != 0) return 0;
+
+	VkPhysicalDeviceSynchronization2FeaturesKHR sync2_features = {0};
+	sync2_features.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+
+	VkPhysicalDeviceFeatures2 features = {0};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &sync2_features;
+	vkGetPhysicalDeviceFeatures2(phys_dev, &features);
+
+	return sync2_features.synchronization2 == VK_TRUE;
+}
+
+int sync2_load(VkPhysicalDevice phys_dev, VkDevice device, struct Sync2 *s2)
+{
+	if (!sync2_supported(phys_dev)) return 1;
+
+	s2->pipeline_barrier2 = (PFN_vkCmdPipelineBarrier2KHR)
+		vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR");
+
+	if (s2->pipeline_barrier2 == NULL) return 1;
+
+	return 0;
+}
+
+void barrier_batch_create(struct Sync2 *sync2, struct BarrierBatch *batch)
+{
+	batch->sync2 = sync2;
+	batch->image_ct = 0;
+	batch->buffer_ct = 0;
+}
+
+void barrier_batch_image(struct BarrierBatch *batch,
+			 VkImage image,
+			 VkImageAspectFlags aspect,
+			 uint32_t base_level, uint32_t level_ct,
+			 VkAccessFlags src_access, VkAccessFlags dst_access,
+			 VkPipelineStageFlags src_stage,
+			 VkPipelineStageFlags dst_stage,
+			 VkImageLayout old_lt, VkImageLayout new_lt)
+{
+	assert(batch->image_ct < BARRIER_BATCH_MAX);
+
+	uint32_t i = batch->image_ct++;
+	VkImageMemoryBarrier *barrier = &batch->images[i];
+
+	*barrier = (VkImageMemoryBarrier) {0};
+	barrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier->oldLayout = old_lt;
+	barrier->newLayout = new_lt;
+	barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier->image = image;
+	barrier->subresourceRange.aspectMask = aspect;
+	barrier->subresourceRange.baseMipLevel = base_level;
+	barrier->subresourceRange.levelCount = level_ct;
+	barrier->subresourceRange.baseArrayLayer = 0;
+	barrier->subresourceRange.layerCount = 1;
+	barrier->srcAccessMask = src_access;
+	barrier->dstAccessMask = dst_access;
+
+	batch->image_src_stages[i] = src_stage;
+	batch->image_dst_stages[i] = dst_stage;
+}
+
+void barrier_batch_buffer(struct BarrierBatch *batch,
+			  VkBuffer buffer,
+			  VkDeviceSize offset, VkDeviceSize size,
+			  VkAccessFlags src_access, VkAccessFlags dst_access,
+			  VkPipelineStageFlags src_stage,
+			  VkPipelineStageFlags dst_stage)
+{
+	assert(batch->buffer_ct < BARRIER_BATCH_MAX);
+
+	uint32_t i = batch->buffer_ct++;
+	VkBufferMemoryBarrier *barrier = &batch->buffers[i];
+
+	*barrier = (VkBufferMemoryBarrier) {0};
+	barrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier->buffer = buffer;
+	barrier->offset = offset;
+	barrier->size = size;
+	barrier->srcAccessMask = src_access;
+	barrier->dstAccessMask = dst_access;
+
+	batch->buffer_src_stages[i] = src_stage;
+	batch->buffer_dst_stages[i] = dst_stage;
+}
+
+// The legacy access and stage bits have the same values in the 2 versions
+static void record_sync2(struct BarrierBatch *batch, VkCommandBuffer cbuf)
+{
+	VkImageMemoryBarrier2KHR images[BARRIER_BATCH_MAX];
+	for (uint32_t i = 0; i < batch->image_ct; i++) {
+		VkImageMemoryBarrier *src = &batch->images[i];
+
+		images[i] = (VkImageMemoryBarrier2KHR) {0};
+		images[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+		images[i].srcStageMask = batch->image_src_stages[i];
+		images[i].srcAccessMask = src->srcAccessMask;
+		images[i].dstStageMask = batch->image_dst_stages[i];
+		images[i].dstAccessMask = src->dstAccessMask;
+		images[i].oldLayout = src->oldLayout;
+		images[i].newLayout = src->newLayout;
+		images[i].srcQueueFamilyIndex = src->srcQueueFamilyIndex;
+		images[i].dstQueueFamilyIndex = src->dstQueueFamilyIndex;
+		images[i].image = src->image;
+		images[i].subresourceRange = src->subresourceRange;
+	}
+
+	VkBufferMemoryBarrier2KHR buffers[BARRIER_BATCH_MAX];
+	for (uint32_t i = 0; i < batch->buffer_ct; i++) {
+		VkBufferMemoryBarrier *src = &batch->buffers[i];
+
+		buffers[i] = (VkBufferMemoryBarrier2KHR) {0};
+		buffers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+		buffers[i].srcStageMask = batch->buffer_src_stages[i];
+		buffers[i].srcAccessMask = src->srcAccessMask;
+		buffers[i].dstStageMask = batch->buffer_dst_stages[i];
+		buffers[i].dstAccessMask = src->dstAccessMask;
+		buffers[i].srcQueueFamilyIndex = src->srcQueueFamilyIndex;
+		buffers[i].dstQueueFamilyIndex = src->dstQueueFamilyIndex;
+		buffers[i].buffer = src->buffer;
+		buffers[i].offset = src->offset;
+		buffers[i].size = src->size;
+	}
+
+	VkDependencyInfoKHR info = {0};
+	info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+	info.bufferMemoryBarrierCount = batch->buffer_ct;
+	info.pBufferMemoryBarriers = buffers;
+	info.imageMemoryBarrierCount = batch->image_ct;
+	info.pImageMemoryBarriers = images;
+
+	batch->sync2->pipeline_barrier2(cbuf, &info);
+}
+
+void barrier_batch_record(struct BarrierBatch *batch, VkCommandBuffer cbuf)
+{
+	if (batch->image_ct == 0 && batch->buffer_ct == 0) return;
+
+	if (batch->sync2 != NULL) {
+		record_sync2(batch, cbuf);
+	} else {
+		// One set of stages for the whole call
+		VkPipelineStageFlags src_stages = 0;
+		VkPipelineStageFlags dst_stages = 0;
+		for (uint32_t i = 0; i < batch->image_ct; i++) {
+			src_stages |= batch->image_src_stages[i];
+			dst_stages |= batch->image_dst_stages[i];
+		}
+		for (uint32_t i = 0; i < batch->buffer_ct; i++) {
+			src_stages |= batch->buffer_src_stages[i];
+			dst_stages |= batch->buffer_dst_stages[i];
+		}
+
+		vkCmdPipelineBarrier(cbuf,
+				     src_stages,
+				     dst_stages,
+				     0,
+				     0, NULL,
+				     batch->buffer_ct, batch->buffers,
+				     batch->image_ct, batch->images);
+	}
+
+	batch->image_ct = 0;
+	batch->buffer_ct = 0;
+}
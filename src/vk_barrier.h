@@ -0,0 +1,95 @@
+#ifndef VK_BARRIER_H_
+#define VK_BARRIER_H_
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+// Most image (and buffer) barriers a BarrierBatch can hold
+#define BARRIER_BATCH_MAX 16
+
+/*
+ * VK_KHR_synchronization2. Its barriers each carry their own stage masks, so a
+ * batch of them doesn't have to wait on the union of every barrier's source
+ * stages like vkCmdPipelineBarrier does.
+ *
+ * create_device and create_device_queues enable the extension whenever the
+ * device supports it.
+ */
+struct Sync2 {
+	// Extension commands aren't exported by the loader
+	PFN_vkCmdPipelineBarrier2KHR pipeline_barrier2;
+};
+
+/*
+ * Returns 1 if the device has the extension and the feature, 0 otherwise.
+ */
+int sync2_supported(VkPhysicalDevice phys_dev);
+
+/*
+ * Loads the commands. Returns 0 on success, or 1 if the device doesn't support
+ * synchronization2, in which case batches have to be recorded without it.
+ */
+int sync2_load(VkPhysicalDevice phys_dev, VkDevice device, struct Sync2 *s2);
+
+/*
+ * Image and buffer barriers collected to be recorded in one call, rather than
+ * one vkCmdPipelineBarrier (or worse, one submission) each.
+ */
+struct BarrierBatch {
+	// If not NULL, barriers are recorded with vkCmdPipelineBarrier2KHR
+	struct Sync2 *sync2;
+
+	uint32_t image_ct;
+	VkImageMemoryBarrier images[BARRIER_BATCH_MAX];
+	VkPipelineStageFlags image_src_stages[BARRIER_BATCH_MAX];
+	VkPipelineStageFlags image_dst_stages[BARRIER_BATCH_MAX];
+
+	uint32_t buffer_ct;
+	VkBufferMemoryBarrier buffers[BARRIER_BATCH_MAX];
+	VkPipelineStageFlags buffer_src_stages[BARRIER_BATCH_MAX];
+	VkPipelineStageFlags buffer_dst_stages[BARRIER_BATCH_MAX];
+};
+
+/*
+ * sync2: Can be NULL
+ */
+void barrier_batch_create(struct Sync2 *sync2, struct BarrierBatch *batch);
+
+/*
+ * Adds a layout transition (or if the layouts are the same, a memory
+ * dependency) for mip levels [base_level, base_level + level_ct) of an image.
+ *
+ * src_access: What accesses to wait on, like VK_ACCESS_TRANSFER_WRITE_BIT
+ * dst_access: What accesses should wait, like VK_ACCESS_SHADER_READ_BIT
+ * src_stage: What pipeline stage to wait on
+ * dst_stage: What pipeline stage should wait
+ */
+void barrier_batch_image(struct BarrierBatch *batch,
+			 VkImage image,
+			 VkImageAspectFlags aspect,
+			 uint32_t base_level, uint32_t level_ct,
+			 VkAccessFlags src_access, VkAccessFlags dst_access,
+			 VkPipelineStageFlags src_stage,
+			 VkPipelineStageFlags dst_stage,
+			 VkImageLayout old_lt, VkImageLayout new_lt);
+
+/*
+ * Adds a memory dependency on <size> bytes of a buffer starting at <offset>.
+ * size can be VK_WHOLE_SIZE.
+ */
+void barrier_batch_buffer(struct BarrierBatch *batch,
+			  VkBuffer buffer,
+			  VkDeviceSize offset, VkDeviceSize size,
+			  VkAccessFlags src_access, VkAccessFlags dst_access,
+			  VkPipelineStageFlags src_stage,
+			  VkPipelineStageFlags dst_stage);
+
+/*
+ * Records every barrier in the batch into a command buffer that is already
+ * recording, with one command, then empties the batch. Records nothing if the
+ * batch is empty.
+ */
+void barrier_batch_record(struct BarrierBatch *batch, VkCommandBuffer cbuf);
+
+#endif // VK_BARRIER_H_
@@ -0,0 +1,205 @@
+#include "vk_bindless.h"
+#include "vk_pipe.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+int bindless_supported(VkPhysicalDevice phys_dev)
+{
+	VkPhysicalDeviceVulkan12Features features_12 = {0};
+	features_12.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 features = {0};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &features_12;
+	vkGetPhysicalDeviceFeatures2(phys_dev, &features);
+
+	return features_12.runtimeDescriptorArray == VK_TRUE
+		&& features_12.shaderSampledImageArrayNonUniformIndexing
+		== VK_TRUE
+		&& features_12.descriptorBindingSampledImageUpdateAfterBind
+		== VK_TRUE
+		&& features_12.descriptorBindingUpdateUnusedWhilePending
+		== VK_TRUE
+		&& features_12.descriptorBindingPartiallyBound == VK_TRUE;
+}
+
+static uint32_t min_u32(uint32_t a, uint32_t b)
+{
+	return a < b ? a : b;
+}
+
+uint32_t bindless_max(VkPhysicalDevice phys_dev)
+{
+	VkPhysicalDeviceVulkan12Properties props_12 = {0};
+	props_12.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 props = {0};
+	props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	props.pNext = &props_12;
+	vkGetPhysicalDeviceProperties2(phys_dev, &props);
+
+	// Combined image samplers count as both a sampler and a sampled image
+	uint32_t max = BINDLESS_MAX_TEXTURES;
+	max = min_u32(max,
+		      props_12.maxPerStageDescriptorUpdateAfterBindSamplers);
+	max = min_u32(max,
+		      props_12.maxPerStageDescriptorUpdateAfterBindSampledImages);
+	max = min_u32(max, props_12.maxPerStageUpdateAfterBindResources);
+	max = min_u32(max, props_12.maxDescriptorSetUpdateAfterBindSamplers);
+	max = min_u32(max,
+		      props_12.maxDescriptorSetUpdateAfterBindSampledImages);
+
+	return max;
+}
+
+void bindless_create(VkDevice device, uint32_t cap, VkShaderStageFlags stages,
+		     struct Bindless *bl)
+{
+	bl->cap = cap;
+	bl->ct = 0;
+	bl->free_ct = 0;
+	bl->free_idxs = malloc(sizeof(bl->free_idxs[0]) * cap);
+
+	// Pool
+	VkDescriptorPoolSize pool_size = {0};
+	pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pool_size.descriptorCount = cap;
+
+	VkDescriptorPoolCreateInfo pool_info = {0};
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	pool_info.poolSizeCount = 1;
+	pool_info.pPoolSizes = &pool_size;
+	pool_info.maxSets = 1;
+
+	VkResult res = vkCreateDescriptorPool(device, &pool_info, NULL,
+					      &bl->dpool);
+	assert(res == VK_SUCCESS);
+
+	// Layout, one binding holding the whole array
+	VkDescriptorSetLayoutBinding binding = {0};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.descriptorCount = cap;
+	binding.stageFlags = stages;
+
+	VkDescriptorBindingFlags binding_flags =
+		VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+		| VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
+		| VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info = {0};
+	flags_info.sType =
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	flags_info.bindingCount = 1;
+	flags_info.pBindingFlags = &binding_flags;
+
+	VkDescriptorSetLayoutCreateInfo layout_info = {0};
+	layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.pNext = &flags_info;
+	layout_info.flags =
+		VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	layout_info.bindingCount = 1;
+	layout_info.pBindings = &binding;
+
+	res = vkCreateDescriptorSetLayout(device, &layout_info, NULL,
+					  &bl->layout);
+	assert(res == VK_SUCCESS);
+
+	// Set
+	VkDescriptorSetAllocateInfo alloc_info = {0};
+	alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	alloc_info.descriptorPool = bl->dpool;
+	alloc_info.descriptorSetCount = 1;
+	alloc_info.pSetLayouts = &bl->layout;
+
+	res = vkAllocateDescriptorSets(device, &alloc_info, &bl->set);
+	assert(res == VK_SUCCESS);
+}
+
+void bindless_destroy(VkDevice device, struct Bindless bl)
+{
+	// Frees the set too
+	vkDestroyDescriptorPool(device, bl.dpool, NULL);
+	vkDestroyDescriptorSetLayout(device, bl.layout, NULL);
+
+	free(bl.free_idxs);
+}
+
+uint32_t bindless_add(VkDevice device, struct Bindless *bl,
+		      VkSampler sampler, VkImageView view)
+{
+	uint32_t idx;
+	if (bl->free_ct > 0) {
+		idx = bl->free_idxs[--bl->free_ct];
+	} else {
+		assert(bl->ct < bl->cap);
+		idx = bl->ct++;
+	}
+
+	bindless_write(device, bl, idx, sampler, view);
+
+	return idx;
+}
+
+void bindless_write(VkDevice device, struct Bindless *bl, uint32_t idx,
+		    VkSampler sampler, VkImageView view)
+{
+	assert(idx < bl->ct);
+
+	VkDescriptorImageInfo image_info = {0};
+	image_info.sampler = sampler;
+	image_info.imageView = view;
+	image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet desc_write = {0};
+	desc_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	desc_write.dstSet = bl->set;
+	desc_write.dstBinding = 0;
+	desc_write.dstArrayElement = idx;
+
+	desc_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	desc_write.descriptorCount = 1;
+	desc_write.pImageInfo = &image_info;
+
+	vkUpdateDescriptorSets(device, 1, &desc_write, 0, NULL);
+}
+
+void bindless_remove(struct Bindless *bl, uint32_t idx)
+{
+	assert(idx < bl->ct);
+	assert(bl->free_ct < bl->cap);
+
+	bl->free_idxs[bl->free_ct++] = idx;
+}
+
+void bindless_layout(VkDevice device, struct Bindless *bl,
+		     VkShaderStageFlags push_stages, uint32_t push_size,
+		     VkPipelineLayout *layout)
+{
+	assert(push_size >= sizeof(uint32_t));
+
+	VkPushConstantRange range = {0};
+	range.stageFlags = push_stages;
+	range.offset = 0;
+	range.size = push_size;
+
+	create_layout(device, 1, &bl->layout, 1, &range, layout);
+}
+
+void bindless_bind(VkCommandBuffer cbuf, VkPipelineBindPoint bind_point,
+		   VkPipelineLayout layout, struct Bindless *bl)
+{
+	vkCmdBindDescriptorSets(cbuf, bind_point, layout,
+				0, 1, &bl->set,
+				0, NULL);
+}
+
+void bindless_push_index(VkCommandBuffer cbuf, VkPipelineLayout layout,
+			 VkShaderStageFlags stages, uint32_t idx)
+{
+	vkCmdPushConstants(cbuf, layout, stages, 0, sizeof(idx), &idx);
+}
@@ -0,0 +1,109 @@
+#ifndef VK_BINDLESS_H_
+#define VK_BINDLESS_H_
+
+#include <vulkan/vulkan.h>
+
+// Most textures a Bindless table holds, even if the device allows more
+#define BINDLESS_MAX_TEXTURES 4096
+
+/*
+ * Every texture in one descriptor set, as a single array of combined image
+ * samplers that shaders index into:
+ *
+ *     layout(set = 0, binding = 0) uniform sampler2D textures[];
+ *     layout(push_constant) uniform Push { uint texture; } push;
+ *     ...
+ *     texture(textures[push.texture], texc)
+ *
+ * The set is bound once, and switching textures between draws is just a push
+ * constant (or a per-instance attribute, wrapped in nonuniformEXT), instead
+ * of a set per material and a vkCmdBindDescriptorSets per draw.
+ *
+ * Built on descriptor indexing (core in Vulkan 1.2): slots can be written
+ * after the set is bound, and slots no draw reads can stay empty or be
+ * written while earlier frames are still in flight. A slot a pending command
+ * buffer reads must not be rewritten until that command buffer is done.
+ *
+ * create_device and create_device_queues enable the features whenever the
+ * device supports them.
+ */
+struct Bindless {
+	VkDescriptorPool dpool;
+	VkDescriptorSetLayout layout;
+	VkDescriptorSet set;
+
+	uint32_t cap;
+	// Slots handed out so far, including removed ones
+	uint32_t ct;
+	// Removed slots, reused before new ones
+	uint32_t free_ct;
+	uint32_t *free_idxs;
+};
+
+/*
+ * Returns 1 if the device has every descriptor indexing feature Bindless
+ * needs, 0 otherwise.
+ */
+int bindless_supported(VkPhysicalDevice phys_dev);
+
+/*
+ * Returns how many textures a Bindless table can hold on this device, at most
+ * BINDLESS_MAX_TEXTURES.
+ */
+uint32_t bindless_max(VkPhysicalDevice phys_dev);
+
+/*
+ * Creates the table with every slot empty. Mallocs.
+ *
+ * cap: At most bindless_max
+ * stages: Shader stages that sample the textures
+ */
+void bindless_create(VkDevice device, uint32_t cap, VkShaderStageFlags stages,
+		     struct Bindless *bl);
+
+void bindless_destroy(VkDevice device, struct Bindless bl);
+
+/*
+ * Writes a texture into a free slot and returns its index. The view must be
+ * in SHADER_READ_ONLY_OPTIMAL whenever it's sampled.
+ */
+uint32_t bindless_add(VkDevice device, struct Bindless *bl,
+		      VkSampler sampler, VkImageView view);
+
+/*
+ * Points slot <idx> at another texture, like a streamed texture that has
+ * replaced its placeholder.
+ */
+void bindless_write(VkDevice device, struct Bindless *bl, uint32_t idx,
+		    VkSampler sampler, VkImageView view);
+
+/*
+ * Frees slot <idx> for bindless_add to reuse. The slot keeps its texture until
+ * then.
+ */
+void bindless_remove(struct Bindless *bl, uint32_t idx);
+
+/*
+ * Creates a pipeline layout with the table as set 0, and one push-constant
+ * range from offset 0.
+ *
+ * push_size: Size of the push constants in bytes, at least 4 for the index
+ */
+void bindless_layout(VkDevice device, struct Bindless *bl,
+		     VkShaderStageFlags push_stages, uint32_t push_size,
+		     VkPipelineLayout *layout);
+
+/*
+ * Binds the table as set 0. Once per command buffer (or per pipeline layout
+ * change) is enough.
+ */
+void bindless_bind(VkCommandBuffer cbuf, VkPipelineBindPoint bind_point,
+		   VkPipelineLayout layout, struct Bindless *bl);
+
+/*
+ * Pushes the texture index for the following draws, at offset 0.
+ */
+void bindless_push_index(VkCommandBuffer cbuf, VkPipelineLayout layout,
+			 VkShaderStageFlags stages, uint32_t idx);
+
+#endif // VK_BINDLESS_H_
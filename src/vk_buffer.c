@@ -3,6 +3,7 @@
 
 #include "vk_buffer.h"
 #include "vk_cbuf.h"
+#include "vk_sync.h"
 
 void buffer_create(VkDevice device,
 		   VkPhysicalDeviceMemoryProperties dev_mem_props,
@@ -118,6 +119,105 @@ void copy_buffer_buffer(VkDevice device,
 	submit_syncless(device, queue, cpool, cbuf);
 }
 
+static void ownership_barrier(VkCommandBuffer cbuf, VkBuffer buffer,
+			      uint32_t src_fam, uint32_t dst_fam,
+			      VkAccessFlags src_access, VkAccessFlags dst_access,
+			      VkPipelineStageFlags src_stage,
+			      VkPipelineStageFlags dst_stage)
+{
+	VkBufferMemoryBarrier barrier = {0};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = src_access;
+	barrier.dstAccessMask = dst_access;
+	barrier.srcQueueFamilyIndex = src_fam;
+	barrier.dstQueueFamilyIndex = dst_fam;
+	barrier.buffer = buffer;
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(cbuf, src_stage, dst_stage, 0,
+			     0, NULL, 1, &barrier, 0, NULL);
+}
+
+void copy_buffer_buffer_owned(VkDevice device,
+			      VkQueue xfer_queue, VkCommandPool xfer_cpool,
+			      uint32_t xfer_fam,
+			      VkQueue dst_queue, VkCommandPool dst_cpool,
+			      uint32_t dst_fam,
+			      VkAccessFlags dst_access,
+			      VkPipelineStageFlags dst_stage,
+			      VkDeviceSize size,
+			      VkBuffer src, VkBuffer dst)
+{
+	if (xfer_fam == dst_fam) {
+		copy_buffer_buffer(device, dst_queue, dst_cpool, size, src, dst);
+		return;
+	}
+
+	// Copy and release on the transfer queue. The release's destination
+	// stage and access are ignored.
+	VkCommandBuffer release;
+	cbuf_begin_one_time(device, xfer_cpool, &release);
+
+	VkBufferCopy region = {0};
+	region.size = size;
+	vkCmdCopyBuffer(release, src, dst, 1, &region);
+
+	ownership_barrier(release, dst, xfer_fam, dst_fam,
+			  VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+			  VK_PIPELINE_STAGE_TRANSFER_BIT,
+			  VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+	VkResult res = vkEndCommandBuffer(release);
+	assert(res == VK_SUCCESS);
+
+	// Acquire on the destination queue, after the semaphore wait. The
+	// acquire's source access is ignored, but its source stage has to
+	// match the wait.
+	VkCommandBuffer acquire;
+	cbuf_begin_one_time(device, dst_cpool, &acquire);
+
+	ownership_barrier(acquire, dst, xfer_fam, dst_fam,
+			  0, dst_access,
+			  dst_stage, dst_stage);
+
+	res = vkEndCommandBuffer(acquire);
+	assert(res == VK_SUCCESS);
+
+	// Submit both
+	VkSemaphore released;
+	create_sem(device, &released);
+
+	VkSubmitInfo release_info = {0};
+	release_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	release_info.commandBufferCount = 1;
+	release_info.pCommandBuffers = &release;
+	release_info.signalSemaphoreCount = 1;
+	release_info.pSignalSemaphores = &released;
+
+	res = vkQueueSubmit(xfer_queue, 1, &release_info, NULL);
+	assert(res == VK_SUCCESS);
+
+	VkSubmitInfo acquire_info = {0};
+	acquire_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	acquire_info.waitSemaphoreCount = 1;
+	acquire_info.pWaitSemaphores = &released;
+	acquire_info.pWaitDstStageMask = &dst_stage;
+	acquire_info.commandBufferCount = 1;
+	acquire_info.pCommandBuffers = &acquire;
+
+	res = vkQueueSubmit(dst_queue, 1, &acquire_info, NULL);
+	assert(res == VK_SUCCESS);
+
+	// The acquire can't finish before the release
+	res = vkQueueWaitIdle(dst_queue);
+	assert(res == VK_SUCCESS);
+
+	vkFreeCommandBuffers(device, xfer_cpool, 1, &release);
+	vkFreeCommandBuffers(device, dst_cpool, 1, &acquire);
+	vkDestroySemaphore(device, released, NULL);
+}
+
 void copy_buffer_image(VkDevice device, VkQueue queue, VkCommandPool cpool,
 		       VkImageAspectFlagBits aspect,
 		       uint32_t width, uint32_t height,
@@ -125,9 +225,21 @@ void copy_buffer_image(VkDevice device, VkQueue queue, VkCommandPool cpool,
 {
 	VkCommandBuffer cbuf;
 	cbuf_begin_one_time(device, cpool, &cbuf);
-	
-	// Record
-        VkBufferImageCopy region = {
+
+	copy_buffer_image_cmd(cbuf, aspect, width, height, src, dst);
+
+	VkResult res = vkEndCommandBuffer(cbuf);
+	assert(res == VK_SUCCESS);
+
+	submit_syncless(device, queue, cpool, cbuf);
+}
+
+void copy_buffer_image_cmd(VkCommandBuffer cbuf,
+			   VkImageAspectFlagBits aspect,
+			   uint32_t width, uint32_t height,
+			   VkBuffer src, VkImage dst)
+{
+	VkBufferImageCopy region = {
 		.bufferOffset = 0,
 		.bufferRowLength = width,
 		.bufferImageHeight = height,
@@ -154,9 +266,4 @@ void copy_buffer_image(VkDevice device, VkQueue queue, VkCommandPool cpool,
 			       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 			       1,
 			       &region);
-
-	VkResult res = vkEndCommandBuffer(cbuf);
-	assert(res == VK_SUCCESS);
-
-	submit_syncless(device, queue, cpool, cbuf);
 }
@@ -50,6 +50,25 @@ void copy_buffer_buffer(VkDevice device, VkQueue queue, VkCommandPool cpool,
 			VkDeviceSize size,
 			VkBuffer src, VkBuffer dst);
 
+/*
+ * Copies one buffer to another on a transfer queue, then transfers ownership of
+ * <dst> to the queue family that will use it: the transfer queue releases it
+ * and <dst_queue> acquires it, with a semaphore in between. Just does
+ * copy_buffer_buffer if both families are the same. Waits for completion.
+ *
+ * dst_access, dst_stage: How <dst> will first be used on <dst_queue>, like
+ * VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT and VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+ */
+void copy_buffer_buffer_owned(VkDevice device,
+			      VkQueue xfer_queue, VkCommandPool xfer_cpool,
+			      uint32_t xfer_fam,
+			      VkQueue dst_queue, VkCommandPool dst_cpool,
+			      uint32_t dst_fam,
+			      VkAccessFlags dst_access,
+			      VkPipelineStageFlags dst_stage,
+			      VkDeviceSize size,
+			      VkBuffer src, VkBuffer dst);
+
 /*
  * Copies a buffer to an image.
  * Image must already be VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL.
@@ -58,4 +77,14 @@ void copy_buffer_image(VkDevice device, VkQueue queue, VkCommandPool cpool,
 		       VkImageAspectFlagBits aspect,
 		       uint32_t width, uint32_t height,
 		       VkBuffer src, VkImage dst);
+
+/*
+ * Same as copy_buffer_image, but records the copy into a command buffer that
+ * is already recording, so it can share a submission with the layout
+ * transitions around it.
+ */
+void copy_buffer_image_cmd(VkCommandBuffer cbuf,
+			   VkImageAspectFlagBits aspect,
+			   uint32_t width, uint32_t height,
+			   VkBuffer src, VkImage dst);
 #endif // VK_BUFFER_H_
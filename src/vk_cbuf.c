@@ -26,30 +26,55 @@ void create_cbuf(VkDevice device,
 		 uint32_t index_ct,
 		 VkCommandBuffer *cbuf)
 {
-	VkResult res;
+	create_cbuf_range(device, cpool, rpass,
+			  clear_ct, clears,
+			  fb,
+			  width, height,
+			  layout, pipel,
+			  desc_set_ct, desc_sets,
+			  vbuf, ibuf,
+			  0, index_ct,
+			  cbuf);
+}
 
+void create_cbuf_range(VkDevice device,
+		       VkCommandPool cpool,
+		       VkRenderPass rpass,
+		       uint32_t clear_ct, VkClearValue *clears,
+		       VkFramebuffer fb,
+		       uint32_t width, uint32_t height,
+		       VkPipelineLayout layout,
+		       VkPipeline pipel,
+		       uint32_t desc_set_ct, VkDescriptorSet *desc_sets,
+		       VkBuffer vbuf, VkBuffer ibuf,
+		       uint32_t first_index, uint32_t index_ct,
+		       VkCommandBuffer *cbuf)
+{
 	// Allocate
 	cbuf_begin_one_time(device, cpool, cbuf);
 
-	// Enter render pass
-	VkOffset2D render_area_offset = {0};
-	render_area_offset.x = 0;
-	render_area_offset.y = 0;
-	VkExtent2D render_area_extent = {0};
-	render_area_extent.width = width;
-	render_area_extent.height = height;
+	cbuf_record_ranges(*cbuf, rpass,
+			   clear_ct, clears,
+			   fb,
+			   width, height,
+			   layout, pipel,
+			   desc_set_ct, desc_sets,
+			   vbuf, ibuf,
+			   1, &first_index, &index_ct);
 
-	VkRenderPassBeginInfo rpass_info = {0};
-	rpass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	rpass_info.renderPass = rpass;
-	rpass_info.framebuffer = fb;
-	rpass_info.renderArea.offset = render_area_offset;
-	rpass_info.renderArea.extent = render_area_extent;
-	rpass_info.clearValueCount = clear_ct;
-	rpass_info.pClearValues = clears;
-
-	vkCmdBeginRenderPass(*cbuf, &rpass_info, VK_SUBPASS_CONTENTS_INLINE);
+	// Finish
+	VkResult res = vkEndCommandBuffer(*cbuf);
+	assert(res == VK_SUCCESS);
+}
 
+// Everything before the draws of cbuf_draw_ranges and its variants
+static void bind_draw_state(VkCommandBuffer cbuf,
+			    uint32_t width, uint32_t height,
+			    VkPipelineLayout layout,
+			    VkPipeline pipel,
+			    uint32_t desc_set_ct, VkDescriptorSet *desc_sets,
+			    VkBuffer vbuf, VkBuffer ibuf)
+{
 	// Set scissors and viewport
 	VkViewport viewport = {0};
 	viewport.x = 0;
@@ -69,22 +94,22 @@ void create_cbuf(VkDevice device,
 	scissor.offset = scissor_offset;
 	scissor.extent = scissor_extent;
 
-	vkCmdSetViewport(*cbuf, 0, 1, &viewport);
-	vkCmdSetScissor(*cbuf, 0, 1, &scissor);
+	vkCmdSetViewport(cbuf, 0, 1, &viewport);
+	vkCmdSetScissor(cbuf, 0, 1, &scissor);
 
 	// Bind vertex buffer
 	VkBuffer vertex_buffers[] = {vbuf};
 	VkDeviceSize offsets[] = {0};
-	vkCmdBindVertexBuffers(*cbuf, 0, 1, vertex_buffers, offsets);
+	vkCmdBindVertexBuffers(cbuf, 0, 1, vertex_buffers, offsets);
 
 	// Bind pipeline
-	vkCmdBindPipeline(*cbuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipel);
+	vkCmdBindPipeline(cbuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipel);
 
 	// Bind descriptor sets, if any
 	if (desc_set_ct > 0) {
 		assert(layout != NULL);
 		
-		vkCmdBindDescriptorSets(*cbuf,
+		vkCmdBindDescriptorSets(cbuf,
 					VK_PIPELINE_BIND_POINT_GRAPHICS,
 					layout,
 					0,
@@ -92,15 +117,120 @@ void create_cbuf(VkDevice device,
 					0, NULL);
 	}
 
+	vkCmdBindIndexBuffer(cbuf, ibuf, 0, VK_INDEX_TYPE_UINT32);
+}
+
+void cbuf_draw_ranges(VkCommandBuffer cbuf,
+		      uint32_t width, uint32_t height,
+		      VkPipelineLayout layout,
+		      VkPipeline pipel,
+		      uint32_t desc_set_ct, VkDescriptorSet *desc_sets,
+		      VkBuffer vbuf, VkBuffer ibuf,
+		      uint32_t range_ct,
+		      uint32_t *first_indices, uint32_t *index_cts)
+{
+	bind_draw_state(cbuf, width, height, layout, pipel,
+			desc_set_ct, desc_sets, vbuf, ibuf);
+
 	// Draw! :)
-	vkCmdBindIndexBuffer(*cbuf, ibuf, 0, VK_INDEX_TYPE_UINT32);
-	vkCmdDrawIndexed(*cbuf, index_ct, 1, 0, 0, 0);
+	for (uint32_t i = 0; i < range_ct; i++) {
+		vkCmdDrawIndexed(cbuf, index_cts[i], 1, first_indices[i], 0, 0);
+	}
+}
 
-	// Finish
-	vkCmdEndRenderPass(*cbuf);
+void draw_push_range(VkPushConstantRange *range)
+{
+	range->stageFlags = DRAW_PUSH_STAGES;
+	range->offset = 0;
+	range->size = sizeof(struct DrawPush);
+}
 
-	res = vkEndCommandBuffer(*cbuf);
-	assert(res == VK_SUCCESS);
+void cbuf_push_draw(VkCommandBuffer cbuf, VkPipelineLayout layout,
+		    struct DrawPush *push)
+{
+	vkCmdPushConstants(cbuf, layout, DRAW_PUSH_STAGES,
+			   0, sizeof(*push), push);
+}
+
+void cbuf_draw_ranges_pushed(VkCommandBuffer cbuf,
+			     uint32_t width, uint32_t height,
+			     VkPipelineLayout layout,
+			     VkPipeline pipel,
+			     uint32_t desc_set_ct, VkDescriptorSet *desc_sets,
+			     VkBuffer vbuf, VkBuffer ibuf,
+			     uint32_t range_ct,
+			     uint32_t *first_indices, uint32_t *index_cts,
+			     struct DrawPush *pushes)
+{
+	assert(layout != NULL);
+
+	bind_draw_state(cbuf, width, height, layout, pipel,
+			desc_set_ct, desc_sets, vbuf, ibuf);
+
+	for (uint32_t i = 0; i < range_ct; i++) {
+		cbuf_push_draw(cbuf, layout, &pushes[i]);
+		vkCmdDrawIndexed(cbuf, index_cts[i], 1, first_indices[i], 0, 0);
+	}
+}
+
+void cbuf_record_ranges(VkCommandBuffer cbuf,
+			VkRenderPass rpass,
+			uint32_t clear_ct, VkClearValue *clears,
+			VkFramebuffer fb,
+			uint32_t width, uint32_t height,
+			VkPipelineLayout layout,
+			VkPipeline pipel,
+			uint32_t desc_set_ct, VkDescriptorSet *desc_sets,
+			VkBuffer vbuf, VkBuffer ibuf,
+			uint32_t range_ct,
+			uint32_t *first_indices, uint32_t *index_cts)
+{
+	// Enter render pass
+	VkOffset2D render_area_offset = {0};
+	render_area_offset.x = 0;
+	render_area_offset.y = 0;
+	VkExtent2D render_area_extent = {0};
+	render_area_extent.width = width;
+	render_area_extent.height = height;
+
+	VkRenderPassBeginInfo rpass_info = {0};
+	rpass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	rpass_info.renderPass = rpass;
+	rpass_info.framebuffer = fb;
+	rpass_info.renderArea.offset = render_area_offset;
+	rpass_info.renderArea.extent = render_area_extent;
+	rpass_info.clearValueCount = clear_ct;
+	rpass_info.pClearValues = clears;
+
+	vkCmdBeginRenderPass(cbuf, &rpass_info, VK_SUBPASS_CONTENTS_INLINE);
+
+	cbuf_draw_ranges(cbuf, width, height, layout, pipel,
+			 desc_set_ct, desc_sets, vbuf, ibuf,
+			 range_ct, first_indices, index_cts);
+
+	vkCmdEndRenderPass(cbuf);
+}
+
+void cbuf_record_ranges_dynamic(VkCommandBuffer cbuf,
+				struct DynRender *dr,
+				struct DynAttachment *color,
+				struct DynAttachment *depth,
+				uint32_t width, uint32_t height,
+				VkPipelineLayout layout,
+				VkPipeline pipel,
+				uint32_t desc_set_ct,
+				VkDescriptorSet *desc_sets,
+				VkBuffer vbuf, VkBuffer ibuf,
+				uint32_t range_ct,
+				uint32_t *first_indices, uint32_t *index_cts)
+{
+	dyn_render_begin(dr, cbuf, width, height, color, depth);
+
+	cbuf_draw_ranges(cbuf, width, height, layout, pipel,
+			 desc_set_ct, desc_sets, vbuf, ibuf,
+			 range_ct, first_indices, index_cts);
+
+	dyn_render_end(dr, cbuf);
 }
 
 void cbuf_begin_one_time(VkDevice device,
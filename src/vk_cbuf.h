@@ -2,6 +2,29 @@
 #define VK_CBUF_H_
 
 #include <vulkan/vulkan.h>
+#include <cglm/cglm.h>
+
+#include "vk_dyn_render.h"
+
+// Stages that can read a DrawPush
+#define DRAW_PUSH_STAGES (VK_SHADER_STAGE_VERTEX_BIT \
+			  | VK_SHADER_STAGE_FRAGMENT_BIT)
+
+/*
+ * Per-draw data passed as push constants, matching this block in shaders:
+ *
+ *     layout(push_constant) uniform Draw {
+ *             mat4 model;
+ *             uint material;
+ *     } draw;
+ *
+ * The material is an index into whatever the shaders keep materials in, like
+ * a Bindless table or a storage buffer.
+ */
+struct DrawPush {
+	mat4 model;
+	uint32_t material;
+};
 
 void create_cpool(VkDevice device, uint32_t queue_fam, VkCommandPool *cpool);
 
@@ -25,6 +48,104 @@ void create_cbuf(VkDevice device,
 		 uint32_t index_ct,
 		 VkCommandBuffer *cbuf);
 
+/*
+ * Same as create_cbuf, but only draws <index_ct> indices starting at
+ * <first_index>, for example to draw a single LOD out of a LodChain.
+ */
+void create_cbuf_range(VkDevice device,
+		       VkCommandPool cpool,
+		       VkRenderPass rpass,
+		       uint32_t clear_ct, VkClearValue *clears,
+		       VkFramebuffer fb,
+		       uint32_t width, uint32_t height,
+		       VkPipelineLayout layout,
+		       VkPipeline pipel,
+		       uint32_t desc_set_ct, VkDescriptorSet *desc_sets,
+		       VkBuffer vbuf, VkBuffer ibuf,
+		       uint32_t first_index, uint32_t index_ct,
+		       VkCommandBuffer *cbuf);
+
+/*
+ * Records a render pass drawing <range_ct> ranges of the index buffer into a
+ * command buffer that is already recording, for example the chunks that
+ * survived culling.
+ *
+ * Doesn't begin or end the command buffer, so more work can be recorded around
+ * the render pass.
+ */
+void cbuf_record_ranges(VkCommandBuffer cbuf,
+			VkRenderPass rpass,
+			uint32_t clear_ct, VkClearValue *clears,
+			VkFramebuffer fb,
+			uint32_t width, uint32_t height,
+			VkPipelineLayout layout,
+			VkPipeline pipel,
+			uint32_t desc_set_ct, VkDescriptorSet *desc_sets,
+			VkBuffer vbuf, VkBuffer ibuf,
+			uint32_t range_ct,
+			uint32_t *first_indices, uint32_t *index_cts);
+
+/*
+ * Records what cbuf_record_ranges does inside its render pass: viewport,
+ * scissor, bindings and draws. For recording into a render pass or rendering
+ * scope begun by someone else (like a RenderGraph pass).
+ */
+void cbuf_draw_ranges(VkCommandBuffer cbuf,
+		      uint32_t width, uint32_t height,
+		      VkPipelineLayout layout,
+		      VkPipeline pipel,
+		      uint32_t desc_set_ct, VkDescriptorSet *desc_sets,
+		      VkBuffer vbuf, VkBuffer ibuf,
+		      uint32_t range_ct,
+		      uint32_t *first_indices, uint32_t *index_cts);
+
+/*
+ * Fills in the push-constant range for a DrawPush, for create_layout.
+ */
+void draw_push_range(VkPushConstantRange *range);
+
+/*
+ * Pushes <push> for the following draws. The layout must have been created
+ * with draw_push_range.
+ */
+void cbuf_push_draw(VkCommandBuffer cbuf, VkPipelineLayout layout,
+		    struct DrawPush *push);
+
+/*
+ * Same as cbuf_draw_ranges, but pushes pushes[i] before drawing range i, so
+ * each range gets its own model matrix and material without touching a
+ * buffer. The layout must have been created with draw_push_range.
+ */
+void cbuf_draw_ranges_pushed(VkCommandBuffer cbuf,
+			     uint32_t width, uint32_t height,
+			     VkPipelineLayout layout,
+			     VkPipeline pipel,
+			     uint32_t desc_set_ct, VkDescriptorSet *desc_sets,
+			     VkBuffer vbuf, VkBuffer ibuf,
+			     uint32_t range_ct,
+			     uint32_t *first_indices, uint32_t *index_cts,
+			     struct DrawPush *pushes);
+
+/*
+ * Same as cbuf_record_ranges, but with dynamic rendering instead of a render
+ * pass and framebuffer. The attachments must already be in the layouts they
+ * name.
+ *
+ * depth: Can be NULL
+ */
+void cbuf_record_ranges_dynamic(VkCommandBuffer cbuf,
+				struct DynRender *dr,
+				struct DynAttachment *color,
+				struct DynAttachment *depth,
+				uint32_t width, uint32_t height,
+				VkPipelineLayout layout,
+				VkPipeline pipel,
+				uint32_t desc_set_ct,
+				VkDescriptorSet *desc_sets,
+				VkBuffer vbuf, VkBuffer ibuf,
+				uint32_t range_ct,
+				uint32_t *first_indices, uint32_t *index_cts);
+
 /*
  * Allocate a command buffer for one-time use and begin recording.
  */
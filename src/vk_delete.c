@@ -0,0 +1,163 @@
+#include "vk_delete.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static void push(struct DeletionQueue *dq, struct Deletion del)
+{
+	if (dq->ct == dq->cap) {
+		dq->cap *= 2;
+		dq->entries = realloc(dq->entries,
+				      sizeof(dq->entries[0]) * dq->cap);
+		assert(dq->entries != NULL);
+	}
+
+	dq->entries[dq->ct++] = del;
+}
+
+static void destroy_entry(VkDevice device, struct Deletion del)
+{
+	if (del.fn != NULL) {
+		del.fn(device, del.data);
+		free(del.data);
+		return;
+	}
+
+	// Non-dispatchable handles are 64-bit on every platform, but only
+	// pointers on 64-bit ones, so go through the integer type
+	switch (del.type) {
+	case VK_OBJECT_TYPE_BUFFER:
+		vkDestroyBuffer(device, (VkBuffer) del.handle, NULL);
+		break;
+	case VK_OBJECT_TYPE_DEVICE_MEMORY:
+		vkFreeMemory(device, (VkDeviceMemory) del.handle, NULL);
+		break;
+	case VK_OBJECT_TYPE_IMAGE:
+		vkDestroyImage(device, (VkImage) del.handle, NULL);
+		break;
+	case VK_OBJECT_TYPE_IMAGE_VIEW:
+		vkDestroyImageView(device, (VkImageView) del.handle, NULL);
+		break;
+	case VK_OBJECT_TYPE_SAMPLER:
+		vkDestroySampler(device, (VkSampler) del.handle, NULL);
+		break;
+	case VK_OBJECT_TYPE_FRAMEBUFFER:
+		vkDestroyFramebuffer(device, (VkFramebuffer) del.handle, NULL);
+		break;
+	case VK_OBJECT_TYPE_RENDER_PASS:
+		vkDestroyRenderPass(device, (VkRenderPass) del.handle, NULL);
+		break;
+	case VK_OBJECT_TYPE_PIPELINE:
+		vkDestroyPipeline(device, (VkPipeline) del.handle, NULL);
+		break;
+	case VK_OBJECT_TYPE_PIPELINE_LAYOUT:
+		vkDestroyPipelineLayout(device, (VkPipelineLayout) del.handle,
+					NULL);
+		break;
+	case VK_OBJECT_TYPE_DESCRIPTOR_POOL:
+		vkDestroyDescriptorPool(device, (VkDescriptorPool) del.handle,
+					NULL);
+		break;
+	case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT:
+		vkDestroyDescriptorSetLayout(device,
+					     (VkDescriptorSetLayout) del.handle,
+					     NULL);
+		break;
+	case VK_OBJECT_TYPE_SEMAPHORE:
+		vkDestroySemaphore(device, (VkSemaphore) del.handle, NULL);
+		break;
+	case VK_OBJECT_TYPE_FENCE:
+		vkDestroyFence(device, (VkFence) del.handle, NULL);
+		break;
+	case VK_OBJECT_TYPE_SWAPCHAIN_KHR:
+		vkDestroySwapchainKHR(device, (VkSwapchainKHR) del.handle, NULL);
+		break;
+	default:
+		assert(0 && "Unsupported object type");
+	}
+}
+
+void deletion_queue_create(struct DeletionQueue *dq)
+{
+	dq->ct = 0;
+	dq->cap = DELETION_QUEUE_INIT_CAP;
+	dq->entries = malloc(sizeof(dq->entries[0]) * dq->cap);
+}
+
+void deletion_queue_destroy(VkDevice device, struct DeletionQueue dq)
+{
+	for (uint32_t i = 0; i < dq.ct; i++) {
+		destroy_entry(device, dq.entries[i]);
+	}
+
+	free(dq.entries);
+}
+
+void deletion_queue_push(struct DeletionQueue *dq, uint64_t value,
+			 VkObjectType type, uint64_t handle)
+{
+	if (handle == 0) return;
+
+	struct Deletion del = {0};
+	del.value = value;
+	del.type = type;
+	del.handle = handle;
+
+	push(dq, del);
+}
+
+void deletion_queue_push_fn(struct DeletionQueue *dq, uint64_t value,
+			    DeletionFn fn, size_t size, void *data)
+{
+	struct Deletion del = {0};
+	del.value = value;
+	del.fn = fn;
+	del.data = malloc(size);
+	memcpy(del.data, data, size);
+
+	push(dq, del);
+}
+
+void deletion_queue_push_buffer(struct DeletionQueue *dq, uint64_t value,
+				struct Buffer buf)
+{
+	deletion_queue_push(dq, value, VK_OBJECT_TYPE_BUFFER,
+			    (uint64_t) buf.handle);
+	deletion_queue_push(dq, value, VK_OBJECT_TYPE_DEVICE_MEMORY,
+			    (uint64_t) buf.memory);
+}
+
+void deletion_queue_push_image(struct DeletionQueue *dq, uint64_t value,
+			       struct Image image)
+{
+	// View first, as it refers to the image
+	deletion_queue_push(dq, value, VK_OBJECT_TYPE_IMAGE_VIEW,
+			    (uint64_t) image.view);
+	deletion_queue_push(dq, value, VK_OBJECT_TYPE_IMAGE,
+			    (uint64_t) image.handle);
+	deletion_queue_push(dq, value, VK_OBJECT_TYPE_DEVICE_MEMORY,
+			    (uint64_t) image.memory);
+}
+
+uint32_t deletion_queue_collect(VkDevice device, struct DeletionQueue *dq,
+				uint64_t completed)
+{
+	// Keep the survivors in push order, so things are always destroyed
+	// before what they depend on
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < dq->ct; i++) {
+		struct Deletion del = dq->entries[i];
+
+		if (del.value <= completed) {
+			destroy_entry(device, del);
+		} else {
+			dq->entries[kept++] = del;
+		}
+	}
+
+	uint32_t destroyed = dq->ct - kept;
+	dq->ct = kept;
+
+	return destroyed;
+}
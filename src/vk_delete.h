@@ -0,0 +1,83 @@
+#ifndef VK_DELETE_H_
+#define VK_DELETE_H_
+
+#include <stddef.h>
+
+#include <vulkan/vulkan.h>
+
+#include "vk_buffer.h"
+#include "vk_image.h"
+
+#define DELETION_QUEUE_INIT_CAP 16
+
+// Destroys whatever <data> describes. <data> is freed by the queue afterwards.
+typedef void (*DeletionFn) (VkDevice device, void *data);
+
+struct Deletion {
+	// Timeline value (frame) that has to complete before destruction
+	uint64_t value;
+
+	// Either a single handle of a type supported by deletion_queue_push...
+	VkObjectType type;
+	uint64_t handle;
+
+	// ...or a callback, if fn is not NULL
+	DeletionFn fn;
+	void *data;
+};
+
+/*
+ * Resources that are no longer needed on the host but might still be in use by
+ * the GPU. Each is tagged with the timeline value (see FrameScheduler) of the
+ * last frame that used it, and is destroyed once that value has completed,
+ * instead of waiting for the device to go idle.
+ */
+struct DeletionQueue {
+	uint32_t ct;
+	uint32_t cap;
+	struct Deletion *entries;
+};
+
+void deletion_queue_create(struct DeletionQueue *dq);
+
+/*
+ * Destroys everything left in the queue immediately. The device must no
+ * longer be using any of it.
+ */
+void deletion_queue_destroy(VkDevice device, struct DeletionQueue dq);
+
+/*
+ * Queues a single handle for destruction.
+ *
+ * type: One of BUFFER, DEVICE_MEMORY, IMAGE, IMAGE_VIEW, SAMPLER,
+ *       FRAMEBUFFER, RENDER_PASS, PIPELINE, PIPELINE_LAYOUT,
+ *       DESCRIPTOR_POOL, DESCRIPTOR_SET_LAYOUT, SEMAPHORE, FENCE or
+ *       SWAPCHAIN_KHR
+ * handle: The handle, cast to uint64_t
+ */
+void deletion_queue_push(struct DeletionQueue *dq, uint64_t value,
+			 VkObjectType type, uint64_t handle);
+
+/*
+ * Queues a call to <fn> with a copy of the <size> bytes at <data>, for
+ * resources that aren't a single handle.
+ */
+void deletion_queue_push_fn(struct DeletionQueue *dq, uint64_t value,
+			    DeletionFn fn, size_t size, void *data);
+
+void deletion_queue_push_buffer(struct DeletionQueue *dq, uint64_t value,
+				struct Buffer buf);
+
+void deletion_queue_push_image(struct DeletionQueue *dq, uint64_t value,
+			       struct Image image);
+
+/*
+ * Destroys everything tagged with a value up to and including <completed>,
+ * and returns how many entries were destroyed.
+ *
+ * completed: Usually frame_sched_completed
+ */
+uint32_t deletion_queue_collect(VkDevice device, struct DeletionQueue *dq,
+				uint64_t completed);
+
+#endif // VK_DELETE_H_
@@ -0,0 +1,315 @@
+#include "vk_desc.h"
+#include "vk_uniform.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Starting number of slots in a LayoutCache
+#define LAYOUT_CACHE_INITIAL_CAP 16
+
+// Descriptors of each type a DescAllocator pool has room for, per set
+static const VkDescriptorPoolSize pool_ratios[] = {
+	{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2},
+	{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4},
+	{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2},
+	{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1}
+};
+
+// Returns how many descriptors of <type> a pool has room for per set, 0 if
+// the type isn't in pool_ratios
+static uint32_t pool_ratio(VkDescriptorType type)
+{
+	uint32_t size_ct = sizeof(pool_ratios) / sizeof(pool_ratios[0]);
+	for (uint32_t i = 0; i < size_ct; i++) {
+		if (pool_ratios[i].type == type) {
+			return pool_ratios[i].descriptorCount;
+		}
+	}
+
+	return 0;
+}
+
+// FNV-1a. Keys are zeroed before being filled in, so padding hashes the same.
+static uint64_t hash_key(const struct LayoutKey *key)
+{
+	const unsigned char *bytes = (const unsigned char *) key;
+	uint64_t hash = 0xcbf29ce484222325;
+
+	for (size_t i = 0; i < sizeof(*key); i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3;
+	}
+
+	return hash;
+}
+
+// Returns the slot holding <key>, or the empty slot it would go in
+static uint32_t find_slot(struct LayoutCache *cache,
+			  const struct LayoutKey *key, uint64_t hash)
+{
+	uint32_t mask = cache->cap - 1;
+	uint32_t i = hash & mask;
+
+	while (cache->entries[i].layout != VK_NULL_HANDLE) {
+		struct LayoutEntry *entry = &cache->entries[i];
+		if (entry->hash == hash
+		    && memcmp(&entry->key, key, sizeof(*key)) == 0) {
+			break;
+		}
+
+		i = (i + 1) & mask;
+	}
+
+	return i;
+}
+
+static void alloc_entries(uint32_t cap, struct LayoutCache *cache)
+{
+	cache->cap = cap;
+	cache->entries = malloc(sizeof(cache->entries[0]) * cap);
+
+	for (uint32_t i = 0; i < cap; i++) {
+		cache->entries[i].layout = VK_NULL_HANDLE;
+	}
+}
+
+static void grow(struct LayoutCache *cache)
+{
+	uint32_t old_cap = cache->cap;
+	struct LayoutEntry *old_entries = cache->entries;
+
+	alloc_entries(old_cap * 2, cache);
+
+	for (uint32_t i = 0; i < old_cap; i++) {
+		struct LayoutEntry *entry = &old_entries[i];
+		if (entry->layout == VK_NULL_HANDLE) continue;
+
+		uint32_t slot = find_slot(cache, &entry->key, entry->hash);
+		cache->entries[slot] = *entry;
+	}
+
+	free(old_entries);
+}
+
+void layout_cache_create(struct LayoutCache *cache)
+{
+	cache->ct = 0;
+	alloc_entries(LAYOUT_CACHE_INITIAL_CAP, cache);
+
+	cache->hit_ct = 0;
+	cache->miss_ct = 0;
+}
+
+void layout_cache_destroy(VkDevice device, struct LayoutCache cache)
+{
+	for (uint32_t i = 0; i < cache.cap; i++) {
+		if (cache.entries[i].layout == VK_NULL_HANDLE) continue;
+
+		vkDestroyDescriptorSetLayout(device, cache.entries[i].layout,
+					     NULL);
+	}
+
+	free(cache.entries);
+}
+
+VkDescriptorSetLayout layout_cache_get(VkDevice device,
+				       struct LayoutCache *cache,
+				       uint32_t binding_ct,
+				       const VkDescriptorSetLayoutBinding *bindings)
+{
+	assert(binding_ct <= LAYOUT_CACHE_MAX_BINDINGS);
+
+	struct LayoutKey key;
+	memset(&key, 0, sizeof(key));
+	key.binding_ct = binding_ct;
+
+	// Insertion sort by binding number
+	for (uint32_t i = 0; i < binding_ct; i++) {
+		assert(bindings[i].pImmutableSamplers == NULL);
+
+		struct LayoutBinding b = {0};
+		b.binding = bindings[i].binding;
+		b.type = bindings[i].descriptorType;
+		b.count = bindings[i].descriptorCount;
+		b.stages = bindings[i].stageFlags;
+
+		uint32_t j = i;
+		while (j > 0 && key.bindings[j - 1].binding > b.binding) {
+			key.bindings[j] = key.bindings[j - 1];
+			j--;
+		}
+		key.bindings[j] = b;
+	}
+
+	// Every layout has to fit in a fresh DescAllocator pool, or
+	// desc_alloc_get would have nowhere left to try
+	for (uint32_t i = 0; i < binding_ct; i++) {
+		uint32_t total = 0;
+		for (uint32_t j = 0; j < binding_ct; j++) {
+			if (key.bindings[j].type == key.bindings[i].type) {
+				total += key.bindings[j].count;
+			}
+		}
+		assert(total <= pool_ratio(key.bindings[i].type));
+	}
+
+	uint64_t hash = hash_key(&key);
+	uint32_t slot = find_slot(cache, &key, hash);
+
+	struct LayoutEntry *entry = &cache->entries[slot];
+	if (entry->layout != VK_NULL_HANDLE) {
+		cache->hit_ct++;
+		return entry->layout;
+	}
+
+	cache->miss_ct++;
+
+	if ((cache->ct + 1) * 2 > cache->cap) {
+		grow(cache);
+		slot = find_slot(cache, &key, hash);
+	}
+
+	VkDescriptorSetLayoutBinding descs[LAYOUT_CACHE_MAX_BINDINGS];
+	for (uint32_t i = 0; i < binding_ct; i++) {
+		descs[i] = (VkDescriptorSetLayoutBinding) {0};
+		descs[i].binding = key.bindings[i].binding;
+		descs[i].descriptorType = key.bindings[i].type;
+		descs[i].descriptorCount = key.bindings[i].count;
+		descs[i].stageFlags = key.bindings[i].stages;
+	}
+
+	entry = &cache->entries[slot];
+	entry->key = key;
+	entry->hash = hash;
+	create_descriptor_layout(device, binding_ct, descs, &entry->layout);
+	cache->ct++;
+
+	return entry->layout;
+}
+
+static void pool_list_push(struct DescPoolList *list, VkDescriptorPool pool)
+{
+	if (list->ct == list->cap) {
+		list->cap = list->cap == 0 ? 4 : list->cap * 2;
+		list->pools = realloc(list->pools,
+				      sizeof(list->pools[0]) * list->cap);
+	}
+
+	list->pools[list->ct++] = pool;
+}
+
+// Adds a pool to the current slot, reusing a free one if there is any
+static VkDescriptorPool take_pool(VkDevice device, struct DescAllocator *alloc)
+{
+	VkDescriptorPool pool;
+
+	if (alloc->free.ct > 0) {
+		pool = alloc->free.pools[--alloc->free.ct];
+	} else {
+		uint32_t size_ct = sizeof(pool_ratios) / sizeof(pool_ratios[0]);
+		VkDescriptorPoolSize sizes[sizeof(pool_ratios)
+					   / sizeof(pool_ratios[0])];
+		for (uint32_t i = 0; i < size_ct; i++) {
+			sizes[i].type = pool_ratios[i].type;
+			sizes[i].descriptorCount =
+				pool_ratios[i].descriptorCount
+				* alloc->sets_per_pool;
+		}
+
+		VkDescriptorPoolCreateInfo info = {0};
+		info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		info.poolSizeCount = size_ct;
+		info.pPoolSizes = sizes;
+		info.maxSets = alloc->sets_per_pool;
+
+		VkResult res = vkCreateDescriptorPool(device, &info, NULL,
+						      &pool);
+		assert(res == VK_SUCCESS);
+
+		alloc->pool_ct++;
+	}
+
+	pool_list_push(&alloc->used[alloc->slot], pool);
+
+	return pool;
+}
+
+void desc_alloc_create(uint32_t frame_ct, uint32_t sets_per_pool,
+		       struct DescAllocator *alloc)
+{
+	assert(frame_ct > 0);
+	assert(sets_per_pool > 0);
+
+	alloc->sets_per_pool = sets_per_pool;
+	alloc->frame_ct = frame_ct;
+	alloc->slot = 0;
+	alloc->pool_ct = 0;
+
+	alloc->used = malloc(sizeof(alloc->used[0]) * frame_ct);
+	for (uint32_t i = 0; i < frame_ct; i++) {
+		alloc->used[i] = (struct DescPoolList) {0};
+	}
+	alloc->free = (struct DescPoolList) {0};
+}
+
+void desc_alloc_destroy(VkDevice device, struct DescAllocator alloc)
+{
+	for (uint32_t i = 0; i < alloc.frame_ct; i++) {
+		for (uint32_t j = 0; j < alloc.used[i].ct; j++) {
+			vkDestroyDescriptorPool(device, alloc.used[i].pools[j],
+						NULL);
+		}
+		free(alloc.used[i].pools);
+	}
+
+	for (uint32_t i = 0; i < alloc.free.ct; i++) {
+		vkDestroyDescriptorPool(device, alloc.free.pools[i], NULL);
+	}
+	free(alloc.free.pools);
+
+	free(alloc.used);
+}
+
+void desc_alloc_begin(VkDevice device, struct DescAllocator *alloc,
+		      uint32_t slot)
+{
+	assert(slot < alloc->frame_ct);
+	alloc->slot = slot;
+
+	struct DescPoolList *used = &alloc->used[slot];
+	for (uint32_t i = 0; i < used->ct; i++) {
+		VkResult res = vkResetDescriptorPool(device, used->pools[i], 0);
+		assert(res == VK_SUCCESS);
+
+		pool_list_push(&alloc->free, used->pools[i]);
+	}
+	used->ct = 0;
+}
+
+void desc_alloc_get(VkDevice device, struct DescAllocator *alloc,
+		    VkDescriptorSetLayout layout,
+		    VkDescriptorSet *set)
+{
+	struct DescPoolList *used = &alloc->used[alloc->slot];
+	VkDescriptorPool pool = used->ct > 0 ? used->pools[used->ct - 1]
+					     : take_pool(device, alloc);
+
+	VkDescriptorSetAllocateInfo info = {0};
+	info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	info.descriptorPool = pool;
+	info.descriptorSetCount = 1;
+	info.pSetLayouts = &layout;
+
+	VkResult res = vkAllocateDescriptorSets(device, &info, set);
+
+	// Full, so move on to another pool. A fresh one has room for any set
+	// whose layout came from a LayoutCache.
+	if (res == VK_ERROR_OUT_OF_POOL_MEMORY
+	    || res == VK_ERROR_FRAGMENTED_POOL) {
+		info.descriptorPool = take_pool(device, alloc);
+		res = vkAllocateDescriptorSets(device, &info, set);
+	}
+
+	assert(res == VK_SUCCESS);
+}
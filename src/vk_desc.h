@@ -0,0 +1,136 @@
+#ifndef VK_DESC_H_
+#define VK_DESC_H_
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+// Most bindings a cached layout can have
+#define LAYOUT_CACHE_MAX_BINDINGS 16
+
+// Default for how many sets each pool of a DescAllocator holds
+#define DESC_ALLOC_DEFAULT_SETS 64
+
+struct LayoutBinding {
+	uint32_t binding;
+	VkDescriptorType type;
+	uint32_t count;
+	VkShaderStageFlags stages;
+};
+
+struct LayoutKey {
+	uint32_t binding_ct;
+	// Sorted by binding number, unused ones zeroed, so keys can be compared
+	// whole
+	struct LayoutBinding bindings[LAYOUT_CACHE_MAX_BINDINGS];
+};
+
+struct LayoutEntry {
+	struct LayoutKey key;
+	uint64_t hash;
+	// VK_NULL_HANDLE for empty slots
+	VkDescriptorSetLayout layout;
+};
+
+/*
+ * Descriptor set layouts keyed on their bindings, so sets with the same
+ * bindings share one layout instead of each creating their own.
+ *
+ * An open-addressed hash table. Layouts are small and live as long as the
+ * cache, so nothing is ever evicted. Bindings with immutable samplers or
+ * flags aren't supported.
+ *
+ * So that any set can come from a DescAllocator, a layout may only have
+ * uniform buffers (up to 2), combined image samplers (up to 4), storage
+ * buffers (up to 2) and storage images (up to 1).
+ */
+struct LayoutCache {
+	uint32_t ct;
+	// Power of two, at least twice ct
+	uint32_t cap;
+	struct LayoutEntry *entries;
+
+	uint64_t hit_ct;
+	uint64_t miss_ct;
+};
+
+void layout_cache_create(struct LayoutCache *cache);
+
+/*
+ * Destroys every layout in the cache. Nothing may still be using them.
+ */
+void layout_cache_destroy(VkDevice device, struct LayoutCache cache);
+
+/*
+ * Returns the layout with these bindings, in any order, creating it if
+ * needed. The layout belongs to the cache.
+ */
+VkDescriptorSetLayout layout_cache_get(VkDevice device,
+				       struct LayoutCache *cache,
+				       uint32_t binding_ct,
+				       const VkDescriptorSetLayoutBinding *bindings);
+
+struct DescPoolList {
+	uint32_t ct;
+	uint32_t cap;
+	VkDescriptorPool *pools;
+};
+
+/*
+ * Hands out descriptor sets that only live for one frame.
+ *
+ * Each frame-in-flight slot has its own list of pools. Sets come from the
+ * last pool in the current slot's list; when it runs out, another pool is
+ * added, reusing a free one if there is any. Beginning a slot again resets
+ * all of its pools at once (a single vkResetDescriptorPool each, however many
+ * sets were allocated) and puts them back on the free list, so sets never
+ * have to be freed one by one and the pools grow to fit the busiest frame.
+ */
+struct DescAllocator {
+	uint32_t sets_per_pool;
+	uint32_t frame_ct;
+	// Slot sets are currently allocated for
+	uint32_t slot;
+
+	struct DescPoolList *used;
+	struct DescPoolList free;
+
+	// Pools created over the allocator's lifetime
+	uint32_t pool_ct;
+};
+
+/*
+ * Creates the allocator, without any pools yet. Mallocs.
+ *
+ * frame_ct: Frames in flight, like FrameScheduler's
+ * sets_per_pool: Sets each pool holds, like DESC_ALLOC_DEFAULT_SETS. Each
+ *                pool has room for a few of every common descriptor type per
+ *                set.
+ */
+void desc_alloc_create(uint32_t frame_ct, uint32_t sets_per_pool,
+		       struct DescAllocator *alloc);
+
+/*
+ * Destroys every pool, freeing every set. Nothing may still be using them.
+ */
+void desc_alloc_destroy(VkDevice device, struct DescAllocator alloc);
+
+/*
+ * Starts allocating for frame-in-flight <slot>, resetting every pool it used
+ * last time. The frame that last used the slot must have finished (like after
+ * frame_sched_begin or sync_pool_acquire).
+ */
+void desc_alloc_begin(VkDevice device, struct DescAllocator *alloc,
+		      uint32_t slot);
+
+/*
+ * Allocates a set for the current slot. It stays valid until the slot is
+ * begun again.
+ *
+ * layout: From a LayoutCache, which makes sure a set fits in one pool
+ */
+void desc_alloc_get(VkDevice device, struct DescAllocator *alloc,
+		    VkDescriptorSetLayout layout,
+		    VkDescriptorSet *set);
+
+#endif // VK_DESC_H_
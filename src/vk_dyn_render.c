@@ -0,0 +1,83 @@
+#include "vk_dyn_render.h"
+#include "vk_tools.h"
+
+#include <assert.h>
+
+int dyn_render_supported(VkPhysicalDevice phys_dev)
+{
+	char *exts[] = {
+		VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME
+	};
+	if (check_dev_exts(phys_dev, ARRAY_SIZE(exts), exts) != 0) return 0;
+
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dyn_features = {0};
+	dyn_features.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+	VkPhysicalDeviceFeatures2 features = {0};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &dyn_features;
+	vkGetPhysicalDeviceFeatures2(phys_dev, &features);
+
+	return dyn_features.dynamicRendering == VK_TRUE;
+}
+
+int dyn_render_load(VkPhysicalDevice phys_dev, VkDevice device,
+		    struct DynRender *dr)
+{
+	if (!dyn_render_supported(phys_dev)) return 1;
+
+	dr->begin_rendering = (PFN_vkCmdBeginRenderingKHR)
+		vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR");
+	dr->end_rendering = (PFN_vkCmdEndRenderingKHR)
+		vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR");
+
+	if (dr->begin_rendering == NULL || dr->end_rendering == NULL) return 1;
+
+	return 0;
+}
+
+static void fill_attachment(struct DynAttachment *attachment,
+			    VkRenderingAttachmentInfoKHR *info)
+{
+	*info = (VkRenderingAttachmentInfoKHR) {0};
+	info->sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+	info->imageView = attachment->view;
+	info->imageLayout = attachment->layout;
+	info->resolveMode = VK_RESOLVE_MODE_NONE;
+	info->loadOp = attachment->load_op;
+	info->storeOp = attachment->store_op;
+	info->clearValue = attachment->clear;
+}
+
+void dyn_render_begin(struct DynRender *dr, VkCommandBuffer cbuf,
+		      uint32_t width, uint32_t height,
+		      struct DynAttachment *color,
+		      struct DynAttachment *depth)
+{
+	assert(color != NULL);
+
+	VkRenderingAttachmentInfoKHR color_info;
+	fill_attachment(color, &color_info);
+
+	VkRenderingAttachmentInfoKHR depth_info;
+	if (depth != NULL) fill_attachment(depth, &depth_info);
+
+	VkRenderingInfoKHR info = {0};
+	info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+	info.renderArea.offset.x = 0;
+	info.renderArea.offset.y = 0;
+	info.renderArea.extent.width = width;
+	info.renderArea.extent.height = height;
+	info.layerCount = 1;
+	info.colorAttachmentCount = 1;
+	info.pColorAttachments = &color_info;
+	info.pDepthAttachment = depth != NULL ? &depth_info : NULL;
+
+	dr->begin_rendering(cbuf, &info);
+}
+
+void dyn_render_end(struct DynRender *dr, VkCommandBuffer cbuf)
+{
+	dr->end_rendering(cbuf);
+}
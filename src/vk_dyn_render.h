@@ -0,0 +1,58 @@
+#ifndef VK_DYN_RENDER_H_
+#define VK_DYN_RENDER_H_
+
+#include <vulkan/vulkan.h>
+
+/*
+ * VK_KHR_dynamic_rendering: rendering straight into image views, with no
+ * VkRenderPass or VkFramebuffer objects. Attachments are named when recording
+ * instead, so nothing has to be rebuilt when they're recreated (on resize, for
+ * example).
+ *
+ * Without a render pass nothing transitions layouts either, so images have to
+ * be put in the layouts given here with barriers (see image_transition_cmd).
+ *
+ * create_device and create_device_queues enable the extension whenever the
+ * device supports it.
+ */
+struct DynRender {
+	// Extension commands aren't exported by the loader
+	PFN_vkCmdBeginRenderingKHR begin_rendering;
+	PFN_vkCmdEndRenderingKHR end_rendering;
+};
+
+struct DynAttachment {
+	VkImageView view;
+	// Layout the image is in while rendering, like
+	// COLOR_ATTACHMENT_OPTIMAL
+	VkImageLayout layout;
+	VkAttachmentLoadOp load_op;
+	VkAttachmentStoreOp store_op;
+	// Only used with VK_ATTACHMENT_LOAD_OP_CLEAR
+	VkClearValue clear;
+};
+
+/*
+ * Returns 1 if the device has the extension and the feature, 0 otherwise.
+ */
+int dyn_render_supported(VkPhysicalDevice phys_dev);
+
+/*
+ * Loads the commands. Returns 0 on success, or 1 if the device doesn't support
+ * dynamic rendering, in which case the render pass path has to be used.
+ */
+int dyn_render_load(VkPhysicalDevice phys_dev, VkDevice device,
+		    struct DynRender *dr);
+
+/*
+ * Begins rendering to <color> and (if not NULL) <depth>, covering the whole
+ * width x height area.
+ */
+void dyn_render_begin(struct DynRender *dr, VkCommandBuffer cbuf,
+		      uint32_t width, uint32_t height,
+		      struct DynAttachment *color,
+		      struct DynAttachment *depth);
+
+void dyn_render_end(struct DynRender *dr, VkCommandBuffer cbuf);
+
+#endif // VK_DYN_RENDER_H_
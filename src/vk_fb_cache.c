@@ -0,0 +1,255 @@
+#include "vk_fb_cache.h"
+#include "vk_window.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// FNV-1a. Keys are zeroed before being filled in, so padding hashes the same.
+static uint64_t hash_key(const struct FbKey *key)
+{
+	const unsigned char *bytes = (const unsigned char *) key;
+	uint64_t hash = 0xcbf29ce484222325;
+
+	for (size_t i = 0; i < sizeof(*key); i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3;
+	}
+
+	return hash;
+}
+
+// Returns the slot holding <key>, or the empty slot it would go in
+static uint32_t find_slot(struct FbCache *cache, const struct FbKey *key,
+			  uint64_t hash)
+{
+	uint32_t mask = cache->cap - 1;
+	uint32_t i = hash & mask;
+
+	while (cache->entries[i].fb != VK_NULL_HANDLE) {
+		struct FbEntry *entry = &cache->entries[i];
+		if (entry->hash == hash
+		    && memcmp(&entry->key, key, sizeof(*key)) == 0) {
+			break;
+		}
+
+		i = (i + 1) & mask;
+	}
+
+	return i;
+}
+
+// Empties a slot, moving later entries in its probe run back so lookups don't
+// stop early at the gap
+static void remove_slot(struct FbCache *cache, uint32_t i)
+{
+	uint32_t mask = cache->cap - 1;
+	cache->entries[i].fb = VK_NULL_HANDLE;
+	cache->ct--;
+
+	uint32_t j = i;
+	while (1) {
+		j = (j + 1) & mask;
+		struct FbEntry *entry = &cache->entries[j];
+		if (entry->fb == VK_NULL_HANDLE) break;
+
+		// Leave entries whose home slot is after the gap
+		uint32_t home = entry->hash & mask;
+		int after_gap = i <= j ? (i < home && home <= j)
+				       : (i < home || home <= j);
+		if (after_gap) continue;
+
+		cache->entries[i] = *entry;
+		entry->fb = VK_NULL_HANDLE;
+		i = j;
+	}
+}
+
+static void alloc_entries(uint32_t cap, struct FbCache *cache)
+{
+	cache->cap = cap;
+	cache->entries = malloc(sizeof(cache->entries[0]) * cap);
+
+	for (uint32_t i = 0; i < cap; i++) {
+		cache->entries[i].fb = VK_NULL_HANDLE;
+	}
+}
+
+static void grow(struct FbCache *cache)
+{
+	uint32_t old_cap = cache->cap;
+	struct FbEntry *old_entries = cache->entries;
+
+	alloc_entries(old_cap * 2, cache);
+
+	for (uint32_t i = 0; i < old_cap; i++) {
+		struct FbEntry *entry = &old_entries[i];
+		if (entry->fb == VK_NULL_HANDLE) continue;
+
+		uint32_t slot = find_slot(cache, &entry->key, entry->hash);
+		cache->entries[slot] = *entry;
+	}
+
+	free(old_entries);
+}
+
+static void retire(VkDevice device, struct DeletionQueue *dq, uint64_t value,
+		   VkFramebuffer fb)
+{
+	if (dq == NULL) {
+		vkDestroyFramebuffer(device, fb, NULL);
+	} else {
+		deletion_queue_push(dq, value, VK_OBJECT_TYPE_FRAMEBUFFER,
+				    (uint64_t) fb);
+	}
+}
+
+// Evicts the least recently used unpinned framebuffer. Returns 1 if there
+// wasn't one.
+static int evict_lru(VkDevice device, struct FbCache *cache,
+		     struct DeletionQueue *dq)
+{
+	uint32_t lru = cache->cap;
+	for (uint32_t i = 0; i < cache->cap; i++) {
+		struct FbEntry *entry = &cache->entries[i];
+		if (entry->fb == VK_NULL_HANDLE || entry->pinned) continue;
+
+		if (lru == cache->cap
+		    || entry->last_use < cache->entries[lru].last_use) {
+			lru = i;
+		}
+	}
+
+	if (lru == cache->cap) return 1;
+
+	struct FbEntry *entry = &cache->entries[lru];
+	retire(device, dq, entry->last_use, entry->fb);
+	remove_slot(cache, lru);
+	cache->evict_ct++;
+
+	return 0;
+}
+
+void fb_cache_create(uint32_t max_ct, struct FbCache *cache)
+{
+	assert(max_ct > 0);
+
+	uint32_t cap = 1;
+	while (cap < max_ct * 2) cap *= 2;
+
+	cache->max_ct = max_ct;
+	cache->ct = 0;
+	alloc_entries(cap, cache);
+
+	cache->hit_ct = 0;
+	cache->miss_ct = 0;
+	cache->evict_ct = 0;
+}
+
+void fb_cache_destroy(VkDevice device, struct FbCache cache)
+{
+	for (uint32_t i = 0; i < cache.cap; i++) {
+		if (cache.entries[i].fb == VK_NULL_HANDLE) continue;
+
+		vkDestroyFramebuffer(device, cache.entries[i].fb, NULL);
+	}
+
+	free(cache.entries);
+}
+
+VkFramebuffer fb_cache_get(VkDevice device,
+			   struct FbCache *cache,
+			   struct DeletionQueue *dq,
+			   uint64_t frame,
+			   VkRenderPass rpass,
+			   uint32_t view_ct, const VkImageView *views,
+			   uint32_t width, uint32_t height,
+			   int pin)
+{
+	assert(view_ct <= FB_CACHE_MAX_VIEWS);
+
+	struct FbKey key;
+	memset(&key, 0, sizeof(key));
+	key.rpass = rpass;
+	key.width = width;
+	key.height = height;
+	key.view_ct = view_ct;
+	for (uint32_t i = 0; i < view_ct; i++) {
+		key.views[i] = views[i];
+	}
+
+	uint64_t hash = hash_key(&key);
+	uint32_t slot = find_slot(cache, &key, hash);
+
+	struct FbEntry *entry = &cache->entries[slot];
+	if (entry->fb != VK_NULL_HANDLE) {
+		if (frame > entry->last_use) entry->last_use = frame;
+		if (pin) entry->pinned = 1;
+		cache->hit_ct++;
+
+		return entry->fb;
+	}
+
+	cache->miss_ct++;
+
+	// Make room. If everything is pinned, the table grows instead.
+	int moved = 0;
+	if (cache->ct >= cache->max_ct) {
+		moved = evict_lru(device, cache, dq) == 0;
+	}
+	if ((cache->ct + 1) * 2 > cache->cap) {
+		grow(cache);
+		moved = 1;
+	}
+	if (moved) slot = find_slot(cache, &key, hash);
+
+	entry = &cache->entries[slot];
+	entry->key = key;
+	entry->hash = hash;
+	entry->last_use = frame;
+	entry->pinned = pin != 0;
+	create_framebuffer(device, width, height, rpass,
+			   view_ct, key.views,
+			   &entry->fb);
+	cache->ct++;
+
+	return entry->fb;
+}
+
+uint32_t fb_cache_evict_view(VkDevice device,
+			     struct FbCache *cache,
+			     struct DeletionQueue *dq,
+			     uint64_t last_use,
+			     VkImageView view)
+{
+	uint32_t evicted = 0;
+
+	uint32_t i = 0;
+	while (i < cache->cap) {
+		struct FbEntry *entry = &cache->entries[i];
+
+		int uses_view = 0;
+		if (entry->fb != VK_NULL_HANDLE) {
+			for (uint32_t j = 0; j < entry->key.view_ct; j++) {
+				if (entry->key.views[j] == view) uses_view = 1;
+			}
+		}
+
+		if (!uses_view) {
+			i++;
+			continue;
+		}
+
+		uint64_t value = last_use > entry->last_use ? last_use
+							    : entry->last_use;
+		retire(device, dq, value, entry->fb);
+
+		// Removing can move another entry into this slot, so check it
+		// again
+		remove_slot(cache, i);
+		cache->evict_ct++;
+		evicted++;
+	}
+
+	return evicted;
+}
@@ -0,0 +1,103 @@
+#ifndef VK_FB_CACHE_H_
+#define VK_FB_CACHE_H_
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "vk_delete.h"
+
+// Most attachments a cached framebuffer can have
+#define FB_CACHE_MAX_VIEWS 8
+// Default for how many framebuffers to keep before evicting
+#define FB_CACHE_DEFAULT_MAX 64
+
+struct FbKey {
+	VkRenderPass rpass;
+	uint32_t width;
+	uint32_t height;
+	uint32_t view_ct;
+	// Unused views are VK_NULL_HANDLE, so keys can be compared whole
+	VkImageView views[FB_CACHE_MAX_VIEWS];
+};
+
+struct FbEntry {
+	struct FbKey key;
+	uint64_t hash;
+	// VK_NULL_HANDLE for empty slots
+	VkFramebuffer fb;
+
+	// Timeline value (see FrameScheduler) of the last frame that asked for
+	// it
+	uint64_t last_use;
+	// Never evicted to make room, only by fb_cache_evict_view
+	int pinned;
+};
+
+/*
+ * Framebuffers keyed on (render pass, attachments, extent), so render targets
+ * and swapchain images share framebuffers instead of each building their own.
+ *
+ * An open-addressed hash table. Once it holds max_ct framebuffers, getting a
+ * new one evicts the least recently used unpinned one, which goes to a
+ * DeletionQueue so frames still using it aren't affected.
+ *
+ * Framebuffers don't keep their views alive, so before destroying a view, call
+ * fb_cache_evict_view; otherwise a new view could be given the same handle
+ * and match a framebuffer that refers to the destroyed one.
+ */
+struct FbCache {
+	uint32_t max_ct;
+	uint32_t ct;
+	// Power of two, at least twice max_ct
+	uint32_t cap;
+	struct FbEntry *entries;
+
+	uint64_t hit_ct;
+	uint64_t miss_ct;
+	uint64_t evict_ct;
+};
+
+/*
+ * max_ct: How many framebuffers to keep before evicting. Pinned framebuffers
+ *         beyond that make the table grow instead.
+ */
+void fb_cache_create(uint32_t max_ct, struct FbCache *cache);
+
+/*
+ * Destroys every framebuffer in the cache immediately. The device must no
+ * longer be using any of them.
+ */
+void fb_cache_destroy(VkDevice device, struct FbCache cache);
+
+/*
+ * Returns the framebuffer for the given render pass, attachments and extent,
+ * creating it if needed.
+ *
+ * dq: Where evicted framebuffers go. If NULL, they're destroyed immediately.
+ * frame: Timeline value of the frame the framebuffer will be used in
+ * pin: If not 0, the framebuffer is never evicted to make room
+ */
+VkFramebuffer fb_cache_get(VkDevice device,
+			   struct FbCache *cache,
+			   struct DeletionQueue *dq,
+			   uint64_t frame,
+			   VkRenderPass rpass,
+			   uint32_t view_ct, const VkImageView *views,
+			   uint32_t width, uint32_t height,
+			   int pin);
+
+/*
+ * Evicts every framebuffer (pinned or not) that has <view> as an attachment.
+ * Returns how many were evicted.
+ *
+ * dq: Where evicted framebuffers go. If NULL, they're destroyed immediately.
+ * last_use: Timeline value of the last frame that used the view
+ */
+uint32_t fb_cache_evict_view(VkDevice device,
+			     struct FbCache *cache,
+			     struct DeletionQueue *dq,
+			     uint64_t last_use,
+			     VkImageView view);
+
+#endif // VK_FB_CACHE_H_
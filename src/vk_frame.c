@@ -0,0 +1,113 @@
+#include "vk_frame.h"
+
+#include <assert.h>
+
+#include "vk_sync.h"
+
+void frame_sched_create(VkDevice device, uint32_t frames_in_flight,
+			struct FrameScheduler *sched)
+{
+	assert(frames_in_flight > 0);
+
+	sched->frames_in_flight = frames_in_flight;
+	sched->frame = 0;
+	sched->completed = 0;
+
+	create_timeline_sem(device, 0, &sched->timeline);
+}
+
+void frame_sched_destroy(VkDevice device, struct FrameScheduler sched)
+{
+	vkDestroySemaphore(device, sched.timeline, NULL);
+}
+
+uint64_t frame_sched_begin(VkDevice device, struct FrameScheduler *sched,
+			   uint32_t *slot)
+{
+	uint64_t frame = sched->frame + 1;
+
+	// The slot was last used frames_in_flight frames ago
+	if (frame > sched->frames_in_flight) {
+		frame_sched_wait(device, sched,
+				 frame - sched->frames_in_flight);
+	}
+
+	sched->frame = frame;
+
+	if (slot != NULL) {
+		*slot = frame % sched->frames_in_flight;
+	}
+
+	return frame;
+}
+
+void frame_sched_submit(VkQueue queue, struct FrameScheduler *sched,
+			VkSemaphore s_wait, VkSemaphore s_signal,
+			VkCommandBuffer cbuf)
+{
+	VkPipelineStageFlags wait_stage =
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+	// Values for binary semaphores are ignored, but the arrays still have
+	// to line up with the semaphore arrays
+	VkSemaphore signal_sems[] = {sched->timeline, s_signal};
+	uint64_t signal_values[] = {sched->frame, 0};
+	uint64_t wait_value = 0;
+
+	VkTimelineSemaphoreSubmitInfo timeline_info = {0};
+	timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timeline_info.waitSemaphoreValueCount = s_wait != VK_NULL_HANDLE;
+	timeline_info.pWaitSemaphoreValues = &wait_value;
+	timeline_info.signalSemaphoreValueCount =
+		s_signal != VK_NULL_HANDLE ? 2 : 1;
+	timeline_info.pSignalSemaphoreValues = signal_values;
+
+	VkSubmitInfo submit_info = {0};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.pNext = &timeline_info;
+	submit_info.waitSemaphoreCount = s_wait != VK_NULL_HANDLE;
+	submit_info.pWaitSemaphores = &s_wait;
+	submit_info.pWaitDstStageMask = &wait_stage;
+	submit_info.commandBufferCount = cbuf != VK_NULL_HANDLE;
+	submit_info.pCommandBuffers = &cbuf;
+	submit_info.signalSemaphoreCount = timeline_info.signalSemaphoreValueCount;
+	submit_info.pSignalSemaphores = signal_sems;
+
+	VkResult res = vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE);
+	assert(res == VK_SUCCESS);
+}
+
+uint64_t frame_sched_completed(VkDevice device, struct FrameScheduler *sched)
+{
+	uint64_t value;
+	VkResult res = vkGetSemaphoreCounterValue(device, sched->timeline,
+						  &value);
+	assert(res == VK_SUCCESS);
+
+	sched->completed = value;
+
+	return value;
+}
+
+void frame_sched_wait(VkDevice device, struct FrameScheduler *sched,
+		      uint64_t value)
+{
+	// Skip the call entirely if we already know it's done
+	if (value <= sched->completed) return;
+
+	VkSemaphoreWaitInfo info = {0};
+	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	info.semaphoreCount = 1;
+	info.pSemaphores = &sched->timeline;
+	info.pValues = &value;
+
+	VkResult res = vkWaitSemaphores(device, &info, UINT64_MAX);
+	assert(res == VK_SUCCESS);
+
+	sched->completed = value;
+}
+
+void frame_sched_wait_idle(VkDevice device, struct FrameScheduler *sched)
+{
+	frame_sched_wait(device, sched, sched->frame);
+}
@@ -0,0 +1,73 @@
+#ifndef VK_FRAME_H_
+#define VK_FRAME_H_
+
+#include <vulkan/vulkan.h>
+
+/*
+ * Paces frames in flight with a single timeline semaphore. Frame N signals the
+ * value N when it finishes executing, so waiting for a frame is a wait on its
+ * value, and anything tagged with a frame's value can be reused once the
+ * semaphore has reached it. There are no fences to reset.
+ *
+ * Frames are numbered from 1; 0 means "no frame".
+ */
+struct FrameScheduler {
+	VkSemaphore timeline;
+	uint32_t frames_in_flight;
+
+	// Value of the last frame begun
+	uint64_t frame;
+	// Highest value the timeline is known to have reached
+	uint64_t completed;
+};
+
+void frame_sched_create(VkDevice device, uint32_t frames_in_flight,
+			struct FrameScheduler *sched);
+
+void frame_sched_destroy(VkDevice device, struct FrameScheduler sched);
+
+/*
+ * Begins a new frame, waiting until the frame that last used the same slot has
+ * finished executing. Returns the new frame's value.
+ *
+ * Every frame begun has to be submitted, in order, or waits on it will never
+ * return. To drop a frame, submit it with no command buffer.
+ *
+ * slot: If not NULL, receives the index (less than frames_in_flight) of the
+ *       per-frame resources to use
+ */
+uint64_t frame_sched_begin(VkDevice device, struct FrameScheduler *sched,
+			   uint32_t *slot);
+
+/*
+ * Submits the current frame's command buffer, signalling the timeline with the
+ * frame's value when it finishes.
+ *
+ * s_wait: Binary semaphore to wait on at COLOR_ATTACHMENT_OUTPUT (usually
+ *         image available semaphore), or VK_NULL_HANDLE
+ * s_signal: Binary semaphore to signal as well (usually for presentation to
+ *           wait on), or VK_NULL_HANDLE
+ * cbuf: Can be VK_NULL_HANDLE, in which case only the semaphores are used
+ */
+void frame_sched_submit(VkQueue queue, struct FrameScheduler *sched,
+			VkSemaphore s_wait, VkSemaphore s_signal,
+			VkCommandBuffer cbuf);
+
+/*
+ * Returns the value of the last frame that has finished executing, without
+ * blocking.
+ */
+uint64_t frame_sched_completed(VkDevice device, struct FrameScheduler *sched);
+
+/*
+ * Blocks until frame <value> has finished executing.
+ */
+void frame_sched_wait(VkDevice device, struct FrameScheduler *sched,
+		      uint64_t value);
+
+/*
+ * Blocks until every frame begun so far has finished executing.
+ */
+void frame_sched_wait_idle(VkDevice device, struct FrameScheduler *sched);
+
+#endif // VK_FRAME_H_
@@ -0,0 +1,631 @@
+#include "vk_graph.h"
+#include "vk_image.h"
+#include "ll_vk_image.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+// Accesses whose results have to be made available to later ones
+#define WRITE_ACCESS (VK_ACCESS_SHADER_WRITE_BIT \
+		      | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT \
+		      | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT \
+		      | VK_ACCESS_TRANSFER_WRITE_BIT \
+		      | VK_ACCESS_HOST_WRITE_BIT \
+		      | VK_ACCESS_MEMORY_WRITE_BIT)
+
+// What a GraphUsage means for the image
+struct UsageInfo {
+	VkImageLayout layout;
+	VkPipelineStageFlags stage;
+	VkAccessFlags access;
+	VkImageUsageFlags image_usage;
+};
+
+static struct UsageInfo usage_info(enum GraphUsage usage,
+				   VkImageAspectFlags aspect)
+{
+	struct UsageInfo info = {0};
+
+	switch (usage) {
+	case GRAPH_USAGE_COLOR:
+		info.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		info.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		info.access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT
+			| VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		info.image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		break;
+	case GRAPH_USAGE_DEPTH:
+		info.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		info.stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+			| VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		info.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
+			| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		info.image_usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		break;
+	case GRAPH_USAGE_SAMPLED:
+		info.layout = (aspect & VK_IMAGE_ASPECT_DEPTH_BIT)
+			? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+			: VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		info.stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+			| VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		info.access = VK_ACCESS_SHADER_READ_BIT;
+		info.image_usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+		break;
+	case GRAPH_USAGE_STORAGE:
+		info.layout = VK_IMAGE_LAYOUT_GENERAL;
+		info.stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		info.access = VK_ACCESS_SHADER_READ_BIT
+			| VK_ACCESS_SHADER_WRITE_BIT;
+		info.image_usage = VK_IMAGE_USAGE_STORAGE_BIT;
+		break;
+	case GRAPH_USAGE_TRANSFER_SRC:
+		info.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		info.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		info.access = VK_ACCESS_TRANSFER_READ_BIT;
+		info.image_usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		break;
+	case GRAPH_USAGE_TRANSFER_DST:
+		info.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		info.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		info.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+		info.image_usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		break;
+	case GRAPH_USAGE_PRESENT:
+		// The present waits on a semaphore, which covers everything,
+		// so the barrier only has to change the layout
+		info.layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		info.stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		info.access = 0;
+		info.image_usage = 0;
+		break;
+	}
+
+	return info;
+}
+
+static int is_attachment(enum GraphUsage usage)
+{
+	return usage == GRAPH_USAGE_COLOR || usage == GRAPH_USAGE_DEPTH;
+}
+
+static struct GraphResource *add_resource(struct RenderGraph *graph)
+{
+	assert(graph->res_ct < GRAPH_MAX_RESOURCES);
+
+	struct GraphResource *res = &graph->resources[graph->res_ct];
+	*res = (struct GraphResource) {0};
+	res->first_pass = GRAPH_MAX_PASSES;
+
+	return res;
+}
+
+static void add_use(struct RenderGraph *graph, uint32_t pass, uint32_t res,
+		    enum GraphUsage usage, const VkClearValue *clear)
+{
+	assert(pass < graph->pass_ct);
+	assert(res < graph->res_ct);
+
+	struct GraphPass *p = &graph->passes[pass];
+	assert(p->use_ct < GRAPH_MAX_USES);
+
+	struct GraphUse *use = &p->uses[p->use_ct++];
+	*use = (struct GraphUse) {0};
+	use->res = res;
+	use->usage = usage;
+	if (clear != NULL) {
+		use->clear = 1;
+		use->clear_value = *clear;
+	}
+}
+
+void graph_create(struct RenderGraph *graph)
+{
+	graph->res_ct = 0;
+	graph->pass_ct = 0;
+	graph->slot_ct = 0;
+}
+
+uint32_t graph_import(struct RenderGraph *graph,
+		      VkImage image, VkImageView view,
+		      VkImageAspectFlags aspect,
+		      uint32_t width, uint32_t height,
+		      VkImageLayout initial_layout,
+		      VkPipelineStageFlags initial_stage,
+		      VkAccessFlags initial_access)
+{
+	struct GraphResource *res = add_resource(graph);
+	res->transient = 0;
+	res->image = image;
+	res->view = view;
+	res->aspect = aspect;
+	res->width = width;
+	res->height = height;
+	res->initial_layout = initial_layout;
+	res->initial_stage = initial_stage;
+	res->initial_access = initial_access;
+
+	return graph->res_ct++;
+}
+
+void graph_set_import(struct RenderGraph *graph, uint32_t res,
+		      VkImage image, VkImageView view,
+		      uint32_t width, uint32_t height)
+{
+	assert(res < graph->res_ct);
+	assert(!graph->resources[res].transient);
+
+	graph->resources[res].image = image;
+	graph->resources[res].view = view;
+	graph->resources[res].width = width;
+	graph->resources[res].height = height;
+}
+
+uint32_t graph_transient(struct RenderGraph *graph,
+			 VkFormat format,
+			 VkImageAspectFlags aspect,
+			 uint32_t width, uint32_t height)
+{
+	struct GraphResource *res = add_resource(graph);
+	res->transient = 1;
+	res->image = VK_NULL_HANDLE;
+	res->view = VK_NULL_HANDLE;
+	res->format = format;
+	res->aspect = aspect;
+	res->width = width;
+	res->height = height;
+	res->initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	res->initial_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	res->initial_access = 0;
+
+	return graph->res_ct++;
+}
+
+uint32_t graph_pass(struct RenderGraph *graph, const char *name,
+		    GraphRecordFn fn, void *data)
+{
+	assert(graph->pass_ct < GRAPH_MAX_PASSES);
+
+	struct GraphPass *pass = &graph->passes[graph->pass_ct];
+	*pass = (struct GraphPass) {0};
+	pass->name = name;
+	pass->fn = fn;
+	pass->data = data;
+
+	return graph->pass_ct++;
+}
+
+void graph_pass_color(struct RenderGraph *graph, uint32_t pass, uint32_t res,
+		      const VkClearValue *clear)
+{
+	add_use(graph, pass, res, GRAPH_USAGE_COLOR, clear);
+}
+
+void graph_pass_depth(struct RenderGraph *graph, uint32_t pass, uint32_t res,
+		      const VkClearValue *clear)
+{
+	add_use(graph, pass, res, GRAPH_USAGE_DEPTH, clear);
+}
+
+void graph_pass_use(struct RenderGraph *graph, uint32_t pass, uint32_t res,
+		    enum GraphUsage usage)
+{
+	assert(!is_attachment(usage));
+
+	add_use(graph, pass, res, usage, NULL);
+}
+
+// Whether <pass> can continue <prev>'s rendering: it has the same attachments,
+// doesn't clear them and uses nothing else that would need a barrier
+static int can_merge(struct GraphPass *prev, struct GraphPass *pass)
+{
+	if (!prev->renders || !pass->renders) return 0;
+
+	uint32_t prev_attachment_ct = 0;
+	for (uint32_t i = 0; i < prev->use_ct; i++) {
+		if (is_attachment(prev->uses[i].usage)) prev_attachment_ct++;
+	}
+	if (pass->use_ct != prev_attachment_ct) return 0;
+
+	for (uint32_t i = 0; i < pass->use_ct; i++) {
+		struct GraphUse *use = &pass->uses[i];
+		if (!is_attachment(use->usage) || use->clear) return 0;
+
+		int found = 0;
+		for (uint32_t j = 0; j < prev->use_ct; j++) {
+			if (prev->uses[j].res == use->res
+			    && prev->uses[j].usage == use->usage) {
+				found = 1;
+			}
+		}
+		if (!found) return 0;
+	}
+
+	return 1;
+}
+
+void graph_compile(struct RenderGraph *graph)
+{
+	// State of each resource as of the pass being compiled
+	VkImageLayout layouts[GRAPH_MAX_RESOURCES];
+	VkPipelineStageFlags stages[GRAPH_MAX_RESOURCES];
+	VkAccessFlags accesses[GRAPH_MAX_RESOURCES];
+	int has_contents[GRAPH_MAX_RESOURCES];
+
+	for (uint32_t i = 0; i < graph->res_ct; i++) {
+		struct GraphResource *res = &graph->resources[i];
+		layouts[i] = res->initial_layout;
+		stages[i] = res->initial_stage;
+		accesses[i] = res->initial_access;
+		has_contents[i] = res->initial_layout
+			!= VK_IMAGE_LAYOUT_UNDEFINED;
+
+		res->first_pass = GRAPH_MAX_PASSES;
+		res->last_pass = 0;
+		res->usage = 0;
+	}
+
+	for (uint32_t p = 0; p < graph->pass_ct; p++) {
+		struct GraphPass *pass = &graph->passes[p];
+		pass->barrier_ct = 0;
+		pass->src_stages = 0;
+		pass->dst_stages = 0;
+		pass->renders = 0;
+		pass->merged = 0;
+		pass->ends_rendering = 0;
+
+		uint32_t color_ct = 0;
+		for (uint32_t i = 0; i < pass->use_ct; i++) {
+			if (pass->uses[i].usage == GRAPH_USAGE_COLOR) color_ct++;
+			if (is_attachment(pass->uses[i].usage)) pass->renders = 1;
+		}
+		// dyn_render_begin takes exactly one color attachment
+		assert(!pass->renders || color_ct == 1);
+
+		if (p > 0 && can_merge(&graph->passes[p - 1], pass)) {
+			pass->merged = 1;
+		}
+
+		for (uint32_t i = 0; i < pass->use_ct; i++) {
+			struct GraphUse *use = &pass->uses[i];
+			struct GraphResource *res = &graph->resources[use->res];
+			struct UsageInfo info = usage_info(use->usage,
+							   res->aspect);
+			uint32_t r = use->res;
+
+			if (res->first_pass == GRAPH_MAX_PASSES) {
+				res->first_pass = p;
+			}
+			res->last_pass = p;
+			res->last_stage = info.stage;
+			res->last_access = info.access;
+			res->usage |= info.image_usage;
+
+			if (is_attachment(use->usage)) {
+				if (use->clear) {
+					use->load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+				} else if (has_contents[r]) {
+					use->load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
+				} else {
+					use->load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				}
+			}
+
+			// Merged passes leave everything as the previous
+			// pass had it
+			if (pass->merged) continue;
+
+			int prev_writes = (accesses[r] & WRITE_ACCESS) != 0;
+			int writes = (info.access & WRITE_ACCESS) != 0;
+			if (layouts[r] != info.layout || prev_writes || writes) {
+				struct GraphBarrier *barrier =
+					&pass->barriers[pass->barrier_ct++];
+				barrier->res = r;
+				barrier->old_layout = has_contents[r]
+					? layouts[r]
+					: VK_IMAGE_LAYOUT_UNDEFINED;
+				barrier->new_layout = info.layout;
+				barrier->src_access = accesses[r] & WRITE_ACCESS;
+				barrier->dst_access = info.access;
+
+				pass->src_stages |= stages[r];
+				pass->dst_stages |= info.stage;
+			}
+
+			layouts[r] = info.layout;
+			stages[r] = info.stage;
+			accesses[r] = info.access;
+			if (writes) has_contents[r] = 1;
+		}
+	}
+
+	// Rendering scopes: each runs from a pass that isn't merged to the last
+	// pass merged into it. Transients aren't stored after a scope that
+	// ends their lifetime.
+	for (uint32_t p = 0; p < graph->pass_ct; p++) {
+		struct GraphPass *pass = &graph->passes[p];
+		if (!pass->renders || pass->merged) continue;
+
+		uint32_t end = p;
+		while (end + 1 < graph->pass_ct
+		       && graph->passes[end + 1].merged) {
+			end++;
+		}
+		graph->passes[end].ends_rendering = 1;
+
+		for (uint32_t q = p; q <= end; q++) {
+			struct GraphPass *scoped = &graph->passes[q];
+			for (uint32_t i = 0; i < scoped->use_ct; i++) {
+				struct GraphUse *use = &scoped->uses[i];
+				struct GraphResource *res =
+					&graph->resources[use->res];
+
+				int dead = res->transient
+					&& res->last_pass <= end;
+				use->store_op = dead
+					? VK_ATTACHMENT_STORE_OP_DONT_CARE
+					: VK_ATTACHMENT_STORE_OP_STORE;
+			}
+		}
+	}
+}
+
+uint32_t graph_alias_slots(uint32_t ct,
+			   const uint32_t *firsts, const uint32_t *lasts,
+			   const uint32_t *type_bits,
+			   uint32_t *slots)
+{
+	if (ct == 0) return 0;
+
+	// Place resources in the order they start, so each slot fills up
+	// front to back
+	uint32_t *order = malloc(sizeof(order[0]) * ct);
+	for (uint32_t i = 0; i < ct; i++) {
+		uint32_t j = i;
+		while (j > 0 && firsts[order[j - 1]] > firsts[i]) {
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = i;
+	}
+
+	// Last pass using each slot, and the memory types all of its
+	// resources can use
+	uint32_t *slot_lasts = malloc(sizeof(slot_lasts[0]) * ct);
+	uint32_t *slot_bits = malloc(sizeof(slot_bits[0]) * ct);
+	uint32_t slot_ct = 0;
+
+	for (uint32_t i = 0; i < ct; i++) {
+		uint32_t r = order[i];
+
+		uint32_t slot = slot_ct;
+		for (uint32_t s = 0; s < slot_ct; s++) {
+			if (slot_lasts[s] < firsts[r]
+			    && (slot_bits[s] & type_bits[r]) != 0) {
+				slot = s;
+				break;
+			}
+		}
+
+		if (slot == slot_ct) {
+			slot_ct++;
+			slot_lasts[slot] = lasts[r];
+			slot_bits[slot] = type_bits[r];
+		} else {
+			slot_lasts[slot] = lasts[r];
+			slot_bits[slot] &= type_bits[r];
+		}
+
+		slots[r] = slot;
+	}
+
+	free(order);
+	free(slot_lasts);
+	free(slot_bits);
+
+	return slot_ct;
+}
+
+void graph_realize(VkDevice device,
+		   VkPhysicalDeviceMemoryProperties mem_props,
+		   uint32_t queue_fam,
+		   struct RenderGraph *graph)
+{
+	VkResult res;
+
+	// Transients that are actually used
+	uint32_t idxs[GRAPH_MAX_RESOURCES];
+	uint32_t firsts[GRAPH_MAX_RESOURCES];
+	uint32_t lasts[GRAPH_MAX_RESOURCES];
+	uint32_t type_bits[GRAPH_MAX_RESOURCES];
+	VkMemoryRequirements reqs[GRAPH_MAX_RESOURCES];
+	uint32_t slots[GRAPH_MAX_RESOURCES];
+	uint32_t ct = 0;
+
+	for (uint32_t i = 0; i < graph->res_ct; i++) {
+		struct GraphResource *r = &graph->resources[i];
+		if (!r->transient || r->first_pass == GRAPH_MAX_PASSES) continue;
+
+		image_handle_create(device, queue_fam, r->format, r->usage,
+				    VK_SAMPLE_COUNT_1_BIT,
+				    r->width, r->height,
+				    &r->image);
+		vkGetImageMemoryRequirements(device, r->image, &reqs[ct]);
+
+		idxs[ct] = i;
+		firsts[ct] = r->first_pass;
+		lasts[ct] = r->last_pass;
+		type_bits[ct] = reqs[ct].memoryTypeBits;
+		ct++;
+	}
+
+	graph->slot_ct = graph_alias_slots(ct, firsts, lasts, type_bits, slots);
+
+	// Each slot is as big as its biggest resource. Everything is bound at
+	// offset 0, so alignment doesn't matter.
+	for (uint32_t s = 0; s < graph->slot_ct; s++) {
+		VkMemoryRequirements slot_reqs = {0};
+		slot_reqs.memoryTypeBits = ~0u;
+
+		for (uint32_t i = 0; i < ct; i++) {
+			if (slots[i] != s) continue;
+
+			if (reqs[i].size > slot_reqs.size) {
+				slot_reqs.size = reqs[i].size;
+			}
+			slot_reqs.memoryTypeBits &= reqs[i].memoryTypeBits;
+		}
+
+		VkMemoryAllocateInfo alloc_info = {0};
+		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		alloc_info.allocationSize = slot_reqs.size;
+		alloc_info.memoryTypeIndex =
+			find_memory_type(mem_props, slot_reqs,
+					 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		res = vkAllocateMemory(device, &alloc_info, NULL,
+				       &graph->slots[s]);
+		assert(res == VK_SUCCESS);
+	}
+
+	for (uint32_t i = 0; i < ct; i++) {
+		struct GraphResource *r = &graph->resources[idxs[i]];
+		r->slot = slots[i];
+
+		res = vkBindImageMemory(device, r->image,
+					graph->slots[r->slot], 0);
+		assert(res == VK_SUCCESS);
+
+		image_view_create(device, r->format,
+				  (VkImageAspectFlagBits) r->aspect,
+				  r->image, &r->view);
+	}
+
+	// A transient's first use has to wait for whoever had its memory
+	// before: the resource before it in the slot, or for the first one,
+	// the last one from the previous frame
+	for (uint32_t i = 0; i < ct; i++) {
+		// Resources in a slot never overlap, so their first passes
+		// all differ
+		uint32_t prev = ct;
+		uint32_t last = i;
+		for (uint32_t j = 0; j < ct; j++) {
+			if (slots[j] != slots[i]) continue;
+
+			if (firsts[j] < firsts[i]
+			    && (prev == ct || firsts[j] > firsts[prev])) {
+				prev = j;
+			}
+			if (firsts[j] > firsts[last]) last = j;
+		}
+		if (prev == ct) prev = last;
+
+		struct GraphResource *r = &graph->resources[idxs[i]];
+		struct GraphResource *p = &graph->resources[idxs[prev]];
+		struct GraphPass *pass = &graph->passes[r->first_pass];
+
+		pass->src_stages |= p->last_stage;
+		for (uint32_t b = 0; b < pass->barrier_ct; b++) {
+			if (pass->barriers[b].res == idxs[i]) {
+				pass->barriers[b].src_access |=
+					p->last_access & WRITE_ACCESS;
+			}
+		}
+	}
+}
+
+void graph_execute(struct RenderGraph *graph, struct DynRender *dr,
+		   VkCommandBuffer cbuf)
+{
+	for (uint32_t p = 0; p < graph->pass_ct; p++) {
+		struct GraphPass *pass = &graph->passes[p];
+
+		if (pass->barrier_ct > 0) {
+			VkImageMemoryBarrier barriers[GRAPH_MAX_USES];
+			for (uint32_t i = 0; i < pass->barrier_ct; i++) {
+				struct GraphBarrier *b = &pass->barriers[i];
+				struct GraphResource *res =
+					&graph->resources[b->res];
+
+				barriers[i] = (VkImageMemoryBarrier) {0};
+				barriers[i].sType =
+					VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barriers[i].srcAccessMask = b->src_access;
+				barriers[i].dstAccessMask = b->dst_access;
+				barriers[i].oldLayout = b->old_layout;
+				barriers[i].newLayout = b->new_layout;
+				barriers[i].srcQueueFamilyIndex =
+					VK_QUEUE_FAMILY_IGNORED;
+				barriers[i].dstQueueFamilyIndex =
+					VK_QUEUE_FAMILY_IGNORED;
+				barriers[i].image = res->image;
+				barriers[i].subresourceRange.aspectMask =
+					res->aspect;
+				barriers[i].subresourceRange.baseMipLevel = 0;
+				barriers[i].subresourceRange.levelCount = 1;
+				barriers[i].subresourceRange.baseArrayLayer = 0;
+				barriers[i].subresourceRange.layerCount = 1;
+			}
+
+			vkCmdPipelineBarrier(cbuf,
+					     pass->src_stages, pass->dst_stages,
+					     0,
+					     0, NULL,
+					     0, NULL,
+					     pass->barrier_ct, barriers);
+		}
+
+		if (pass->renders && !pass->merged) {
+			struct DynAttachment color = {0};
+			struct DynAttachment depth = {0};
+			int has_depth = 0;
+			uint32_t width = 0;
+			uint32_t height = 0;
+
+			for (uint32_t i = 0; i < pass->use_ct; i++) {
+				struct GraphUse *use = &pass->uses[i];
+				if (!is_attachment(use->usage)) continue;
+
+				struct GraphResource *res =
+					&graph->resources[use->res];
+				struct DynAttachment *att =
+					use->usage == GRAPH_USAGE_COLOR
+					? &color : &depth;
+				if (use->usage == GRAPH_USAGE_DEPTH) {
+					has_depth = 1;
+				}
+
+				att->view = res->view;
+				att->layout = usage_info(use->usage,
+							 res->aspect).layout;
+				att->load_op = use->load_op;
+				att->store_op = use->store_op;
+				att->clear = use->clear_value;
+
+				width = res->width;
+				height = res->height;
+			}
+
+			dyn_render_begin(dr, cbuf, width, height,
+					 &color, has_depth ? &depth : NULL);
+		}
+
+		if (pass->fn != NULL) pass->fn(cbuf, pass->data);
+
+		if (pass->ends_rendering) dyn_render_end(dr, cbuf);
+	}
+}
+
+void graph_destroy(VkDevice device, struct RenderGraph graph)
+{
+	for (uint32_t i = 0; i < graph.res_ct; i++) {
+		struct GraphResource *res = &graph.resources[i];
+		if (!res->transient || res->image == VK_NULL_HANDLE) continue;
+
+		vkDestroyImageView(device, res->view, NULL);
+		vkDestroyImage(device, res->image, NULL);
+	}
+
+	for (uint32_t s = 0; s < graph.slot_ct; s++) {
+		vkFreeMemory(device, graph.slots[s], NULL);
+	}
+}
@@ -0,0 +1,252 @@
+#ifndef VK_GRAPH_H_
+#define VK_GRAPH_H_
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "vk_dyn_render.h"
+
+#define GRAPH_MAX_RESOURCES 16
+#define GRAPH_MAX_PASSES 16
+// Most resources a single pass can use
+#define GRAPH_MAX_USES 4
+
+/*
+ * How a pass uses a resource. Each one implies a layout, the stages that touch
+ * the image and the accesses they make.
+ */
+enum GraphUsage {
+	// Color attachment, written
+	GRAPH_USAGE_COLOR,
+	// Depth attachment, tested and written
+	GRAPH_USAGE_DEPTH,
+	// Read by fragment or compute shaders. Depth images are read in
+	// DEPTH_STENCIL_READ_ONLY_OPTIMAL.
+	GRAPH_USAGE_SAMPLED,
+	// Read and written by compute shaders, in GENERAL
+	GRAPH_USAGE_STORAGE,
+	GRAPH_USAGE_TRANSFER_SRC,
+	GRAPH_USAGE_TRANSFER_DST,
+	// Handed to the presentation engine after the graph
+	GRAPH_USAGE_PRESENT
+};
+
+// Records a pass's commands. Rendering has already begun for passes with
+// attachments.
+typedef void (*GraphRecordFn)(VkCommandBuffer cbuf, void *data);
+
+struct GraphResource {
+	// Transient resources are created by graph_realize and only live
+	// within the graph, so their contents are never kept between frames
+	int transient;
+
+	VkImage image;
+	VkImageView view;
+	VkFormat format;
+	VkImageAspectFlags aspect;
+	uint32_t width;
+	uint32_t height;
+
+	// State the image is in when the graph starts. For transients, the
+	// contents are always undefined.
+	VkImageLayout initial_layout;
+	VkPipelineStageFlags initial_stage;
+	VkAccessFlags initial_access;
+
+	// Filled in by graph_compile. first_pass is GRAPH_MAX_PASSES if no
+	// pass uses the resource.
+	uint32_t first_pass;
+	uint32_t last_pass;
+	VkPipelineStageFlags last_stage;
+	VkAccessFlags last_access;
+	VkImageUsageFlags usage;
+
+	// Filled in by graph_realize, for transients
+	uint32_t slot;
+};
+
+struct GraphUse {
+	uint32_t res;
+	enum GraphUsage usage;
+
+	// Attachments only
+	int clear;
+	VkClearValue clear_value;
+	// Filled in by graph_compile, for attachments
+	VkAttachmentLoadOp load_op;
+	VkAttachmentStoreOp store_op;
+};
+
+// A layout transition or memory dependency, in terms of resource indices so a
+// compiled graph can be run with different images (see graph_set_import)
+struct GraphBarrier {
+	uint32_t res;
+	VkImageLayout old_layout;
+	VkImageLayout new_layout;
+	VkAccessFlags src_access;
+	VkAccessFlags dst_access;
+};
+
+struct GraphPass {
+	const char *name;
+	// Can be NULL for passes that only move resources into a state, like
+	// PRESENT
+	GraphRecordFn fn;
+	void *data;
+
+	uint32_t use_ct;
+	struct GraphUse uses[GRAPH_MAX_USES];
+
+	// Filled in by graph_compile. All of a pass's barriers are recorded
+	// with one vkCmdPipelineBarrier.
+	uint32_t barrier_ct;
+	struct GraphBarrier barriers[GRAPH_MAX_USES];
+	VkPipelineStageFlags src_stages;
+	VkPipelineStageFlags dst_stages;
+
+	// Whether the pass has attachments
+	int renders;
+	// Whether the pass continues the previous pass's rendering instead of
+	// beginning its own
+	int merged;
+	// Whether rendering ends after the pass (the next pass isn't merged)
+	int ends_rendering;
+};
+
+/*
+ * A frame described as passes and the images they use, instead of hand-placed
+ * barriers.
+ *
+ * Compiling works out from the order of the passes where each image has to
+ * change layout or have its writes made visible, and puts all of a pass's
+ * barriers in one vkCmdPipelineBarrier. It also works out attachment load and
+ * store ops: transients aren't stored after their last use, and attachments
+ * that haven't been written aren't loaded.
+ *
+ * Passes with attachments render with dynamic rendering (see DynRender).
+ * Consecutive passes with the same attachments and nothing in between share a
+ * rendering scope, like merged subpasses would.
+ *
+ * Transient images whose lifetimes don't overlap share memory.
+ *
+ * Usage:
+ * - graph_create, then add resources and passes in execution order
+ * - graph_compile, then graph_realize
+ * - Each frame, graph_set_import for images that change (like the swapchain
+ *   image), then graph_execute
+ */
+struct RenderGraph {
+	uint32_t res_ct;
+	struct GraphResource resources[GRAPH_MAX_RESOURCES];
+
+	uint32_t pass_ct;
+	struct GraphPass passes[GRAPH_MAX_PASSES];
+
+	// Memory shared by transients, one per alias slot
+	uint32_t slot_ct;
+	VkDeviceMemory slots[GRAPH_MAX_RESOURCES];
+};
+
+void graph_create(struct RenderGraph *graph);
+
+/*
+ * Adds an image owned by the caller. Returns its resource index.
+ *
+ * initial_layout: Layout the image is in when the graph runs. UNDEFINED
+ *                 discards the contents.
+ * initial_stage, initial_access: Last use of the image before the graph runs
+ */
+uint32_t graph_import(struct RenderGraph *graph,
+		      VkImage image, VkImageView view,
+		      VkImageAspectFlags aspect,
+		      uint32_t width, uint32_t height,
+		      VkImageLayout initial_layout,
+		      VkPipelineStageFlags initial_stage,
+		      VkAccessFlags initial_access);
+
+/*
+ * Swaps the image behind an imported resource without recompiling, like the
+ * swapchain image that was acquired this frame.
+ */
+void graph_set_import(struct RenderGraph *graph, uint32_t res,
+		      VkImage image, VkImageView view,
+		      uint32_t width, uint32_t height);
+
+/*
+ * Adds an image created by graph_realize and only used within the graph.
+ * Returns its resource index.
+ */
+uint32_t graph_transient(struct RenderGraph *graph,
+			 VkFormat format,
+			 VkImageAspectFlags aspect,
+			 uint32_t width, uint32_t height);
+
+/*
+ * Adds a pass. Passes run in the order they're added. Returns its index.
+ *
+ * fn: Can be NULL
+ */
+uint32_t graph_pass(struct RenderGraph *graph, const char *name,
+		    GraphRecordFn fn, void *data);
+
+/*
+ * Makes <res> the pass's color or depth attachment.
+ *
+ * clear: If not NULL, the attachment is cleared to it instead of loaded
+ */
+void graph_pass_color(struct RenderGraph *graph, uint32_t pass, uint32_t res,
+		      const VkClearValue *clear);
+void graph_pass_depth(struct RenderGraph *graph, uint32_t pass, uint32_t res,
+		      const VkClearValue *clear);
+
+/*
+ * Marks <res> as used by the pass in some other way.
+ */
+void graph_pass_use(struct RenderGraph *graph, uint32_t pass, uint32_t res,
+		    enum GraphUsage usage);
+
+/*
+ * Works out lifetimes, barriers, rendering scopes and attachment ops. Doesn't
+ * touch the device, so the result can be inspected without one.
+ */
+void graph_compile(struct RenderGraph *graph);
+
+/*
+ * Creates the transient images, sharing memory between the ones whose
+ * lifetimes don't overlap. Must be called after graph_compile, and before
+ * graph_execute if there are any transients.
+ */
+void graph_realize(VkDevice device,
+		   VkPhysicalDeviceMemoryProperties mem_props,
+		   uint32_t queue_fam,
+		   struct RenderGraph *graph);
+
+/*
+ * Records the graph into a command buffer that is already recording.
+ *
+ * dr: Only used if a pass has attachments
+ */
+void graph_execute(struct RenderGraph *graph, struct DynRender *dr,
+		   VkCommandBuffer cbuf);
+
+/*
+ * Destroys the transient images and their memory. Imported images are left
+ * alone.
+ */
+void graph_destroy(VkDevice device, struct RenderGraph graph);
+
+/*
+ * Assigns resources to memory slots so resources share a slot only if their
+ * lifetimes (first to last pass, inclusive) don't overlap and they have a
+ * memory type in common. Returns the number of slots.
+ *
+ * type_bits: Each resource's VkMemoryRequirements.memoryTypeBits
+ * slots: Output, the slot of each resource
+ */
+uint32_t graph_alias_slots(uint32_t ct,
+			   const uint32_t *firsts, const uint32_t *lasts,
+			   const uint32_t *type_bits,
+			   uint32_t *slots);
+
+#endif // VK_GRAPH_H_
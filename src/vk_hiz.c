@@ -0,0 +1,494 @@
+#include "vk_hiz.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "vk_image.h"
+#include "vk_pipe.h"
+#include "vk_uniform.h"
+
+// Must match local_size in the shader
+#define HIZ_GROUP_SIZE 8
+
+static uint32_t level_size(uint32_t size, uint32_t level)
+{
+	for (uint32_t i = 0; i <= level; i++) {
+		size /= 2;
+		if (size == 0) size = 1;
+	}
+
+	return size;
+}
+
+static void create_pyramid_image(VkDevice device,
+				 VkPhysicalDeviceMemoryProperties mem_props,
+				 uint32_t queue_fam,
+				 struct HiZ *hiz)
+{
+	VkImageCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.imageType = VK_IMAGE_TYPE_2D,
+		.format = HIZ_FORMAT,
+		.extent = {
+			.width = hiz->width,
+			.height = hiz->height,
+			.depth = 1,
+		},
+		.mipLevels = hiz->mip_ct,
+		.arrayLayers = 1,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.tiling = VK_IMAGE_TILING_OPTIMAL,
+		.usage = VK_IMAGE_USAGE_STORAGE_BIT
+			| VK_IMAGE_USAGE_SAMPLED_BIT
+			| VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		.queueFamilyIndexCount = 1,
+		.pQueueFamilyIndices = &queue_fam,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+	};
+
+	VkResult res = vkCreateImage(device, &info, NULL, &hiz->image);
+	assert(res == VK_SUCCESS);
+
+	image_memory_bind(device, mem_props,
+			  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			  hiz->image, &hiz->memory);
+
+	hiz->views = malloc(sizeof(hiz->views[0]) * hiz->mip_ct);
+	for (uint32_t i = 0; i < hiz->mip_ct; i++) {
+		VkImageViewCreateInfo view_info = {
+			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+			.image = hiz->image,
+			.viewType = VK_IMAGE_VIEW_TYPE_2D,
+			.format = HIZ_FORMAT,
+			.components = {
+				.r = VK_COMPONENT_SWIZZLE_IDENTITY,
+				.g = VK_COMPONENT_SWIZZLE_IDENTITY,
+				.b = VK_COMPONENT_SWIZZLE_IDENTITY,
+				.a = VK_COMPONENT_SWIZZLE_IDENTITY
+			},
+			.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.subresourceRange.baseMipLevel = i,
+			.subresourceRange.levelCount = 1,
+			.subresourceRange.baseArrayLayer = 0,
+			.subresourceRange.layerCount = 1
+		};
+
+		res = vkCreateImageView(device, &view_info, NULL, &hiz->views[i]);
+		assert(res == VK_SUCCESS);
+	}
+
+	VkSamplerCreateInfo sampler_info = {0};
+	sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_info.magFilter = VK_FILTER_NEAREST;
+	sampler_info.minFilter = VK_FILTER_NEAREST;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+
+	res = vkCreateSampler(device, &sampler_info, NULL, &hiz->sampler);
+	assert(res == VK_SUCCESS);
+}
+
+static void create_downsample_sets(VkDevice device, VkImageView depth_view,
+				   struct HiZ *hiz)
+{
+	VkDescriptorSetLayoutBinding bindings[2];
+	create_descriptor_binding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				  VK_SHADER_STAGE_COMPUTE_BIT, &bindings[0]);
+	create_descriptor_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+				  VK_SHADER_STAGE_COMPUTE_BIT, &bindings[1]);
+	create_descriptor_layout(device, 2, bindings, &hiz->desc_layout);
+
+	VkDescriptorPoolSize pool_sizes[2] = {0};
+	pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pool_sizes[0].descriptorCount = hiz->mip_ct;
+	pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	pool_sizes[1].descriptorCount = hiz->mip_ct;
+
+	VkDescriptorPoolCreateInfo pool_info = {0};
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.poolSizeCount = 2;
+	pool_info.pPoolSizes = pool_sizes;
+	pool_info.maxSets = hiz->mip_ct;
+
+	VkResult res = vkCreateDescriptorPool(device, &pool_info, NULL,
+					      &hiz->dpool);
+	assert(res == VK_SUCCESS);
+
+	hiz->sets = malloc(sizeof(hiz->sets[0]) * hiz->mip_ct);
+	for (uint32_t i = 0; i < hiz->mip_ct; i++) {
+		allocate_descriptor_set(device, hiz->dpool, hiz->desc_layout,
+					&hiz->sets[i]);
+
+		VkDescriptorImageInfo src_info = {0};
+		src_info.sampler = hiz->sampler;
+		if (i == 0) {
+			src_info.imageView = depth_view;
+			src_info.imageLayout =
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		} else {
+			src_info.imageView = hiz->views[i - 1];
+			src_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		}
+
+		VkDescriptorImageInfo dst_info = {0};
+		dst_info.imageView = hiz->views[i];
+		dst_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet writes[2] = {0};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = hiz->sets[i];
+		writes[0].dstBinding = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType =
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &src_info;
+
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = hiz->sets[i];
+		writes[1].dstBinding = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo = &dst_info;
+
+		vkUpdateDescriptorSets(device, 2, writes, 0, NULL);
+	}
+}
+
+static void create_downsample_pipel(VkDevice device, VkPipelineCache pcache,
+				    struct HiZ *hiz)
+{
+	FILE *fp = fopen(HIZ_SHADER_PATH, "rb");
+	assert(fp != NULL);
+
+	size_t cs_size;
+	read_bin(fp, &cs_size, NULL);
+	char *cs_buf = malloc(cs_size);
+	read_bin(fp, &cs_size, cs_buf);
+	fclose(fp);
+
+	VkShaderModule cs_mod;
+	create_shmod(device, cs_size, cs_buf, &cs_mod);
+	free(cs_buf);
+
+	VkPipelineShaderStageCreateInfo cs_stage;
+	create_shtage(cs_mod, VK_SHADER_STAGE_COMPUTE_BIT, &cs_stage);
+
+	create_layout(device, 1, &hiz->desc_layout, 0, NULL, &hiz->layout);
+	create_compute_pipel(device, pcache, cs_stage, hiz->layout,
+			     &hiz->pipel);
+
+	vkDestroyShaderModule(device, cs_mod, NULL);
+}
+
+void hiz_create(VkDevice device,
+		VkPipelineCache pcache,
+		VkPhysicalDeviceMemoryProperties mem_props,
+		uint32_t queue_fam,
+		VkImageView depth_view,
+		uint32_t width, uint32_t height,
+		uint32_t readback_ct,
+		struct HiZ *hiz)
+{
+	hiz->width = level_size(width, 0);
+	hiz->height = level_size(height, 0);
+
+	hiz->mip_ct = 1;
+	while (level_size(width, hiz->mip_ct - 1) > 1
+	       || level_size(height, hiz->mip_ct - 1) > 1) {
+		hiz->mip_ct++;
+	}
+
+	hiz->readback_level = 0;
+	while (level_size(width, hiz->readback_level) > HIZ_READBACK_MAX_SIZE
+	       || level_size(height, hiz->readback_level) > HIZ_READBACK_MAX_SIZE) {
+		hiz->readback_level++;
+	}
+	hiz->readback_width = level_size(width, hiz->readback_level);
+	hiz->readback_height = level_size(height, hiz->readback_level);
+
+	create_pyramid_image(device, mem_props, queue_fam, hiz);
+	create_downsample_sets(device, depth_view, hiz);
+	create_downsample_pipel(device, pcache, hiz);
+
+	// Readback buffers, which stay mapped
+	VkDeviceSize readback_size = sizeof(float) * hiz->readback_width
+		* hiz->readback_height;
+
+	hiz->readback_ct = readback_ct;
+	hiz->readbacks = malloc(sizeof(hiz->readbacks[0]) * readback_ct);
+	hiz->readback_data = malloc(sizeof(hiz->readback_data[0]) * readback_ct);
+	hiz->readback_view_projs = malloc(sizeof(hiz->readback_view_projs[0])
+					  * readback_ct);
+	hiz->readback_frames = malloc(sizeof(hiz->readback_frames[0])
+				      * readback_ct);
+
+	for (uint32_t i = 0; i < readback_ct; i++) {
+		buffer_create(device, mem_props, readback_size,
+			      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			      &hiz->readbacks[i]);
+
+		VkResult res = vkMapMemory(device, hiz->readbacks[i].memory,
+					   0, readback_size, 0,
+					   (void **) &hiz->readback_data[i]);
+		assert(res == VK_SUCCESS);
+
+		hiz->readback_frames[i] = 0;
+	}
+}
+
+void hiz_destroy(VkDevice device, struct HiZ hiz)
+{
+	for (uint32_t i = 0; i < hiz.readback_ct; i++) {
+		vkUnmapMemory(device, hiz.readbacks[i].memory);
+		buffer_destroy(hiz.readbacks[i]);
+	}
+	free(hiz.readbacks);
+	free(hiz.readback_data);
+	free(hiz.readback_view_projs);
+	free(hiz.readback_frames);
+
+	vkDestroyPipeline(device, hiz.pipel, NULL);
+	vkDestroyPipelineLayout(device, hiz.layout, NULL);
+	vkDestroyDescriptorPool(device, hiz.dpool, NULL);
+	vkDestroyDescriptorSetLayout(device, hiz.desc_layout, NULL);
+	free(hiz.sets);
+
+	vkDestroySampler(device, hiz.sampler, NULL);
+	for (uint32_t i = 0; i < hiz.mip_ct; i++) {
+		vkDestroyImageView(device, hiz.views[i], NULL);
+	}
+	free(hiz.views);
+
+	vkDestroyImage(device, hiz.image, NULL);
+	vkFreeMemory(device, hiz.memory, NULL);
+}
+
+static void level_barrier(VkCommandBuffer cbuf, VkImage image, uint32_t level)
+{
+	VkImageMemoryBarrier barrier = {0};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = level;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT
+		| VK_ACCESS_TRANSFER_READ_BIT;
+
+	vkCmdPipelineBarrier(cbuf,
+			     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+			     | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			     0,
+			     0, NULL,
+			     0, NULL,
+			     1, &barrier);
+}
+
+void hiz_record(struct HiZ *hiz, VkCommandBuffer cbuf,
+		uint32_t readback_idx, uint64_t frame, mat4 view_proj)
+{
+	assert(readback_idx < hiz->readback_ct);
+
+	// The whole pyramid is rebuilt, so the old contents can be thrown away.
+	// Still wait for last frame's readback copy to be done with it though.
+	VkImageMemoryBarrier barrier = {0};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = hiz->image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = hiz->mip_ct;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(cbuf,
+			     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+			     | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			     0,
+			     0, NULL,
+			     0, NULL,
+			     1, &barrier);
+
+	vkCmdBindPipeline(cbuf, VK_PIPELINE_BIND_POINT_COMPUTE, hiz->pipel);
+
+	// Level 0 is made from the depth buffer, every other level from the one
+	// above it
+	uint32_t w = hiz->width;
+	uint32_t h = hiz->height;
+	for (uint32_t i = 0; i < hiz->mip_ct; i++) {
+		vkCmdBindDescriptorSets(cbuf,
+					VK_PIPELINE_BIND_POINT_COMPUTE,
+					hiz->layout,
+					0,
+					1, &hiz->sets[i],
+					0, NULL);
+
+		vkCmdDispatch(cbuf,
+			      (w + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE,
+			      (h + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE,
+			      1);
+
+		level_barrier(cbuf, hiz->image, i);
+
+		if (w > 1) w /= 2;
+		if (h > 1) h /= 2;
+	}
+
+	// Copy the coarse level back for the CPU
+	VkBufferImageCopy region = {0};
+	region.bufferOffset = 0;
+	region.bufferRowLength = hiz->readback_width;
+	region.bufferImageHeight = hiz->readback_height;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = hiz->readback_level;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent.width = hiz->readback_width;
+	region.imageExtent.height = hiz->readback_height;
+	region.imageExtent.depth = 1;
+
+	VkBuffer readback = hiz->readbacks[readback_idx].handle;
+	vkCmdCopyImageToBuffer(cbuf, hiz->image, VK_IMAGE_LAYOUT_GENERAL,
+			       readback, 1, &region);
+
+	VkBufferMemoryBarrier buf_barrier = {0};
+	buf_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	buf_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	buf_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	buf_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buf_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buf_barrier.buffer = readback;
+	buf_barrier.offset = 0;
+	buf_barrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(cbuf,
+			     VK_PIPELINE_STAGE_TRANSFER_BIT,
+			     VK_PIPELINE_STAGE_HOST_BIT,
+			     0,
+			     0, NULL,
+			     1, &buf_barrier,
+			     0, NULL);
+
+	memcpy(hiz->readback_view_projs[readback_idx], view_proj, sizeof(mat4));
+	hiz->readback_frames[readback_idx] = frame;
+}
+
+uint32_t hiz_latest_readback(struct HiZ *hiz, uint64_t completed)
+{
+	// A buffer tagged with a later frame is being written again, even if
+	// it held finished depth before
+	uint32_t latest = hiz->readback_ct;
+	for (uint32_t i = 0; i < hiz->readback_ct; i++) {
+		uint64_t frame = hiz->readback_frames[i];
+		if (frame == 0 || frame > completed) continue;
+
+		if (latest == hiz->readback_ct
+		    || frame > hiz->readback_frames[latest]) {
+			latest = i;
+		}
+	}
+
+	return latest;
+}
+
+size_t hiz_cull_aabbs(struct HiZ *hiz, uint64_t completed,
+		      struct AabbArray *aabbs,
+		      size_t idx_ct, uint32_t *indices)
+{
+	uint32_t readback_idx = hiz_latest_readback(hiz, completed);
+	if (readback_idx == hiz->readback_ct) return idx_ct;
+
+	float *depths = hiz->readback_data[readback_idx];
+	vec4 *view_proj = hiz->readback_view_projs[readback_idx];
+
+	size_t out = 0;
+	for (size_t i = 0; i < idx_ct; i++) {
+		uint32_t idx = indices[i];
+		vec3 min = {aabbs->min_x[idx], aabbs->min_y[idx], aabbs->min_z[idx]};
+		vec3 max = {aabbs->max_x[idx], aabbs->max_y[idx], aabbs->max_z[idx]};
+
+		if (!hiz_is_occluded(depths,
+				     hiz->readback_width, hiz->readback_height,
+				     view_proj, min, max)) {
+			indices[out++] = idx;
+		}
+	}
+
+	return out;
+}
+
+int hiz_is_occluded(float *depths, uint32_t width, uint32_t height,
+		    mat4 view_proj, vec3 min, vec3 max)
+{
+	// Screen-space bounds of the box, and its nearest depth
+	float x0 = INFINITY, y0 = INFINITY;
+	float x1 = -INFINITY, y1 = -INFINITY;
+	float nearest = INFINITY;
+
+	for (int i = 0; i < 8; i++) {
+		vec4 corner = {i & 1 ? max[0] : min[0],
+			       i & 2 ? max[1] : min[1],
+			       i & 4 ? max[2] : min[2],
+			       1.0f};
+		vec4 clip;
+		glm_mat4_mulv(view_proj, corner, clip);
+
+		// Crosses the camera plane, so could cover anything
+		if (clip[3] <= 0.0f) return 0;
+
+		float x = clip[0] / clip[3];
+		float y = clip[1] / clip[3];
+		float z = clip[2] / clip[3];
+
+		if (x < x0) x0 = x;
+		if (x > x1) x1 = x;
+		if (y < y0) y0 = y;
+		if (y > y1) y1 = y;
+		if (z < nearest) nearest = z;
+	}
+
+	// Clipped by the near plane
+	if (nearest < 0.0f) return 0;
+
+	// Off-screen boxes are left to frustum culling
+	if (x1 < -1.0f || x0 > 1.0f || y1 < -1.0f || y0 > 1.0f) return 0;
+
+	// To texels, grown by one on each side since the levels don't line up
+	// exactly with the screen when sizes were rounded down
+	int tx0 = floorf((x0 * 0.5f + 0.5f) * width) - 1;
+	int tx1 = floorf((x1 * 0.5f + 0.5f) * width) + 1;
+	int ty0 = floorf((y0 * 0.5f + 0.5f) * height) - 1;
+	int ty1 = floorf((y1 * 0.5f + 0.5f) * height) + 1;
+
+	if (tx0 < 0) tx0 = 0;
+	if (ty0 < 0) ty0 = 0;
+	if (tx1 > (int) width - 1) tx1 = width - 1;
+	if (ty1 > (int) height - 1) ty1 = height - 1;
+
+	for (int y = ty0; y <= ty1; y++) {
+		for (int x = tx0; x <= tx1; x++) {
+			if (depths[y * width + x] >= nearest) return 0;
+		}
+	}
+
+	return 1;
+}
@@ -0,0 +1,123 @@
+#ifndef VK_HIZ_H_
+#define VK_HIZ_H_
+
+#include <vulkan/vulkan.h>
+#include <cglm/cglm.h>
+
+#include "vk_buffer.h"
+#include "cull.h"
+
+#define HIZ_FORMAT VK_FORMAT_R32_SFLOAT
+#define HIZ_SHADER_PATH "assets/shaders/hiz/downsample.comp.spv"
+
+// The level read back to the CPU is the first one whose sides both fit in
+// this many texels
+#define HIZ_READBACK_MAX_SIZE 64
+
+/*
+ * A hierarchical depth pyramid built from a depth buffer with a compute
+ * shader. Each texel of a level holds the furthest depth of the texels it
+ * covers in the level above it, so anything nearer than that is hidden behind
+ * it. Level 0 is half the size of the depth buffer.
+ *
+ * One coarse level is copied back into host memory each frame, into one of
+ * <readback_ct> buffers (one per frame in flight), so objects can be tested
+ * against earlier depth on the CPU before being drawn. Each buffer is tagged
+ * with the frame that wrote it, and culling reads whichever finished most
+ * recently, so the depth is usually only a frame or two old. Boxes are
+ * projected with the matrix that depth was rendered with, but anything that
+ * has only just come out from behind something can still be culled for that
+ * long.
+ */
+struct HiZ {
+	uint32_t width;
+	uint32_t height;
+	uint32_t mip_ct;
+
+	VkImage image;
+	VkDeviceMemory memory;
+	// One per level
+	VkImageView *views;
+	VkSampler sampler;
+
+	VkDescriptorSetLayout desc_layout;
+	VkDescriptorPool dpool;
+	// One per level, reading the level above and writing this one
+	VkDescriptorSet *sets;
+	VkPipelineLayout layout;
+	VkPipeline pipel;
+
+	uint32_t readback_level;
+	uint32_t readback_width;
+	uint32_t readback_height;
+	uint32_t readback_ct;
+	struct Buffer *readbacks;
+	float **readback_data;
+	// View-projection matrix the readback was rendered with, and the value
+	// of the frame that last wrote it (0 if none has)
+	mat4 *readback_view_projs;
+	uint64_t *readback_frames;
+};
+
+/*
+ * Creates a HiZ pyramid for a depth buffer. Needs to be recreated whenever the
+ * depth buffer is.
+ *
+ * pcache: For the downsample pipeline, or VK_NULL_HANDLE
+ * depth_view: View of the depth buffer, which needs SAMPLED usage
+ * width, height: Size of the depth buffer
+ * readback_ct: How many frames can be in flight at once
+ */
+void hiz_create(VkDevice device,
+		VkPipelineCache pcache,
+		VkPhysicalDeviceMemoryProperties mem_props,
+		uint32_t queue_fam,
+		VkImageView depth_view,
+		uint32_t width, uint32_t height,
+		uint32_t readback_ct,
+		struct HiZ *hiz);
+
+void hiz_destroy(VkDevice device, struct HiZ hiz);
+
+/*
+ * Records building the pyramid and copying the readback level into buffer
+ * <readback_idx>. Record after the depth buffer has been rendered to and made
+ * readable to compute shaders (see rpass_with_sampled_depth).
+ *
+ * readback_idx: Must not be in use by a frame still executing, like the
+ *               frame's slot from frame_sched_begin
+ * frame: Value of the frame the commands will be submitted in
+ * view_proj: The matrix the depth buffer was rendered with
+ */
+void hiz_record(struct HiZ *hiz, VkCommandBuffer cbuf,
+		uint32_t readback_idx, uint64_t frame, mat4 view_proj);
+
+/*
+ * Returns the index of the readback written by the latest frame up to
+ * <completed>, or readback_ct if no finished frame has written one.
+ *
+ * completed: Usually frame_sched_completed
+ */
+uint32_t hiz_latest_readback(struct HiZ *hiz, uint64_t completed);
+
+/*
+ * Removes the boxes hidden behind the latest finished readback (see
+ * hiz_latest_readback) from a list of box indices (such as the output of
+ * cull_aabbs), and returns how many are left. Does nothing if there isn't
+ * one.
+ */
+size_t hiz_cull_aabbs(struct HiZ *hiz, uint64_t completed,
+		      struct AabbArray *aabbs,
+		      size_t idx_ct, uint32_t *indices);
+
+/*
+ * Returns 1 if the box between <min> and <max> is definitely hidden behind a
+ * depth buffer (or a HiZ level) rendered with <view_proj>, and 0 if it might
+ * be visible.
+ *
+ * depths: Row-major, <width> by <height>, 0 near and 1 far
+ */
+int hiz_is_occluded(float *depths, uint32_t width, uint32_t height,
+		    mat4 view_proj, vec3 min, vec3 max);
+
+#endif // VK_HIZ_H_
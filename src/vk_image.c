@@ -4,6 +4,7 @@
 #include "vk_image.h"
 #include "ll_vk_image.h"
 #include "vk_cbuf.h"
+#include "vk_barrier.h"
 
 void image_create(VkDevice device,
 		  uint32_t queue_fam,
@@ -16,13 +17,32 @@ void image_create(VkDevice device,
 		  uint32_t width, uint32_t height,
 		  struct Image *image)
 {
-	image_handle_create(device,
-			    queue_fam,
-			    format,
-			    usage,
-			    samples,
-			    width, height,
-			    &image->handle);
+	image_create_mips(device, queue_fam, dev_mem_props,
+			  format, usage, req_props, aspect, samples,
+			  width, height, 1,
+			  image);
+}
+
+void image_create_mips(VkDevice device,
+		       uint32_t queue_fam,
+		       VkPhysicalDeviceMemoryProperties dev_mem_props,
+		       VkFormat format,
+		       VkImageUsageFlags usage,
+		       VkMemoryPropertyFlags req_props,
+		       VkImageAspectFlagBits aspect,
+		       VkSampleCountFlagBits samples,
+		       uint32_t width, uint32_t height,
+		       uint32_t mip_ct,
+		       struct Image *image)
+{
+	image_handle_create_mips(device,
+				 queue_fam,
+				 format,
+				 usage,
+				 samples,
+				 width, height,
+				 mip_ct,
+				 &image->handle);
 
 	image_memory_bind(device,
 			  dev_mem_props,
@@ -30,11 +50,25 @@ void image_create(VkDevice device,
 			  image->handle,
 			  &image->memory);
 
-	image_view_create(device,
-			  format,
-			  aspect,
-			  image->handle,
-			  &image->view);
+	image_view_create_levels(device,
+				 format,
+				 aspect,
+				 0, mip_ct,
+				 image->handle,
+				 &image->view);
+}
+
+uint32_t image_mip_ct(uint32_t width, uint32_t height)
+{
+	uint32_t size = width > height ? width : height;
+
+	uint32_t mip_ct = 1;
+	while (size > 1) {
+		size /= 2;
+		mip_ct++;
+	}
+
+	return mip_ct;
 }
 
 void image_destroy(VkDevice device,
@@ -55,31 +89,13 @@ void image_transition(VkDevice device,
 		      VkPipelineStageFlags dst_stage,
 		      VkImageLayout old_lt, VkImageLayout new_lt)
 {
-	VkImageMemoryBarrier barrier = {0};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	barrier.oldLayout = old_lt;
-	barrier.newLayout = new_lt;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = aspect;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
-	barrier.srcAccessMask = src_mask;
-	barrier.dstAccessMask = dst_mask;
-
 	VkCommandBuffer cbuf;
 	cbuf_begin_one_time(device, cpool, &cbuf);
-	
-	vkCmdPipelineBarrier(cbuf,
-			     src_stage,
-			     dst_stage,
-			     0,
-			     0, NULL,
-			     0, NULL,
-			     1, &barrier);
+
+	image_transition_cmd(cbuf, image, aspect,
+			     src_mask, dst_mask,
+			     src_stage, dst_stage,
+			     old_lt, new_lt);
 
 	VkResult res = vkEndCommandBuffer(cbuf);
 	assert(res == VK_SUCCESS);
@@ -97,6 +113,23 @@ void image_transition(VkDevice device,
 	vkFreeCommandBuffers(device, cpool, 1, &cbuf);
 }
 
+void image_transition_cmd(VkCommandBuffer cbuf,
+			  VkImage image,
+			  VkImageAspectFlags aspect,
+			  VkAccessFlags src_mask, VkAccessFlags dst_mask,
+			  VkPipelineStageFlags src_stage,
+			  VkPipelineStageFlags dst_stage,
+			  VkImageLayout old_lt, VkImageLayout new_lt)
+{
+	struct BarrierBatch batch;
+	barrier_batch_create(NULL, &batch);
+	barrier_batch_image(&batch, image, aspect, 0, 1,
+			    src_mask, dst_mask,
+			    src_stage, dst_stage,
+			    old_lt, new_lt);
+	barrier_batch_record(&batch, cbuf);
+}
+
 void copy_image_buffer(VkDevice device,
 		       VkQueue queue,
 		       VkCommandPool cpool,
@@ -184,6 +217,20 @@ void image_handle_create(VkDevice device,
 			 VkSampleCountFlagBits samples,
 			 uint32_t width, uint32_t height,
 			 VkImage *image)
+{
+	image_handle_create_mips(device, queue_fam, format, usage, samples,
+				 width, height, 1,
+				 image);
+}
+
+void image_handle_create_mips(VkDevice device,
+			      uint32_t queue_fam,
+			      VkFormat format,
+			      VkImageUsageFlags usage,
+			      VkSampleCountFlagBits samples,
+			      uint32_t width, uint32_t height,
+			      uint32_t mip_ct,
+			      VkImage *image)
 {
 	VkImageCreateInfo info = {
 		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
@@ -194,7 +241,7 @@ void image_handle_create(VkDevice device,
 			.height = height,
 			.depth = 1,
 		},
-		.mipLevels = 1,
+		.mipLevels = mip_ct,
 		.arrayLayers = 1,
 		.samples = samples,
 		.tiling = VK_IMAGE_TILING_OPTIMAL,
@@ -242,6 +289,16 @@ void image_view_create(VkDevice device,
 		       VkImageAspectFlagBits aspect,
 		       VkImage image,
 		       VkImageView *view)
+{
+	image_view_create_levels(device, format, aspect, 0, 1, image, view);
+}
+
+void image_view_create_levels(VkDevice device,
+			      VkFormat format,
+			      VkImageAspectFlagBits aspect,
+			      uint32_t base_level, uint32_t level_ct,
+			      VkImage image,
+			      VkImageView *view)
 {
 	VkImageViewCreateInfo info = {
 		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
@@ -255,8 +312,8 @@ void image_view_create(VkDevice device,
 			.a = VK_COMPONENT_SWIZZLE_IDENTITY
 		},
 		.subresourceRange.aspectMask = aspect,
-		.subresourceRange.baseMipLevel = 0,
-		.subresourceRange.levelCount = 1,
+		.subresourceRange.baseMipLevel = base_level,
+		.subresourceRange.levelCount = level_ct,
 		.subresourceRange.baseArrayLayer = 0,
 		.subresourceRange.layerCount = 1
 	};
@@ -20,10 +20,32 @@ void image_create(VkDevice device,
 		  VkImageUsageFlags usage,
 		  VkMemoryPropertyFlags req_props,
 		  VkImageAspectFlagBits aspect,
-		  uint32_t width, uint32_t height,
 		  VkSampleCountFlagBits samples,
+		  uint32_t width, uint32_t height,
 		  struct Image *image);
 
+/*
+ * Same as image_create, but with <mip_ct> mip levels. The view covers all of
+ * them. Fill in the levels after the first with mip_gen_record.
+ */
+void image_create_mips(VkDevice device,
+		       uint32_t queue_fam,
+		       VkPhysicalDeviceMemoryProperties dev_mem_props,
+		       VkFormat format,
+		       VkImageUsageFlags usage,
+		       VkMemoryPropertyFlags req_props,
+		       VkImageAspectFlagBits aspect,
+		       VkSampleCountFlagBits samples,
+		       uint32_t width, uint32_t height,
+		       uint32_t mip_ct,
+		       struct Image *image);
+
+/*
+ * Number of mip levels in a full chain for an image of the given size, down to
+ * 1x1.
+ */
+uint32_t image_mip_ct(uint32_t width, uint32_t height);
+
 /*
  * Transitions an image's layout.
  *
@@ -43,6 +65,19 @@ void image_transition(VkDevice device, VkQueue queue,
 		      VkPipelineStageFlags dst_stage,
 		      VkImageLayout old_lt, VkImageLayout new_lt);
 
+/*
+ * Same as image_transition, but records the barrier into a command buffer
+ * that is already recording instead of submitting and waiting. To record
+ * several barriers at once, use a BarrierBatch.
+ */
+void image_transition_cmd(VkCommandBuffer cbuf,
+			  VkImage image,
+			  VkImageAspectFlags aspect,
+			  VkAccessFlags src_mask, VkAccessFlags dst_mask,
+			  VkPipelineStageFlags src_stage,
+			  VkPipelineStageFlags dst_stage,
+			  VkImageLayout old_lt, VkImageLayout new_lt);
+
 /*
  * Copy an given image to a given buffer.
  *
@@ -88,6 +123,18 @@ void image_handle_create(VkDevice device,
 			 uint32_t width, uint32_t height,
 			 VkImage *image);
 
+/*
+ * Same as image_handle_create, but with <mip_ct> mip levels.
+ */
+void image_handle_create_mips(VkDevice device,
+			      uint32_t queue_fam,
+			      VkFormat format,
+			      VkImageUsageFlags usage,
+			      VkSampleCountFlagBits samples,
+			      uint32_t width, uint32_t height,
+			      uint32_t mip_ct,
+			      VkImage *image);
+
 /*
  * Allocates and binds memory for an image.
  */
@@ -106,6 +153,16 @@ void image_view_create(VkDevice device,
 		       VkImage image,
 		       VkImageView *view);
 
+/*
+ * Creates an image view of mip levels [base_level, base_level + level_ct).
+ */
+void image_view_create_levels(VkDevice device,
+			      VkFormat format,
+			      VkImageAspectFlagBits aspect,
+			      uint32_t base_level, uint32_t level_ct,
+			      VkImage image,
+			      VkImageView *view);
+
 /*
  * Destroys an Image struct and all associated resources
  */
@@ -0,0 +1,422 @@
+#include "vk_mips.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "vk_image.h"
+#include "vk_pipe.h"
+#include "vk_uniform.h"
+#include "vk_barrier.h"
+
+// Must match local_size in the shader
+#define MIPS_GROUP_SIZE 8
+
+static uint32_t level_size(uint32_t size, uint32_t level)
+{
+	size >>= level;
+	return size == 0 ? 1 : size;
+}
+
+int mip_method_supported(VkPhysicalDevice phys_dev, VkFormat format,
+			 enum MipMethod method)
+{
+	VkFormatProperties props;
+	vkGetPhysicalDeviceFormatProperties(phys_dev, format, &props);
+	VkFormatFeatureFlags features = props.optimalTilingFeatures;
+
+	if (method == MIP_METHOD_BLIT) {
+		VkFormatFeatureFlags blit = VK_FORMAT_FEATURE_BLIT_SRC_BIT
+			| VK_FORMAT_FEATURE_BLIT_DST_BIT
+			| VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		return (features & blit) == blit;
+	}
+
+	if (method == MIP_METHOD_COMPUTE) {
+		// The shader writes without a format, so it works for any
+		// format that can be a storage image
+		VkPhysicalDeviceFeatures dev_features;
+		vkGetPhysicalDeviceFeatures(phys_dev, &dev_features);
+
+		VkFormatFeatureFlags compute =
+			VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+			| VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+		return (features & compute) == compute
+			&& dev_features.shaderStorageImageWriteWithoutFormat;
+	}
+
+	return 0;
+}
+
+enum MipMethod mip_method(VkPhysicalDevice phys_dev, VkFormat format)
+{
+	if (mip_method_supported(phys_dev, format, MIP_METHOD_BLIT)) {
+		return MIP_METHOD_BLIT;
+	}
+	if (mip_method_supported(phys_dev, format, MIP_METHOD_COMPUTE)) {
+		return MIP_METHOD_COMPUTE;
+	}
+
+	return MIP_METHOD_NONE;
+}
+
+VkImageUsageFlags mip_gen_usage(VkPhysicalDevice phys_dev, VkFormat format)
+{
+	switch (mip_method(phys_dev, format)) {
+	case MIP_METHOD_BLIT:
+		return VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+			| VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	case MIP_METHOD_COMPUTE:
+		return VK_IMAGE_USAGE_SAMPLED_BIT
+			| VK_IMAGE_USAGE_STORAGE_BIT;
+	default:
+		return 0;
+	}
+}
+
+void mip_gen_create(VkPhysicalDevice phys_dev, VkPipelineCache pcache,
+		    struct MipGen *gen)
+{
+	gen->phys_dev = phys_dev;
+	gen->pcache = pcache;
+	gen->forced = MIP_METHOD_NONE;
+
+	gen->desc_layout = VK_NULL_HANDLE;
+	gen->layout = VK_NULL_HANDLE;
+	gen->pipel = VK_NULL_HANDLE;
+	gen->sampler = VK_NULL_HANDLE;
+
+	gen->view_ct = 0;
+	gen->views = NULL;
+	gen->dpool_ct = 0;
+	gen->dpools = NULL;
+}
+
+static void create_compute_objects(VkDevice device, struct MipGen *gen)
+{
+	VkDescriptorSetLayoutBinding bindings[2];
+	create_descriptor_binding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				  VK_SHADER_STAGE_COMPUTE_BIT, &bindings[0]);
+	create_descriptor_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+				  VK_SHADER_STAGE_COMPUTE_BIT, &bindings[1]);
+	create_descriptor_layout(device, 2, bindings, &gen->desc_layout);
+
+	FILE *fp = fopen(MIPS_SHADER_PATH, "rb");
+	assert(fp != NULL);
+
+	size_t cs_size;
+	read_bin(fp, &cs_size, NULL);
+	char *cs_buf = malloc(cs_size);
+	read_bin(fp, &cs_size, cs_buf);
+	fclose(fp);
+
+	VkShaderModule cs_mod;
+	create_shmod(device, cs_size, cs_buf, &cs_mod);
+	free(cs_buf);
+
+	VkPipelineShaderStageCreateInfo cs_stage;
+	create_shtage(cs_mod, VK_SHADER_STAGE_COMPUTE_BIT, &cs_stage);
+
+	create_layout(device, 1, &gen->desc_layout, 0, NULL, &gen->layout);
+	create_compute_pipel(device, gen->pcache, cs_stage, gen->layout,
+			     &gen->pipel);
+
+	vkDestroyShaderModule(device, cs_mod, NULL);
+
+	// Texels are fetched, not filtered
+	VkSamplerCreateInfo sampler_info = {0};
+	sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_info.magFilter = VK_FILTER_NEAREST;
+	sampler_info.minFilter = VK_FILTER_NEAREST;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+
+	VkResult res = vkCreateSampler(device, &sampler_info, NULL,
+				       &gen->sampler);
+	assert(res == VK_SUCCESS);
+}
+
+static void record_blit(VkCommandBuffer cbuf,
+			VkImage image,
+			uint32_t width, uint32_t height,
+			uint32_t mip_ct)
+{
+	struct BarrierBatch batch;
+	barrier_batch_create(NULL, &batch);
+
+	for (uint32_t i = 1; i < mip_ct; i++) {
+		// Read the level above, write this one
+		barrier_batch_image(&batch, image, VK_IMAGE_ASPECT_COLOR_BIT,
+				    i - 1, 1,
+				    VK_ACCESS_TRANSFER_WRITE_BIT,
+				    VK_ACCESS_TRANSFER_READ_BIT,
+				    VK_PIPELINE_STAGE_TRANSFER_BIT,
+				    VK_PIPELINE_STAGE_TRANSFER_BIT,
+				    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+		barrier_batch_image(&batch, image, VK_IMAGE_ASPECT_COLOR_BIT,
+				    i, 1,
+				    0,
+				    VK_ACCESS_TRANSFER_WRITE_BIT,
+				    VK_PIPELINE_STAGE_TRANSFER_BIT,
+				    VK_PIPELINE_STAGE_TRANSFER_BIT,
+				    VK_IMAGE_LAYOUT_UNDEFINED,
+				    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		barrier_batch_record(&batch, cbuf);
+
+		VkImageBlit blit = {0};
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = i - 1;
+		blit.srcSubresource.baseArrayLayer = 0;
+		blit.srcSubresource.layerCount = 1;
+		blit.srcOffsets[1].x = level_size(width, i - 1);
+		blit.srcOffsets[1].y = level_size(height, i - 1);
+		blit.srcOffsets[1].z = 1;
+
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = i;
+		blit.dstSubresource.baseArrayLayer = 0;
+		blit.dstSubresource.layerCount = 1;
+		blit.dstOffsets[1].x = level_size(width, i);
+		blit.dstOffsets[1].y = level_size(height, i);
+		blit.dstOffsets[1].z = 1;
+
+		vkCmdBlitImage(cbuf,
+			       image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			       image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			       1, &blit,
+			       VK_FILTER_LINEAR);
+	}
+}
+
+// Views and sets for one image, kept until mip_gen_reset
+static VkDescriptorSet *alloc_level_sets(VkDevice device, struct MipGen *gen,
+					 VkImage image, VkFormat format,
+					 uint32_t mip_ct)
+{
+	gen->views = realloc(gen->views,
+			     sizeof(gen->views[0]) * (gen->view_ct + mip_ct));
+	VkImageView *views = &gen->views[gen->view_ct];
+	gen->view_ct += mip_ct;
+
+	for (uint32_t i = 0; i < mip_ct; i++) {
+		image_view_create_levels(device, format,
+					 VK_IMAGE_ASPECT_COLOR_BIT,
+					 i, 1,
+					 image, &views[i]);
+	}
+
+	uint32_t set_ct = mip_ct - 1;
+
+	VkDescriptorPoolSize pool_sizes[2] = {0};
+	pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pool_sizes[0].descriptorCount = set_ct;
+	pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	pool_sizes[1].descriptorCount = set_ct;
+
+	VkDescriptorPoolCreateInfo pool_info = {0};
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.poolSizeCount = 2;
+	pool_info.pPoolSizes = pool_sizes;
+	pool_info.maxSets = set_ct;
+
+	gen->dpools = realloc(gen->dpools,
+			      sizeof(gen->dpools[0]) * (gen->dpool_ct + 1));
+	VkDescriptorPool *dpool = &gen->dpools[gen->dpool_ct++];
+
+	VkResult res = vkCreateDescriptorPool(device, &pool_info, NULL, dpool);
+	assert(res == VK_SUCCESS);
+
+	// Set i - 1 reads level i - 1 and writes level i
+	VkDescriptorSet *sets = malloc(sizeof(sets[0]) * set_ct);
+	for (uint32_t i = 1; i < mip_ct; i++) {
+		VkDescriptorSet set;
+		allocate_descriptor_set(device, *dpool, gen->desc_layout, &set);
+		sets[i - 1] = set;
+
+		VkDescriptorImageInfo src_info = {0};
+		src_info.sampler = gen->sampler;
+		src_info.imageView = views[i - 1];
+		src_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkDescriptorImageInfo dst_info = {0};
+		dst_info.imageView = views[i];
+		dst_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet writes[2] = {0};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = set;
+		writes[0].dstBinding = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType =
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &src_info;
+
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = set;
+		writes[1].dstBinding = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo = &dst_info;
+
+		vkUpdateDescriptorSets(device, 2, writes, 0, NULL);
+	}
+
+	return sets;
+}
+
+static void record_compute(VkDevice device, struct MipGen *gen,
+			   VkCommandBuffer cbuf,
+			   VkImage image, VkFormat format,
+			   uint32_t width, uint32_t height,
+			   uint32_t mip_ct)
+{
+	if (gen->pipel == VK_NULL_HANDLE) create_compute_objects(device, gen);
+
+	VkDescriptorSet *sets = alloc_level_sets(device, gen, image, format,
+						 mip_ct);
+
+	// Level 0 is read, the rest are written in turn
+	struct BarrierBatch batch;
+	barrier_batch_create(NULL, &batch);
+
+	barrier_batch_image(&batch, image, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1,
+			    VK_ACCESS_TRANSFER_WRITE_BIT,
+			    VK_ACCESS_SHADER_READ_BIT,
+			    VK_PIPELINE_STAGE_TRANSFER_BIT,
+			    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	barrier_batch_image(&batch, image, VK_IMAGE_ASPECT_COLOR_BIT,
+			    1, mip_ct - 1,
+			    0,
+			    VK_ACCESS_SHADER_WRITE_BIT,
+			    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			    VK_IMAGE_LAYOUT_UNDEFINED,
+			    VK_IMAGE_LAYOUT_GENERAL);
+	barrier_batch_record(&batch, cbuf);
+
+	vkCmdBindPipeline(cbuf, VK_PIPELINE_BIND_POINT_COMPUTE, gen->pipel);
+
+	for (uint32_t i = 1; i < mip_ct; i++) {
+		vkCmdBindDescriptorSets(cbuf,
+					VK_PIPELINE_BIND_POINT_COMPUTE,
+					gen->layout,
+					0,
+					1, &sets[i - 1],
+					0, NULL);
+
+		uint32_t w = level_size(width, i);
+		uint32_t h = level_size(height, i);
+		vkCmdDispatch(cbuf,
+			      (w + MIPS_GROUP_SIZE - 1) / MIPS_GROUP_SIZE,
+			      (h + MIPS_GROUP_SIZE - 1) / MIPS_GROUP_SIZE,
+			      1);
+
+		// The next level reads this one
+		barrier_batch_image(&batch, image, VK_IMAGE_ASPECT_COLOR_BIT,
+				    i, 1,
+				    VK_ACCESS_SHADER_WRITE_BIT,
+				    VK_ACCESS_SHADER_READ_BIT,
+				    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				    VK_IMAGE_LAYOUT_GENERAL,
+				    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		barrier_batch_record(&batch, cbuf);
+	}
+
+	free(sets);
+}
+
+void mip_gen_record(VkDevice device, struct MipGen *gen,
+		    VkCommandBuffer cbuf,
+		    VkImage image, VkFormat format,
+		    uint32_t width, uint32_t height,
+		    uint32_t mip_ct,
+		    VkAccessFlags dst_access, VkPipelineStageFlags dst_stage,
+		    VkImageLayout final_lt)
+{
+	assert(mip_ct >= 1);
+
+	struct BarrierBatch batch;
+	barrier_batch_create(NULL, &batch);
+
+	enum MipMethod method = gen->forced;
+	if (method == MIP_METHOD_NONE) {
+		method = mip_method(gen->phys_dev, format);
+	}
+	if (mip_ct > 1) {
+		assert(mip_method_supported(gen->phys_dev, format, method));
+	}
+
+	if (mip_ct == 1) {
+		barrier_batch_image(&batch, image, VK_IMAGE_ASPECT_COLOR_BIT,
+				    0, 1,
+				    VK_ACCESS_TRANSFER_WRITE_BIT, dst_access,
+				    VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage,
+				    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				    final_lt);
+	} else if (method == MIP_METHOD_BLIT) {
+		record_blit(cbuf, image, width, height, mip_ct);
+
+		// Every level but the last was blitted from, the last was
+		// only written
+		barrier_batch_image(&batch, image, VK_IMAGE_ASPECT_COLOR_BIT,
+				    0, mip_ct - 1,
+				    0, dst_access,
+				    VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage,
+				    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				    final_lt);
+		barrier_batch_image(&batch, image, VK_IMAGE_ASPECT_COLOR_BIT,
+				    mip_ct - 1, 1,
+				    VK_ACCESS_TRANSFER_WRITE_BIT, dst_access,
+				    VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage,
+				    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				    final_lt);
+	} else {
+		record_compute(device, gen, cbuf, image, format,
+			       width, height, mip_ct);
+
+		barrier_batch_image(&batch, image, VK_IMAGE_ASPECT_COLOR_BIT,
+				    0, mip_ct,
+				    VK_ACCESS_SHADER_WRITE_BIT, dst_access,
+				    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				    dst_stage,
+				    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				    final_lt);
+	}
+
+	barrier_batch_record(&batch, cbuf);
+}
+
+void mip_gen_reset(VkDevice device, struct MipGen *gen)
+{
+	for (uint32_t i = 0; i < gen->view_ct; i++) {
+		vkDestroyImageView(device, gen->views[i], NULL);
+	}
+	for (uint32_t i = 0; i < gen->dpool_ct; i++) {
+		vkDestroyDescriptorPool(device, gen->dpools[i], NULL);
+	}
+
+	free(gen->views);
+	free(gen->dpools);
+	gen->view_ct = 0;
+	gen->views = NULL;
+	gen->dpool_ct = 0;
+	gen->dpools = NULL;
+}
+
+void mip_gen_destroy(VkDevice device, struct MipGen gen)
+{
+	mip_gen_reset(device, &gen);
+
+	if (gen.pipel == VK_NULL_HANDLE) return;
+
+	vkDestroyPipeline(device, gen.pipel, NULL);
+	vkDestroyPipelineLayout(device, gen.layout, NULL);
+	vkDestroyDescriptorSetLayout(device, gen.desc_layout, NULL);
+	vkDestroySampler(device, gen.sampler, NULL);
+}
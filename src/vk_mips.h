@@ -0,0 +1,100 @@
+#ifndef VK_MIPS_H_
+#define VK_MIPS_H_
+
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#define MIPS_SHADER_PATH "assets/shaders/mips/downsample.comp.spv"
+
+enum MipMethod {
+	// Chained vkCmdBlitImage with linear filtering, each level from the
+	// one above it
+	MIP_METHOD_BLIT,
+	// A compute shader averaging blocks of texels, for formats that can't
+	// be blitted with linear filtering
+	MIP_METHOD_COMPUTE,
+	// Neither works for the format
+	MIP_METHOD_NONE
+};
+
+/*
+ * Fills in the mip levels of images from level 0, on the GPU.
+ *
+ * The compute path needs a pipeline and, for every image, a view per level
+ * and descriptor sets. The pipeline is only created the first time it's
+ * needed. The views and sets are kept until mip_gen_reset, since the device
+ * uses them after recording.
+ */
+struct MipGen {
+	VkPhysicalDevice phys_dev;
+	VkPipelineCache pcache;
+	// MIP_METHOD_NONE (what mip_gen_create sets) to use mip_method for
+	// every format, or a method to always use, like to test it
+	enum MipMethod forced;
+
+	// Compute path. VK_NULL_HANDLE until first used.
+	VkDescriptorSetLayout desc_layout;
+	VkPipelineLayout layout;
+	VkPipeline pipel;
+	VkSampler sampler;
+
+	// Used by recorded work, until mip_gen_reset
+	uint32_t view_ct;
+	VkImageView *views;
+	uint32_t dpool_ct;
+	VkDescriptorPool *dpools;
+};
+
+/*
+ * Which method mip_gen_record would use for <format>.
+ */
+enum MipMethod mip_method(VkPhysicalDevice phys_dev, VkFormat format);
+
+/*
+ * Returns 1 if <method> works for <format>, 0 otherwise.
+ */
+int mip_method_supported(VkPhysicalDevice phys_dev, VkFormat format,
+			 enum MipMethod method);
+
+/*
+ * Usage flags an image of <format> needs, on top of whatever else it's used
+ * for, so mip_gen_record can fill in its levels. Only right for a MipGen
+ * that isn't forced to another method.
+ */
+VkImageUsageFlags mip_gen_usage(VkPhysicalDevice phys_dev, VkFormat format);
+
+/*
+ * pcache: For the compute pipeline, or VK_NULL_HANDLE. Must outlive gen.
+ */
+void mip_gen_create(VkPhysicalDevice phys_dev, VkPipelineCache pcache,
+		    struct MipGen *gen);
+
+/*
+ * Records filling in levels 1 to mip_ct - 1 of a color image from level 0, then
+ * moving every level into <final_lt>.
+ *
+ * Level 0 must be in TRANSFER_DST_OPTIMAL and have just been written by a
+ * transfer (like copy_buffer_image_cmd). The other levels' contents are
+ * discarded. If gen->forced is set, it must be supported for <format>.
+ *
+ * dst_access, dst_stage: How the image will be used after, like
+ *                        VK_ACCESS_SHADER_READ_BIT from
+ *                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+ */
+void mip_gen_record(VkDevice device, struct MipGen *gen,
+		    VkCommandBuffer cbuf,
+		    VkImage image, VkFormat format,
+		    uint32_t width, uint32_t height,
+		    uint32_t mip_ct,
+		    VkAccessFlags dst_access, VkPipelineStageFlags dst_stage,
+		    VkImageLayout final_lt);
+
+/*
+ * Frees what recorded work used. The device must be done with it.
+ */
+void mip_gen_reset(VkDevice device, struct MipGen *gen);
+
+void mip_gen_destroy(VkDevice device, struct MipGen gen);
+
+#endif // VK_MIPS_H_
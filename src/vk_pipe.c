@@ -48,28 +48,35 @@ void create_shtage(VkShaderModule shmod,
 void create_layout(VkDevice device,
 		   uint32_t desc_layout_ct,
 		   VkDescriptorSetLayout *desc_layouts,
+		   uint32_t push_range_ct,
+		   VkPushConstantRange *push_ranges,
 		   VkPipelineLayout *layout)
 {
 	VkPipelineLayoutCreateInfo info = {0};
 	info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	info.setLayoutCount = desc_layout_ct;
 	info.pSetLayouts = desc_layouts;
+	info.pushConstantRangeCount = push_range_ct;
+	info.pPushConstantRanges = push_ranges;
 
 	VkResult res = vkCreatePipelineLayout(device, &info, NULL, layout);
 	assert(res == VK_SUCCESS);
 }
 
-void create_pipel(VkDevice device,
-		  uint32_t shtage_ct,
-		  VkPipelineShaderStageCreateInfo *shtages,
-		  VkPipelineLayout layout,
-		  uint32_t binding_ct,
-		  VkVertexInputBindingDescription *binding_descs,
-		  uint32_t attr_ct,
-		  VkVertexInputAttributeDescription *attr_descs,
-		  VkRenderPass rpass,
-		  int has_depth, VkSampleCountFlagBits samples,
-		  VkPipeline *pipel)
+// Shared by both pipeline kinds. <next> is chained onto the create info.
+static void create_graphics_pipel(VkDevice device,
+				  VkPipelineCache pcache,
+				  uint32_t shtage_ct,
+				  VkPipelineShaderStageCreateInfo *shtages,
+				  VkPipelineLayout layout,
+				  uint32_t binding_ct,
+				  VkVertexInputBindingDescription *binding_descs,
+				  uint32_t attr_ct,
+				  VkVertexInputAttributeDescription *attr_descs,
+				  VkRenderPass rpass,
+				  int has_depth, VkSampleCountFlagBits samples,
+				  const void *next,
+				  VkPipeline *pipel)
 {
 	VkPipelineVertexInputStateCreateInfo vertex_input = {0};
 	vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -156,6 +163,7 @@ void create_pipel(VkDevice device,
 
 	VkGraphicsPipelineCreateInfo info = {0};
 	info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	info.pNext = next;
 	info.stageCount = shtage_ct;
 	info.pStages = shtages;
 	info.pVertexInputState = &vertex_input;
@@ -171,10 +179,74 @@ void create_pipel(VkDevice device,
 	info.subpass = 0;
 
 	VkResult res = vkCreateGraphicsPipelines(device,
-						 VK_NULL_HANDLE,
+						 pcache,
 						 1,
 						 &info,
 						 NULL,
 						 pipel);
 	assert(res == VK_SUCCESS);
 }
+
+void create_pipel(VkDevice device,
+		  VkPipelineCache pcache,
+		  uint32_t shtage_ct,
+		  VkPipelineShaderStageCreateInfo *shtages,
+		  VkPipelineLayout layout,
+		  uint32_t binding_ct,
+		  VkVertexInputBindingDescription *binding_descs,
+		  uint32_t attr_ct,
+		  VkVertexInputAttributeDescription *attr_descs,
+		  VkRenderPass rpass,
+		  int has_depth, VkSampleCountFlagBits samples,
+		  VkPipeline *pipel)
+{
+	create_graphics_pipel(device, pcache, shtage_ct, shtages, layout,
+			      binding_ct, binding_descs, attr_ct, attr_descs,
+			      rpass, has_depth, samples, NULL, pipel);
+}
+
+void create_pipel_dynamic(VkDevice device,
+			  VkPipelineCache pcache,
+			  uint32_t shtage_ct,
+			  VkPipelineShaderStageCreateInfo *shtages,
+			  VkPipelineLayout layout,
+			  uint32_t binding_ct,
+			  VkVertexInputBindingDescription *binding_descs,
+			  uint32_t attr_ct,
+			  VkVertexInputAttributeDescription *attr_descs,
+			  VkFormat color_fmt, VkFormat depth_fmt,
+			  VkSampleCountFlagBits samples,
+			  VkPipeline *pipel)
+{
+	VkPipelineRenderingCreateInfoKHR rendering_info = {0};
+	rendering_info.sType =
+		VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	rendering_info.colorAttachmentCount = 1;
+	rendering_info.pColorAttachmentFormats = &color_fmt;
+	rendering_info.depthAttachmentFormat = depth_fmt;
+
+	create_graphics_pipel(device, pcache, shtage_ct, shtages, layout,
+			      binding_ct, binding_descs, attr_ct, attr_descs,
+			      VK_NULL_HANDLE, depth_fmt != VK_FORMAT_UNDEFINED,
+			      samples, &rendering_info, pipel);
+}
+
+void create_compute_pipel(VkDevice device,
+			  VkPipelineCache pcache,
+			  VkPipelineShaderStageCreateInfo shtage,
+			  VkPipelineLayout layout,
+			  VkPipeline *pipel)
+{
+	VkComputePipelineCreateInfo info = {0};
+	info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	info.stage = shtage;
+	info.layout = layout;
+
+	VkResult res = vkCreateComputePipelines(device,
+						pcache,
+						1,
+						&info,
+						NULL,
+						pipel);
+	assert(res == VK_SUCCESS);
+}
@@ -12,17 +12,33 @@ void create_shmod(VkDevice device,
 		  char *code,
 		  VkShaderModule *shmod);
 
+/*
+ * Creates a pipeline layout from descriptor set layouts and push-constant
+ * ranges.
+ *
+ * Push constants are recorded straight into the command buffer, so small
+ * per-draw data (like a model matrix, see DrawPush) doesn't need a buffer
+ * write or a descriptor set each. The ranges' total size must fit in
+ * maxPushConstantsSize, which is at least 128 bytes.
+ *
+ * If desc_layout_ct or push_range_ct is 0, the matching array can be NULL.
+ */
 void create_layout(VkDevice device,
 		   uint32_t desc_layout_ct,
 		   VkDescriptorSetLayout *desc_layouts,
+		   uint32_t push_range_ct,
+		   VkPushConstantRange *push_ranges,
 		   VkPipelineLayout *layout);
 
 /*
  * Creates a graphics pipeline.
  *
+ * pcache: Pipeline cache to look the pipeline up in and add it to (see
+ *         PipeCache), or VK_NULL_HANDLE
  * has_pipe: Whether a depth stencil attachment will be used (1 = true)
  */
 void create_pipel(VkDevice device,
+		  VkPipelineCache pcache,
 		  uint32_t shtage_ct,
 		  VkPipelineShaderStageCreateInfo *shtages,
 		  VkPipelineLayout layout,
@@ -34,6 +50,36 @@ void create_pipel(VkDevice device,
 		  int has_depth, VkSampleCountFlagBits samples,
 		  VkPipeline *pipel);
 
+/*
+ * Same as create_pipel, but for dynamic rendering (see DynRender): instead of
+ * a render pass, takes the formats of the attachments it will render to.
+ *
+ * color_fmt: Format of the color attachment
+ * depth_fmt: Format of the depth attachment, or VK_FORMAT_UNDEFINED if there
+ *            isn't one
+ */
+void create_pipel_dynamic(VkDevice device,
+			  VkPipelineCache pcache,
+			  uint32_t shtage_ct,
+			  VkPipelineShaderStageCreateInfo *shtages,
+			  VkPipelineLayout layout,
+			  uint32_t binding_ct,
+			  VkVertexInputBindingDescription *binding_descs,
+			  uint32_t attr_ct,
+			  VkVertexInputAttributeDescription *attr_descs,
+			  VkFormat color_fmt, VkFormat depth_fmt,
+			  VkSampleCountFlagBits samples,
+			  VkPipeline *pipel);
+
+/*
+ * Creates a compute pipeline from a single compute shader stage.
+ */
+void create_compute_pipel(VkDevice device,
+			  VkPipelineCache pcache,
+			  VkPipelineShaderStageCreateInfo shtage,
+			  VkPipelineLayout layout,
+			  VkPipeline *pipel);
+
 void create_shtage(VkShaderModule shmod,
 		   VkShaderStageFlagBits stage,
 		   VkPipelineShaderStageCreateInfo *shtage);
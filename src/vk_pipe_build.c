@@ -0,0 +1,151 @@
+#include "vk_pipe_build.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "vk_pipe.h"
+
+static void build_one(struct PipeBuild *build, struct PipeBuildJob *job)
+{
+	struct PipeDesc *desc = &job->desc;
+
+	if (desc->rpass != VK_NULL_HANDLE) {
+		create_pipel(build->device, build->pcache,
+			     desc->shtage_ct, desc->shtages, desc->layout,
+			     desc->binding_ct, desc->binding_descs,
+			     desc->attr_ct, desc->attr_descs,
+			     desc->rpass, desc->has_depth, desc->samples,
+			     &job->pipel);
+	} else {
+		create_pipel_dynamic(build->device, build->pcache,
+				     desc->shtage_ct, desc->shtages,
+				     desc->layout,
+				     desc->binding_ct, desc->binding_descs,
+				     desc->attr_ct, desc->attr_descs,
+				     desc->color_fmt, desc->depth_fmt,
+				     desc->samples,
+				     &job->pipel);
+	}
+}
+
+static void *worker(void *data)
+{
+	struct PipeBuild *build = data;
+
+	while (1) {
+		// A signal can wake the wait early, without a post
+		while (sem_wait(&build->submitted) != 0) {
+			assert(errno == EINTR);
+		}
+
+		// Every job posts once, and stop only posts once the queued
+		// ones are done, so there's always a job to take if not
+		// stopping
+		if (atomic_load(&build->stop)) break;
+
+		uint32_t idx = atomic_fetch_add(&build->next_job, 1);
+		struct PipeBuildJob *job = &build->jobs[idx];
+
+		build_one(build, job);
+
+		pthread_mutex_lock(&build->done_lock);
+		atomic_store(&job->state, PIPE_BUILD_DONE);
+		pthread_cond_broadcast(&build->done);
+		pthread_mutex_unlock(&build->done_lock);
+	}
+
+	return NULL;
+}
+
+void pipe_build_create(VkDevice device, VkPipelineCache pcache,
+		       uint32_t worker_ct, struct PipeBuild *build)
+{
+	if (worker_ct == 0) {
+		long core_ct = sysconf(_SC_NPROCESSORS_ONLN);
+		worker_ct = core_ct > 0 ? core_ct : 1;
+		if (worker_ct > PIPE_BUILD_MAX_WORKERS) {
+			worker_ct = PIPE_BUILD_MAX_WORKERS;
+		}
+	}
+	assert(worker_ct <= PIPE_BUILD_MAX_WORKERS);
+
+	build->device = device;
+	build->pcache = pcache;
+	build->job_ct = 0;
+	build->worker_ct = worker_ct;
+
+	int err = sem_init(&build->submitted, 0, 0);
+	assert(err == 0);
+
+	atomic_init(&build->next_job, 0);
+	atomic_init(&build->stop, 0);
+
+	err = pthread_mutex_init(&build->done_lock, NULL);
+	assert(err == 0);
+	err = pthread_cond_init(&build->done, NULL);
+	assert(err == 0);
+
+	for (uint32_t i = 0; i < worker_ct; i++) {
+		err = pthread_create(&build->workers[i], NULL, worker, build);
+		assert(err == 0);
+	}
+}
+
+void pipe_build_destroy(struct PipeBuild *build)
+{
+	for (uint32_t i = 0; i < build->job_ct; i++) {
+		pipe_build_wait(build, i);
+	}
+
+	atomic_store(&build->stop, 1);
+	for (uint32_t i = 0; i < build->worker_ct; i++) {
+		sem_post(&build->submitted);
+	}
+
+	for (uint32_t i = 0; i < build->worker_ct; i++) {
+		int err = pthread_join(build->workers[i], NULL);
+		assert(err == 0);
+	}
+
+	pthread_cond_destroy(&build->done);
+	pthread_mutex_destroy(&build->done_lock);
+	sem_destroy(&build->submitted);
+}
+
+uint32_t pipe_build_submit(struct PipeBuild *build, const struct PipeDesc *desc)
+{
+	assert(build->job_ct < PIPE_BUILD_MAX);
+	assert(desc->shtage_ct <= PIPE_DESC_MAX_STAGES);
+
+	uint32_t id = build->job_ct++;
+	struct PipeBuildJob *job = &build->jobs[id];
+
+	job->desc = *desc;
+	job->pipel = VK_NULL_HANDLE;
+	atomic_init(&job->state, PIPE_BUILD_QUEUED);
+
+	sem_post(&build->submitted);
+
+	return id;
+}
+
+int pipe_build_ready(struct PipeBuild *build, uint32_t id)
+{
+	assert(id < build->job_ct);
+
+	return atomic_load(&build->jobs[id].state) == PIPE_BUILD_DONE;
+}
+
+VkPipeline pipe_build_wait(struct PipeBuild *build, uint32_t id)
+{
+	if (!pipe_build_ready(build, id)) {
+		pthread_mutex_lock(&build->done_lock);
+		while (!pipe_build_ready(build, id)) {
+			pthread_cond_wait(&build->done, &build->done_lock);
+		}
+		pthread_mutex_unlock(&build->done_lock);
+	}
+
+	return build->jobs[id].pipel;
+}
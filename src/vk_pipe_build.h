@@ -0,0 +1,123 @@
+#ifndef VK_PIPE_BUILD_H_
+#define VK_PIPE_BUILD_H_
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <vulkan/vulkan.h>
+
+// Most threads a PipeBuild can have
+#define PIPE_BUILD_MAX_WORKERS 16
+// Most pipelines a PipeBuild can ever be asked for
+#define PIPE_BUILD_MAX 64
+// Most shader stages in a PipeDesc
+#define PIPE_DESC_MAX_STAGES 5
+
+/*
+ * Everything create_pipel (or create_pipel_dynamic) takes to create a
+ * graphics pipeline.
+ *
+ * The stages are copied, but the shader modules, layout, render pass and
+ * vertex descriptions are only pointed to, and must stay alive until the
+ * pipeline is built.
+ */
+struct PipeDesc {
+	uint32_t shtage_ct;
+	VkPipelineShaderStageCreateInfo shtages[PIPE_DESC_MAX_STAGES];
+	VkPipelineLayout layout;
+
+	uint32_t binding_ct;
+	VkVertexInputBindingDescription *binding_descs;
+	uint32_t attr_ct;
+	VkVertexInputAttributeDescription *attr_descs;
+
+	// VK_NULL_HANDLE for dynamic rendering, with the attachment formats
+	// below instead
+	VkRenderPass rpass;
+	// Only used with a render pass
+	int has_depth;
+	// Only used with dynamic rendering. depth_fmt can be
+	// VK_FORMAT_UNDEFINED.
+	VkFormat color_fmt;
+	VkFormat depth_fmt;
+
+	VkSampleCountFlagBits samples;
+};
+
+enum PipeBuildState {
+	PIPE_BUILD_QUEUED,
+	PIPE_BUILD_DONE
+};
+
+struct PipeBuildJob {
+	struct PipeDesc desc;
+	atomic_int state;
+	// Written by a worker before state becomes PIPE_BUILD_DONE
+	VkPipeline pipel;
+};
+
+/*
+ * Creates pipelines on a pool of worker threads, so startup compiles several
+ * at once instead of one after another on the main thread.
+ *
+ * pipe_build_submit queues a description and returns its id right away.
+ * That id works as a future: pipe_build_ready polls it and pipe_build_wait
+ * blocks until the pipeline exists. The workers share one VkPipelineCache
+ * (like a PipeCache's), which Vulkan synchronizes internally.
+ *
+ * Submitting and waiting must happen on one thread. Must not be moved after
+ * creation, since the workers hold a pointer to it.
+ */
+struct PipeBuild {
+	VkDevice device;
+	VkPipelineCache pcache;
+
+	// Only appended to, by pipe_build_submit
+	uint32_t job_ct;
+	struct PipeBuildJob jobs[PIPE_BUILD_MAX];
+
+	uint32_t worker_ct;
+	pthread_t workers[PIPE_BUILD_MAX_WORKERS];
+	// Posted once for every job, and once per worker to stop
+	sem_t submitted;
+	atomic_uint next_job;
+	atomic_int stop;
+
+	// Signalled whenever a job is done, for pipe_build_wait
+	pthread_mutex_t done_lock;
+	pthread_cond_t done;
+};
+
+/*
+ * Starts the workers.
+ *
+ * pcache: Shared by every pipeline, or VK_NULL_HANDLE
+ * worker_ct: Threads to compile on, or 0 for one per CPU core. At most
+ *            PIPE_BUILD_MAX_WORKERS.
+ */
+void pipe_build_create(VkDevice device, VkPipelineCache pcache,
+		       uint32_t worker_ct, struct PipeBuild *build);
+
+/*
+ * Waits for every queued pipeline, then stops the workers. The pipelines
+ * belong to the caller and aren't destroyed.
+ */
+void pipe_build_destroy(struct PipeBuild *build);
+
+/*
+ * Queues a pipeline to be created and returns its id.
+ */
+uint32_t pipe_build_submit(struct PipeBuild *build, const struct PipeDesc *desc);
+
+/*
+ * Returns 1 if pipeline <id> has been created, 0 otherwise.
+ */
+int pipe_build_ready(struct PipeBuild *build, uint32_t id);
+
+/*
+ * Blocks until pipeline <id> has been created, and returns it.
+ */
+VkPipeline pipe_build_wait(struct PipeBuild *build, uint32_t id);
+
+#endif // VK_PIPE_BUILD_H_
@@ -0,0 +1,167 @@
+#include "vk_pipe_cache.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static uint64_t hash_data(const unsigned char *bytes, size_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3;
+	}
+
+	return hash;
+}
+
+// Returns the whole file, or NULL if it can't be read. Mallocs.
+static unsigned char *read_file(const char *path, size_t *size)
+{
+	FILE *fp = fopen(path, "rb");
+	if (fp == NULL) return NULL;
+
+	unsigned char *data = NULL;
+	long end;
+	if (fseek(fp, 0, SEEK_END) == 0 && (end = ftell(fp)) > 0) {
+		rewind(fp);
+
+		data = malloc(end);
+		if (fread(data, 1, end, fp) == (size_t) end) {
+			*size = end;
+		} else {
+			free(data);
+			data = NULL;
+		}
+	}
+
+	fclose(fp);
+
+	return data;
+}
+
+int pipe_cache_valid(const VkPhysicalDeviceProperties *props,
+		     const void *data, size_t size)
+{
+	struct PipeCacheFileHeader file;
+	if (size < sizeof(file)) return 0;
+	memcpy(&file, data, sizeof(file));
+
+	if (file.magic != PIPE_CACHE_MAGIC
+	    || file.driver_version != props->driverVersion
+	    || file.vendor_id != props->vendorID
+	    || file.device_id != props->deviceID
+	    || memcmp(file.uuid, props->pipelineCacheUUID, VK_UUID_SIZE) != 0
+	    || file.data_size != size - sizeof(file)) {
+		return 0;
+	}
+
+	const unsigned char *cache_data = (const unsigned char *) data
+		+ sizeof(file);
+	if (hash_data(cache_data, file.data_size) != file.hash) return 0;
+
+	// The driver checks its own header too, but a mismatch there is only
+	// reported as an empty cache
+	VkPipelineCacheHeaderVersionOne vk_header;
+	if (file.data_size < sizeof(vk_header)) return 0;
+	memcpy(&vk_header, cache_data, sizeof(vk_header));
+
+	return vk_header.headerSize >= sizeof(vk_header)
+		&& vk_header.headerVersion
+		== VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		&& vk_header.vendorID == props->vendorID
+		&& vk_header.deviceID == props->deviceID
+		&& memcmp(vk_header.pipelineCacheUUID, props->pipelineCacheUUID,
+			  VK_UUID_SIZE) == 0;
+}
+
+void pipe_cache_create(VkPhysicalDevice phys_dev, VkDevice device,
+		       const char *path, struct PipeCache *cache)
+{
+	VkPhysicalDeviceProperties props;
+	vkGetPhysicalDeviceProperties(phys_dev, &props);
+
+	cache->path = malloc(strlen(path) + 1);
+	strcpy(cache->path, path);
+	cache->loaded_size = 0;
+
+	size_t size = 0;
+	unsigned char *data = read_file(path, &size);
+
+	VkPipelineCacheCreateInfo info = {0};
+	info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+	if (data != NULL && pipe_cache_valid(&props, data, size)) {
+		cache->loaded_size = size - sizeof(struct PipeCacheFileHeader);
+		info.initialDataSize = cache->loaded_size;
+		info.pInitialData = data + sizeof(struct PipeCacheFileHeader);
+	}
+
+	VkResult res = vkCreatePipelineCache(device, &info, NULL,
+					     &cache->handle);
+	assert(res == VK_SUCCESS);
+
+	free(data);
+}
+
+int pipe_cache_save(VkPhysicalDevice phys_dev, VkDevice device,
+		    struct PipeCache *cache)
+{
+	VkPhysicalDeviceProperties props;
+	vkGetPhysicalDeviceProperties(phys_dev, &props);
+
+	size_t size;
+	VkResult res = vkGetPipelineCacheData(device, cache->handle, &size,
+					      NULL);
+	assert(res == VK_SUCCESS);
+
+	unsigned char *data = malloc(size);
+	res = vkGetPipelineCacheData(device, cache->handle, &size, data);
+	assert(res == VK_SUCCESS);
+
+	struct PipeCacheFileHeader file = {0};
+	file.magic = PIPE_CACHE_MAGIC;
+	file.driver_version = props.driverVersion;
+	file.vendor_id = props.vendorID;
+	file.device_id = props.deviceID;
+	memcpy(file.uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+	file.data_size = size;
+	file.hash = hash_data(data, size);
+
+	// Write elsewhere first so a partly written file is never loaded. The
+	// name is unique, since another process may be saving the same cache.
+	char tmp[PATH_MAX + 8];
+	snprintf(tmp, sizeof(tmp), "%s.XXXXXX", cache->path);
+
+	int ret = 1;
+	int fd = mkstemp(tmp);
+	FILE *fp = fd < 0 ? NULL : fdopen(fd, "wb");
+	if (fp != NULL) {
+		fwrite(&file, sizeof(file), 1, fp);
+		fwrite(data, 1, size, fp);
+		int err = ferror(fp);
+
+		if (fclose(fp) == 0 && !err && rename(tmp, cache->path) == 0) {
+			ret = 0;
+		} else {
+			remove(tmp);
+		}
+	} else if (fd >= 0) {
+		close(fd);
+		remove(tmp);
+	}
+
+	free(data);
+
+	return ret;
+}
+
+void pipe_cache_destroy(VkDevice device, struct PipeCache cache)
+{
+	vkDestroyPipelineCache(device, cache.handle, NULL);
+	free(cache.path);
+}
@@ -0,0 +1,74 @@
+#ifndef VK_PIPE_CACHE_H_
+#define VK_PIPE_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+// "VPCF", first four bytes of a pipeline cache file
+#define PIPE_CACHE_MAGIC 0x46435056
+
+/*
+ * Written in front of the driver's cache data.
+ *
+ * The driver's own header only names the device and a cache UUID. Some
+ * drivers don't change the UUID between versions, so the driver version is
+ * checked too, and the data is hashed to catch truncated or damaged files.
+ */
+struct PipeCacheFileHeader {
+	uint32_t magic;
+	uint32_t driver_version;
+	uint32_t vendor_id;
+	uint32_t device_id;
+	uint8_t uuid[VK_UUID_SIZE];
+	uint64_t data_size;
+	// FNV-1a of the data
+	uint64_t hash;
+};
+
+/*
+ * A VkPipelineCache kept on disk between runs, so pipelines compiled once
+ * don't have to be compiled from SPIR-V again on the next launch.
+ *
+ * Pass handle to create_pipel and friends. A file left by another device or
+ * driver, or one that is damaged, is ignored, and the cache starts empty.
+ */
+struct PipeCache {
+	VkPipelineCache handle;
+	char *path;
+
+	// Bytes of cache data that were loaded, 0 if the cache started empty
+	size_t loaded_size;
+};
+
+/*
+ * Creates the cache, filled from <path> if it holds valid data for this
+ * device and driver. A missing or invalid file isn't an error. Mallocs.
+ */
+void pipe_cache_create(VkPhysicalDevice phys_dev, VkDevice device,
+		       const char *path, struct PipeCache *cache);
+
+/*
+ * Writes the cache, with everything added since it was created, back to its
+ * path. Usually on shutdown, once all pipelines are created.
+ *
+ * Returns 0 on success, or 1 if the file couldn't be written. The old file is
+ * only replaced once the new one is complete.
+ */
+int pipe_cache_save(VkPhysicalDevice phys_dev, VkDevice device,
+		    struct PipeCache *cache);
+
+/*
+ * Destroys the cache without saving it.
+ */
+void pipe_cache_destroy(VkDevice device, struct PipeCache cache);
+
+/*
+ * Returns 1 if <data> (a pipeline cache file's contents) was written for this
+ * device and driver, and is complete. 0 otherwise.
+ */
+int pipe_cache_valid(const VkPhysicalDeviceProperties *props,
+		     const void *data, size_t size);
+
+#endif // VK_PIPE_CACHE_H_
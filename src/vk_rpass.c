@@ -109,6 +109,72 @@ void rpass_with_depth(VkDevice device,
 	assert(res == VK_SUCCESS);
 }
 
+void rpass_with_sampled_depth(VkDevice device,
+			      VkFormat c_format, VkFormat d_format,
+			      VkRenderPass *rpass)
+{
+	VkAttachmentDescription color_attachment = default_color_attachment;
+	color_attachment.format = c_format;
+
+	VkAttachmentDescription depth_attachment = default_depth_attachment;
+	depth_attachment.format = d_format;
+	depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depth_attachment.finalLayout =
+		VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+	VkAttachmentDescription attachments[] = {color_attachment,
+						 depth_attachment};
+
+	VkAttachmentReference color_attach_ref = {0};
+	color_attach_ref.attachment = 0;
+	color_attach_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depth_attach_ref = {0};
+	depth_attach_ref.attachment = 1;
+	depth_attach_ref.layout =
+		VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass = {0};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &color_attach_ref;
+	subpass.pDepthStencilAttachment = &depth_attach_ref;
+
+	VkSubpassDependency deps[2] = {0};
+
+	// Don't clear depth while the previous frame's compute pass still reads it
+	deps[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	deps[0].dstSubpass = 0;
+	deps[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+		| VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	deps[0].srcAccessMask = 0;
+	deps[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+		| VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	deps[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+		| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	// Make depth writes visible to compute shaders afterwards
+	deps[1].srcSubpass = 0;
+	deps[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	deps[1].srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+		| VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	deps[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	deps[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	deps[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	VkRenderPassCreateInfo info = {0};
+	info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	info.attachmentCount = ARRAY_SIZE(attachments);
+	info.pAttachments = attachments;
+	info.subpassCount = 1;
+	info.pSubpasses = &subpass;
+	info.dependencyCount = ARRAY_SIZE(deps);
+	info.pDependencies = deps;
+
+	VkResult res = vkCreateRenderPass(device, &info, NULL, rpass);
+	assert(res == VK_SUCCESS);
+}
+
 void rpass_multisampled_with_depth(VkDevice device,
 				   VkFormat c_format, VkFormat d_format,
 				   VkSampleCountFlagBits samples,
@@ -18,6 +18,17 @@ void rpass_with_depth(VkDevice device,
 		      VkFormat c_format, VkFormat d_format,
 		      VkRenderPass *rpass);
 
+/*
+ * Same as rpass_with_depth, but the depth attachment is stored and left in
+ * DEPTH_STENCIL_READ_ONLY_OPTIMAL, ready to be read by compute shaders (for
+ * example to build a HiZ pyramid).
+ *
+ * The depth image needs VK_IMAGE_USAGE_SAMPLED_BIT.
+ */
+void rpass_with_sampled_depth(VkDevice device,
+			      VkFormat c_format, VkFormat d_format,
+			      VkRenderPass *rpass);
+
 /*
  * Creates a multisampled renderpass with color and depth attachments, resolving
  * to the swapchain image.
@@ -0,0 +1,194 @@
+#include "vk_submit.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <sched.h>
+
+struct Batch {
+	uint32_t ct;
+	struct SubmitJob jobs[SUBMIT_MAX_BATCH];
+	VkTimelineSemaphoreSubmitInfo timeline_infos[SUBMIT_MAX_BATCH];
+	VkSubmitInfo infos[SUBMIT_MAX_BATCH];
+};
+
+static void submit_batch(struct SubmitService *svc, struct Batch *batch)
+{
+	for (uint32_t i = 0; i < batch->ct; i++) {
+		struct SubmitJob *job = &batch->jobs[i];
+
+		VkTimelineSemaphoreSubmitInfo *timeline_info =
+			&batch->timeline_infos[i];
+		*timeline_info = (VkTimelineSemaphoreSubmitInfo) {0};
+		timeline_info->sType =
+			VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timeline_info->waitSemaphoreValueCount = job->wait_ct;
+		timeline_info->pWaitSemaphoreValues = job->wait_values;
+		timeline_info->signalSemaphoreValueCount = job->signal_ct;
+		timeline_info->pSignalSemaphoreValues = job->signal_values;
+
+		VkSubmitInfo *info = &batch->infos[i];
+		*info = (VkSubmitInfo) {0};
+		info->sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		info->pNext = timeline_info;
+		info->waitSemaphoreCount = job->wait_ct;
+		info->pWaitSemaphores = job->waits;
+		info->pWaitDstStageMask = job->wait_stages;
+		info->commandBufferCount = job->cbuf != NULL;
+		info->pCommandBuffers = &job->cbuf;
+		info->signalSemaphoreCount = job->signal_ct;
+		info->pSignalSemaphores = job->signals;
+	}
+
+	VkResult res = vkQueueSubmit(svc->queue, batch->ct, batch->infos,
+				     VK_NULL_HANDLE);
+	assert(res == VK_SUCCESS);
+
+	// Presents go after the whole batch, since they wait on semaphores
+	// signalled by it
+	for (uint32_t i = 0; i < batch->ct; i++) {
+		struct SubmitJob *job = &batch->jobs[i];
+		if (job->swapchain == VK_NULL_HANDLE) continue;
+
+		VkPresentInfoKHR present_info = {0};
+		present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		present_info.waitSemaphoreCount =
+			job->present_wait != VK_NULL_HANDLE;
+		present_info.pWaitSemaphores = &job->present_wait;
+		present_info.swapchainCount = 1;
+		present_info.pSwapchains = &job->swapchain;
+		present_info.pImageIndices = &job->image_idx;
+
+		res = vkQueuePresentKHR(svc->queue, &present_info);
+		assert(res == VK_SUCCESS || res == VK_SUBOPTIMAL_KHR
+		       || res == VK_ERROR_OUT_OF_DATE_KHR);
+
+		// Kept until submit_service_present_result takes it, so a
+		// later successful present can't hide it. Out of date wins
+		// over suboptimal.
+		if (res == VK_ERROR_OUT_OF_DATE_KHR) {
+			atomic_store(&svc->present_result, res);
+		} else if (res == VK_SUBOPTIMAL_KHR) {
+			int expected = VK_SUCCESS;
+			atomic_compare_exchange_strong(&svc->present_result,
+						       &expected, res);
+		}
+	}
+
+	svc->job_ct += batch->ct;
+	svc->batch_ct++;
+}
+
+static void *submit_thread(void *data)
+{
+	struct SubmitService *svc = data;
+	struct Batch batch;
+
+	while (1) {
+		// Every push posts once, after its job is visible, so there
+		// are at least as many jobs as counts taken here
+		while (sem_wait(&svc->pending) != 0) {
+			assert(errno == EINTR);
+		}
+
+		batch.ct = 1;
+		while (batch.ct < SUBMIT_MAX_BATCH
+		       && sem_trywait(&svc->pending) == 0) {
+			batch.ct++;
+		}
+
+		int stopping = 0;
+		uint32_t popped = 0;
+		for (uint32_t i = 0; i < batch.ct; i++) {
+			while (mpsc_pop(&svc->jobs, &batch.jobs[popped]) != 0) {
+				// The count posted by submit_service_destroy
+				// has no job. All pushes finished before it.
+				if (atomic_load(&svc->stop)) {
+					stopping = 1;
+					break;
+				}
+
+				// A producer that claimed an earlier slot
+				// hasn't published it yet
+				sched_yield();
+			}
+
+			if (!stopping) popped++;
+		}
+		batch.ct = popped;
+
+		if (batch.ct > 0) submit_batch(svc, &batch);
+
+		if (stopping) break;
+	}
+
+	return NULL;
+}
+
+void submit_service_create(VkQueue queue, struct SubmitService *svc)
+{
+	svc->queue = queue;
+	svc->job_ct = 0;
+	svc->batch_ct = 0;
+
+	mpsc_create(SUBMIT_QUEUE_CAP, sizeof(struct SubmitJob), &svc->jobs);
+
+	int err = sem_init(&svc->pending, 0, 0);
+	assert(err == 0);
+
+	atomic_init(&svc->stop, 0);
+	atomic_init(&svc->present_result, VK_SUCCESS);
+
+	err = pthread_create(&svc->thread, NULL, submit_thread, svc);
+	assert(err == 0);
+}
+
+void submit_service_destroy(struct SubmitService *svc)
+{
+	// Wakes the submit thread with a count that has no job, once it has
+	// submitted everything pushed before this
+	atomic_store(&svc->stop, 1);
+	sem_post(&svc->pending);
+
+	int err = pthread_join(svc->thread, NULL);
+	assert(err == 0);
+
+	sem_destroy(&svc->pending);
+	mpsc_destroy(svc->jobs);
+}
+
+VkResult submit_service_present_result(struct SubmitService *svc)
+{
+	return atomic_exchange(&svc->present_result, VK_SUCCESS);
+}
+
+void submit_service_push(struct SubmitService *svc, struct SubmitJob *job)
+{
+	assert(job->wait_ct <= SUBMIT_MAX_WAITS);
+	assert(job->signal_ct <= SUBMIT_MAX_SIGNALS);
+
+	while (mpsc_push(&svc->jobs, job) != 0) {
+		sched_yield();
+	}
+
+	sem_post(&svc->pending);
+}
+
+void submit_job_wait(struct SubmitJob *job, VkSemaphore sem, uint64_t value,
+		     VkPipelineStageFlags stage)
+{
+	assert(job->wait_ct < SUBMIT_MAX_WAITS);
+
+	job->waits[job->wait_ct] = sem;
+	job->wait_values[job->wait_ct] = value;
+	job->wait_stages[job->wait_ct] = stage;
+	job->wait_ct++;
+}
+
+void submit_job_signal(struct SubmitJob *job, VkSemaphore sem, uint64_t value)
+{
+	assert(job->signal_ct < SUBMIT_MAX_SIGNALS);
+
+	job->signals[job->signal_ct] = sem;
+	job->signal_values[job->signal_ct] = value;
+	job->signal_ct++;
+}
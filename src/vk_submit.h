@@ -0,0 +1,105 @@
+#ifndef VK_SUBMIT_H_
+#define VK_SUBMIT_H_
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <vulkan/vulkan.h>
+
+#include "mpsc.h"
+
+#define SUBMIT_MAX_WAITS 4
+#define SUBMIT_MAX_SIGNALS 4
+
+// Most jobs put into a single vkQueueSubmit call
+#define SUBMIT_MAX_BATCH 32
+// Most jobs waiting to be submitted at once
+#define SUBMIT_QUEUE_CAP 256
+
+/*
+ * One pre-recorded command buffer, with the semaphores it waits on and
+ * signals. Semaphores can be binary or timeline; values for binary ones are
+ * ignored.
+ */
+struct SubmitJob {
+	// Can be NULL, to only wait and signal
+	VkCommandBuffer cbuf;
+
+	uint32_t wait_ct;
+	VkSemaphore waits[SUBMIT_MAX_WAITS];
+	uint64_t wait_values[SUBMIT_MAX_WAITS];
+	VkPipelineStageFlags wait_stages[SUBMIT_MAX_WAITS];
+
+	uint32_t signal_ct;
+	VkSemaphore signals[SUBMIT_MAX_SIGNALS];
+	uint64_t signal_values[SUBMIT_MAX_SIGNALS];
+
+	// If not NULL, <image_idx> is presented after the job is submitted,
+	// waiting on <present_wait> (a binary semaphore)
+	VkSwapchainKHR swapchain;
+	uint32_t image_idx;
+	VkSemaphore present_wait;
+};
+
+/*
+ * Owns a VkQueue, and submits work pushed to it from any thread. A dedicated
+ * thread drains the pushed jobs and submits as many as are waiting (up to
+ * SUBMIT_MAX_BATCH) in one vkQueueSubmit, so callers never touch the queue
+ * directly and don't need to lock around it.
+ *
+ * Nothing else may use the queue while the service exists. Must not be moved
+ * after creation, since the submit thread holds a pointer to it.
+ */
+struct SubmitService {
+	VkQueue queue;
+
+	struct Mpsc jobs;
+	// Counts jobs that have been pushed but not yet popped
+	sem_t pending;
+	atomic_int stop;
+	pthread_t thread;
+
+	// Worst present result since submit_service_present_result last took
+	// it: VK_SUCCESS, VK_SUBOPTIMAL_KHR or VK_ERROR_OUT_OF_DATE_KHR
+	atomic_int present_result;
+
+	// Written by the submit thread only
+	uint64_t job_ct;
+	uint64_t batch_ct;
+};
+
+void submit_service_create(VkQueue queue, struct SubmitService *svc);
+
+/*
+ * Submits everything already pushed, then stops the submit thread. Doesn't
+ * wait for the GPU.
+ */
+void submit_service_destroy(struct SubmitService *svc);
+
+/*
+ * Queues a job for submission. Safe to call from any thread. Only blocks
+ * (yielding) if SUBMIT_QUEUE_CAP jobs are already waiting.
+ *
+ * Jobs pushed by one thread are submitted in the order they were pushed.
+ */
+void submit_service_push(struct SubmitService *svc, struct SubmitJob *job);
+
+/*
+ * Returns the worst result of the presents submitted since the last call
+ * (VK_ERROR_OUT_OF_DATE_KHR, then VK_SUBOPTIMAL_KHR, then VK_SUCCESS), and
+ * resets it. Presents happen on the submit thread, so this is how callers
+ * find out the swapchain needs recreating: check it once a frame, like the
+ * result of vkQueuePresentKHR.
+ */
+VkResult submit_service_present_result(struct SubmitService *svc);
+
+/*
+ * Helpers for filling in a SubmitJob, which should start zeroed.
+ */
+void submit_job_wait(struct SubmitJob *job, VkSemaphore sem, uint64_t value,
+		     VkPipelineStageFlags stage);
+
+void submit_job_signal(struct SubmitJob *job, VkSemaphore sem, uint64_t value);
+
+#endif // VK_SUBMIT_H_
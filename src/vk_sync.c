@@ -20,3 +20,18 @@ void create_fence(VkDevice device, VkFenceCreateFlags flags, VkFence *fence)
 	VkResult res = vkCreateFence(device, &info, NULL, fence);
 	assert(res == VK_SUCCESS);
 }
+
+void create_timeline_sem(VkDevice device, uint64_t initial, VkSemaphore *sem)
+{
+	VkSemaphoreTypeCreateInfo type_info = {0};
+	type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	type_info.initialValue = initial;
+
+	VkSemaphoreCreateInfo info = {0};
+	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	info.pNext = &type_info;
+
+	VkResult res = vkCreateSemaphore(device, &info, NULL, sem);
+	assert(res == VK_SUCCESS);
+}
@@ -7,4 +7,10 @@ void create_sem(VkDevice device, VkSemaphore *sem);
 
 void create_fence(VkDevice device, VkFenceCreateFlags flags, VkFence *fence);
 
+/*
+ * Creates a timeline semaphore, whose payload is a counter that only ever
+ * increases, starting at <initial>.
+ */
+void create_timeline_sem(VkDevice device, uint64_t initial, VkSemaphore *sem);
+
 #endif // VK_SYNC_H_
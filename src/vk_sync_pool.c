@@ -4,6 +4,7 @@
 
 #include <stdlib.h>
 #include <assert.h>
+#include <time.h>
 
 #include <vulkan/vulkan.h>
 
@@ -12,6 +13,12 @@ void sync_pool_create(VkDevice device, uint32_t ct,
 {
 	sync_pool->ct = ct;
 	sync_pool->cur = 0;
+	sync_pool->cur_stalled = 0;
+	sync_pool->cur_stall_secs = 0.0;
+
+	struct SyncPoolStats stats = {0};
+	sync_pool->stats = stats;
+
 	sync_pool->fences = malloc(sizeof(sync_pool->fences[0]) * ct);
 
 	for (int i = 0; i < ct; i++) {
@@ -20,14 +27,51 @@ void sync_pool_create(VkDevice device, uint32_t ct,
 	}
 }
 
+static double elapsed_since(struct timespec *s_time)
+{
+	struct timespec e_time;
+	clock_gettime(CLOCK_MONOTONIC, &e_time);
+
+	return (e_time.tv_sec - s_time->tv_sec)
+		+ (e_time.tv_nsec - s_time->tv_nsec) / 1000000000.0;
+}
+
 void sync_pool_acquire(VkDevice device, struct SyncPool *sync_pool,
 		       VkFence *fence, uint32_t *idx)
+{
+	int busy = sync_pool_acquire_timeout(device, sync_pool, UINT64_MAX,
+					     fence, idx);
+	assert(busy == 0);
+}
+
+int sync_pool_acquire_timeout(VkDevice device, struct SyncPool *sync_pool,
+			      uint64_t timeout,
+			      VkFence *fence, uint32_t *idx)
 {
 	VkFence f = sync_pool->fences[sync_pool->cur];
+	struct SyncPoolStats *stats = &sync_pool->stats;
+
+	// Check first, so only actual stalls are timed
+	VkResult res = vkGetFenceStatus(device, f);
+
+	if (res == VK_NOT_READY) {
+		sync_pool->cur_stalled = 1;
 
-        VkResult res = vkWaitForFences(device,
-				       1, &f,
-				       VK_TRUE, UINT64_MAX);
+		if (timeout > 0) {
+			struct timespec s_time;
+			clock_gettime(CLOCK_MONOTONIC, &s_time);
+
+			res = vkWaitForFences(device, 1, &f,
+					      VK_TRUE, timeout);
+
+			sync_pool->cur_stall_secs += elapsed_since(&s_time);
+		}
+	}
+
+	if (res == VK_NOT_READY || res == VK_TIMEOUT) {
+		stats->busy_ct++;
+		return 1;
+	}
 	assert(res == VK_SUCCESS);
 
 	res = vkResetFences(device, 1, &f);
@@ -40,6 +84,26 @@ void sync_pool_acquire(VkDevice device, struct SyncPool *sync_pool,
 	}
 
 	sync_pool->cur = (sync_pool->cur + 1) % sync_pool->ct;
+	stats->acquire_ct++;
+
+	// However many attempts it took, this was one stall
+	if (sync_pool->cur_stalled) {
+		stats->stall_ct++;
+		stats->stall_secs += sync_pool->cur_stall_secs;
+		if (sync_pool->cur_stall_secs > stats->max_stall_secs) {
+			stats->max_stall_secs = sync_pool->cur_stall_secs;
+		}
+	}
+	sync_pool->cur_stalled = 0;
+	sync_pool->cur_stall_secs = 0.0;
+
+	return 0;
+}
+
+int sync_pool_try_acquire(VkDevice device, struct SyncPool *sync_pool,
+			  VkFence *fence, uint32_t *idx)
+{
+	return sync_pool_acquire_timeout(device, sync_pool, 0, fence, idx);
 }
 
 void sync_pool_destroy(VkDevice device, struct SyncPool sync_pool)
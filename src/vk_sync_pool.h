@@ -3,11 +3,38 @@
 
 #include <vulkan/vulkan.h>
 
+/*
+ * How often, and for how long, acquiring a fence had to block on the GPU.
+ */
+struct SyncPoolStats {
+	// Successful acquisitions
+	uint64_t acquire_ct;
+	// Successful acquisitions that found the fence unsignalled at least
+	// once and had to wait (or try again, for try_acquire). Counted once
+	// each, however many attempts it took.
+	uint64_t stall_ct;
+	// Attempts that gave up because the fence wasn't signalled in time
+	uint64_t busy_ct;
+
+	// Time spent blocked in vkWaitForFences, in seconds, by acquisitions
+	// that have succeeded. The max is per acquisition, all attempts added
+	// up.
+	double stall_secs;
+	double max_stall_secs;
+};
+
 struct SyncPool {
 	uint32_t ct;
 	VkFence *fences;
 	void **extra;
 	uint32_t cur;
+
+	// Whether the current fence was found unsignalled, and how long was
+	// spent blocked on it, until it's acquired and added to stats
+	int cur_stalled;
+	double cur_stall_secs;
+
+	struct SyncPoolStats stats;
 };
 
 /*
@@ -27,6 +54,27 @@ void sync_pool_create(VkDevice device, uint32_t ct,
 void sync_pool_acquire(VkDevice device, struct SyncPool *sync_pool,
 		       VkFence *fence, uint32_t *idx);
 
+/*
+ * Same as sync_pool_acquire, but gives up after <timeout> nanoseconds.
+ *
+ * Returns 0 if a fence was acquired, and 1 if the GPU hadn't finished with it
+ * yet, in which case nothing is output and the same fence will be tried next
+ * time.
+ */
+int sync_pool_acquire_timeout(VkDevice device, struct SyncPool *sync_pool,
+			      uint64_t timeout,
+			      VkFence *fence, uint32_t *idx);
+
+/*
+ * Acquires a fence only if it's already signalled, without blocking. Returns
+ * the same as sync_pool_acquire_timeout.
+ *
+ * Lets the caller do other CPU work (and try again) instead of stalling on
+ * the GPU.
+ */
+int sync_pool_try_acquire(VkDevice device, struct SyncPool *sync_pool,
+			  VkFence *fence, uint32_t *idx);
+
 void sync_pool_destroy(VkDevice device, struct SyncPool sync_pool);
 
 #endif // VK_SYNC_POOL_H_
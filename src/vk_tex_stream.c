@@ -0,0 +1,428 @@
+#include "vk_tex_stream.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "vk_barrier.h"
+#include "vk_cbuf.h"
+#include "vk_sync.h"
+#include "vk_texture.h"
+
+// Ring allocations are aligned to the largest block size of any format
+#define TEX_STREAM_ALIGN 16
+
+#define NO_TEX UINT32_MAX
+
+static VkDeviceSize align_up(VkDeviceSize x, VkDeviceSize align)
+{
+	return (x + align - 1) / align * align;
+}
+
+static void *worker(void *data)
+{
+	struct TexStream *stream = data;
+
+	while (1) {
+		while (sem_wait(&stream->requested) != 0) {
+			assert(errno == EINTR);
+		}
+		if (atomic_load(&stream->stop)) break;
+
+		// Every request posts once, after its path is written
+		uint32_t idx = atomic_fetch_add(&stream->next_request, 1);
+		struct StreamedTexture *st = &stream->textures[idx];
+
+		int res = texture_load(st->path, st->format, stream->cache_dir,
+				       &st->tex);
+		if (res != 0) {
+			atomic_store(&st->state, TEX_STREAM_FAILED);
+			continue;
+		}
+
+		atomic_store(&st->state, TEX_STREAM_DECODED);
+
+		// Can't be full, it holds as many indices as there can be
+		// textures
+		res = mpsc_push(&stream->decoded, &idx);
+		assert(res == 0);
+	}
+
+	return NULL;
+}
+
+/*
+ * Reserves <size> contiguous bytes of the ring buffer. Allocations don't wrap
+ * around the end; the leftover space is skipped.
+ *
+ * Returns 0 on success, or 1 if there's no room until uploads finish.
+ */
+static int ring_alloc(struct TexStream *stream, VkDeviceSize size,
+		      VkDeviceSize *offset)
+{
+	// Nothing is using the ring, so start the next lap. Otherwise the
+	// space skipped to reach it is counted as in use, and with nothing in
+	// flight to free it, a texture that doesn't fit before the end would
+	// never fit.
+	if (stream->ring_head == stream->ring_tail) {
+		stream->ring_head = align_up(stream->ring_head,
+					     stream->ring_size);
+		stream->ring_tail = stream->ring_head;
+	}
+
+	VkDeviceSize start = align_up(stream->ring_head, TEX_STREAM_ALIGN);
+	if (start % stream->ring_size + size > stream->ring_size) {
+		start = align_up(start, stream->ring_size);
+	}
+
+	if (start + size - stream->ring_tail > stream->ring_size) return 1;
+
+	stream->ring_head = start + size;
+	*offset = start % stream->ring_size;
+
+	return 0;
+}
+
+static void create_placeholder(struct TexStream *stream)
+{
+	// Grey checkerboard, so missing textures are obvious but not jarring
+	unsigned char texels[] = {
+		160, 160, 160, 255,   96,  96,  96, 255,
+		 96,  96,  96, 255,  160, 160, 160, 255
+	};
+
+	struct Texture tex = {0};
+	tex.format = VK_FORMAT_R8G8B8A8_UNORM;
+	tex.width = 2;
+	tex.height = 2;
+	tex.level_ct = 1;
+	tex.offsets[0] = 0;
+	tex.sizes[0] = sizeof(texels);
+	tex.size = sizeof(texels);
+	tex.data = texels;
+
+	struct Buffer staging;
+	texture_staging_create(stream->device, stream->mem_props, tex,
+			       &staging);
+	texture_image_create(stream->device, stream->queue_fam,
+			     stream->mem_props, tex, &stream->placeholder);
+
+	struct BarrierBatch batch;
+	barrier_batch_create(NULL, &batch);
+
+	VkCommandBuffer cbuf;
+	cbuf_begin_one_time(stream->device, stream->cpool, &cbuf);
+
+	texture_upload_cmd(cbuf, &batch, tex,
+			   staging.handle, stream->placeholder.handle,
+			   VK_ACCESS_SHADER_READ_BIT,
+			   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+	VkResult res = vkEndCommandBuffer(cbuf);
+	assert(res == VK_SUCCESS);
+	submit_syncless(stream->device, stream->queue, stream->cpool, cbuf);
+
+	buffer_destroy(staging);
+}
+
+void tex_stream_create(VkDevice device,
+		       uint32_t queue_fam,
+		       VkQueue queue,
+		       VkPhysicalDeviceMemoryProperties mem_props,
+		       VkDeviceSize ring_size,
+		       const char *cache_dir,
+		       struct TexStream *stream)
+{
+	stream->device = device;
+	stream->queue_fam = queue_fam;
+	stream->queue = queue;
+	stream->mem_props = mem_props;
+	stream->cache_dir = cache_dir;
+	stream->tex_ct = 0;
+
+	// Ring
+	stream->ring_size = align_up(ring_size, TEX_STREAM_ALIGN);
+	stream->ring_head = 0;
+	stream->ring_tail = 0;
+
+	buffer_create(device, mem_props, stream->ring_size,
+		      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &stream->ring);
+
+	void *mapped;
+	VkResult res = vkMapMemory(device, stream->ring.memory,
+				   0, stream->ring_size, 0, &mapped);
+	assert(res == VK_SUCCESS);
+	stream->ring_data = mapped;
+
+	// Uploads
+	create_cpool(device, queue_fam, &stream->cpool);
+	create_timeline_sem(device, 0, &stream->timeline);
+	stream->value = 0;
+	stream->upload_first = 0;
+	stream->upload_ct = 0;
+
+	create_placeholder(stream);
+
+	// Workers
+	mpsc_create(TEX_STREAM_MAX, sizeof(uint32_t), &stream->decoded);
+	stream->held = NO_TEX;
+
+	int err = sem_init(&stream->requested, 0, 0);
+	assert(err == 0);
+
+	atomic_init(&stream->next_request, 0);
+	atomic_init(&stream->stop, 0);
+
+	for (uint32_t i = 0; i < TEX_STREAM_WORKER_CT; i++) {
+		err = pthread_create(&stream->workers[i], NULL, worker, stream);
+		assert(err == 0);
+	}
+}
+
+void tex_stream_destroy(struct TexStream *stream)
+{
+	// Workers finish the texture they're on, and skip any still queued
+	atomic_store(&stream->stop, 1);
+	for (uint32_t i = 0; i < TEX_STREAM_WORKER_CT; i++) {
+		sem_post(&stream->requested);
+	}
+
+	for (uint32_t i = 0; i < TEX_STREAM_WORKER_CT; i++) {
+		int err = pthread_join(stream->workers[i], NULL);
+		assert(err == 0);
+	}
+
+	VkSemaphoreWaitInfo info = {0};
+	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	info.semaphoreCount = 1;
+	info.pSemaphores = &stream->timeline;
+	info.pValues = &stream->value;
+
+	VkResult res = vkWaitSemaphores(stream->device, &info, UINT64_MAX);
+	assert(res == VK_SUCCESS);
+
+	for (uint32_t i = 0; i < stream->tex_ct; i++) {
+		struct StreamedTexture *st = &stream->textures[i];
+
+		int state = atomic_load(&st->state);
+		if (state == TEX_STREAM_DECODED) {
+			texture_destroy(st->tex);
+		} else if (state == TEX_STREAM_UPLOADING
+			   || state == TEX_STREAM_RESIDENT) {
+			image_destroy(stream->device, st->image);
+		}
+
+		free(st->path);
+	}
+
+	sem_destroy(&stream->requested);
+	mpsc_destroy(stream->decoded);
+
+	image_destroy(stream->device, stream->placeholder);
+
+	// Frees the upload command buffers too
+	vkDestroyCommandPool(stream->device, stream->cpool, NULL);
+	vkDestroySemaphore(stream->device, stream->timeline, NULL);
+
+	vkUnmapMemory(stream->device, stream->ring.memory);
+	buffer_destroy(stream->ring);
+}
+
+uint32_t tex_stream_request(struct TexStream *stream,
+			    const char *path, VkFormat format)
+{
+	assert(stream->tex_ct < TEX_STREAM_MAX);
+
+	uint32_t id = stream->tex_ct++;
+	struct StreamedTexture *st = &stream->textures[id];
+
+	size_t len = strlen(path);
+	st->path = malloc(sizeof(st->path[0]) * (len + 1));
+	memcpy(st->path, path, len + 1);
+
+	st->format = format;
+	st->level_ct = 0;
+	atomic_init(&st->state, TEX_STREAM_QUEUED);
+
+	sem_post(&stream->requested);
+
+	return id;
+}
+
+/*
+ * Marks the textures of every finished upload resident, and frees their ring
+ * space and command buffers.
+ */
+static uint32_t retire_uploads(struct TexStream *stream)
+{
+	if (stream->upload_ct == 0) return 0;
+
+	uint64_t done;
+	VkResult res = vkGetSemaphoreCounterValue(stream->device,
+						  stream->timeline, &done);
+	assert(res == VK_SUCCESS);
+
+	uint32_t resident_ct = 0;
+	while (stream->upload_ct > 0) {
+		struct TexStreamUpload *up =
+			&stream->uploads[stream->upload_first];
+		if (up->value > done) break;
+
+		for (uint32_t i = 0; i < up->tex_ct; i++) {
+			atomic_store(&stream->textures[up->texs[i]].state,
+				     TEX_STREAM_RESIDENT);
+		}
+		resident_ct += up->tex_ct;
+
+		stream->ring_tail = up->ring_end;
+		vkFreeCommandBuffers(stream->device, stream->cpool,
+				     1, &up->cbuf);
+
+		stream->upload_first =
+			(stream->upload_first + 1) % TEX_STREAM_UPLOADS_MAX;
+		stream->upload_ct--;
+	}
+
+	return resident_ct;
+}
+
+uint32_t tex_stream_update(struct TexStream *stream)
+{
+	uint32_t resident_ct = retire_uploads(stream);
+	if (stream->upload_ct == TEX_STREAM_UPLOADS_MAX) return resident_ct;
+
+	// Copy as many decoded textures into the ring as fit
+	struct TexStreamUpload up = {0};
+	VkDeviceSize offsets[TEX_STREAM_BATCH_MAX];
+
+	while (up.tex_ct < TEX_STREAM_BATCH_MAX) {
+		uint32_t idx = stream->held;
+		if (idx == NO_TEX && mpsc_pop(&stream->decoded, &idx) != 0) {
+			break;
+		}
+		stream->held = NO_TEX;
+
+		struct StreamedTexture *st = &stream->textures[idx];
+
+		// Would never fit
+		if (st->tex.size > stream->ring_size) {
+			texture_destroy(st->tex);
+			atomic_store(&st->state, TEX_STREAM_FAILED);
+			continue;
+		}
+
+		VkDeviceSize offset;
+		if (ring_alloc(stream, st->tex.size, &offset) != 0) {
+			stream->held = idx;
+			break;
+		}
+
+		memcpy(stream->ring_data + offset, st->tex.data, st->tex.size);
+		texture_image_create(stream->device, stream->queue_fam,
+				     stream->mem_props, st->tex, &st->image);
+		st->level_ct = st->tex.level_ct;
+
+		offsets[up.tex_ct] = offset;
+		up.texs[up.tex_ct] = idx;
+		up.tex_ct++;
+	}
+
+	if (up.tex_ct == 0) return resident_ct;
+
+	// One barrier batch for every texture either side of the copies
+	struct BarrierBatch batch;
+	barrier_batch_create(NULL, &batch);
+
+	cbuf_begin_one_time(stream->device, stream->cpool, &up.cbuf);
+
+	for (uint32_t i = 0; i < up.tex_ct; i++) {
+		struct StreamedTexture *st = &stream->textures[up.texs[i]];
+		barrier_batch_image(&batch, st->image.handle,
+				    VK_IMAGE_ASPECT_COLOR_BIT,
+				    0, st->tex.level_ct,
+				    0,
+				    VK_ACCESS_TRANSFER_WRITE_BIT,
+				    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				    VK_PIPELINE_STAGE_TRANSFER_BIT,
+				    VK_IMAGE_LAYOUT_UNDEFINED,
+				    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	}
+	barrier_batch_record(&batch, up.cbuf);
+
+	for (uint32_t i = 0; i < up.tex_ct; i++) {
+		struct StreamedTexture *st = &stream->textures[up.texs[i]];
+		texture_copy_cmd(up.cbuf, st->tex, stream->ring.handle,
+				 offsets[i], st->image.handle);
+	}
+
+	// Frames submitted later on the same queue sample them
+	for (uint32_t i = 0; i < up.tex_ct; i++) {
+		struct StreamedTexture *st = &stream->textures[up.texs[i]];
+		barrier_batch_image(&batch, st->image.handle,
+				    VK_IMAGE_ASPECT_COLOR_BIT,
+				    0, st->tex.level_ct,
+				    VK_ACCESS_TRANSFER_WRITE_BIT,
+				    VK_ACCESS_SHADER_READ_BIT,
+				    VK_PIPELINE_STAGE_TRANSFER_BIT,
+				    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+	barrier_batch_record(&batch, up.cbuf);
+
+	VkResult res = vkEndCommandBuffer(up.cbuf);
+	assert(res == VK_SUCCESS);
+
+	// The texels live in the ring now
+	for (uint32_t i = 0; i < up.tex_ct; i++) {
+		struct StreamedTexture *st = &stream->textures[up.texs[i]];
+		texture_destroy(st->tex);
+		atomic_store(&st->state, TEX_STREAM_UPLOADING);
+	}
+
+	up.value = ++stream->value;
+	up.ring_end = stream->ring_head;
+
+	VkTimelineSemaphoreSubmitInfo timeline_info = {0};
+	timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timeline_info.signalSemaphoreValueCount = 1;
+	timeline_info.pSignalSemaphoreValues = &up.value;
+
+	VkSubmitInfo info = {0};
+	info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	info.pNext = &timeline_info;
+	info.commandBufferCount = 1;
+	info.pCommandBuffers = &up.cbuf;
+	info.signalSemaphoreCount = 1;
+	info.pSignalSemaphores = &stream->timeline;
+
+	res = vkQueueSubmit(stream->queue, 1, &info, VK_NULL_HANDLE);
+	assert(res == VK_SUCCESS);
+
+	uint32_t slot = (stream->upload_first + stream->upload_ct)
+		% TEX_STREAM_UPLOADS_MAX;
+	stream->uploads[slot] = up;
+	stream->upload_ct++;
+
+	return resident_ct;
+}
+
+enum TexState tex_stream_state(struct TexStream *stream, uint32_t id)
+{
+	assert(id < stream->tex_ct);
+
+	return atomic_load(&stream->textures[id].state);
+}
+
+VkImageView tex_stream_view(struct TexStream *stream, uint32_t id)
+{
+	if (tex_stream_state(stream, id) != TEX_STREAM_RESIDENT) {
+		return stream->placeholder.view;
+	}
+
+	return stream->textures[id].image.view;
+}
@@ -0,0 +1,167 @@
+#ifndef VK_TEX_STREAM_H_
+#define VK_TEX_STREAM_H_
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <vulkan/vulkan.h>
+
+#include "mpsc.h"
+#include "texture.h"
+#include "vk_buffer.h"
+#include "vk_image.h"
+
+// Threads decoding (and encoding) textures
+#define TEX_STREAM_WORKER_CT 4
+// Most textures a stream can ever be asked for. Must be a power of two.
+#define TEX_STREAM_MAX 256
+// Most textures copied by one upload submission, each needing two barriers
+// in a BarrierBatch
+#define TEX_STREAM_BATCH_MAX 8
+// Most upload submissions the GPU can be working on at once
+#define TEX_STREAM_UPLOADS_MAX 8
+
+enum TexState {
+	// Requested, waiting for or being decoded by a worker
+	TEX_STREAM_QUEUED,
+	// Decoded, waiting for room in the ring buffer
+	TEX_STREAM_DECODED,
+	// Copied into the ring buffer, the upload hasn't finished yet
+	TEX_STREAM_UPLOADING,
+	// Uploaded, the image can be sampled
+	TEX_STREAM_RESIDENT,
+	// Couldn't be loaded, or is bigger than the ring buffer
+	TEX_STREAM_FAILED
+};
+
+struct StreamedTexture {
+	char *path;
+	VkFormat format;
+	atomic_int state;
+
+	// Written by a worker, freed once copied into the ring buffer
+	struct Texture tex;
+	// Created once the texture is copied into the ring buffer
+	struct Image image;
+	// Mip levels of <image>, kept after <tex> is freed
+	uint32_t level_ct;
+};
+
+struct TexStreamUpload {
+	VkCommandBuffer cbuf;
+	// Timeline value signalled when the upload is done
+	uint64_t value;
+	// Ring buffer position to free up to once it's done
+	VkDeviceSize ring_end;
+
+	uint32_t tex_ct;
+	uint32_t texs[TEX_STREAM_BATCH_MAX];
+};
+
+/*
+ * Loads textures in the background, so starting up doesn't wait for every
+ * image to be decoded and uploaded.
+ *
+ * Worker threads decode each requested file (through texture_load, with its
+ * cache) while the main thread keeps rendering. tex_stream_update, called
+ * once a frame, copies decoded textures into a persistently mapped ring
+ * staging buffer and uploads up to TEX_STREAM_BATCH_MAX of them per
+ * submission: one batch of barriers, one copy per texture, one more batch of
+ * barriers. Until a texture is resident, tex_stream_view hands out a small
+ * placeholder instead.
+ *
+ * Everything but the workers runs on the thread calling tex_stream_update,
+ * which must be the one submitting to <queue>. Must not be moved after
+ * creation, since the workers hold a pointer to it.
+ */
+struct TexStream {
+	VkDevice device;
+	uint32_t queue_fam;
+	VkQueue queue;
+	VkPhysicalDeviceMemoryProperties mem_props;
+	const char *cache_dir;
+
+	// Only appended to, by tex_stream_request
+	uint32_t tex_ct;
+	struct StreamedTexture textures[TEX_STREAM_MAX];
+
+	pthread_t workers[TEX_STREAM_WORKER_CT];
+	// Posted once for every request, and once per worker to stop
+	sem_t requested;
+	atomic_uint next_request;
+	atomic_int stop;
+	// Indices of decoded textures, pushed by the workers
+	struct Mpsc decoded;
+	// Popped from <decoded> but didn't fit in the ring buffer yet, or
+	// UINT32_MAX
+	uint32_t held;
+
+	// Staging memory, used as a ring. Head and tail count every byte ever
+	// allocated and freed, so they only wrap in the modulo.
+	struct Buffer ring;
+	unsigned char *ring_data;
+	VkDeviceSize ring_size;
+	VkDeviceSize ring_head;
+	VkDeviceSize ring_tail;
+
+	VkCommandPool cpool;
+	VkSemaphore timeline;
+	uint64_t value;
+
+	// Submitted uploads, oldest first
+	uint32_t upload_first;
+	uint32_t upload_ct;
+	struct TexStreamUpload uploads[TEX_STREAM_UPLOADS_MAX];
+
+	// Sampled in place of textures that aren't resident
+	struct Image placeholder;
+};
+
+/*
+ * Creates the ring buffer and placeholder, and starts the workers. The
+ * placeholder is uploaded right away, waiting on <queue>.
+ *
+ * ring_size: Bytes of staging memory. Textures bigger than that (with every
+ *            mip level) fail to load, smaller ones wait for room.
+ * cache_dir: Passed to texture_load, can be NULL. Must outlive the stream.
+ */
+void tex_stream_create(VkDevice device,
+		       uint32_t queue_fam,
+		       VkQueue queue,
+		       VkPhysicalDeviceMemoryProperties mem_props,
+		       VkDeviceSize ring_size,
+		       const char *cache_dir,
+		       struct TexStream *stream);
+
+/*
+ * Stops the workers, waits for any uploads and destroys every image,
+ * including ones still handed out by tex_stream_view.
+ */
+void tex_stream_destroy(struct TexStream *stream);
+
+/*
+ * Queues <path> to be loaded as <format> (see texture_load), and returns its
+ * id. Doesn't block.
+ */
+uint32_t tex_stream_request(struct TexStream *stream,
+			    const char *path, VkFormat format);
+
+/*
+ * Retires finished uploads and starts a new one with whatever has been
+ * decoded since, if there's room for it. Never waits on the GPU or the
+ * workers.
+ *
+ * Returns how many textures became resident.
+ */
+uint32_t tex_stream_update(struct TexStream *stream);
+
+enum TexState tex_stream_state(struct TexStream *stream, uint32_t id);
+
+/*
+ * Returns the view of texture <id> if it's resident, otherwise the
+ * placeholder's. Either is in SHADER_READ_ONLY_OPTIMAL.
+ */
+VkImageView tex_stream_view(struct TexStream *stream, uint32_t id);
+
+#endif // VK_TEX_STREAM_H_
@@ -0,0 +1,104 @@
+#include "vk_texture.h"
+
+#include <assert.h>
+
+int texture_bc_supported(VkPhysicalDevice phys_dev)
+{
+	VkPhysicalDeviceFeatures features;
+	vkGetPhysicalDeviceFeatures(phys_dev, &features);
+
+	return features.textureCompressionBC == VK_TRUE;
+}
+
+void texture_image_create(VkDevice device,
+			  uint32_t queue_fam,
+			  VkPhysicalDeviceMemoryProperties mem_props,
+			  struct Texture tex,
+			  struct Image *image)
+{
+	image_create_mips(device, queue_fam, mem_props,
+			  tex.format,
+			  VK_IMAGE_USAGE_SAMPLED_BIT
+			  | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			  VK_IMAGE_ASPECT_COLOR_BIT,
+			  VK_SAMPLE_COUNT_1_BIT,
+			  tex.width, tex.height,
+			  tex.level_ct,
+			  image);
+}
+
+void texture_staging_create(VkDevice device,
+			    VkPhysicalDeviceMemoryProperties mem_props,
+			    struct Texture tex,
+			    struct Buffer *staging)
+{
+	buffer_create(device, mem_props,
+		      tex.size,
+		      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      staging);
+
+	buffer_write(*staging, tex.size, tex.data);
+}
+
+void texture_copy_cmd(VkCommandBuffer cbuf,
+		      struct Texture tex,
+		      VkBuffer staging, VkDeviceSize offset,
+		      VkImage image)
+{
+	assert(offset % 16 == 0);
+
+	// Extents are in texels, even for the partial blocks of small levels
+	VkBufferImageCopy regions[TEXTURE_MAX_LEVELS] = {0};
+	for (uint32_t i = 0; i < tex.level_ct; i++) {
+		uint32_t w = tex.width >> i;
+		uint32_t h = tex.height >> i;
+
+		regions[i].bufferOffset = offset + tex.offsets[i];
+		regions[i].imageSubresource.aspectMask =
+			VK_IMAGE_ASPECT_COLOR_BIT;
+		regions[i].imageSubresource.mipLevel = i;
+		regions[i].imageSubresource.baseArrayLayer = 0;
+		regions[i].imageSubresource.layerCount = 1;
+		regions[i].imageExtent.width = w == 0 ? 1 : w;
+		regions[i].imageExtent.height = h == 0 ? 1 : h;
+		regions[i].imageExtent.depth = 1;
+	}
+
+	vkCmdCopyBufferToImage(cbuf, staging, image,
+			       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			       tex.level_ct, regions);
+}
+
+void texture_upload_cmd(VkCommandBuffer cbuf,
+			struct BarrierBatch *batch,
+			struct Texture tex,
+			VkBuffer staging,
+			VkImage image,
+			VkAccessFlags dst_access,
+			VkPipelineStageFlags dst_stage)
+{
+	barrier_batch_image(batch, image, VK_IMAGE_ASPECT_COLOR_BIT,
+			    0, tex.level_ct,
+			    0,
+			    VK_ACCESS_TRANSFER_WRITE_BIT,
+			    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			    VK_PIPELINE_STAGE_TRANSFER_BIT,
+			    VK_IMAGE_LAYOUT_UNDEFINED,
+			    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	barrier_batch_record(batch, cbuf);
+
+	texture_copy_cmd(cbuf, tex, staging, 0, image);
+
+	barrier_batch_image(batch, image, VK_IMAGE_ASPECT_COLOR_BIT,
+			    0, tex.level_ct,
+			    VK_ACCESS_TRANSFER_WRITE_BIT,
+			    dst_access,
+			    VK_PIPELINE_STAGE_TRANSFER_BIT,
+			    dst_stage,
+			    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	barrier_batch_record(batch, cbuf);
+}
@@ -0,0 +1,65 @@
+#ifndef VK_TEXTURE_H_
+#define VK_TEXTURE_H_
+
+#include <vulkan/vulkan.h>
+
+#include "texture.h"
+#include "vk_image.h"
+#include "vk_buffer.h"
+#include "vk_barrier.h"
+
+/*
+ * Returns 1 if the device can sample BC1 to BC7 images, 0 otherwise.
+ * create_device and create_device_queues enable the feature when it's there.
+ */
+int texture_bc_supported(VkPhysicalDevice phys_dev);
+
+/*
+ * Creates a sampled image with the texture's format, size and mip levels,
+ * which texture_upload_cmd can copy into.
+ */
+void texture_image_create(VkDevice device,
+			  uint32_t queue_fam,
+			  VkPhysicalDeviceMemoryProperties mem_props,
+			  struct Texture tex,
+			  struct Image *image);
+
+/*
+ * Creates a host-visible staging buffer holding every level of the texture.
+ */
+void texture_staging_create(VkDevice device,
+			    VkPhysicalDeviceMemoryProperties mem_props,
+			    struct Texture tex,
+			    struct Buffer *staging);
+
+/*
+ * Records copying every level from <staging>, starting at <offset>, into the
+ * image with one copy command. The image must be in TRANSFER_DST_OPTIMAL.
+ *
+ * offset: Must be a multiple of 16 (and so of every format's block size)
+ */
+void texture_copy_cmd(VkCommandBuffer cbuf,
+		      struct Texture tex,
+		      VkBuffer staging, VkDeviceSize offset,
+		      VkImage image);
+
+/*
+ * Records texture_copy_cmd from the start of the staging buffer, in between
+ * transitioning the image to TRANSFER_DST_OPTIMAL and then to
+ * SHADER_READ_ONLY_OPTIMAL. Compressed levels are copied as they are; nothing
+ * is decoded.
+ *
+ * batch: Empty, is left empty
+ * dst_access, dst_stage: How the image will be used after, like
+ *                        VK_ACCESS_SHADER_READ_BIT from
+ *                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+ */
+void texture_upload_cmd(VkCommandBuffer cbuf,
+			struct BarrierBatch *batch,
+			struct Texture tex,
+			VkBuffer staging,
+			VkImage image,
+			VkAccessFlags dst_access,
+			VkPipelineStageFlags dst_stage);
+
+#endif // VK_TEXTURE_H_
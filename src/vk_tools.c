@@ -1,4 +1,7 @@
 #include "vk_tools.h"
+#include "vk_dyn_render.h"
+#include "vk_barrier.h"
+#include "vk_bindless.h"
 
 #include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
@@ -7,6 +10,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <stdatomic.h>
 
 #define MAX_EXTENSION_NAME_LEN 256
 
@@ -15,31 +19,114 @@ void get_queue(VkDevice device, uint32_t queue_fam, VkQueue *queue)
 	vkGetDeviceQueue(device, queue_fam, 0, queue);
 }
 
+void get_queues(VkDevice device, struct QueueFams fams, struct Queues *queues)
+{
+	get_queue(device, fams.graphics, &queues->graphics);
+	get_queue(device, fams.transfer, &queues->transfer);
+	get_queue(device, fams.compute, &queues->compute);
+}
+
 void create_device(VkPhysicalDevice phys_dev, uint32_t queue_fam, VkDevice *device)
+{
+	struct QueueFams fams = {queue_fam, queue_fam, queue_fam};
+	create_device_queues(phys_dev, fams, device);
+}
+
+void create_device_queues(VkPhysicalDevice phys_dev,
+			  struct QueueFams fams,
+			  VkDevice *device)
 {
 	// Make sure swapchain extension is available
-	char *exts[] = {
-		VK_KHR_SWAPCHAIN_EXTENSION_NAME
-	};
-	uint32_t ext_ct = 1;
+	char *exts[3];
+	uint32_t ext_ct = 0;
+	exts[ext_ct++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
 	assert(check_dev_exts(phys_dev, ext_ct, exts) == 0);
 
-	// VkDeviceQueueCreateInfo
-	VkDeviceQueueCreateInfo queue_info = {0};
-	queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-	queue_info.queueFamilyIndex = queue_fam;
-	queue_info.queueCount = 1;
+	// Dynamic rendering is optional; without it, render passes are used
+	int dyn_render = dyn_render_supported(phys_dev);
+	if (dyn_render) exts[ext_ct++] = VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME;
+
+	// So is synchronization2; without it, barriers are recorded with
+	// vkCmdPipelineBarrier
+	int sync2 = sync2_supported(phys_dev);
+	if (sync2) exts[ext_ct++] = VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME;
+
+	// VkDeviceQueueCreateInfo, one for each distinct family
+	uint32_t fam_list[] = {fams.graphics, fams.transfer, fams.compute};
+	VkDeviceQueueCreateInfo queue_infos[3];
+	uint32_t queue_info_ct = 0;
 	float queue_priority = 1.0f;
-	queue_info.pQueuePriorities = &queue_priority;
+
+	for (int i = 0; i < 3; i++) {
+		int seen = 0;
+		for (int j = 0; j < i; j++) {
+			if (fam_list[j] == fam_list[i]) seen = 1;
+		}
+		if (seen) continue;
+
+		VkDeviceQueueCreateInfo queue_info = {0};
+		queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queue_info.queueFamilyIndex = fam_list[i];
+		queue_info.queueCount = 1;
+		queue_info.pQueuePriorities = &queue_priority;
+
+		queue_infos[queue_info_ct++] = queue_info;
+	}
 
 	// VkPhysicalDeviceFeatures
 	VkPhysicalDeviceFeatures dev_features = {0};
 
+	// Lets the mip generation compute fallback write any storage format
+	VkPhysicalDeviceFeatures supported;
+	vkGetPhysicalDeviceFeatures(phys_dev, &supported);
+	dev_features.shaderStorageImageWriteWithoutFormat =
+		supported.shaderStorageImageWriteWithoutFormat;
+	// And lets block-compressed textures be sampled
+	dev_features.textureCompressionBC = supported.textureCompressionBC;
+
+	// Timeline semaphores are core in 1.2, but still need to be enabled
+	VkPhysicalDeviceVulkan12Features features_12 = {0};
+	features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	features_12.timelineSemaphore = VK_TRUE;
+
+	// Descriptor indexing is core too, but optional; without it, every
+	// material needs its own set instead of a slot in a Bindless table
+	if (bindless_supported(phys_dev)) {
+		features_12.runtimeDescriptorArray = VK_TRUE;
+		features_12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		features_12.descriptorBindingSampledImageUpdateAfterBind =
+			VK_TRUE;
+		features_12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		features_12.descriptorBindingPartiallyBound = VK_TRUE;
+	}
+
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dyn_features = {0};
+	dyn_features.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	dyn_features.dynamicRendering = VK_TRUE;
+
+	VkPhysicalDeviceSynchronization2FeaturesKHR sync2_features = {0};
+	sync2_features.sType =
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+	sync2_features.synchronization2 = VK_TRUE;
+
+	// Chain whichever optional features are there
+	void **next = &features_12.pNext;
+	if (dyn_render) {
+		*next = &dyn_features;
+		next = &dyn_features.pNext;
+	}
+	if (sync2) {
+		*next = &sync2_features;
+		next = &sync2_features.pNext;
+	}
+
 	// VkDeviceCreateInfo
 	VkDeviceCreateInfo device_info = {0};
 	device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-	device_info.pQueueCreateInfos = &queue_info;
-	device_info.queueCreateInfoCount = 1;
+	device_info.pNext = &features_12;
+	device_info.pQueueCreateInfos = queue_infos;
+	device_info.queueCreateInfoCount = queue_info_ct;
 	device_info.pEnabledFeatures = &dev_features;
 	device_info.enabledExtensionCount = ext_ct;
 	device_info.ppEnabledExtensionNames = (const char * const *) exts;
@@ -49,6 +136,50 @@ void create_device(VkPhysicalDevice phys_dev, uint32_t queue_fam, VkDevice *devi
 	assert(res == VK_SUCCESS);
 }
 
+void get_queue_fams(VkPhysicalDevice phys_dev, struct QueueFams *fams)
+{
+	uint32_t queue_fam_ct;
+	vkGetPhysicalDeviceQueueFamilyProperties(phys_dev, &queue_fam_ct, NULL);
+
+	VkQueueFamilyProperties *queue_fam_props =
+		malloc(sizeof(VkQueueFamilyProperties) * queue_fam_ct);
+	vkGetPhysicalDeviceQueueFamilyProperties(phys_dev,
+						 &queue_fam_ct,
+						 queue_fam_props);
+
+	fams->graphics = get_queue_fam(phys_dev);
+	fams->transfer = fams->graphics;
+	fams->compute = fams->graphics;
+
+	// Prefer transfer families that can't do anything else (usually DMA
+	// engines), then ones that at least can't do graphics. Graphics and
+	// compute families can always do transfers, so those are the fallback.
+	int transfer_score = 0;
+	for (uint32_t i = 0; i < queue_fam_ct; i++) {
+		VkQueueFlags flags = queue_fam_props[i].queueFlags;
+		if (!(flags & VK_QUEUE_TRANSFER_BIT)) continue;
+		if (flags & VK_QUEUE_GRAPHICS_BIT) continue;
+
+		int score = flags & VK_QUEUE_COMPUTE_BIT ? 1 : 2;
+		if (score > transfer_score) {
+			transfer_score = score;
+			fams->transfer = i;
+		}
+	}
+
+	for (uint32_t i = 0; i < queue_fam_ct; i++) {
+		VkQueueFlags flags = queue_fam_props[i].queueFlags;
+
+		if ((flags & VK_QUEUE_COMPUTE_BIT)
+		    && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+			fams->compute = i;
+			break;
+		}
+	}
+
+	free(queue_fam_props);
+}
+
 uint32_t get_queue_fam(VkPhysicalDevice phys_dev)
 {
 	uint32_t queue_fam_ct;
@@ -180,7 +311,7 @@ void create_instance(DebugCallback dbg_cback,
 	app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	app_info.pEngineName = "Epic Triangle Engine";
 	app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	app_info.apiVersion = VK_API_VERSION_1_0;
+	app_info.apiVersion = VK_API_VERSION_1_2;
 
 	VkInstanceCreateInfo instance_info = {0};
 	instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -213,7 +344,9 @@ default_debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
 	
 	printf("Validation layer: %s\n", pCallbackData->pMessage);
 
-	if (pUserData != NULL) (*(int*)pUserData)++;
+	// Layers can call this from any thread that uses Vulkan (like a
+	// PipeBuild's workers), so pUserData is an atomic_int
+	if (pUserData != NULL) atomic_fetch_add((atomic_int *) pUserData, 1);
 
 	return VK_FALSE;
 }
@@ -60,14 +60,53 @@ void destroy_dbg_msgr(VkInstance instance,
  */
 uint32_t get_physical_device(VkInstance instance, VkPhysicalDevice *phys_dev);
 
+/*
+ * Queue families for each kind of work. Transfer and compute are the same as
+ * graphics when the device has no separate families for them.
+ */
+struct QueueFams {
+	uint32_t graphics;
+	uint32_t transfer;
+	uint32_t compute;
+};
+
+/*
+ * One queue from each family in a QueueFams. Queues from the same family are
+ * the same queue.
+ */
+struct Queues {
+	VkQueue graphics;
+	VkQueue transfer;
+	VkQueue compute;
+};
+
 uint32_t get_queue_fam(VkPhysicalDevice phys_dev);
 
+/*
+ * Picks the graphics family get_queue_fam would, plus a transfer family
+ * without graphics (ideally transfer-only) and a compute family without
+ * graphics, where the device has them.
+ */
+void get_queue_fams(VkPhysicalDevice phys_dev, struct QueueFams *fams);
+
+/*
+ * Creates a device with one queue in the given family.
+ */
 void create_device(VkPhysicalDevice phys_dev,
 		   uint32_t queue_fam,
 		   VkDevice *device);
 
+/*
+ * Creates a device with one queue in each distinct family in <fams>.
+ */
+void create_device_queues(VkPhysicalDevice phys_dev,
+			  struct QueueFams fams,
+			  VkDevice *device);
+
 void get_queue(VkDevice device, uint32_t queue_fam, VkQueue *queue);
 
+void get_queues(VkDevice device, struct QueueFams fams, struct Queues *queues);
+
 void populate_dbg_info(VkDebugUtilsMessengerCreateInfoEXT *dbg_info,
 		       DebugCallback dbg_cback,
 		       void *pUserData);
@@ -76,6 +115,10 @@ void create_dbg_msgr(VkInstance instance,
 		     VkDebugUtilsMessengerCreateInfoEXT *dbg_info,
 		     VkDebugUtilsMessengerEXT *dbg_msgr);
 
+/*
+ * Prints every message. If pUserData isn't NULL, it must point to an
+ * atomic_int, which is incremented once per message.
+ */
 VKAPI_ATTR VkBool32 VKAPI_CALL
 default_debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
 		       VkDebugUtilsMessageTypeFlagsEXT messageType,
@@ -4,6 +4,48 @@
 
 #include "vk_uniform.h"
 
+// Allocates a set with <set->layout> and writes every descriptor
+static void set_fill(VkDevice device, VkDescriptorPool dpool,
+		     uint32_t desc_ct,
+		     VkDescriptorType *desc_types,
+		     VkDescriptorBufferInfo *buffer_infos,
+		     VkDescriptorImageInfo *image_infos,
+		     struct Set *set)
+{
+	assert(desc_ct <= DESC_WRITER_MAX);
+
+	// Allocate set
+	allocate_descriptor_set(device, dpool, set->layout, &set->handle);
+
+	// Write every descriptor in one call
+	struct DescWriter writer;
+	desc_writer_create(&writer);
+
+	for (int i = 0; i < desc_ct; i++) {
+		if (desc_types[i] == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+			assert(buffer_infos[i].buffer != NULL);
+			assert(buffer_infos[i].range > 0);
+			desc_writer_buffer(&writer, set->handle, i,
+					   desc_types[i],
+					   buffer_infos[i].buffer,
+					   buffer_infos[i].range);
+		} else if (desc_types[i]
+			   == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) {
+			assert(image_infos[i].sampler != NULL);
+			assert(image_infos[i].imageView != NULL);
+			desc_writer_image(&writer, set->handle, i,
+					  image_infos[i].sampler,
+					  image_infos[i].imageView,
+					  image_infos[i].imageLayout);
+		} else {
+			printf("(set_create) Bad type: %d\n", desc_types[i]);
+			exit(1);
+		}
+	}
+
+	desc_writer_flush(device, &writer);
+}
+
 void set_create(VkDevice device, VkDescriptorPool dpool,
 		uint32_t desc_ct,
 		VkDescriptorType *desc_types,
@@ -22,20 +64,33 @@ void set_create(VkDevice device, VkDescriptorPool dpool,
 
 	// Create set layout
 	create_descriptor_layout(device, desc_ct, descs, &set->layout);
+	free(descs);
 
-	// Allocate set
-	allocate_descriptor_set(device, dpool, set->layout, &set->handle);
+	set_fill(device, dpool, desc_ct, desc_types, buffer_infos, image_infos,
+		 set);
+}
+
+void set_create_cached(VkDevice device, VkDescriptorPool dpool,
+		       struct LayoutCache *cache,
+		       uint32_t desc_ct,
+		       VkDescriptorType *desc_types,
+		       VkDescriptorBufferInfo *buffer_infos,
+		       VkDescriptorImageInfo *image_infos,
+		       VkShaderStageFlags *stages,
+		       struct Set *set)
+{
+	assert(desc_ct <= LAYOUT_CACHE_MAX_BINDINGS);
 
-	// Write
+	VkDescriptorSetLayoutBinding descs[LAYOUT_CACHE_MAX_BINDINGS];
 	for (int i = 0; i < desc_ct; i++) {
-		write_descriptor_general(device, set->handle,
-					 i, desc_types[i],
-					 buffer_infos[i].buffer,
-					 buffer_infos[i].range,
-					 image_infos[i].sampler,
-					 image_infos[i].imageView,
-					 image_infos[i].imageLayout);
+		create_descriptor_binding(i, desc_types[i], stages[i],
+					  &descs[i]);
 	}
+
+	set->layout = layout_cache_get(device, cache, desc_ct, descs);
+
+	set_fill(device, dpool, desc_ct, desc_types, buffer_infos, image_infos,
+		 set);
 }
 
 void set_destroy(VkDevice device, struct Set set)
@@ -124,6 +179,111 @@ void write_descriptor_image(VkDevice device,
 	vkUpdateDescriptorSets(device, 1, &desc_write, 0, NULL);
 }
 
+void desc_writer_create(struct DescWriter *writer)
+{
+	writer->ct = 0;
+}
+
+void desc_writer_buffer(struct DescWriter *writer,
+			VkDescriptorSet set, uint32_t location,
+			VkDescriptorType type,
+			VkBuffer buffer, VkDeviceSize size)
+{
+	assert(writer->ct < DESC_WRITER_MAX);
+	uint32_t i = writer->ct++;
+
+	VkDescriptorBufferInfo *buffer_info = &writer->buffers[i];
+	buffer_info->buffer = buffer;
+	buffer_info->offset = 0;
+	buffer_info->range = size;
+
+	VkWriteDescriptorSet *desc_write = &writer->writes[i];
+	*desc_write = (VkWriteDescriptorSet) {0};
+	desc_write->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	desc_write->dstSet = set;
+	desc_write->dstBinding = location;
+	desc_write->dstArrayElement = 0;
+
+	desc_write->descriptorType = type;
+	desc_write->descriptorCount = 1;
+	desc_write->pBufferInfo = buffer_info;
+}
+
+void desc_writer_image(struct DescWriter *writer,
+		       VkDescriptorSet set, uint32_t location,
+		       VkSampler sampler,
+		       VkImageView view, VkImageLayout layout)
+{
+	assert(writer->ct < DESC_WRITER_MAX);
+	uint32_t i = writer->ct++;
+
+	VkDescriptorImageInfo *image_info = &writer->images[i];
+	image_info->sampler = sampler;
+	image_info->imageView = view;
+	image_info->imageLayout = layout;
+
+	VkWriteDescriptorSet *desc_write = &writer->writes[i];
+	*desc_write = (VkWriteDescriptorSet) {0};
+	desc_write->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	desc_write->dstSet = set;
+	desc_write->dstBinding = location;
+	desc_write->dstArrayElement = 0;
+
+	desc_write->descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	desc_write->descriptorCount = 1;
+	desc_write->pImageInfo = image_info;
+}
+
+void desc_writer_flush(VkDevice device, struct DescWriter *writer)
+{
+	if (writer->ct == 0) return;
+
+	vkUpdateDescriptorSets(device, writer->ct, writer->writes, 0, NULL);
+	writer->ct = 0;
+}
+
+void desc_template_create(VkDevice device,
+			  VkDescriptorSetLayout layout,
+			  uint32_t desc_ct,
+			  VkDescriptorType *desc_types,
+			  size_t *offsets,
+			  VkDescriptorUpdateTemplate *tmpl)
+{
+	VkDescriptorUpdateTemplateEntry *entries =
+		malloc(sizeof(entries[0]) * desc_ct);
+
+	for (uint32_t i = 0; i < desc_ct; i++) {
+		entries[i].dstBinding = i;
+		entries[i].dstArrayElement = 0;
+		entries[i].descriptorCount = 1;
+		entries[i].descriptorType = desc_types[i];
+		entries[i].offset = offsets[i];
+		// Only matters for arrays
+		entries[i].stride = 0;
+	}
+
+	VkDescriptorUpdateTemplateCreateInfo info = {0};
+	info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+	info.descriptorUpdateEntryCount = desc_ct;
+	info.pDescriptorUpdateEntries = entries;
+	info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+	info.descriptorSetLayout = layout;
+
+	VkResult res = vkCreateDescriptorUpdateTemplate(device, &info, NULL,
+							tmpl);
+	assert(res == VK_SUCCESS);
+
+	free(entries);
+}
+
+void desc_template_write(VkDevice device,
+			 VkDescriptorUpdateTemplate tmpl,
+			 VkDescriptorSet set,
+			 const void *data)
+{
+	vkUpdateDescriptorSetWithTemplate(device, set, tmpl, data);
+}
+
 void create_descriptor_pool(VkDevice device,
 			    uint32_t desc_cap,
 			    uint32_t set_cap,
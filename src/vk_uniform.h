@@ -4,12 +4,28 @@
 #include <vulkan/vulkan.h>
 
 #include "vk_buffer.h"
+#include "vk_desc.h"
+
+// Most descriptor writes a DescWriter holds before it has to be flushed
+#define DESC_WRITER_MAX 32
 
 struct Set {
 	VkDescriptorSet handle;
 	VkDescriptorSetLayout layout;
 };
 
+/*
+ * Descriptor writes collected to be made in one vkUpdateDescriptorSets call,
+ * rather than one call each. Writes can be to any number of sets.
+ */
+struct DescWriter {
+	uint32_t ct;
+	VkWriteDescriptorSet writes[DESC_WRITER_MAX];
+	// What the writes point to
+	VkDescriptorBufferInfo buffers[DESC_WRITER_MAX];
+	VkDescriptorImageInfo images[DESC_WRITER_MAX];
+};
+
 /*
  * Create a VkDescriptorSet.
  *
@@ -27,6 +43,22 @@ void set_create(VkDevice device, VkDescriptorPool dpool,
 		VkShaderStageFlags *stages,
 		struct Set *set);
 
+/*
+ * Same as set_create, but takes the layout from <cache>, so sets with the same
+ * bindings share one. The layout belongs to the cache, so don't set_destroy
+ * the set.
+ *
+ * desc_ct: At most LAYOUT_CACHE_MAX_BINDINGS
+ */
+void set_create_cached(VkDevice device, VkDescriptorPool dpool,
+		       struct LayoutCache *cache,
+		       uint32_t desc_ct,
+		       VkDescriptorType *desc_types,
+		       VkDescriptorBufferInfo *buffer_infos,
+		       VkDescriptorImageInfo *image_infos,
+		       VkShaderStageFlags *stages,
+		       struct Set *set);
+
 /*
  * Destroys a Set struct.
  *
@@ -78,6 +110,63 @@ void write_descriptor_image(VkDevice device,
 			    VkDescriptorSet set, uint32_t location,
 			    VkSampler sampler,
 			    VkImageView view, VkImageLayout layout);
+
+/*
+ * Starts an empty DescWriter.
+ */
+void desc_writer_create(struct DescWriter *writer);
+
+/*
+ * Adds a write of <size> bytes of a buffer, from the start, to descriptor
+ * <location> of <set>.
+ *
+ * type: Like VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER or STORAGE_BUFFER
+ */
+void desc_writer_buffer(struct DescWriter *writer,
+			VkDescriptorSet set, uint32_t location,
+			VkDescriptorType type,
+			VkBuffer buffer, VkDeviceSize size);
+
+/*
+ * Adds a write of a combined image sampler to descriptor <location> of <set>.
+ */
+void desc_writer_image(struct DescWriter *writer,
+		       VkDescriptorSet set, uint32_t location,
+		       VkSampler sampler,
+		       VkImageView view, VkImageLayout layout);
+
+/*
+ * Makes every write added so far in one call, and empties the writer.
+ */
+void desc_writer_flush(VkDevice device, struct DescWriter *writer);
+
+/*
+ * Creates an update template for writing every descriptor of a set with
+ * <layout> at once, from a packed struct the caller defines. Descriptor <i>
+ * is read from <offsets[i]> bytes into the struct, as a VkDescriptorBufferInfo
+ * for buffers or a VkDescriptorImageInfo for images, so the struct can be
+ * kept around and written again every frame with a single
+ * desc_template_write.
+ *
+ * desc_types: Type of each descriptor, in binding order from 0
+ * offsets: Like offsetof(struct FrameDescs, ubo)
+ */
+void desc_template_create(VkDevice device,
+			  VkDescriptorSetLayout layout,
+			  uint32_t desc_ct,
+			  VkDescriptorType *desc_types,
+			  size_t *offsets,
+			  VkDescriptorUpdateTemplate *tmpl);
+
+/*
+ * Writes every descriptor of <set> from <data>, laid out as given to
+ * desc_template_create.
+ */
+void desc_template_write(VkDevice device,
+			 VkDescriptorUpdateTemplate tmpl,
+			 VkDescriptorSet set,
+			 const void *data);
+
 /*
  * Creates a descriptor pool.
  *
@@ -1,10 +1,43 @@
 #include "vk_window.h"
 #include "vk_image.h"
+#include "vk_tools.h"
 
 #include <stdio.h>
 #include <assert.h>
 #include <stdlib.h>
 
+// Gets a pinned framebuffer for each swapchain view, with the extra views
+// attached after it. Anything evicted to make room goes to <dq>, since earlier
+// frames may still be using it.
+static void get_swapchain_fbs(VkDevice device, struct FbCache *fb_cache,
+			      struct DeletionQueue *dq, uint64_t frame,
+			      VkRenderPass rpass,
+			      uint32_t image_ct, VkImageView *views,
+			      uint32_t extra_view_ct, VkImageView *extra_views,
+			      uint32_t width, uint32_t height,
+			      VkFramebuffer *fbs)
+{
+	assert(1 + extra_view_ct <= FB_CACHE_MAX_VIEWS);
+
+	VkImageView all_views[FB_CACHE_MAX_VIEWS];
+	for (uint32_t i = 0; i < extra_view_ct; i++) {
+		all_views[1 + i] = extra_views[i];
+	}
+
+	for (uint32_t i = 0; i < image_ct; i++) {
+		// Dynamic rendering doesn't use framebuffers
+		if (rpass == VK_NULL_HANDLE) {
+			fbs[i] = VK_NULL_HANDLE;
+			continue;
+		}
+
+		all_views[0] = views[i];
+		fbs[i] = fb_cache_get(device, fb_cache, dq, frame, rpass,
+				      1 + extra_view_ct, all_views,
+				      width, height, 1);
+	}
+}
+
 void window_create(GLFWwindow *gwin,
 		   VkPhysicalDevice phys_dev,
 		   VkInstance instance,
@@ -16,18 +49,43 @@ void window_create(GLFWwindow *gwin,
 		   uint32_t extra_view_ct, VkImageView *extra_views,
 		   uint32_t swidth, uint32_t sheight,
 		   struct Window *win)
+{
+	window_create_config(gwin, phys_dev, instance, device, surface,
+			     queue_fam, queue, rpass,
+			     extra_view_ct, extra_views,
+			     swidth, sheight,
+			     SWAPCHAIN_CONFIG_DEFAULT,
+			     win);
+}
+
+void window_create_config(GLFWwindow *gwin,
+			  VkPhysicalDevice phys_dev,
+			  VkInstance instance,
+			  VkDevice device,
+			  VkSurfaceKHR surface,
+			  uint32_t queue_fam,
+			  VkQueue queue,
+			  VkRenderPass rpass,
+			  uint32_t extra_view_ct, VkImageView *extra_views,
+			  uint32_t swidth, uint32_t sheight,
+			  struct SwapchainConfig config,
+			  struct Window *win)
 {
 	// Created resources are first assigned to local variables, then the
 	// outputs are set later (because I find it more readable)
 
 	// Swapchain
 	VkSwapchainKHR swapchain;
-	create_swapchain(phys_dev,
-			 device,
-			 queue_fam,
-			 surface,
-			 &swapchain,
-			 swidth, sheight);
+	VkPresentModeKHR present_mode;
+	create_swapchain_config(phys_dev,
+				device,
+				queue_fam,
+				surface,
+				config,
+				VK_NULL_HANDLE,
+				&present_mode,
+				&swapchain,
+				swidth, sheight);
 
 	// Image views
 	uint32_t image_ct;
@@ -36,23 +94,20 @@ void window_create(GLFWwindow *gwin,
 	VkImageView *views = malloc(sizeof(VkImageView) * image_ct);
 	create_swapchain_image_views(device, swapchain, &image_ct, views);
 
+	// Images, for barriers when rendering without a render pass
+	VkImage *images = malloc(sizeof(VkImage) * image_ct);
+	VkResult res = vkGetSwapchainImagesKHR(device, swapchain,
+					       &image_ct, images);
+	assert(res == VK_SUCCESS);
+
 	// Framebuffers
-	uint32_t all_view_ct = 1 + extra_view_ct;
+	struct FbCache fb_cache;
+	fb_cache_create(FB_CACHE_DEFAULT_MAX, &fb_cache);
 
+	// The cache is new, so nothing can be evicted yet
 	VkFramebuffer *fbs = malloc(sizeof(VkFramebuffer) * image_ct);
-	for (int i = 0; i < image_ct; i++) {
-		VkImageView *all_views =
-			concat_image_views(1, &views[i],
-					   extra_view_ct, extra_views);
-		
-		create_framebuffer(device,
-				   swidth, sheight,
-				   rpass,
-				   all_view_ct, all_views,
-				   &fbs[i]);
-
-		free(all_views);
-	}
+	get_swapchain_fbs(device, &fb_cache, NULL, 0, rpass, image_ct, views,
+			  extra_view_ct, extra_views, swidth, sheight, fbs);
 
 	// Assign
 	win->gwin = gwin;
@@ -63,11 +118,15 @@ void window_create(GLFWwindow *gwin,
 	win->queue_fam = queue_fam;
 	win->queue = queue;
 	win->rpass = rpass;
+	win->config = config;
 
 	win->swapchain = swapchain;
+	win->present_mode = present_mode;
 	win->image_ct = image_ct;
+	win->images = images;
 	win->views = views;
 	win->fbs = fbs;
+	win->fb_cache = fb_cache;
 }
 
 void window_recreate_swapchain(struct Window *win,
@@ -76,23 +135,55 @@ void window_recreate_swapchain(struct Window *win,
 {
 	vkDeviceWaitIdle(win->device);
 
-	// Recreate swapchain
-	create_swapchain(win->phys_dev,
-			 win->device,
-			 win->queue_fam,
-			 win->surface,
-			 &win->swapchain,
-			 swidth, sheight);
+	// Nothing is in use any more, so the old resources can go right away
+	struct DeletionQueue dq;
+	deletion_queue_create(&dq);
+
+	window_recreate_swapchain_deferred(win, &dq, 0,
+					   extra_view_ct, extra_views,
+					   swidth, sheight);
+
+	deletion_queue_destroy(win->device, dq);
+}
 
-	// Recreate swapchain image views
-	// First destroy old image views
+void window_recreate_swapchain_deferred(struct Window *win,
+					struct DeletionQueue *dq,
+					uint64_t last_use,
+					uint32_t extra_view_ct,
+					VkImageView *extra_views,
+					uint32_t swidth, uint32_t sheight)
+{
+	// Recreate swapchain, handing the old one over so the presentation
+	// engine can reuse its resources and frames already queued with it can
+	// still be shown
+	VkSwapchainKHR old_swapchain = win->swapchain;
+	create_swapchain_config(win->phys_dev,
+				win->device,
+				win->queue_fam,
+				win->surface,
+				win->config,
+				old_swapchain,
+				&win->present_mode,
+				&win->swapchain,
+				swidth, sheight);
+
+	// Retire the old swapchain, framebuffers and image views
 	assert(win->views != NULL);
+	assert(win->fbs != NULL);
+
+	deletion_queue_push(dq, last_use, VK_OBJECT_TYPE_SWAPCHAIN_KHR,
+			    (uint64_t) old_swapchain);
 
 	for (int i = 0; i < win->image_ct; i++) {
-		vkDestroyImageView(win->device, win->views[i], NULL);
+		fb_cache_evict_view(win->device, &win->fb_cache, dq, last_use,
+				    win->views[i]);
+		deletion_queue_push(dq, last_use, VK_OBJECT_TYPE_IMAGE_VIEW,
+				    (uint64_t) win->views[i]);
 	}
 
+	free(win->fbs);
 	free(win->views);
+	free(win->images);
 
 	// Get new image count and allocate
 	create_swapchain_image_views(win->device,
@@ -107,34 +198,18 @@ void window_recreate_swapchain(struct Window *win,
 				     &win->image_ct,
 				     win->views);
 
-	// Recreate framebuffers
-	// First destroy the old ones
-	assert(win->fbs != NULL);
-
-	for (int i = 0; i < win->image_ct; i++) {
-		vkDestroyFramebuffer(win->device, win->fbs[i], NULL);
-	}
-
-	free(win->fbs);
+	win->images = malloc(sizeof(VkImage) * win->image_ct);
+	VkResult res = vkGetSwapchainImagesKHR(win->device, win->swapchain,
+					       &win->image_ct, win->images);
+	assert(res == VK_SUCCESS);
 
-	// Create new framebuffers
-	uint32_t all_view_ct = 1 + extra_view_ct;
-	
+	// Create new framebuffers, first used in the frame after <last_use>
 	win->fbs = malloc(sizeof(VkFramebuffer) * win->image_ct);
-
-	for (int i = 0; i < win->image_ct; i++) {
-		VkImageView *all_views
-			= concat_image_views(1, &win->views[i],
-					     extra_view_ct, extra_views);
-
-		create_framebuffer(win->device,
-				   swidth,
-				   sheight,
-				   win->rpass,
-				   all_view_ct, all_views,
-				   &win->fbs[i]);
-		free(all_views);
-	}
+	get_swapchain_fbs(win->device, &win->fb_cache, dq, last_use + 1,
+			  win->rpass,
+			  win->image_ct, win->views,
+			  extra_view_ct, extra_views, swidth, sheight,
+			  win->fbs);
 }
 
 int window_acquire(struct Window *win,
@@ -169,20 +244,47 @@ int window_acquire(struct Window *win,
 			continue;
 		}
 
-		assert(res == VK_SUCCESS);
+		assert(res == VK_SUCCESS || res == VK_SUBOPTIMAL_KHR);
 		*fb = win->fbs[*image_idx];
 
 		return was_recreated;
 	}
 }
 
+int window_try_acquire(struct Window *win,
+		       VkSemaphore sem,
+		       uint32_t *image_idx,
+		       VkFramebuffer *fb)
+{
+	VkResult res = vkAcquireNextImageKHR(win->device,
+					     win->swapchain,
+					     UINT64_MAX,
+					     sem,
+					     NULL,
+					     image_idx);
+
+	if (res == VK_ERROR_OUT_OF_DATE_KHR) return 1;
+
+	// A suboptimal image can still be presented; the next present will
+	// report it too, and the caller can recreate then
+	assert(res == VK_SUCCESS || res == VK_SUBOPTIMAL_KHR);
+	*fb = win->fbs[*image_idx];
+
+	return 0;
+}
+
 void window_cleanup(struct Window *win)
 {
+	fb_cache_destroy(win->device, win->fb_cache);
+
 	for (int i = 0; i < win->image_ct; i++) {
-		vkDestroyFramebuffer(win->device, win->fbs[i], NULL);
 		vkDestroyImageView(win->device, win->views[i], NULL);
 	}
 
+	free(win->fbs);
+	free(win->views);
+	free(win->images);
+
 	vkDestroySwapchainKHR(win->device, win->swapchain, NULL);
 }
 
@@ -198,6 +300,21 @@ void create_swapchain(VkPhysicalDevice phys_dev,
 		      VkSurfaceKHR surface,
 		      VkSwapchainKHR *swapchain,
 		      uint32_t width, uint32_t height)
+{
+	create_swapchain_config(phys_dev, device, queue_fam, surface,
+				SWAPCHAIN_CONFIG_DEFAULT, VK_NULL_HANDLE, NULL,
+				swapchain, width, height);
+}
+
+void create_swapchain_config(VkPhysicalDevice phys_dev,
+			     VkDevice device,
+			     uint32_t queue_fam,
+			     VkSurfaceKHR surface,
+			     struct SwapchainConfig config,
+			     VkSwapchainKHR old_swapchain,
+			     VkPresentModeKHR *present_mode,
+			     VkSwapchainKHR *swapchain,
+			     uint32_t width, uint32_t height)
 {
 	// Ensure surface has presentation support
 	VkBool32 support = VK_FALSE;
@@ -208,6 +325,9 @@ void create_swapchain(VkPhysicalDevice phys_dev,
 	VkSurfaceCapabilitiesKHR caps;
 	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(phys_dev, surface, &caps);
 
+	VkPresentModeKHR mode = choose_present_mode(phys_dev, surface,
+						    config.policy);
+
 	VkExtent2D extent;
 	extent.width = width;
 	extent.height = height;
@@ -215,7 +335,7 @@ void create_swapchain(VkPhysicalDevice phys_dev,
 	VkSwapchainCreateInfoKHR info = {0};
 	info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
 	info.surface = surface;
-	info.minImageCount = caps.minImageCount;
+	info.minImageCount = choose_image_ct(caps, mode, config.image_ct);
 	info.imageFormat = SW_FORMAT;
 	info.imageColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
 	info.imageExtent = extent;
@@ -226,12 +346,113 @@ void create_swapchain(VkPhysicalDevice phys_dev,
 	info.pQueueFamilyIndices = &queue_fam;
 	info.preTransform = caps.currentTransform;
 	info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-	info.presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+	info.presentMode = mode;
 	info.clipped = VK_TRUE;
-	info.oldSwapchain = VK_NULL_HANDLE;
+	info.oldSwapchain = old_swapchain;
 
 	VkResult res = vkCreateSwapchainKHR(device, &info, NULL, swapchain);
 	assert(res == VK_SUCCESS);
+
+	if (present_mode != NULL) *present_mode = mode;
+}
+
+VkPresentModeKHR choose_present_mode(VkPhysicalDevice phys_dev,
+				     VkSurfaceKHR surface,
+				     enum PresentPolicy policy)
+{
+	VkPresentModeKHR throughput[] = {
+		VK_PRESENT_MODE_IMMEDIATE_KHR,
+		VK_PRESENT_MODE_MAILBOX_KHR,
+	};
+	VkPresentModeKHR low_latency[] = {
+		VK_PRESENT_MODE_MAILBOX_KHR,
+		VK_PRESENT_MODE_IMMEDIATE_KHR,
+	};
+	VkPresentModeKHR adaptive_vsync[] = {
+		VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+	};
+
+	VkPresentModeKHR *prefs = NULL;
+	uint32_t pref_ct = 0;
+	switch (policy) {
+	case PRESENT_POLICY_THROUGHPUT:
+		prefs = throughput;
+		pref_ct = ARRAY_SIZE(throughput);
+		break;
+	case PRESENT_POLICY_LOW_LATENCY:
+		prefs = low_latency;
+		pref_ct = ARRAY_SIZE(low_latency);
+		break;
+	case PRESENT_POLICY_ADAPTIVE_VSYNC:
+		prefs = adaptive_vsync;
+		pref_ct = ARRAY_SIZE(adaptive_vsync);
+		break;
+	case PRESENT_POLICY_VSYNC:
+		break;
+	}
+
+	uint32_t mode_ct;
+	VkResult res = vkGetPhysicalDeviceSurfacePresentModesKHR(
+		phys_dev, surface, &mode_ct, NULL);
+	assert(res == VK_SUCCESS);
+
+	VkPresentModeKHR *modes = malloc(sizeof(modes[0]) * mode_ct);
+	res = vkGetPhysicalDeviceSurfacePresentModesKHR(
+		phys_dev, surface, &mode_ct, modes);
+	assert(res == VK_SUCCESS);
+
+	// FIFO is the only mode that's guaranteed
+	VkPresentModeKHR chosen = VK_PRESENT_MODE_FIFO_KHR;
+	for (uint32_t i = 0; i < pref_ct; i++) {
+		int supported = 0;
+		for (uint32_t j = 0; j < mode_ct; j++) {
+			if (modes[j] == prefs[i]) supported = 1;
+		}
+
+		if (supported) {
+			chosen = prefs[i];
+			break;
+		}
+	}
+
+	free(modes);
+
+	return chosen;
+}
+
+uint32_t choose_image_ct(VkSurfaceCapabilitiesKHR caps,
+			 VkPresentModeKHR present_mode,
+			 uint32_t requested)
+{
+	uint32_t ct = requested;
+	if (ct == 0) {
+		ct = caps.minImageCount;
+		if (present_mode == VK_PRESENT_MODE_MAILBOX_KHR) ct++;
+	}
+
+	if (ct < caps.minImageCount) ct = caps.minImageCount;
+	// A max of 0 means there isn't one
+	if (caps.maxImageCount > 0 && ct > caps.maxImageCount) {
+		ct = caps.maxImageCount;
+	}
+
+	return ct;
+}
+
+const char *present_mode_name(VkPresentModeKHR present_mode)
+{
+	switch (present_mode) {
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:
+		return "IMMEDIATE_KHR";
+	case VK_PRESENT_MODE_MAILBOX_KHR:
+		return "MAILBOX_KHR";
+	case VK_PRESENT_MODE_FIFO_KHR:
+		return "FIFO_KHR";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+		return "FIFO_RELAXED_KHR";
+	default:
+		return "UNKNOWN";
+	}
 }
 
 void create_swapchain_image_views(VkDevice device,
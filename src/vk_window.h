@@ -6,6 +6,39 @@
 #include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
 
+#include "vk_delete.h"
+#include "vk_fb_cache.h"
+
+/*
+ * What to prioritize when choosing a present mode. Each policy tries modes in
+ * order, falling back to FIFO (which is always supported).
+ */
+enum PresentPolicy {
+	// Uncapped frame rate, tearing allowed: IMMEDIATE, MAILBOX, FIFO
+	PRESENT_POLICY_THROUGHPUT,
+	// Newest frame shown at each vblank, without tearing: MAILBOX,
+	// IMMEDIATE, FIFO
+	PRESENT_POLICY_LOW_LATENCY,
+	// Vsync, but tear instead of waiting when a frame is late:
+	// FIFO_RELAXED, FIFO
+	PRESENT_POLICY_ADAPTIVE_VSYNC,
+	// Vsync: FIFO
+	PRESENT_POLICY_VSYNC,
+};
+
+struct SwapchainConfig {
+	enum PresentPolicy policy;
+
+	// How many images to ask for, clamped to what the surface supports. If
+	// 0, uses the minimum, plus one for MAILBOX so there's always an image
+	// to render to while another is queued.
+	uint32_t image_ct;
+};
+
+// What window_create uses, and what it always did
+#define SWAPCHAIN_CONFIG_DEFAULT \
+	((struct SwapchainConfig) {PRESENT_POLICY_THROUGHPUT, 0})
+
 /*
  * A struct wrapping a GLFW window and the swapchain associated with it.
  *
@@ -21,12 +54,20 @@ struct Window {
 	uint32_t queue_fam;
 	VkQueue queue;
 	VkRenderPass rpass;
+	struct SwapchainConfig config;
 
 	// Created
 	VkSwapchainKHR swapchain;
+	VkPresentModeKHR present_mode;
 	uint32_t image_ct;
+	VkImage *images;
 	VkImageView *views;
+	// Pinned in fb_cache. VK_NULL_HANDLE if there's no render pass.
 	VkFramebuffer *fbs;
+
+	// Holds the swapchain framebuffers. Other render targets can use it
+	// too.
+	struct FbCache fb_cache;
 };
 
 /*
@@ -35,6 +76,9 @@ struct Window {
  * Creates a swapchain, swapchain image views, and framebuffers (which are
  * stored in the Window struct).
  *
+ * rpass: Render pass the framebuffers are for. If VK_NULL_HANDLE, no
+ * framebuffers are made, for rendering straight to the views with dynamic
+ * rendering (see DynRender).
  * extra_views: Image views to include in the framebuffer in addition to the
  * swapchain's. Can be NULL if extra_view_ct is 0.
  */
@@ -50,9 +94,26 @@ void window_create(GLFWwindow *gwin,
 		   uint32_t swidth, uint32_t sheight,
 		   struct Window *win);
 
+/*
+ * Same as window_create, but with a choice of present mode and image count.
+ * The config is kept for when the swapchain is recreated.
+ */
+void window_create_config(GLFWwindow *gwin,
+			  VkPhysicalDevice phys_dev,
+			  VkInstance instance,
+			  VkDevice device,
+			  VkSurfaceKHR surface,
+			  uint32_t queue_fam,
+			  VkQueue queue,
+			  VkRenderPass rpass,
+			  uint32_t extra_view_ct, VkImageView *extra_views,
+			  uint32_t swidth, uint32_t sheight,
+			  struct SwapchainConfig config,
+			  struct Window *win);
+
 /*
  * Recreates the swapchain stored in the Window struct, using swidth and sheight
- * as the new dimensions.
+ * as the new dimensions. Waits for the device to go idle first.
  *
  * extra_views: Image views to include in the framebuffer in addition to the
  * swapchain's. Can be NULL if extra_view_ct is 0.
@@ -61,6 +122,23 @@ void window_recreate_swapchain(struct Window *win,
 			       uint32_t extra_view_ct, VkImageView *extra_views,
 			       uint32_t swidth, uint32_t sheight);
 
+/*
+ * Same as window_recreate_swapchain, but doesn't wait for the device to go
+ * idle. The old swapchain is passed as oldSwapchain, so frames still in flight
+ * can be presented, then it and its framebuffers and image views are pushed to
+ * <dq>, to be destroyed once <last_use> has completed.
+ *
+ * No images acquired from the old swapchain may be left unpresented.
+ *
+ * last_use: Timeline value of the last frame submitted with the old swapchain
+ */
+void window_recreate_swapchain_deferred(struct Window *win,
+					struct DeletionQueue *dq,
+					uint64_t last_use,
+					uint32_t extra_view_ct,
+					VkImageView *extra_views,
+					uint32_t swidth, uint32_t sheight);
+
 /*
  * Acquire a swapchain image.
  *
@@ -79,6 +157,19 @@ int window_acquire(struct Window *win,
 		   uint32_t extra_view_ct, VkImageView *extra_views,
 		   VkFramebuffer *fb);
 
+/*
+ * Acquire a swapchain image, without recreating the swapchain.
+ *
+ * Returns 0 on success (including when the swapchain is suboptimal), or 1 if
+ * the swapchain is out of date. In that case nothing was acquired and <sem>
+ * won't be signalled; recreate with window_recreate_swapchain_deferred and try
+ * again.
+ */
+int window_try_acquire(struct Window *win,
+		       VkSemaphore sem,
+		       uint32_t *image_idx,
+		       VkFramebuffer *fb);
+
 /*
  * Destroys a Window struct and created resources(swapchain, image views,
  * framebuffers)
@@ -98,7 +189,7 @@ void create_surface(VkInstance instance,
 		    VkSurfaceKHR *surface);
 
 /*
- * Create a swapchain.
+ * Create a swapchain, with SWAPCHAIN_CONFIG_DEFAULT.
  */
 void create_swapchain(VkPhysicalDevice phys_dev,
 		      VkDevice device,
@@ -107,6 +198,43 @@ void create_swapchain(VkPhysicalDevice phys_dev,
 		      VkSwapchainKHR *swapchain,
 		      uint32_t width, uint32_t height);
 
+/*
+ * Create a swapchain with the given config.
+ *
+ * old_swapchain: Swapchain being replaced, or VK_NULL_HANDLE. It's retired,
+ * but still has to be destroyed by the caller.
+ * present_mode: If not NULL, receives the mode that was chosen
+ */
+void create_swapchain_config(VkPhysicalDevice phys_dev,
+			     VkDevice device,
+			     uint32_t queue_fam,
+			     VkSurfaceKHR surface,
+			     struct SwapchainConfig config,
+			     VkSwapchainKHR old_swapchain,
+			     VkPresentModeKHR *present_mode,
+			     VkSwapchainKHR *swapchain,
+			     uint32_t width, uint32_t height);
+
+/*
+ * Returns the first present mode the policy prefers that the surface supports.
+ */
+VkPresentModeKHR choose_present_mode(VkPhysicalDevice phys_dev,
+				     VkSurfaceKHR surface,
+				     enum PresentPolicy policy);
+
+/*
+ * Returns how many swapchain images to ask for (see SwapchainConfig.image_ct).
+ */
+uint32_t choose_image_ct(VkSurfaceCapabilitiesKHR caps,
+			 VkPresentModeKHR present_mode,
+			 uint32_t requested);
+
+/*
+ * Returns a present mode's name without the VK_PRESENT_MODE_ prefix, like
+ * "MAILBOX_KHR".
+ */
+const char *present_mode_name(VkPresentModeKHR present_mode);
+
 /*
  * Create the image views for a swapchain.
  *
@@ -11,12 +11,34 @@
 #include "../tests-src/obj.h"
 #include "../tests-src/camera.h"
 #include "../tests-src/fullstack.h"
+#include "../tests-src/lod.h"
+#include "../tests-src/meshlet.h"
+#include "../tests-src/cull.h"
+#include "../tests-src/bvh.h"
+#include "../tests-src/vk_hiz.h"
+#include "../tests-src/vk_frame.h"
+#include "../tests-src/vk_delete.h"
+#include "../tests-src/mpsc.h"
+#include "../tests-src/latency.h"
+#include "../tests-src/vk_submit.h"
+#include "../tests-src/vk_fb_cache.h"
+#include "../tests-src/vk_dyn_render.h"
+#include "../tests-src/vk_graph.h"
+#include "../tests-src/vk_barrier.h"
+#include "../tests-src/vk_mips.h"
+#include "../tests-src/bcn.h"
+#include "../tests-src/texture.h"
+#include "../tests-src/vk_tex_stream.h"
+#include "../tests-src/vk_bindless.h"
+#include "../tests-src/vk_desc.h"
+#include "../tests-src/vk_pipe_cache.h"
+#include "../tests-src/vk_pipe_build.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 
 int main(int argc, char *argv[]) {
-    int suite_count = 12;
+    int suite_count = 34;
     Suite **suites = malloc(sizeof(suites[0]) * suite_count);
 
     int suite_idx = 0;
@@ -34,6 +56,28 @@ int main(int argc, char *argv[]) {
     suites[suite_idx++] = vk_obj_suite();
     suites[suite_idx++] = vk_image_suite();
     suites[suite_idx++] = vk_fullstack_suite();
+    suites[suite_idx++] = vk_lod_suite();
+    suites[suite_idx++] = vk_meshlet_suite();
+    suites[suite_idx++] = vk_cull_suite();
+    suites[suite_idx++] = vk_bvh_suite();
+    suites[suite_idx++] = vk_hiz_suite();
+    suites[suite_idx++] = vk_frame_suite();
+    suites[suite_idx++] = vk_delete_suite();
+    suites[suite_idx++] = vk_mpsc_suite();
+    suites[suite_idx++] = vk_latency_suite();
+    suites[suite_idx++] = vk_submit_suite();
+    suites[suite_idx++] = vk_fb_cache_suite();
+    suites[suite_idx++] = vk_dyn_render_suite();
+    suites[suite_idx++] = vk_graph_suite();
+    suites[suite_idx++] = vk_barrier_suite();
+    suites[suite_idx++] = vk_mips_suite();
+    suites[suite_idx++] = vk_bcn_suite();
+    suites[suite_idx++] = vk_texture_suite();
+    suites[suite_idx++] = vk_tex_stream_suite();
+    suites[suite_idx++] = vk_bindless_suite();
+    suites[suite_idx++] = vk_desc_suite();
+    suites[suite_idx++] = vk_pipe_cache_suite();
+    suites[suite_idx++] = vk_pipe_build_suite();
 
     // If we got a command-line argument, only run that suite
     if (argc == 2) {
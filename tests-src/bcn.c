@@ -0,0 +1,235 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <check.h>
+
+#include "../src/bcn.h"
+
+#include "helpers.h"
+
+// Reference decoders, to check encoded blocks against
+
+static void decode_565(uint16_t c, int out[3])
+{
+	int r = (c >> 11) & 31;
+	int g = (c >> 5) & 63;
+	int b = c & 31;
+	out[0] = (r << 3) | (r >> 2);
+	out[1] = (g << 2) | (g >> 4);
+	out[2] = (b << 3) | (b >> 2);
+}
+
+static void bc1_decode(const unsigned char in[BC1_BLOCK_SIZE],
+		       unsigned char texels[16][4])
+{
+	uint16_t c0 = in[0] | (in[1] << 8);
+	uint16_t c1 = in[2] | (in[3] << 8);
+	uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16)
+		| ((uint32_t) in[7] << 24);
+
+	int palette[4][4];
+	decode_565(c0, palette[0]);
+	decode_565(c1, palette[1]);
+	for (int c = 0; c < 3; c++) {
+		if (c0 > c1) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		} else {
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	palette[0][3] = palette[1][3] = palette[2][3] = 255;
+	palette[3][3] = c0 > c1 ? 255 : 0;
+
+	for (int i = 0; i < 16; i++) {
+		int idx = (indices >> (2 * i)) & 3;
+		for (int c = 0; c < 4; c++) texels[i][c] = palette[idx][c];
+	}
+}
+
+static uint32_t get_bits(const unsigned char *in, uint32_t *pos, uint32_t ct)
+{
+	uint32_t v = 0;
+	for (uint32_t i = 0; i < ct; i++) {
+		if (in[*pos / 8] & (1 << (*pos % 8))) v |= 1u << i;
+		(*pos)++;
+	}
+	return v;
+}
+
+// Only mode 6
+static void bc7_decode(const unsigned char in[BC7_BLOCK_SIZE],
+		       unsigned char texels[16][4])
+{
+	static const int weights[16] = {
+		0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+	};
+
+	uint32_t pos = 0;
+	ck_assert(get_bits(in, &pos, 7) == 1 << 6);
+
+	int e[2][4];
+	for (int c = 0; c < 4; c++) {
+		e[0][c] = get_bits(in, &pos, 7) << 1;
+		e[1][c] = get_bits(in, &pos, 7) << 1;
+	}
+	uint32_t p0 = get_bits(in, &pos, 1);
+	uint32_t p1 = get_bits(in, &pos, 1);
+	for (int c = 0; c < 4; c++) {
+		e[0][c] |= p0;
+		e[1][c] |= p1;
+	}
+
+	for (int i = 0; i < 16; i++) {
+		int w = weights[get_bits(in, &pos, i == 0 ? 3 : 4)];
+		for (int c = 0; c < 4; c++) {
+			texels[i][c] = ((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6;
+		}
+	}
+	ck_assert(pos == 128);
+}
+
+// Largest difference of any channel of any texel
+static int max_error(unsigned char a[16][4], unsigned char b[16][4],
+		     int ch_ct)
+{
+	int max = 0;
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < ch_ct; c++) {
+			int d = abs(a[i][c] - b[i][c]);
+			if (d > max) max = d;
+		}
+	}
+	return max;
+}
+
+START_TEST (ut_bc1_two_colors)
+{
+	// Black and white are exact in 5:6:5, and so are blocks of just them
+	unsigned char texels[16][4];
+	for (int i = 0; i < 16; i++) {
+		unsigned char v = (i + i / 4) % 2 ? 255 : 0;
+		texels[i][0] = texels[i][1] = texels[i][2] = v;
+		texels[i][3] = 255;
+	}
+
+	unsigned char block[BC1_BLOCK_SIZE];
+	bc1_encode_block(texels, block);
+
+	unsigned char out[16][4];
+	bc1_decode(block, out);
+	ck_assert(max_error(texels, out, 4) == 0);
+} END_TEST
+
+START_TEST (ut_bc1_gradient)
+{
+	// Colors on a line are covered by the 4 palette entries
+	unsigned char texels[16][4];
+	for (int i = 0; i < 16; i++) {
+		texels[i][0] = 16 * i;
+		texels[i][1] = 255 - 16 * i;
+		texels[i][2] = 128;
+		texels[i][3] = 255;
+	}
+
+	unsigned char block[BC1_BLOCK_SIZE];
+	bc1_encode_block(texels, block);
+
+	unsigned char out[16][4];
+	bc1_decode(block, out);
+	ck_assert(max_error(texels, out, 3) <= 48);
+} END_TEST
+
+START_TEST (ut_bc7_solid)
+{
+	unsigned char texels[16][4];
+	for (int i = 0; i < 16; i++) {
+		texels[i][0] = 200;
+		texels[i][1] = 100;
+		texels[i][2] = 50;
+		texels[i][3] = 128;
+	}
+
+	unsigned char block[BC7_BLOCK_SIZE];
+	bc7_encode_block(texels, block);
+
+	unsigned char out[16][4];
+	bc7_decode(block, out);
+	ck_assert(max_error(texels, out, 4) <= 1);
+} END_TEST
+
+START_TEST (ut_bc7_gradient)
+{
+	// 16 interpolation steps, with alpha varying along the same line
+	unsigned char texels[16][4];
+	for (int i = 0; i < 16; i++) {
+		texels[i][0] = 17 * i;
+		texels[i][1] = 255 - 17 * i;
+		texels[i][2] = 64;
+		texels[i][3] = 255 - 8 * i;
+	}
+
+	unsigned char block[BC7_BLOCK_SIZE];
+	bc7_encode_block(texels, block);
+
+	unsigned char out[16][4];
+	bc7_decode(block, out);
+	ck_assert(max_error(texels, out, 4) <= 6);
+} END_TEST
+
+START_TEST (ut_bc_encode_edges)
+{
+	// 5x3 needs 2x1 blocks. The right block is mostly the repeated last
+	// column, which is all one color.
+	unsigned char rgba[4 * 5 * 3];
+	for (int i = 0; i < 5 * 3; i++) {
+		unsigned char v = i % 5 == 4 ? 255 : 0;
+		rgba[4 * i] = rgba[4 * i + 1] = rgba[4 * i + 2] = v;
+		rgba[4 * i + 3] = 255;
+	}
+
+	unsigned char blocks[2 * BC1_BLOCK_SIZE];
+	bc_encode(5, 3, rgba, bc1_encode_block, BC1_BLOCK_SIZE, blocks);
+
+	unsigned char out[16][4];
+	bc1_decode(&blocks[BC1_BLOCK_SIZE], out);
+	for (int i = 0; i < 16; i++) {
+		ck_assert(out[i][0] == 255);
+		ck_assert(out[i][1] == 255);
+		ck_assert(out[i][2] == 255);
+	}
+
+	bc1_decode(blocks, out);
+	for (int i = 0; i < 16; i++) ck_assert(out[i][0] == 0);
+} END_TEST
+
+Suite *vk_bcn_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("BCn encoding");
+
+	TCase *tc1 = tcase_create("BC1 two colors");
+	tcase_add_test(tc1, ut_bc1_two_colors);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("BC1 gradient");
+	tcase_add_test(tc2, ut_bc1_gradient);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("BC7 solid");
+	tcase_add_test(tc3, ut_bc7_solid);
+	suite_add_tcase(s, tc3);
+
+	TCase *tc4 = tcase_create("BC7 gradient");
+	tcase_add_test(tc4, ut_bc7_gradient);
+	suite_add_tcase(s, tc4);
+
+	TCase *tc5 = tcase_create("Image edges");
+	tcase_add_test(tc5, ut_bc_encode_edges);
+	suite_add_tcase(s, tc5);
+
+	return s;
+}
@@ -0,0 +1,8 @@
+#ifndef T_BCN_H_
+#define T_BCN_H_
+
+#include <check.h>
+
+Suite *vk_bcn_suite(void);
+
+#endif // T_BCN_H_
@@ -0,0 +1,258 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <check.h>
+
+#include <cglm/cglm.h>
+
+#include "../src/camera.h"
+#include "../src/cull.h"
+#include "../src/bvh.h"
+
+#define BOX_CT 5000
+
+static float rand_range(float min, float max)
+{
+	return min + (max - min) * ((float) rand() / (float) RAND_MAX);
+}
+
+static void gen_boxes(size_t ct, struct AabbArray *aabbs)
+{
+	cull_aabbs_create(ct, aabbs);
+
+	srand(2);
+	for (size_t i = 0; i < ct; i++) {
+		vec3 min = {rand_range(-100, 100), rand_range(-100, 100),
+			    rand_range(-100, 100)};
+		vec3 max = {min[0] + rand_range(0, 3), min[1] + rand_range(0, 3),
+			    min[2] + rand_range(0, 3)};
+		cull_aabbs_set(aabbs, i, min, max);
+	}
+}
+
+static int node_contains(struct BvhNode *n, float min[3], float max[3])
+{
+	for (int i = 0; i < 3; i++) {
+		if (min[i] < n->min[i] || max[i] > n->max[i]) return 0;
+	}
+
+	return 1;
+}
+
+// Checks the bounds and object ranges of every node
+static void check_tree(struct Bvh *bvh, struct AabbArray *aabbs)
+{
+	ck_assert(bvh->nodes[0].first == 0);
+	ck_assert(bvh->nodes[0].ct == aabbs->ct);
+
+	for (uint32_t i = 0; i < bvh->node_ct; i++) {
+		struct BvhNode *n = &bvh->nodes[i];
+
+		if (n->right == 0) {
+			for (uint32_t j = n->first; j < n->first + n->ct; j++) {
+				uint32_t obj = bvh->objects[j];
+				float min[3] = {aabbs->min_x[obj], aabbs->min_y[obj],
+						aabbs->min_z[obj]};
+				float max[3] = {aabbs->max_x[obj], aabbs->max_y[obj],
+						aabbs->max_z[obj]};
+				ck_assert(node_contains(n, min, max));
+			}
+			continue;
+		}
+
+		struct BvhNode *l = &bvh->nodes[i + 1];
+		struct BvhNode *r = &bvh->nodes[n->right];
+		ck_assert(n->right > i + 1);
+		ck_assert(l->first == n->first);
+		ck_assert(r->first == l->first + l->ct);
+		ck_assert(l->ct + r->ct == n->ct);
+		ck_assert(node_contains(n, l->min, l->max));
+		ck_assert(node_contains(n, r->min, r->max));
+	}
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(uint32_t *) a;
+	uint32_t y = *(uint32_t *) b;
+	return (x > y) - (x < y);
+}
+
+START_TEST (ut_build)
+{
+	struct AabbArray aabbs;
+	gen_boxes(BOX_CT, &aabbs);
+
+	struct Bvh bvh;
+	bvh_build(&aabbs, &bvh);
+
+	ck_assert(bvh.node_ct > 1);
+	ck_assert(bvh.node_ct < 2 * BOX_CT);
+
+	// Every object shows up exactly once
+	uint32_t *objects = malloc(sizeof(objects[0]) * BOX_CT);
+	memcpy(objects, bvh.objects, sizeof(objects[0]) * BOX_CT);
+	qsort(objects, BOX_CT, sizeof(objects[0]), cmp_u32);
+	for (uint32_t i = 0; i < BOX_CT; i++) ck_assert(objects[i] == i);
+	free(objects);
+
+	check_tree(&bvh, &aabbs);
+
+	bvh_destroy(bvh);
+	cull_aabbs_destroy(aabbs);
+} END_TEST
+
+START_TEST (ut_refit)
+{
+	struct AabbArray aabbs;
+	gen_boxes(BOX_CT, &aabbs);
+
+	struct Bvh bvh;
+	bvh_build(&aabbs, &bvh);
+
+	// Move some boxes around
+	for (size_t i = 0; i < BOX_CT; i += 7) {
+		aabbs.min_x[i] += 50.0f;
+		aabbs.max_x[i] += 50.0f;
+		aabbs.min_y[i] -= 20.0f;
+		aabbs.max_y[i] -= 20.0f;
+	}
+
+	bvh_refit(&bvh, &aabbs);
+	check_tree(&bvh, &aabbs);
+
+	bvh_destroy(bvh);
+	cull_aabbs_destroy(aabbs);
+} END_TEST
+
+START_TEST (ut_frustum)
+{
+	struct AabbArray aabbs;
+	gen_boxes(BOX_CT, &aabbs);
+
+	struct Bvh bvh;
+	bvh_build(&aabbs, &bvh);
+
+	struct FlyCamera cam = cam_fly_new(-50.0, 10.0, 20.0, 0.3f, -0.1f,
+					   0.0, 0.0);
+	mat4 view_proj;
+	cam_fly_mat(&cam, 800, 600, view_proj);
+	vec4 planes[6];
+	cam_frustum_planes(view_proj, planes);
+
+	uint32_t *linear = malloc(sizeof(linear[0]) * BOX_CT);
+	uint32_t *tree = malloc(sizeof(tree[0]) * BOX_CT);
+
+	size_t linear_ct = cull_aabbs(&aabbs, planes, linear);
+	size_t tree_ct = bvh_query_frustum(&bvh, &aabbs, planes, tree);
+
+	// Same objects, maybe in a different order
+	ck_assert(linear_ct > 0 && linear_ct < BOX_CT);
+	ck_assert(tree_ct == linear_ct);
+	qsort(tree, tree_ct, sizeof(tree[0]), cmp_u32);
+	for (size_t i = 0; i < tree_ct; i++) ck_assert(tree[i] == linear[i]);
+
+	free(linear);
+	free(tree);
+	bvh_destroy(bvh);
+	cull_aabbs_destroy(aabbs);
+} END_TEST
+
+START_TEST (ut_raycast)
+{
+	struct AabbArray aabbs;
+	gen_boxes(BOX_CT, &aabbs);
+
+	struct Bvh bvh;
+	bvh_build(&aabbs, &bvh);
+
+	int hits = 0;
+	for (int r = 0; r < 200; r++) {
+		vec3 origin = {rand_range(-150, 150), rand_range(-150, 150),
+			       rand_range(-150, 150)};
+		vec3 dir = {rand_range(-1, 1), rand_range(-1, 1),
+			    rand_range(-1, 1)};
+
+		float t;
+		uint32_t hit = bvh_raycast(&bvh, &aabbs, origin, dir, &t);
+
+		// Brute force the nearest hit
+		uint32_t expected = BVH_NO_HIT;
+		float expected_t = INFINITY;
+		for (uint32_t i = 0; i < BOX_CT; i++) {
+			float min[3] = {aabbs.min_x[i], aabbs.min_y[i], aabbs.min_z[i]};
+			float max[3] = {aabbs.max_x[i], aabbs.max_y[i], aabbs.max_z[i]};
+
+			float t_near = 0.0f;
+			float t_far = INFINITY;
+			for (int j = 0; j < 3; j++) {
+				float t1 = (min[j] - origin[j]) / dir[j];
+				float t2 = (max[j] - origin[j]) / dir[j];
+				t_near = fmaxf(t_near, fminf(t1, t2));
+				t_far = fminf(t_far, fmaxf(t1, t2));
+			}
+
+			if (t_near <= t_far && t_near < expected_t) {
+				expected_t = t_near;
+				expected = i;
+			}
+		}
+
+		ck_assert((hit == BVH_NO_HIT) == (expected == BVH_NO_HIT));
+		if (hit != BVH_NO_HIT) {
+			hits++;
+			ck_assert(fabsf(t - expected_t) < 0.001f);
+		}
+	}
+
+	ck_assert(hits > 0);
+
+	// Looking straight at a box from a camera
+	struct FlyCamera cam = cam_fly_new(-120.0, 0.5, 0.5, 0.0f, 0.0f,
+					   0.0, 0.0);
+	struct AabbArray one;
+	cull_aabbs_create(1, &one);
+	cull_aabbs_set(&one, 0, (vec3){-1, 0, 0}, (vec3){1, 1, 1});
+
+	struct Bvh one_bvh;
+	bvh_build(&one, &one_bvh);
+
+	float t;
+	ck_assert(bvh_pick_fly(&one_bvh, &one, &cam, &t) == 0);
+	ck_assert(fabsf(t - 119.0f) < 0.001f);
+
+	cam.yaw = M_PI;
+	ck_assert(bvh_pick_fly(&one_bvh, &one, &cam, &t) == BVH_NO_HIT);
+
+	bvh_destroy(one_bvh);
+	cull_aabbs_destroy(one);
+	bvh_destroy(bvh);
+	cull_aabbs_destroy(aabbs);
+} END_TEST
+
+Suite *vk_bvh_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("BVH");
+
+	TCase *tc1 = tcase_create("Build BVH");
+	tcase_add_test(tc1, ut_build);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Refit BVH");
+	tcase_add_test(tc2, ut_refit);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("Frustum query");
+	tcase_add_test(tc3, ut_frustum);
+	suite_add_tcase(s, tc3);
+
+	TCase *tc4 = tcase_create("Ray query");
+	tcase_add_test(tc4, ut_raycast);
+	suite_add_tcase(s, tc4);
+
+	return s;
+}
@@ -0,0 +1,8 @@
+#ifndef T_VK_BVH_H_
+#define T_VK_BVH_H_
+
+#include <check.h>
+
+Suite *vk_bvh_suite(void);
+
+#endif // T_VK_BVH_H_
@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <check.h>
+
+#include <cglm/cglm.h>
+
+#include "../src/camera.h"
+#include "../src/cull.h"
+
+// Looks from (0, 0, 10) towards the origin
+static void test_planes(vec4 planes[6])
+{
+	vec3 eye = {0.0f, 0.0f, 10.0f};
+	vec3 center = {0.0f, 0.0f, 0.0f};
+	mat4 view, proj, view_proj;
+	cam_looker(eye, center, view);
+	cam_projector(800, 600, proj);
+	glm_mat4_mul(proj, view, view_proj);
+
+	cam_frustum_planes(view_proj, planes);
+}
+
+static float rand_range(float min, float max)
+{
+	return min + (max - min) * ((float) rand() / (float) RAND_MAX);
+}
+
+START_TEST (ut_aabbs)
+{
+	vec4 planes[6];
+	test_planes(planes);
+
+	struct AabbArray aabbs;
+	cull_aabbs_create(4, &aabbs);
+
+	// Inside, behind the camera, straddling the left edge, far off to the
+	// side
+	cull_aabbs_set(&aabbs, 0, (vec3){-1, -1, -1}, (vec3){1, 1, 1});
+	cull_aabbs_set(&aabbs, 1, (vec3){-1, -1, 20}, (vec3){1, 1, 22});
+	cull_aabbs_set(&aabbs, 2, (vec3){-100, -1, -1}, (vec3){0, 1, 1});
+	cull_aabbs_set(&aabbs, 3, (vec3){100, -1, -1}, (vec3){102, 1, 1});
+
+	uint32_t out[4];
+	size_t out_ct = cull_aabbs(&aabbs, planes, out);
+
+	ck_assert(out_ct == 2);
+	ck_assert(out[0] == 0);
+	ck_assert(out[1] == 2);
+
+	cull_aabbs_destroy(aabbs);
+} END_TEST
+
+START_TEST (ut_spheres)
+{
+	vec4 planes[6];
+	test_planes(planes);
+
+	struct SphereArray spheres;
+	cull_spheres_create(3, &spheres);
+
+	cull_spheres_set(&spheres, 0, (vec3){0, 0, 0}, 1.0f);
+	cull_spheres_set(&spheres, 1, (vec3){0, 0, 30}, 1.0f);
+	cull_spheres_set(&spheres, 2, (vec3){0, 0, 30}, 25.0f);
+
+	uint32_t out[3];
+	size_t out_ct = cull_spheres(&spheres, planes, out);
+
+	ck_assert(out_ct == 2);
+	ck_assert(out[0] == 0);
+	ck_assert(out[1] == 2);
+
+	cull_spheres_destroy(spheres);
+} END_TEST
+
+START_TEST (ut_matches_scalar)
+{
+	vec4 planes[6];
+	test_planes(planes);
+
+	// Not a multiple of the vector width, so the tail gets tested too
+	size_t ct = 1003;
+	struct AabbArray aabbs;
+	cull_aabbs_create(ct, &aabbs);
+
+	srand(1);
+	for (size_t i = 0; i < ct; i++) {
+		vec3 min = {rand_range(-50, 50), rand_range(-50, 50),
+			    rand_range(-50, 50)};
+		vec3 max = {min[0] + rand_range(0, 4), min[1] + rand_range(0, 4),
+			    min[2] + rand_range(0, 4)};
+		cull_aabbs_set(&aabbs, i, min, max);
+	}
+
+	uint32_t *out = malloc(sizeof(out[0]) * ct);
+	size_t out_ct = cull_aabbs(&aabbs, planes, out);
+
+	// Compare against a plain test of every corner
+	size_t expected_ct = 0;
+	for (size_t i = 0; i < ct; i++) {
+		int inside = 1;
+		for (int p = 0; p < 6; p++) {
+			int any = 0;
+			for (int c = 0; c < 8; c++) {
+				float x = c & 1 ? aabbs.max_x[i] : aabbs.min_x[i];
+				float y = c & 2 ? aabbs.max_y[i] : aabbs.min_y[i];
+				float z = c & 4 ? aabbs.max_z[i] : aabbs.min_z[i];
+				float dist = x * planes[p][0] + y * planes[p][1]
+					+ z * planes[p][2] + planes[p][3];
+				if (dist >= 0.0f) any = 1;
+			}
+			if (!any) inside = 0;
+		}
+
+		if (inside) {
+			ck_assert(expected_ct < out_ct);
+			ck_assert(out[expected_ct] == i);
+			expected_ct++;
+		}
+	}
+
+	ck_assert(expected_ct == out_ct);
+	ck_assert(out_ct > 0 && out_ct < ct);
+
+	free(out);
+	cull_aabbs_destroy(aabbs);
+} END_TEST
+
+Suite *vk_cull_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Frustum Culling");
+
+	TCase *tc1 = tcase_create("Cull boxes");
+	tcase_add_test(tc1, ut_aabbs);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Cull spheres");
+	tcase_add_test(tc2, ut_spheres);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("SIMD matches scalar");
+	tcase_add_test(tc3, ut_matches_scalar);
+	suite_add_tcase(s, tc3);
+
+	return s;
+}
@@ -0,0 +1,8 @@
+#ifndef T_VK_CULL_H_
+#define T_VK_CULL_H_
+
+#include <check.h>
+
+Suite *vk_cull_suite(void);
+
+#endif // T_VK_CULL_H_
@@ -60,9 +60,9 @@ START_TEST (ut_triangle_windowless)
 			     VK_SHADER_STAGE_FRAGMENT_BIT, &shader_stages[1]);
 
 	VkPipelineLayout layout;
-	create_layout(device, 0, NULL, &layout);
+	create_layout(device, 0, NULL, 0, NULL, &layout);
 
-	create_pipel(device, 2, shader_stages, layout,
+	create_pipel(device, VK_NULL_HANDLE, 2, shader_stages, layout,
 		     VERTEX_3_POS_COLOR_BINDING_CT, VERTEX_3_POS_COLOR_BINDINGS,
 		     VERTEX_3_POS_COLOR_ATTRIBUTE_CT, VERTEX_3_POS_COLOR_ATTRIBUTES,
 		     rpass,
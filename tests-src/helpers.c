@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <math.h>
 
 #include "helpers.h"
 
@@ -9,8 +10,10 @@
 #include "../src/vk_tools.h"
 #include "../src/vk_window.h"
 #include "../src/vk_buffer.h"
+#include "../src/vk_cbuf.h"
 #include "../src/vk_pipe.h"
 #include "../src/vk_vertex.h"
+#include "../src/obj.h"
 
 void helper_create_instance(GLFWwindow **gwin,
 			    void *user_data,
@@ -172,7 +175,7 @@ void helper_create_pipel(VkDevice device,
 			 VkPipelineLayout *layout, VkPipeline *pipel)
 {
 	// Layout
-	create_layout(device, 0, NULL, layout);
+	create_layout(device, 0, NULL, 0, NULL, layout);
 
 	// Shaders
 	FILE *fp;
@@ -207,6 +210,7 @@ void helper_create_pipel(VkDevice device,
 
 	// pipeline!
 	create_pipel(device,
+		     VK_NULL_HANDLE,
 		     2, shtages,
 		     *layout,
 		     binding_ct, binding_descs,
@@ -322,20 +326,81 @@ void helper_create_image_with_data(VkPhysicalDevice phys_dev, VkDevice device,
 		     usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
 		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		     aspect,
+		     VK_SAMPLE_COUNT_1_BIT,
 		     width, height,
 		     image);
 
-	image_transition(device, queue, cpool,
-			 image->handle, aspect,
-			 0,
-			 VK_ACCESS_TRANSFER_WRITE_BIT,
-			 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-			 VK_PIPELINE_STAGE_TRANSFER_BIT,
-			 VK_IMAGE_LAYOUT_UNDEFINED,
-			 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	// Transition and copy in one submission
+	VkCommandBuffer cbuf;
+	cbuf_begin_one_time(device, cpool, &cbuf);
 
-	copy_buffer_image(device, queue, cpool, aspect, width, height,
-			  staging.handle, image->handle);
+	image_transition_cmd(cbuf, image->handle, aspect,
+			     0,
+			     VK_ACCESS_TRANSFER_WRITE_BIT,
+			     VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			     VK_PIPELINE_STAGE_TRANSFER_BIT,
+			     VK_IMAGE_LAYOUT_UNDEFINED,
+			     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+	copy_buffer_image_cmd(cbuf, aspect, width, height,
+			      staging.handle, image->handle);
+
+	VkResult res = vkEndCommandBuffer(cbuf);
+	assert(res == VK_SUCCESS);
+	submit_syncless(device, queue, cpool, cbuf);
 
 	buffer_destroy(staging);
 }
+
+void helper_gen_sphere(size_t *vertex_ct, size_t *index_ct,
+		       struct ObjVertex **vertices, uint32_t **indices)
+{
+	uint32_t r_ct = HELPER_SPHERE_RINGS;
+	uint32_t s_ct = HELPER_SPHERE_SEGMENTS;
+	uint32_t top = r_ct * s_ct;
+	uint32_t bottom = top + 1;
+
+	*vertex_ct = r_ct * s_ct + 2;
+	*index_ct = (r_ct - 1) * s_ct * 6 + s_ct * 6;
+	*vertices = calloc(*vertex_ct, sizeof((*vertices)[0]));
+	*indices = malloc(sizeof((*indices)[0]) * *index_ct);
+
+	struct ObjVertex *v = *vertices;
+	uint32_t *idx = *indices;
+
+	for (uint32_t r = 0; r < r_ct; r++) {
+		for (uint32_t s = 0; s < s_ct; s++) {
+			float theta = M_PI * (r + 1) / (r_ct + 1);
+			float phi = 2.0f * M_PI * s / s_ct;
+			float *p = v[r * s_ct + s].pos;
+			p[0] = sinf(theta) * cosf(phi);
+			p[1] = cosf(theta);
+			p[2] = sinf(theta) * sinf(phi);
+		}
+	}
+	v[top].pos[1] = 1.0f;
+	v[bottom].pos[1] = -1.0f;
+
+	size_t i = 0;
+	for (uint32_t r = 0; r < r_ct - 1; r++) {
+		for (uint32_t s = 0; s < s_ct; s++) {
+			uint32_t a = r * s_ct + s;
+			uint32_t b = r * s_ct + (s + 1) % s_ct;
+			uint32_t c = (r + 1) * s_ct + s;
+			uint32_t d = (r + 1) * s_ct + (s + 1) % s_ct;
+
+			idx[i++] = a; idx[i++] = b; idx[i++] = c;
+			idx[i++] = b; idx[i++] = d; idx[i++] = c;
+		}
+	}
+
+	for (uint32_t s = 0; s < s_ct; s++) {
+		idx[i++] = top;
+		idx[i++] = (s + 1) % s_ct;
+		idx[i++] = s;
+
+		idx[i++] = bottom;
+		idx[i++] = (r_ct - 1) * s_ct + s;
+		idx[i++] = (r_ct - 1) * s_ct + (s + 1) % s_ct;
+	}
+}
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdatomic.h>
 
 #include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
@@ -10,12 +11,17 @@
 #include "../src/vk_window.h"
 #include "../src/vk_buffer.h"
 #include "../src/vk_image.h"
+#include "../src/obj.h"
 
 #define DEFAULT_FMT VK_FORMAT_B8G8R8A8_UNORM
 
+// Resolution of helper_gen_sphere
+#define HELPER_SPHERE_RINGS 32
+#define HELPER_SPHERE_SEGMENTS 64
+
 #define VK_OBJECTS \
     GLFWwindow *gwin = NULL; \
-    int dbg_msg_ct = 0; \
+    atomic_int dbg_msg_ct = 0; \
     VkDebugUtilsMessengerEXT dbg_msgr; \
     VkInstance instance = NULL; \
     VkPhysicalDevice phys_dev = NULL; \
@@ -173,4 +179,11 @@ void helper_create_image_with_data(VkPhysicalDevice phys_dev,
 				   VkDeviceSize size, void *data,
 				   struct Image *image);
 
+/*
+ * Generates a closed UV sphere with radius 1 centered on the origin, in the
+ * same format obj_load outputs. Mallocs.
+ */
+void helper_gen_sphere(size_t *vertex_ct, size_t *index_ct,
+		       struct ObjVertex **vertices, uint32_t **indices);
+
 #endif // T_HELPERS_H_
@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <check.h>
+
+#include "../src/latency.h"
+
+START_TEST (ut_complete)
+{
+	struct LatencyTracker tracker;
+	latency_create(2, &tracker);
+
+	ck_assert(latency_avg(&tracker) == 0.0);
+
+	latency_input(&tracker, 1);
+	latency_input(&tracker, 2);
+
+	// Only frame 1 is done
+	latency_complete(&tracker, 1);
+	ck_assert(tracker.sample_ct == 1);
+	ck_assert(tracker.max_secs >= 0.0);
+
+	// Frames aren't counted twice
+	latency_complete(&tracker, 1);
+	ck_assert(tracker.sample_ct == 1);
+
+	latency_input(&tracker, 3);
+	latency_complete(&tracker, 3);
+	ck_assert(tracker.sample_ct == 3);
+	ck_assert(latency_avg(&tracker) <= tracker.max_secs);
+
+	latency_destroy(tracker);
+}
+END_TEST
+
+START_TEST (ut_acquire)
+{
+	struct LatencyTracker tracker;
+	latency_create(2, &tracker);
+
+	ck_assert(latency_acquire_avg(&tracker) == 0.0);
+
+	latency_acquire(&tracker, 0.001);
+	latency_acquire(&tracker, 0.003);
+	ck_assert(tracker.acquire_ct == 2);
+	ck_assert(latency_acquire_avg(&tracker) > 0.0019);
+	ck_assert(latency_acquire_avg(&tracker) < 0.0021);
+
+	latency_destroy(tracker);
+}
+END_TEST
+
+START_TEST (ut_now)
+{
+	double a = latency_now();
+	double b = latency_now();
+
+	ck_assert(b >= a);
+}
+END_TEST
+
+Suite *vk_latency_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Latency tracking");
+
+	TCase *tc1 = tcase_create("Completed frames");
+	tcase_add_test(tc1, ut_complete);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Acquire blocking");
+	tcase_add_test(tc2, ut_acquire);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("Timestamps");
+	tcase_add_test(tc3, ut_now);
+	suite_add_tcase(s, tc3);
+
+	return s;
+}
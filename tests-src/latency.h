@@ -0,0 +1,8 @@
+#ifndef T_LATENCY_H_
+#define T_LATENCY_H_
+
+#include <check.h>
+
+Suite *vk_latency_suite(void);
+
+#endif // T_LATENCY_H_
@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <check.h>
+
+#include "../src/obj.h"
+#include "../src/lod.h"
+
+#include "helpers.h"
+
+START_TEST (ut_simplify)
+{
+	size_t vertex_ct, index_ct;
+	struct ObjVertex *vertices;
+	uint32_t *indices;
+	helper_gen_sphere(&vertex_ct, &index_ct, &vertices, &indices);
+
+	uint32_t *out = malloc(sizeof(out[0]) * index_ct);
+	float error = -1.0f;
+	size_t out_ct = lod_simplify(vertices, vertex_ct, indices, index_ct,
+				     index_ct / 4, out, &error);
+
+	ck_assert(out_ct <= index_ct / 4);
+	ck_assert(out_ct > 0);
+	ck_assert(out_ct % 3 == 0);
+	ck_assert(error > 0.0f);
+
+	// Should still reference the original vertices, and have no degenerate
+	// triangles
+	for (size_t i = 0; i < out_ct; i += 3) {
+		ck_assert(out[i] < vertex_ct);
+		ck_assert(out[i + 1] < vertex_ct);
+		ck_assert(out[i + 2] < vertex_ct);
+		ck_assert(out[i] != out[i + 1]);
+		ck_assert(out[i + 1] != out[i + 2]);
+		ck_assert(out[i + 2] != out[i]);
+	}
+
+	free(out);
+	free(vertices);
+	free(indices);
+} END_TEST
+
+START_TEST (ut_simplify_open)
+{
+	FILE *fp = fopen("assets/models/triangle.obj", "r");
+	ck_assert(fp != NULL);
+
+	size_t vertex_ct, index_ct;
+	obj_load(fp, &vertex_ct, &index_ct, NULL, NULL);
+
+	struct ObjVertex *vertices = malloc(sizeof(vertices[0]) * vertex_ct);
+	uint32_t *indices = malloc(sizeof(indices[0]) * index_ct);
+	obj_load(fp, &vertex_ct, &index_ct, vertices, indices);
+	fclose(fp);
+
+	// Boundary vertices are locked, so nothing can be removed
+	uint32_t out[3];
+	size_t out_ct = lod_simplify(vertices, vertex_ct, indices, index_ct,
+				     0, out, NULL);
+
+	ck_assert(out_ct == 3);
+	ck_assert(memcmp(out, indices, sizeof(out)) == 0);
+
+	free(vertices);
+	free(indices);
+} END_TEST
+
+START_TEST (ut_chain)
+{
+	size_t vertex_ct, index_ct;
+	struct ObjVertex *vertices;
+	uint32_t *indices;
+	helper_gen_sphere(&vertex_ct, &index_ct, &vertices, &indices);
+
+	struct LodChain chain;
+	lod_chain_create(vertices, vertex_ct, indices, index_ct, 4, 0.5f,
+			 &chain);
+
+	ck_assert(chain.lod_ct == 4);
+	ck_assert(chain.counts[0] == index_ct);
+	ck_assert(memcmp(chain.indices, indices,
+			 sizeof(indices[0]) * index_ct) == 0);
+
+	uint32_t total = 0;
+	for (uint32_t i = 0; i < chain.lod_ct; i++) {
+		ck_assert(chain.offsets[i] == total);
+		total += chain.counts[i];
+
+		if (i == 0) continue;
+		ck_assert(chain.counts[i] < chain.counts[i - 1]);
+		ck_assert(chain.errors[i] >= chain.errors[i - 1]);
+	}
+	ck_assert(total == chain.index_ct);
+
+	lod_chain_destroy(chain);
+	free(vertices);
+	free(indices);
+} END_TEST
+
+START_TEST (ut_select)
+{
+	size_t vertex_ct, index_ct;
+	struct ObjVertex *vertices;
+	uint32_t *indices;
+	helper_gen_sphere(&vertex_ct, &index_ct, &vertices, &indices);
+
+	struct LodChain chain;
+	lod_chain_create(vertices, vertex_ct, indices, index_ct, 4, 0.5f,
+			 &chain);
+
+	// Up close we want full detail, far away the coarsest LOD
+	ck_assert(lod_select(&chain, 0.0f, LOD_DEFAULT_ERROR) == 0);
+	ck_assert(lod_select(&chain, 1000000.0f, LOD_DEFAULT_ERROR)
+		  == chain.lod_ct - 1);
+
+	// Further away should never mean more detail
+	uint32_t prev = 0;
+	for (float dist = 1.0f; dist < 10000.0f; dist *= 2.0f) {
+		uint32_t lod = lod_select(&chain, dist, LOD_DEFAULT_ERROR);
+		ck_assert(lod >= prev);
+		prev = lod;
+	}
+
+	// Orbit camera starts a fixed distance from the origin
+	struct OrbitCamera cam = cam_orbit_new(0.0f, 0.0f);
+	vec3 center = {0.0f, 0.0f, 0.0f};
+	ck_assert(lod_select_orbit(&chain, &cam, center, LOD_DEFAULT_ERROR)
+		  == lod_select(&chain, cam.distance, LOD_DEFAULT_ERROR));
+
+	lod_chain_destroy(chain);
+	free(vertices);
+	free(indices);
+} END_TEST
+
+Suite *vk_lod_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("LOD Generation");
+
+	TCase *tc1 = tcase_create("Simplify closed mesh");
+	tcase_add_test(tc1, ut_simplify);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Simplify open mesh");
+	tcase_add_test(tc2, ut_simplify_open);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("LOD chain");
+	tcase_add_test(tc3, ut_chain);
+	suite_add_tcase(s, tc3);
+
+	TCase *tc4 = tcase_create("LOD selection");
+	tcase_add_test(tc4, ut_select);
+	suite_add_tcase(s, tc4);
+
+	return s;
+}
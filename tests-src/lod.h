@@ -0,0 +1,8 @@
+#ifndef T_VK_LOD_H_
+#define T_VK_LOD_H_
+
+#include <check.h>
+
+Suite *vk_lod_suite(void);
+
+#endif // T_VK_LOD_H_
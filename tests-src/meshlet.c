@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <check.h>
+
+#include <cglm/cglm.h>
+
+#include "../src/obj.h"
+#include "../src/camera.h"
+#include "../src/meshlet.h"
+
+#include "helpers.h"
+
+START_TEST (ut_build)
+{
+	size_t vertex_ct, index_ct;
+	struct ObjVertex *vertices;
+	uint32_t *indices;
+	helper_gen_sphere(&vertex_ct, &index_ct, &vertices, &indices);
+
+	struct MeshletSet set;
+	meshlet_build(vertices, vertex_ct, indices, index_ct, &set);
+
+	ck_assert(set.meshlet_ct > 1);
+	ck_assert(set.triangle_ct * 3 == index_ct);
+
+	// Limits are respected, and meshlets reproduce the original triangles
+	// in order
+	size_t idx = 0;
+	for (uint32_t i = 0; i < set.meshlet_ct; i++) {
+		struct Meshlet *m = &set.meshlets[i];
+		ck_assert(m->vertex_ct <= MESHLET_MAX_VERTICES);
+		ck_assert(m->triangle_ct <= MESHLET_MAX_TRIANGLES);
+		ck_assert(m->triangle_ct > 0);
+
+		for (uint32_t j = 0; j < m->triangle_ct * 3; j++) {
+			uint8_t local = set.triangles[m->triangle_offset * 3 + j];
+			ck_assert(local < m->vertex_ct);
+			ck_assert(set.vertices[m->vertex_offset + local]
+				  == indices[idx++]);
+		}
+
+		// Every vertex is inside the bounding sphere
+		for (uint32_t j = 0; j < m->vertex_ct; j++) {
+			float *p = vertices[set.vertices[m->vertex_offset + j]].pos;
+			ck_assert(glm_vec3_distance(m->center, p)
+				  <= m->radius + 0.0001f);
+		}
+	}
+
+	meshlet_set_destroy(set);
+	free(vertices);
+	free(indices);
+} END_TEST
+
+START_TEST (ut_backfacing)
+{
+	size_t vertex_ct, index_ct;
+	struct ObjVertex *vertices;
+	uint32_t *indices;
+	helper_gen_sphere(&vertex_ct, &index_ct, &vertices, &indices);
+
+	struct MeshletSet set;
+	meshlet_build(vertices, vertex_ct, indices, index_ct, &set);
+
+	// Looking at the sphere from +Z, meshlets facing -Z can be culled and
+	// meshlets facing +Z can't
+	vec3 eye = {0.0f, 0.0f, 10.0f};
+	int culled_ct = 0;
+	for (uint32_t i = 0; i < set.meshlet_ct; i++) {
+		struct Meshlet *m = &set.meshlets[i];
+		int culled = meshlet_is_backfacing(m, eye);
+
+		if (culled) {
+			culled_ct++;
+			ck_assert(m->cone_axis[2] < 0.0f);
+		}
+		if (m->cone_cutoff < 1.0f && m->cone_axis[2] > 0.0f) {
+			ck_assert(!culled);
+		}
+	}
+
+	ck_assert(culled_ct > 0);
+
+	meshlet_set_destroy(set);
+	free(vertices);
+	free(indices);
+} END_TEST
+
+START_TEST (ut_cull)
+{
+	size_t vertex_ct, index_ct;
+	struct ObjVertex *vertices;
+	uint32_t *indices;
+	helper_gen_sphere(&vertex_ct, &index_ct, &vertices, &indices);
+
+	struct MeshletSet set;
+	meshlet_build(vertices, vertex_ct, indices, index_ct, &set);
+
+	uint32_t *out = malloc(sizeof(out[0]) * index_ct);
+
+	// Looking at the sphere, about half of it should be culled
+	vec3 eye = {0.0f, 0.0f, 10.0f};
+	vec3 center = {0.0f, 0.0f, 0.0f};
+	mat4 view, proj, view_proj;
+	cam_looker(eye, center, view);
+	cam_projector(800, 600, proj);
+	glm_mat4_mul(proj, view, view_proj);
+
+	size_t out_ct = meshlet_cull(&set, eye, view_proj, out);
+	ck_assert(out_ct > 0);
+	ck_assert(out_ct < index_ct);
+	for (size_t i = 0; i < out_ct; i++) ck_assert(out[i] < vertex_ct);
+
+	// Looking away from the sphere, everything is off-screen
+	vec3 away = {0.0f, 0.0f, 20.0f};
+	cam_looker(eye, away, view);
+	glm_mat4_mul(proj, view, view_proj);
+
+	ck_assert(meshlet_cull(&set, eye, view_proj, out) == 0);
+	ck_assert(meshlet_is_offscreen(&set.meshlets[0], view_proj));
+
+	free(out);
+	meshlet_set_destroy(set);
+	free(vertices);
+	free(indices);
+} END_TEST
+
+Suite *vk_meshlet_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Meshlets");
+
+	TCase *tc1 = tcase_create("Build meshlets");
+	tcase_add_test(tc1, ut_build);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Back-face cone test");
+	tcase_add_test(tc2, ut_backfacing);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("Cull meshlets");
+	tcase_add_test(tc3, ut_cull);
+	suite_add_tcase(s, tc3);
+
+	return s;
+}
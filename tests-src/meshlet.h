@@ -0,0 +1,8 @@
+#ifndef T_VK_MESHLET_H_
+#define T_VK_MESHLET_H_
+
+#include <check.h>
+
+Suite *vk_meshlet_suite(void);
+
+#endif // T_VK_MESHLET_H_
@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include <check.h>
+
+#include "../src/mpsc.h"
+
+#define PRODUCER_CT 4
+#define ITEMS_PER_PRODUCER 100000
+
+struct Item {
+	int producer;
+	int seq;
+};
+
+struct Producer {
+	struct Mpsc *q;
+	int id;
+};
+
+static void *produce(void *data)
+{
+	struct Producer *p = data;
+
+	for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+		struct Item item = {p->id, i};
+
+		// Small queue, so this spins on full a lot
+		while (mpsc_push(p->q, &item) != 0);
+	}
+
+	return NULL;
+}
+
+START_TEST (ut_single_thread)
+{
+	struct Mpsc q;
+	mpsc_create(4, sizeof(int), &q);
+
+	int x;
+	ck_assert(mpsc_pop(&q, &x) == 1);
+
+	// Wrap around a few times
+	for (int lap = 0; lap < 3; lap++) {
+		for (int i = 0; i < 4; i++) {
+			ck_assert(mpsc_push(&q, &i) == 0);
+		}
+
+		int extra = 99;
+		ck_assert(mpsc_push(&q, &extra) == 1);
+
+		for (int i = 0; i < 4; i++) {
+			ck_assert(mpsc_pop(&q, &x) == 0);
+			ck_assert(x == i);
+		}
+		ck_assert(mpsc_pop(&q, &x) == 1);
+	}
+
+	mpsc_destroy(q);
+} END_TEST
+
+START_TEST (ut_multi_producer)
+{
+	struct Mpsc q;
+	mpsc_create(64, sizeof(struct Item), &q);
+
+	pthread_t threads[PRODUCER_CT];
+	struct Producer producers[PRODUCER_CT];
+	for (int i = 0; i < PRODUCER_CT; i++) {
+		producers[i].q = &q;
+		producers[i].id = i;
+		pthread_create(&threads[i], NULL, produce, &producers[i]);
+	}
+
+	// Every item arrives exactly once, and each producer's in order
+	int next[PRODUCER_CT] = {0};
+	int total = 0;
+	while (total < PRODUCER_CT * ITEMS_PER_PRODUCER) {
+		struct Item item;
+		if (mpsc_pop(&q, &item) != 0) continue;
+
+		ck_assert(item.producer >= 0 && item.producer < PRODUCER_CT);
+		ck_assert(item.seq == next[item.producer]);
+		next[item.producer]++;
+		total++;
+	}
+
+	for (int i = 0; i < PRODUCER_CT; i++) {
+		pthread_join(threads[i], NULL);
+		ck_assert(next[i] == ITEMS_PER_PRODUCER);
+	}
+
+	struct Item item;
+	ck_assert(mpsc_pop(&q, &item) == 1);
+
+	mpsc_destroy(q);
+} END_TEST
+
+Suite *vk_mpsc_suite(void) {
+	Suite *s;
+
+	s = suite_create("MPSC Queue");
+
+	TCase *tc1 = tcase_create("Single thread");
+	tcase_add_test(tc1, ut_single_thread);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Multiple producers");
+	tcase_add_test(tc2, ut_multi_producer);
+	suite_add_tcase(s, tc2);
+
+	return s;
+}
@@ -0,0 +1,8 @@
+#ifndef T_MPSC_H_
+#define T_MPSC_H_
+
+#include <check.h>
+
+Suite *vk_mpsc_suite(void);
+
+#endif // T_MPSC_H_
@@ -0,0 +1,408 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/texture.h"
+#include "../src/vk_texture.h"
+#include "../src/vk_cbuf.h"
+
+#include "helpers.h"
+
+#define SRC_PATH "assets/images/texture.png"
+
+static void gen_gradient(uint32_t width, uint32_t height, unsigned char *rgba)
+{
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			unsigned char *t = &rgba[4 * (y * width + x)];
+			t[0] = x * 255 / width;
+			t[1] = y * 255 / height;
+			t[2] = 128;
+			t[3] = 255;
+		}
+	}
+}
+
+static void ck_texture_eq(struct Texture a, struct Texture b)
+{
+	ck_assert(a.format == b.format);
+	ck_assert(a.width == b.width);
+	ck_assert(a.height == b.height);
+	ck_assert(a.level_ct == b.level_ct);
+	ck_assert(a.size == b.size);
+	for (uint32_t i = 0; i < a.level_ct; i++) {
+		ck_assert(a.offsets[i] == b.offsets[i]);
+		ck_assert(a.sizes[i] == b.sizes[i]);
+	}
+	ck_assert(memcmp(a.data, b.data, a.size) == 0);
+}
+
+START_TEST (ut_encode_levels)
+{
+	unsigned char rgba[4 * 8 * 4];
+	gen_gradient(8, 4, rgba);
+
+	struct Texture tex;
+	texture_encode(VK_FORMAT_BC7_UNORM_BLOCK, 8, 4, rgba, &tex);
+
+	// 8x4, 4x2, 2x1 and 1x1, each at least one 16 byte block
+	ck_assert(tex.level_ct == 4);
+	ck_assert(tex.sizes[0] == 32);
+	ck_assert(tex.sizes[1] == 16);
+	ck_assert(tex.sizes[2] == 16);
+	ck_assert(tex.sizes[3] == 16);
+	ck_assert(tex.offsets[3] == 64);
+	ck_assert(tex.size == 80);
+
+	texture_destroy(tex);
+} END_TEST
+
+START_TEST (ut_encode_srgb)
+{
+	// Half black and half white is middle gray in linear space, which is
+	// brighter than 128 once encoded as sRGB
+	unsigned char rgba[4 * 2 * 2] = {
+		0, 0, 0, 255,		255, 255, 255, 255,
+		255, 255, 255, 255,	0, 0, 0, 255,
+	};
+
+	struct Texture tex;
+	texture_encode(VK_FORMAT_R8G8B8A8_SRGB, 2, 2, rgba, &tex);
+	ck_assert(tex.level_ct == 2);
+	ck_assert(memcmp(tex.data, rgba, sizeof(rgba)) == 0);
+
+	unsigned char *last = &tex.data[tex.offsets[1]];
+	ck_assert(last[0] >= 186 && last[0] <= 190);
+	ck_assert(last[3] == 255);
+	texture_destroy(tex);
+
+	texture_encode(VK_FORMAT_R8G8B8A8_UNORM, 2, 2, rgba, &tex);
+	last = &tex.data[tex.offsets[1]];
+	ck_assert(last[0] == 128);
+	texture_destroy(tex);
+} END_TEST
+
+START_TEST (ut_ktx2_round_trip)
+{
+	unsigned char rgba[4 * 12 * 20];
+	gen_gradient(12, 20, rgba);
+
+	VkFormat formats[] = {
+		VK_FORMAT_BC1_RGB_SRGB_BLOCK,
+		VK_FORMAT_BC7_SRGB_BLOCK,
+		VK_FORMAT_R8G8B8A8_UNORM,
+	};
+
+	for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+		struct Texture tex;
+		texture_encode(formats[i], 12, 20, rgba, &tex);
+
+		FILE *fp = tmpfile();
+		ck_assert(fp != NULL);
+		texture_write_ktx2(fp, tex);
+
+		struct Texture loaded;
+		ck_assert(texture_load_ktx2(fp, &loaded) == 0);
+		ck_texture_eq(tex, loaded);
+
+		fclose(fp);
+		texture_destroy(tex);
+		texture_destroy(loaded);
+	}
+} END_TEST
+
+START_TEST (ut_ktx2_invalid)
+{
+	FILE *fp = tmpfile();
+	ck_assert(fp != NULL);
+
+	struct Texture tex;
+
+	// Too short
+	ck_assert(texture_load_ktx2(fp, &tex) == 1);
+
+	// Not KTX2
+	char junk[128] = "DDS ";
+	fwrite(junk, sizeof(junk), 1, fp);
+	ck_assert(texture_load_ktx2(fp, &tex) == 1);
+
+	// Truncated level data
+	unsigned char rgba[4 * 4 * 4];
+	gen_gradient(4, 4, rgba);
+	struct Texture src;
+	texture_encode(VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 4, rgba, &src);
+	texture_write_ktx2(fp, src);
+	texture_destroy(src);
+
+	fflush(fp);
+	long size = ftell(fp);
+	ck_assert(ftruncate(fileno(fp), size - 1) == 0);
+	ck_assert(texture_load_ktx2(fp, &tex) == 1);
+
+	// More levels than a 1x1 image can have, each otherwise well formed
+	unsigned char texels[8] = {0};
+	struct Texture deep = {0};
+	deep.format = VK_FORMAT_R8G8B8A8_UNORM;
+	deep.width = 1;
+	deep.height = 1;
+	deep.level_ct = 2;
+	deep.offsets[1] = 4;
+	deep.sizes[0] = 4;
+	deep.sizes[1] = 4;
+	deep.size = sizeof(texels);
+	deep.data = texels;
+
+	ck_assert(ftruncate(fileno(fp), 0) == 0);
+	texture_write_ktx2(fp, deep);
+	ck_assert(texture_load_ktx2(fp, &tex) == 1);
+
+	fclose(fp);
+} END_TEST
+
+static void write_u32(FILE *fp, uint32_t v)
+{
+	fwrite(&v, sizeof(v), 1, fp);
+}
+
+START_TEST (ut_dds)
+{
+	// 8x8 DXT1 with 2 levels: 4 blocks, then 1
+	unsigned char data[5 * 8];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = i;
+
+	FILE *fp = tmpfile();
+	ck_assert(fp != NULL);
+
+	fwrite("DDS ", 4, 1, fp);
+	write_u32(fp, 124);
+	// Caps, height, width, pitch, depth and mipmap count flags
+	write_u32(fp, 0x1 | 0x2 | 0x4 | 0x8 | 0x1000 | 0x20000);
+	write_u32(fp, 8);
+	write_u32(fp, 8);
+	write_u32(fp, 32);
+	write_u32(fp, 0);
+	write_u32(fp, 2);
+	for (int i = 0; i < 11; i++) write_u32(fp, 0);
+
+	// Pixel format
+	write_u32(fp, 32);
+	write_u32(fp, 0x4);
+	fwrite("DXT1", 4, 1, fp);
+	for (int i = 0; i < 5; i++) write_u32(fp, 0);
+
+	// Caps
+	write_u32(fp, 0x1000 | 0x400000 | 0x8);
+	for (int i = 0; i < 4; i++) write_u32(fp, 0);
+	ck_assert(ftell(fp) == 128);
+
+	fwrite(data, sizeof(data), 1, fp);
+
+	struct Texture tex;
+	ck_assert(texture_load_dds(fp, &tex) == 0);
+	ck_assert(tex.format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK);
+	ck_assert(tex.width == 8);
+	ck_assert(tex.height == 8);
+	ck_assert(tex.level_ct == 2);
+	ck_assert(tex.sizes[0] == 32);
+	ck_assert(tex.sizes[1] == 8);
+	ck_assert(memcmp(tex.data, data, sizeof(data)) == 0);
+	texture_destroy(tex);
+
+	// Missing the last block
+	ck_assert(ftruncate(fileno(fp), 128 + sizeof(data) - 1) == 0);
+	ck_assert(texture_load_dds(fp, &tex) == 1);
+
+	fclose(fp);
+} END_TEST
+
+START_TEST (ut_load_cache)
+{
+	char cache_dir[] = "/tmp/texture-cache-XXXXXX";
+	ck_assert(mkdtemp(cache_dir) != NULL);
+
+	char cached[sizeof(cache_dir) + 64];
+	snprintf(cached, sizeof(cached), "%s/assets_images_texture.png.%d.ktx2",
+		 cache_dir, VK_FORMAT_BC1_RGB_SRGB_BLOCK);
+
+	// The first load encodes and fills the cache
+	struct Texture tex;
+	ck_assert(texture_load(SRC_PATH, VK_FORMAT_BC1_RGB_SRGB_BLOCK,
+			       cache_dir, &tex) == 0);
+	ck_assert(tex.format == VK_FORMAT_BC1_RGB_SRGB_BLOCK);
+	ck_assert(tex.width == 1024);
+	ck_assert(tex.level_ct == 11);
+	ck_assert(access(cached, F_OK) == 0);
+
+	// The second reads it back
+	struct Texture again;
+	ck_assert(texture_load(SRC_PATH, VK_FORMAT_BC1_RGB_SRGB_BLOCK,
+			       cache_dir, &again) == 0);
+	ck_texture_eq(tex, again);
+
+	// So does loading the cached file directly
+	struct Texture direct;
+	ck_assert(texture_load(cached, VK_FORMAT_UNDEFINED, NULL, &direct) == 0);
+	ck_texture_eq(tex, direct);
+
+	texture_destroy(tex);
+	texture_destroy(again);
+	texture_destroy(direct);
+
+	ck_assert(remove(cached) == 0);
+	ck_assert(rmdir(cache_dir) == 0);
+} END_TEST
+
+START_TEST (ut_upload)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	VkFormat format = texture_bc_supported(phys_dev)
+		? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_R8G8B8A8_UNORM;
+
+	unsigned char rgba[4 * 64 * 32];
+	gen_gradient(64, 32, rgba);
+
+	struct Texture tex;
+	texture_encode(format, 64, 32, rgba, &tex);
+
+	struct Buffer staging;
+	texture_staging_create(device, mem_props, tex, &staging);
+
+	// Like texture_image_create, but readable so levels can be compared
+	struct Image image;
+	image_create_mips(device, queue_fam, mem_props,
+			  tex.format,
+			  VK_IMAGE_USAGE_SAMPLED_BIT
+			  | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+			  | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			  VK_IMAGE_ASPECT_COLOR_BIT,
+			  VK_SAMPLE_COUNT_1_BIT,
+			  tex.width, tex.height,
+			  tex.level_ct,
+			  &image);
+
+	struct Buffer dst;
+	buffer_create(device, mem_props, tex.size,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &dst);
+
+	VkCommandPool cpool;
+	create_cpool(device, queue_fam, &cpool);
+
+	VkCommandBuffer cbuf;
+	cbuf_begin_one_time(device, cpool, &cbuf);
+
+	struct BarrierBatch batch;
+	barrier_batch_create(NULL, &batch);
+
+	texture_upload_cmd(cbuf, &batch, tex, staging.handle, image.handle,
+			   VK_ACCESS_TRANSFER_READ_BIT,
+			   VK_PIPELINE_STAGE_TRANSFER_BIT);
+	ck_assert(batch.image_ct == 0);
+
+	barrier_batch_image(&batch, image.handle, VK_IMAGE_ASPECT_COLOR_BIT,
+			    0, tex.level_ct,
+			    0, VK_ACCESS_TRANSFER_READ_BIT,
+			    VK_PIPELINE_STAGE_TRANSFER_BIT,
+			    VK_PIPELINE_STAGE_TRANSFER_BIT,
+			    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	barrier_batch_record(&batch, cbuf);
+
+	VkBufferImageCopy regions[TEXTURE_MAX_LEVELS] = {0};
+	for (uint32_t i = 0; i < tex.level_ct; i++) {
+		regions[i].bufferOffset = tex.offsets[i];
+		regions[i].imageSubresource.aspectMask =
+			VK_IMAGE_ASPECT_COLOR_BIT;
+		regions[i].imageSubresource.mipLevel = i;
+		regions[i].imageSubresource.layerCount = 1;
+		regions[i].imageExtent.width = tex.width >> i ? tex.width >> i : 1;
+		regions[i].imageExtent.height =
+			tex.height >> i ? tex.height >> i : 1;
+		regions[i].imageExtent.depth = 1;
+	}
+	vkCmdCopyImageToBuffer(cbuf, image.handle,
+			       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			       dst.handle, tex.level_ct, regions);
+
+	barrier_batch_buffer(&batch, dst.handle, 0, VK_WHOLE_SIZE,
+			     VK_ACCESS_TRANSFER_WRITE_BIT,
+			     VK_ACCESS_HOST_READ_BIT,
+			     VK_PIPELINE_STAGE_TRANSFER_BIT,
+			     VK_PIPELINE_STAGE_HOST_BIT);
+	barrier_batch_record(&batch, cbuf);
+
+	VkResult res = vkEndCommandBuffer(cbuf);
+	ck_assert(res == VK_SUCCESS);
+	submit_syncless(device, queue, cpool, cbuf);
+
+	// Every level, block for block
+	void *mapped;
+	res = vkMapMemory(device, dst.memory, 0, tex.size, 0, &mapped);
+	ck_assert(res == VK_SUCCESS);
+	ck_assert(memcmp(mapped, tex.data, tex.size) == 0);
+	vkUnmapMemory(device, dst.memory);
+
+	image_destroy(device, image);
+	buffer_destroy(staging);
+	buffer_destroy(dst);
+	vkDestroyCommandPool(device, cpool, NULL);
+	texture_destroy(tex);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_texture_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Texture loading");
+
+	TCase *tc1 = tcase_create("Encode mip levels");
+	tcase_add_test(tc1, ut_encode_levels);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Encode sRGB");
+	tcase_add_test(tc2, ut_encode_srgb);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("KTX2 round trip");
+	tcase_add_test(tc3, ut_ktx2_round_trip);
+	suite_add_tcase(s, tc3);
+
+	TCase *tc4 = tcase_create("Invalid KTX2");
+	tcase_add_test(tc4, ut_ktx2_invalid);
+	suite_add_tcase(s, tc4);
+
+	TCase *tc5 = tcase_create("DDS");
+	tcase_add_test(tc5, ut_dds);
+	suite_add_tcase(s, tc5);
+
+	TCase *tc6 = tcase_create("Load through cache");
+	tcase_add_test(tc6, ut_load_cache);
+	suite_add_tcase(s, tc6);
+
+	TCase *tc7 = tcase_create("Upload");
+	tcase_add_test(tc7, ut_upload);
+	suite_add_tcase(s, tc7);
+
+	return s;
+}
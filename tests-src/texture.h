@@ -0,0 +1,8 @@
+#ifndef T_TEXTURE_H_
+#define T_TEXTURE_H_
+
+#include <check.h>
+
+Suite *vk_texture_suite(void);
+
+#endif // T_TEXTURE_H_
@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_tools.h"
+#include "../src/vk_image.h"
+#include "../src/vk_buffer.h"
+#include "../src/vk_cbuf.h"
+#include "../src/vk_barrier.h"
+
+#include "helpers.h"
+
+#define IM_SIZE 4
+
+// Uploads to an image and reads it back, all in one submission. Every barrier
+// goes through <batch>.
+static void upload_read_back(VkPhysicalDevice phys_dev, VkDevice device,
+			     uint32_t queue_fam, VkQueue queue,
+			     struct BarrierBatch *batch)
+{
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	unsigned char data[4 * IM_SIZE * IM_SIZE];
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = i;
+	}
+
+	struct Buffer src;
+	helper_create_buffer_with_data(phys_dev, device, sizeof(data), data,
+				       &src);
+
+	struct Buffer dst;
+	buffer_create(device, mem_props, sizeof(data),
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &dst);
+
+	struct Image image;
+	image_create(device, queue_fam, mem_props,
+		     DEFAULT_FMT,
+		     VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+		     | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		     VK_IMAGE_ASPECT_COLOR_BIT,
+		     VK_SAMPLE_COUNT_1_BIT,
+		     IM_SIZE, IM_SIZE,
+		     &image);
+
+	VkCommandPool cpool;
+	create_cpool(device, queue_fam, &cpool);
+
+	VkCommandBuffer cbuf;
+	cbuf_begin_one_time(device, cpool, &cbuf);
+
+	// The host write and the layout transition, in one call
+	barrier_batch_buffer(batch, src.handle, 0, VK_WHOLE_SIZE,
+			     VK_ACCESS_HOST_WRITE_BIT,
+			     VK_ACCESS_TRANSFER_READ_BIT,
+			     VK_PIPELINE_STAGE_HOST_BIT,
+			     VK_PIPELINE_STAGE_TRANSFER_BIT);
+	barrier_batch_image(batch, image.handle, VK_IMAGE_ASPECT_COLOR_BIT,
+			    0, 1,
+			    0, VK_ACCESS_TRANSFER_WRITE_BIT,
+			    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			    VK_PIPELINE_STAGE_TRANSFER_BIT,
+			    VK_IMAGE_LAYOUT_UNDEFINED,
+			    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	ck_assert(batch->image_ct == 1);
+	ck_assert(batch->buffer_ct == 1);
+	barrier_batch_record(batch, cbuf);
+	ck_assert(batch->image_ct == 0);
+	ck_assert(batch->buffer_ct == 0);
+
+	copy_buffer_image_cmd(cbuf, VK_IMAGE_ASPECT_COLOR_BIT, IM_SIZE, IM_SIZE,
+			      src.handle, image.handle);
+
+	barrier_batch_image(batch, image.handle, VK_IMAGE_ASPECT_COLOR_BIT,
+			    0, 1,
+			    VK_ACCESS_TRANSFER_WRITE_BIT,
+			    VK_ACCESS_TRANSFER_READ_BIT,
+			    VK_PIPELINE_STAGE_TRANSFER_BIT,
+			    VK_PIPELINE_STAGE_TRANSFER_BIT,
+			    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	barrier_batch_record(batch, cbuf);
+
+	VkBufferImageCopy region = {0};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent.width = IM_SIZE;
+	region.imageExtent.height = IM_SIZE;
+	region.imageExtent.depth = 1;
+	vkCmdCopyImageToBuffer(cbuf, image.handle,
+			       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			       dst.handle, 1, &region);
+
+	barrier_batch_buffer(batch, dst.handle, 0, VK_WHOLE_SIZE,
+			     VK_ACCESS_TRANSFER_WRITE_BIT,
+			     VK_ACCESS_HOST_READ_BIT,
+			     VK_PIPELINE_STAGE_TRANSFER_BIT,
+			     VK_PIPELINE_STAGE_HOST_BIT);
+	barrier_batch_record(batch, cbuf);
+
+	VkResult res = vkEndCommandBuffer(cbuf);
+	ck_assert(res == VK_SUCCESS);
+	submit_syncless(device, queue, cpool, cbuf);
+
+	void *mapped;
+	res = vkMapMemory(device, dst.memory, 0, sizeof(data), 0, &mapped);
+	ck_assert(res == VK_SUCCESS);
+	ck_assert(memcmp(mapped, data, sizeof(data)) == 0);
+	vkUnmapMemory(device, dst.memory);
+
+	image_destroy(device, image);
+	buffer_destroy(src);
+	buffer_destroy(dst);
+	vkDestroyCommandPool(device, cpool, NULL);
+}
+
+START_TEST (ut_barrier_batch)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	struct BarrierBatch batch;
+	barrier_batch_create(NULL, &batch);
+	upload_read_back(phys_dev, device, queue_fam, queue, &batch);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_barrier_batch_sync2)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	// Nothing to test on devices without it
+	struct Sync2 s2;
+	if (sync2_load(phys_dev, device, &s2) != 0) return;
+
+	struct BarrierBatch batch;
+	barrier_batch_create(&s2, &batch);
+	upload_read_back(phys_dev, device, queue_fam, queue, &batch);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_barrier_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Barriers");
+
+	TCase *tc1 = tcase_create("Batch");
+	tcase_add_test(tc1, ut_barrier_batch);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Batch with synchronization2");
+	tcase_add_test(tc2, ut_barrier_batch_sync2);
+	suite_add_tcase(s, tc2);
+
+	return s;
+}
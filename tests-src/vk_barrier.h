@@ -0,0 +1,8 @@
+#ifndef T_VK_BARRIER_H_
+#define T_VK_BARRIER_H_
+
+#include <check.h>
+
+Suite *vk_barrier_suite(void);
+
+#endif // T_VK_BARRIER_H_
@@ -0,0 +1,352 @@
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_bindless.h"
+#include "../src/vk_image.h"
+#include "../src/vk_cbuf.h"
+#include "../src/vk_pipe.h"
+#include "../src/vk_rpass.h"
+#include "../src/vk_sync.h"
+#include "../src/vk_vertex.h"
+
+#include "helpers.h"
+
+#define IMAGE_CT 3
+// Side of the target ut_update_after_bind draws into
+#define TARGET_SIZE 4
+
+static void create_sampler(VkDevice device, VkSampler *sampler)
+{
+	VkSamplerCreateInfo sampler_info = {0};
+	sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_info.magFilter = VK_FILTER_NEAREST;
+	sampler_info.minFilter = VK_FILTER_NEAREST;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
+	sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+
+	VkResult res = vkCreateSampler(device, &sampler_info, NULL, sampler);
+	ck_assert(res == VK_SUCCESS);
+}
+
+START_TEST (ut_slots)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	if (!bindless_supported(phys_dev)) return;
+
+	uint32_t cap = bindless_max(phys_dev);
+	ck_assert(cap > IMAGE_CT);
+	ck_assert(cap <= BINDLESS_MAX_TEXTURES);
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	struct Image images[IMAGE_CT];
+	for (uint32_t i = 0; i < IMAGE_CT; i++) {
+		image_create(device, queue_fam, mem_props,
+			     VK_FORMAT_R8G8B8A8_UNORM,
+			     VK_IMAGE_USAGE_SAMPLED_BIT,
+			     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			     VK_IMAGE_ASPECT_COLOR_BIT,
+			     VK_SAMPLE_COUNT_1_BIT,
+			     4, 4,
+			     &images[i]);
+	}
+
+	VkSampler sampler;
+	create_sampler(device, &sampler);
+
+	struct Bindless bl;
+	bindless_create(device, cap, VK_SHADER_STAGE_FRAGMENT_BIT, &bl);
+
+	// Slots are handed out in order
+	uint32_t idxs[IMAGE_CT];
+	for (uint32_t i = 0; i < IMAGE_CT; i++) {
+		idxs[i] = bindless_add(device, &bl, sampler, images[i].view);
+		ck_assert(idxs[i] == i);
+	}
+
+	// Removed slots are reused before new ones
+	bindless_remove(&bl, idxs[1]);
+	ck_assert(bindless_add(device, &bl, sampler, images[2].view) == 1);
+	ck_assert(bindless_add(device, &bl, sampler, images[0].view) == 3);
+
+	bindless_write(device, &bl, 1, sampler, images[1].view);
+
+	// One bind, then a push per "material"
+	VkPipelineLayout layout;
+	bindless_layout(device, &bl, VK_SHADER_STAGE_FRAGMENT_BIT,
+			sizeof(uint32_t), &layout);
+
+	VkCommandPool cpool;
+	create_cpool(device, queue_fam, &cpool);
+
+	VkCommandBuffer cbuf;
+	cbuf_begin_one_time(device, cpool, &cbuf);
+
+	bindless_bind(cbuf, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, &bl);
+	for (uint32_t i = 0; i < IMAGE_CT; i++) {
+		bindless_push_index(cbuf, layout, VK_SHADER_STAGE_FRAGMENT_BIT,
+				    idxs[i]);
+	}
+
+	VkResult res = vkEndCommandBuffer(cbuf);
+	ck_assert(res == VK_SUCCESS);
+	submit_syncless(device, queue, cpool, cbuf);
+
+	// The set is already bound (and submitted), and can still be written
+	bindless_write(device, &bl, 2, sampler, images[0].view);
+
+	vkDestroyCommandPool(device, cpool, NULL);
+	vkDestroyPipelineLayout(device, layout, NULL);
+	bindless_destroy(device, bl);
+	vkDestroySampler(device, sampler, NULL);
+	for (uint32_t i = 0; i < IMAGE_CT; i++) {
+		image_destroy(device, images[i]);
+	}
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_update_after_bind)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	if (!bindless_supported(phys_dev)) return;
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	VkCommandPool cpool;
+	create_cpool(device, queue_fam, &cpool);
+
+	// Red, green and blue, one texel each
+	uint32_t colors[IMAGE_CT] = {0xff0000ff, 0xff00ff00, 0xffff0000};
+	struct Image images[IMAGE_CT];
+	for (uint32_t i = 0; i < IMAGE_CT; i++) {
+		helper_create_image_with_data(phys_dev, device, queue_fam,
+					      queue, cpool,
+					      VK_FORMAT_R8G8B8A8_UNORM,
+					      VK_IMAGE_USAGE_SAMPLED_BIT,
+					      VK_IMAGE_ASPECT_COLOR_BIT,
+					      1, 1,
+					      sizeof(colors[i]), &colors[i],
+					      &images[i]);
+		image_transition(device, queue, cpool,
+				 images[i].handle, VK_IMAGE_ASPECT_COLOR_BIT,
+				 VK_ACCESS_TRANSFER_WRITE_BIT,
+				 VK_ACCESS_SHADER_READ_BIT,
+				 VK_PIPELINE_STAGE_TRANSFER_BIT,
+				 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+
+	VkSampler sampler;
+	create_sampler(device, &sampler);
+
+	struct Bindless bl;
+	bindless_create(device, bindless_max(phys_dev),
+			VK_SHADER_STAGE_FRAGMENT_BIT, &bl);
+
+	// Slot 1 starts out blue, and is made green after the set is bound
+	ck_assert(bindless_add(device, &bl, sampler, images[0].view) == 0);
+	ck_assert(bindless_add(device, &bl, sampler, images[2].view) == 1);
+
+	VkPipelineLayout layout;
+	bindless_layout(device, &bl, VK_SHADER_STAGE_FRAGMENT_BIT,
+			sizeof(uint32_t), &layout);
+
+	struct Image target;
+	image_create(device, queue_fam, mem_props,
+		     DEFAULT_FMT,
+		     VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+		     | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		     VK_IMAGE_ASPECT_COLOR_BIT,
+		     VK_SAMPLE_COUNT_1_BIT,
+		     TARGET_SIZE, TARGET_SIZE,
+		     &target);
+
+	rpass_basic(device, DEFAULT_FMT, &rpass);
+
+	VkFramebuffer fb;
+	create_framebuffer(device, TARGET_SIZE, TARGET_SIZE, rpass,
+			   1, &target.view, &fb);
+
+	VkPipelineShaderStageCreateInfo shtages[2];
+	helper_create_shtage(device, "assets/testing/shaders/simple.vert.spv",
+			     VK_SHADER_STAGE_VERTEX_BIT, &shtages[0]);
+	helper_create_shtage(device,
+			     "assets/testing/shaders/bindless.frag.spv",
+			     VK_SHADER_STAGE_FRAGMENT_BIT, &shtages[1]);
+
+	create_pipel(device, VK_NULL_HANDLE, 2, shtages, layout,
+		     VERTEX_3_POS_COLOR_BINDING_CT, VERTEX_3_POS_COLOR_BINDINGS,
+		     VERTEX_3_POS_COLOR_ATTRIBUTE_CT,
+		     VERTEX_3_POS_COLOR_ATTRIBUTES,
+		     rpass, 0, VK_SAMPLE_COUNT_1_BIT,
+		     &pipel);
+
+	VkBuffer vbuf, ibuf;
+	helper_create_bufs(phys_dev, device, &vbuf, &ibuf);
+
+	// The triangle twice, the left half sampling slot 0 and the right
+	// half slot 1
+	VkCommandBuffer cbuf;
+	cbuf_begin_one_time(device, cpool, &cbuf);
+
+	VkClearValue clear = {0};
+
+	VkRenderPassBeginInfo rpass_info = {0};
+	rpass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	rpass_info.renderPass = rpass;
+	rpass_info.framebuffer = fb;
+	rpass_info.renderArea.extent.width = TARGET_SIZE;
+	rpass_info.renderArea.extent.height = TARGET_SIZE;
+	rpass_info.clearValueCount = 1;
+	rpass_info.pClearValues = &clear;
+
+	vkCmdBeginRenderPass(cbuf, &rpass_info, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBindPipeline(cbuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipel);
+
+	VkViewport viewport = {0};
+	viewport.width = TARGET_SIZE;
+	viewport.height = TARGET_SIZE;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(cbuf, 0, 1, &viewport);
+
+	bindless_bind(cbuf, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, &bl);
+
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(cbuf, 0, 1, &vbuf, &offset);
+	vkCmdBindIndexBuffer(cbuf, ibuf, 0, VK_INDEX_TYPE_UINT32);
+
+	for (uint32_t i = 0; i < 2; i++) {
+		VkRect2D scissor = {0};
+		scissor.offset.x = i * TARGET_SIZE / 2;
+		scissor.extent.width = TARGET_SIZE / 2;
+		scissor.extent.height = TARGET_SIZE;
+		vkCmdSetScissor(cbuf, 0, 1, &scissor);
+
+		bindless_push_index(cbuf, layout, VK_SHADER_STAGE_FRAGMENT_BIT,
+				    i);
+		vkCmdDrawIndexed(cbuf, 3, 1, 0, 0, 0);
+	}
+
+	vkCmdEndRenderPass(cbuf);
+
+	VkResult res = vkEndCommandBuffer(cbuf);
+	ck_assert(res == VK_SUCCESS);
+
+	// The set is bound in a recorded command buffer, and a slot it reads
+	// can still be written before submitting
+	bindless_write(device, &bl, 1, sampler, images[1].view);
+
+	VkFence fence;
+	create_fence(device, 0, &fence);
+
+	VkSubmitInfo submit_info = {0};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &cbuf;
+
+	res = vkQueueSubmit(queue, 1, &submit_info, fence);
+	ck_assert(res == VK_SUCCESS);
+
+	// A slot no draw reads can be written while the command buffer is
+	// pending
+	ck_assert(bindless_add(device, &bl, sampler, images[2].view) == 2);
+
+	res = vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+	ck_assert(res == VK_SUCCESS);
+	vkFreeCommandBuffers(device, cpool, 1, &cbuf);
+
+	// Read back the middle row
+	struct Buffer buf;
+	buffer_create(device, mem_props, 4 * TARGET_SIZE * TARGET_SIZE,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &buf);
+
+	image_transition(device, queue, cpool,
+			 target.handle, VK_IMAGE_ASPECT_COLOR_BIT,
+			 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			 VK_ACCESS_TRANSFER_READ_BIT,
+			 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			 VK_PIPELINE_STAGE_TRANSFER_BIT,
+			 VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+			 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+	copy_image_buffer(device, queue, cpool,
+			  VK_IMAGE_ASPECT_COLOR_BIT,
+			  TARGET_SIZE, TARGET_SIZE,
+			  target.handle, buf.handle);
+
+	uint32_t *mapped;
+	res = vkMapMemory(device, buf.memory, 0, VK_WHOLE_SIZE, 0,
+			  (void **) &mapped);
+	ck_assert(res == VK_SUCCESS);
+
+	// Byte order: ARGB. Red from slot 0, and green from slot 1 instead of
+	// the blue it held when bound.
+	uint32_t *row = &mapped[TARGET_SIZE * (TARGET_SIZE / 2)];
+	ck_assert(row[TARGET_SIZE / 2 - 1] == 0xffff0000);
+	ck_assert(row[TARGET_SIZE / 2] == 0xff00ff00);
+
+	vkUnmapMemory(device, buf.memory);
+
+	buffer_destroy(buf);
+	vkDestroyFence(device, fence, NULL);
+	vkDestroyPipeline(device, pipel, NULL);
+	vkDestroyFramebuffer(device, fb, NULL);
+	vkDestroyRenderPass(device, rpass, NULL);
+	image_destroy(device, target);
+	vkDestroyCommandPool(device, cpool, NULL);
+	vkDestroyPipelineLayout(device, layout, NULL);
+	bindless_destroy(device, bl);
+	vkDestroySampler(device, sampler, NULL);
+	for (uint32_t i = 0; i < IMAGE_CT; i++) {
+		image_destroy(device, images[i]);
+	}
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_bindless_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Bindless textures");
+
+	TCase *tc1 = tcase_create("Slots");
+	tcase_add_test(tc1, ut_slots);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Update after bind");
+	tcase_add_test(tc2, ut_update_after_bind);
+	suite_add_tcase(s, tc2);
+
+	return s;
+}
@@ -0,0 +1,8 @@
+#ifndef T_VK_BINDLESS_H_
+#define T_VK_BINDLESS_H_
+
+#include <check.h>
+
+Suite *vk_bindless_suite(void);
+
+#endif // T_VK_BINDLESS_H_
@@ -150,6 +150,68 @@ START_TEST (ut_copy_memory)
 	ck_assert(dbg_msg_ct == 0);
 } END_TEST
 
+START_TEST (ut_copy_owned)
+{
+	VK_OBJECTS;
+	helper_get_phys_dev(NULL, &dbg_msg_ct, NULL, &instance, &phys_dev);
+
+	// Use a separate transfer queue if there is one
+	struct QueueFams fams;
+	get_queue_fams(phys_dev, &fams);
+	create_device_queues(phys_dev, fams, &device);
+
+	struct Queues queues;
+	get_queues(device, fams, &queues);
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	int source_data[] = {3, 4, 5};
+	VkDeviceSize buffer_size = sizeof(source_data);
+
+	struct Buffer src;
+	buffer_create(device, mem_props, buffer_size,
+		      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &src);
+	buffer_write(src, buffer_size, source_data);
+
+	struct Buffer dst;
+	buffer_create(device, mem_props, buffer_size,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT
+		      | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &dst);
+
+	VkCommandPool xfer_cpool, gfx_cpool;
+	create_cpool(device, fams.transfer, &xfer_cpool);
+	create_cpool(device, fams.graphics, &gfx_cpool);
+
+	copy_buffer_buffer_owned(device,
+				 queues.transfer, xfer_cpool, fams.transfer,
+				 queues.graphics, gfx_cpool, fams.graphics,
+				 VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+				 VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+				 buffer_size,
+				 src.handle, dst.handle);
+
+	void *dst_data;
+	VkResult res = vkMapMemory(device, dst.memory, 0, buffer_size, 0,
+				   &dst_data);
+	ck_assert(res == VK_SUCCESS);
+	ck_assert(memcmp(dst_data, source_data, buffer_size) == 0);
+	vkUnmapMemory(device, dst.memory);
+
+	buffer_destroy(src);
+	buffer_destroy(dst);
+	vkDestroyCommandPool(device, xfer_cpool, NULL);
+	vkDestroyCommandPool(device, gfx_cpool, NULL);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
 START_TEST (ut_buffer_create)
 {
 	VK_OBJECTS;
@@ -350,5 +412,9 @@ Suite *vk_buffer_suite(void)
 	tcase_add_test(tc7, ut_copy_buffer_image);
 	suite_add_tcase(s, tc7);
 
+	TCase *tc8 = tcase_create("Copy memory to another queue family");
+	tcase_add_test(tc8, ut_copy_owned);
+	suite_add_tcase(s, tc8);
+
 	return s;
 }
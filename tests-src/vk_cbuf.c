@@ -11,6 +11,8 @@
 #include "../src/vk_cbuf.h"
 #include "../src/vk_buffer.h"
 #include "../src/vk_vertex.h"
+#include "../src/vk_image.h"
+#include "../src/vk_rpass.h"
 
 #include "helpers.h"
 
@@ -137,6 +139,150 @@ START_TEST (ut_cbuf_begin_one_time)
 	ck_assert(dbg_msg_ct == 0);
 } END_TEST
 
+START_TEST (ut_draw_ranges_pushed)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	VkPhysicalDeviceMemoryProperties dev_mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &dev_mem_props);
+
+	const uint32_t width = 64;
+	const uint32_t height = 64;
+
+	struct Image image;
+	image_create(device,
+		     queue_fam,
+		     dev_mem_props,
+		     DEFAULT_FMT,
+		     VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+		     | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		     VK_IMAGE_ASPECT_COLOR_BIT,
+		     VK_SAMPLE_COUNT_1_BIT,
+		     width, height,
+		     &image);
+
+	rpass_basic(device, DEFAULT_FMT, &rpass);
+
+	VkFramebuffer fb;
+	create_framebuffer(device, width, height, rpass, 1, &image.view, &fb);
+
+	VkBuffer vbuf, ibuf;
+	helper_create_bufs(phys_dev, device, &vbuf, &ibuf);
+
+	VkPipelineShaderStageCreateInfo shtages[2];
+	helper_create_shtage(device, "assets/testing/shaders/push.vert.spv",
+			     VK_SHADER_STAGE_VERTEX_BIT, &shtages[0]);
+	helper_create_shtage(device, "assets/testing/shaders/push.frag.spv",
+			     VK_SHADER_STAGE_FRAGMENT_BIT, &shtages[1]);
+
+	VkPushConstantRange range;
+	draw_push_range(&range);
+	ck_assert(range.size == sizeof(struct DrawPush));
+	ck_assert(range.size <= 128);
+
+	create_layout(device, 0, NULL, 1, &range, &pipe_layout);
+	ck_assert(pipe_layout != NULL);
+
+	create_pipel(device, VK_NULL_HANDLE, 2, shtages, pipe_layout,
+		     VERTEX_3_POS_COLOR_BINDING_CT, VERTEX_3_POS_COLOR_BINDINGS,
+		     VERTEX_3_POS_COLOR_ATTRIBUTE_CT, VERTEX_3_POS_COLOR_ATTRIBUTES,
+		     rpass, 0, VK_SAMPLE_COUNT_1_BIT,
+		     &pipel);
+
+	// The same triangle twice, with its own push constants each: half
+	// size, moved to the left half in red (material 1) and to the right
+	// half in green (material 2)
+	uint32_t first_indices[] = {0, 0};
+	uint32_t index_cts[] = {3, 3};
+	struct DrawPush pushes[2];
+	for (uint32_t i = 0; i < 2; i++) {
+		glm_mat4_identity(pushes[i].model);
+		glm_translate_x(pushes[i].model, i == 0 ? -0.5f : 0.5f);
+		glm_scale(pushes[i].model, (vec3) {0.5f, 0.5f, 1.0f});
+		pushes[i].material = i + 1;
+	}
+
+	VkCommandPool cpool;
+	create_cpool(device, queue_fam, &cpool);
+
+	VkCommandBuffer cbuf;
+	cbuf_begin_one_time(device, cpool, &cbuf);
+
+	VkClearValue clear = {0};
+
+	VkRenderPassBeginInfo rpass_info = {0};
+	rpass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	rpass_info.renderPass = rpass;
+	rpass_info.framebuffer = fb;
+	rpass_info.renderArea.extent.width = width;
+	rpass_info.renderArea.extent.height = height;
+	rpass_info.clearValueCount = 1;
+	rpass_info.pClearValues = &clear;
+
+	vkCmdBeginRenderPass(cbuf, &rpass_info, VK_SUBPASS_CONTENTS_INLINE);
+	cbuf_draw_ranges_pushed(cbuf, width, height, pipe_layout, pipel,
+				0, NULL, vbuf, ibuf,
+				2, first_indices, index_cts, pushes);
+	vkCmdEndRenderPass(cbuf);
+
+	VkResult res = vkEndCommandBuffer(cbuf);
+	ck_assert(res == VK_SUCCESS);
+
+	submit_syncless(device, queue, cpool, cbuf);
+
+	// Read it back
+	struct Buffer buf;
+	buffer_create(device, dev_mem_props, 4 * width * height,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &buf);
+
+	image_transition(device, queue, cpool,
+			 image.handle, VK_IMAGE_ASPECT_COLOR_BIT,
+			 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			 VK_ACCESS_TRANSFER_READ_BIT,
+			 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			 VK_PIPELINE_STAGE_TRANSFER_BIT,
+			 VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+			 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+	copy_image_buffer(device, queue, cpool,
+			  VK_IMAGE_ASPECT_COLOR_BIT, width, height,
+			  image.handle, buf.handle);
+
+	uint32_t *mapped;
+	res = vkMapMemory(device, buf.memory, 0, VK_WHOLE_SIZE, 0,
+			  (void **) &mapped);
+	ck_assert(res == VK_SUCCESS);
+
+	// Byte order: ARGB. Each triangle covers the middle of its half below
+	// its apex, and the gap between them is the clear color.
+	uint32_t *row = &mapped[width * 40];
+	ck_assert(row[16] == 0xffff0000);
+	ck_assert(row[48] == 0xff00ff00);
+	ck_assert(row[32] == 0x00000000);
+
+	vkUnmapMemory(device, buf.memory);
+
+	buffer_destroy(buf);
+	image_destroy(device, image);
+	vkDestroyCommandPool(device, cpool, NULL);
+	vkDestroyPipeline(device, pipel, NULL);
+	vkDestroyPipelineLayout(device, pipe_layout, NULL);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
 Suite *vk_cbuf_suite(void) {
 	Suite *s;
 
@@ -154,5 +300,9 @@ Suite *vk_cbuf_suite(void) {
 	tcase_add_test(tc3, ut_cbuf_begin_one_time);
 	suite_add_tcase(s, tc3);
 
+	TCase *tc4 = tcase_create("Draw ranges with push constants");
+	tcase_add_test(tc4, ut_draw_ranges_pushed);
+	suite_add_tcase(s, tc4);
+
 	return s;
 }
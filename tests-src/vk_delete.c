@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_delete.h"
+
+// Records which entries have been destroyed, in order
+struct Tracker {
+	int destroyed[64];
+	int ct;
+};
+
+struct Entry {
+	struct Tracker *tracker;
+	int id;
+};
+
+static void destroy_entry(VkDevice device, void *data)
+{
+	struct Entry *entry = data;
+	entry->tracker->destroyed[entry->tracker->ct++] = entry->id;
+}
+
+static void push_entry(struct DeletionQueue *dq, uint64_t value,
+		       struct Tracker *tracker, int id)
+{
+	struct Entry entry = {tracker, id};
+	deletion_queue_push_fn(dq, value, destroy_entry, sizeof(entry), &entry);
+}
+
+START_TEST (ut_collect)
+{
+	struct Tracker tracker = {0};
+	struct DeletionQueue dq;
+	deletion_queue_create(&dq);
+
+	// Out of order on purpose
+	push_entry(&dq, 3, &tracker, 0);
+	push_entry(&dq, 1, &tracker, 1);
+	push_entry(&dq, 2, &tracker, 2);
+	push_entry(&dq, 1, &tracker, 3);
+
+	// Nothing has completed yet
+	ck_assert(deletion_queue_collect(NULL, &dq, 0) == 0);
+	ck_assert(tracker.ct == 0);
+
+	// Both entries for frame 1, in push order
+	ck_assert(deletion_queue_collect(NULL, &dq, 1) == 2);
+	ck_assert(tracker.ct == 2);
+	ck_assert(tracker.destroyed[0] == 1);
+	ck_assert(tracker.destroyed[1] == 3);
+
+	// Skipping ahead takes everything up to the value
+	ck_assert(deletion_queue_collect(NULL, &dq, 3) == 2);
+	ck_assert(tracker.ct == 4);
+	ck_assert(tracker.destroyed[2] == 0);
+	ck_assert(tracker.destroyed[3] == 2);
+	ck_assert(dq.ct == 0);
+
+	deletion_queue_destroy(NULL, dq);
+} END_TEST
+
+START_TEST (ut_grow_and_destroy)
+{
+	struct Tracker tracker = {0};
+	struct DeletionQueue dq;
+	deletion_queue_create(&dq);
+
+	// Past the initial capacity
+	for (int i = 0; i < DELETION_QUEUE_INIT_CAP * 3; i++) {
+		push_entry(&dq, i, &tracker, i);
+	}
+	ck_assert(dq.ct == DELETION_QUEUE_INIT_CAP * 3);
+
+	deletion_queue_collect(NULL, &dq, DELETION_QUEUE_INIT_CAP - 1);
+	ck_assert(tracker.ct == DELETION_QUEUE_INIT_CAP);
+
+	// Destroying the queue flushes whatever is left
+	deletion_queue_destroy(NULL, dq);
+	ck_assert(tracker.ct == DELETION_QUEUE_INIT_CAP * 3);
+	for (int i = 0; i < tracker.ct; i++) {
+		ck_assert(tracker.destroyed[i] == i);
+	}
+} END_TEST
+
+Suite *vk_delete_suite(void) {
+	Suite *s;
+
+	s = suite_create("Deferred deletion");
+
+	TCase *tc1 = tcase_create("Collect completed entries");
+	tcase_add_test(tc1, ut_collect);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Grow and destroy");
+	tcase_add_test(tc2, ut_grow_and_destroy);
+	suite_add_tcase(s, tc2);
+
+	return s;
+}
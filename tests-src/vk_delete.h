@@ -0,0 +1,8 @@
+#ifndef T_VK_DELETE_H_
+#define T_VK_DELETE_H_
+
+#include <check.h>
+
+Suite *vk_delete_suite(void);
+
+#endif // T_VK_DELETE_H_
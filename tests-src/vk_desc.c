@@ -0,0 +1,142 @@
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_desc.h"
+#include "../src/vk_uniform.h"
+
+#include "helpers.h"
+
+START_TEST (ut_layout_cache)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	struct LayoutCache cache;
+	layout_cache_create(&cache);
+
+	VkDescriptorSetLayoutBinding a[2];
+	create_descriptor_binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				  VK_SHADER_STAGE_VERTEX_BIT, &a[0]);
+	create_descriptor_binding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				  VK_SHADER_STAGE_FRAGMENT_BIT, &a[1]);
+
+	// Same bindings, listed the other way round
+	VkDescriptorSetLayoutBinding b[2] = {a[1], a[0]};
+
+	VkDescriptorSetLayout la = layout_cache_get(device, &cache, 2, a);
+	VkDescriptorSetLayout lb = layout_cache_get(device, &cache, 2, b);
+	ck_assert(la == lb);
+	ck_assert(cache.ct == 1);
+	ck_assert(cache.miss_ct == 1);
+	ck_assert(cache.hit_ct == 1);
+
+	// Any difference is another layout
+	b[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	ck_assert(layout_cache_get(device, &cache, 2, b) != la);
+	ck_assert(layout_cache_get(device, &cache, 1, a) != la);
+	ck_assert(cache.ct == 3);
+
+	// Enough layouts to make the table grow, which must keep them all
+	VkDescriptorSetLayout many[32];
+	for (uint32_t i = 0; i < 32; i++) {
+		VkDescriptorSetLayoutBinding binding;
+		create_descriptor_binding(i, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+					  VK_SHADER_STAGE_FRAGMENT_BIT, &binding);
+		many[i] = layout_cache_get(device, &cache, 1, &binding);
+	}
+	ck_assert(cache.ct == 35);
+
+	for (uint32_t i = 0; i < 32; i++) {
+		VkDescriptorSetLayoutBinding binding;
+		create_descriptor_binding(i, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+					  VK_SHADER_STAGE_FRAGMENT_BIT, &binding);
+		ck_assert(layout_cache_get(device, &cache, 1, &binding)
+			  == many[i]);
+	}
+	ck_assert(layout_cache_get(device, &cache, 2, a) == la);
+	ck_assert(cache.ct == 35);
+
+	layout_cache_destroy(device, cache);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_desc_alloc)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	struct LayoutCache cache;
+	layout_cache_create(&cache);
+
+	VkDescriptorSetLayoutBinding binding;
+	create_descriptor_binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				  VK_SHADER_STAGE_VERTEX_BIT, &binding);
+	VkDescriptorSetLayout layout = layout_cache_get(device, &cache,
+							1, &binding);
+
+	struct DescAllocator alloc;
+	desc_alloc_create(2, 4, &alloc);
+
+	// 10 sets need 3 pools of 4
+	VkDescriptorSet sets[10];
+	desc_alloc_begin(device, &alloc, 0);
+	for (uint32_t i = 0; i < 10; i++) {
+		desc_alloc_get(device, &alloc, layout, &sets[i]);
+		ck_assert(sets[i] != VK_NULL_HANDLE);
+	}
+	ck_assert(alloc.pool_ct == 3);
+	ck_assert(alloc.used[0].ct == 3);
+
+	// The other slot can't touch those
+	desc_alloc_begin(device, &alloc, 1);
+	desc_alloc_get(device, &alloc, layout, &sets[0]);
+	ck_assert(alloc.pool_ct == 4);
+
+	// Beginning slot 0 again resets its pools for reuse
+	desc_alloc_begin(device, &alloc, 0);
+	ck_assert(alloc.used[0].ct == 0);
+	ck_assert(alloc.free.ct == 3);
+
+	for (uint32_t i = 0; i < 10; i++) {
+		desc_alloc_get(device, &alloc, layout, &sets[i]);
+	}
+	ck_assert(alloc.pool_ct == 4);
+	ck_assert(alloc.free.ct == 0);
+
+	desc_alloc_destroy(device, alloc);
+	layout_cache_destroy(device, cache);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_desc_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Descriptor layout cache and allocator");
+
+	TCase *tc1 = tcase_create("Layout cache");
+	tcase_add_test(tc1, ut_layout_cache);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Per-frame allocator");
+	tcase_add_test(tc2, ut_desc_alloc);
+	suite_add_tcase(s, tc2);
+
+	return s;
+}
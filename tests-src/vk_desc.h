@@ -0,0 +1,8 @@
+#ifndef T_VK_DESC_H_
+#define T_VK_DESC_H_
+
+#include <check.h>
+
+Suite *vk_desc_suite(void);
+
+#endif // T_VK_DESC_H_
@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_tools.h"
+#include "../src/vk_image.h"
+#include "../src/vk_pipe.h"
+#include "../src/vk_cbuf.h"
+#include "../src/vk_buffer.h"
+#include "../src/vk_vertex.h"
+#include "../src/vk_dyn_render.h"
+
+#include "helpers.h"
+
+#define IM_SIZE 4
+
+START_TEST (ut_dyn_render_clear)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	// Nothing to test on devices without it
+	struct DynRender dr;
+	if (dyn_render_load(phys_dev, device, &dr) != 0) return;
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	struct Image image;
+	image_create(device, queue_fam, mem_props,
+		     DEFAULT_FMT,
+		     VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+		     | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		     VK_IMAGE_ASPECT_COLOR_BIT,
+		     VK_SAMPLE_COUNT_1_BIT,
+		     IM_SIZE, IM_SIZE,
+		     &image);
+
+	VkCommandPool cpool;
+	create_cpool(device, queue_fam, &cpool);
+
+	// Clear to red, with no render pass or framebuffer
+	VkCommandBuffer cbuf;
+	cbuf_begin_one_time(device, cpool, &cbuf);
+
+	image_transition_cmd(cbuf, image.handle, VK_IMAGE_ASPECT_COLOR_BIT,
+			     0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			     VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			     VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			     VK_IMAGE_LAYOUT_UNDEFINED,
+			     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+	struct DynAttachment color = {0};
+	color.view = image.view;
+	color.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	color.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	color.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+	color.clear = (VkClearValue) {{{1.0f, 0.0f, 0.0f, 1.0f}}};
+
+	dyn_render_begin(&dr, cbuf, IM_SIZE, IM_SIZE, &color, NULL);
+	dyn_render_end(&dr, cbuf);
+
+	image_transition_cmd(cbuf, image.handle, VK_IMAGE_ASPECT_COLOR_BIT,
+			     VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			     VK_ACCESS_TRANSFER_READ_BIT,
+			     VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			     VK_PIPELINE_STAGE_TRANSFER_BIT,
+			     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+	VkResult res = vkEndCommandBuffer(cbuf);
+	ck_assert(res == VK_SUCCESS);
+	submit_syncless(device, queue, cpool, cbuf);
+
+	// Read it back
+	struct Buffer buf;
+	buffer_create(device, mem_props, 4 * IM_SIZE * IM_SIZE,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &buf);
+
+	copy_image_buffer(device, queue, cpool,
+			  VK_IMAGE_ASPECT_COLOR_BIT,
+			  IM_SIZE, IM_SIZE,
+			  image.handle, buf.handle);
+
+	unsigned char *mapped;
+	res = vkMapMemory(device, buf.memory, 0, 4 * IM_SIZE * IM_SIZE, 0,
+			  (void **) &mapped);
+	ck_assert(res == VK_SUCCESS);
+
+	// BGRA
+	for (int i = 0; i < IM_SIZE * IM_SIZE; i++) {
+		ck_assert(mapped[4 * i + 0] == 0);
+		ck_assert(mapped[4 * i + 1] == 0);
+		ck_assert(mapped[4 * i + 2] == 255);
+		ck_assert(mapped[4 * i + 3] == 255);
+	}
+
+	vkUnmapMemory(device, buf.memory);
+
+	buffer_destroy(buf);
+	image_destroy(device, image);
+	vkDestroyCommandPool(device, cpool, NULL);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_create_pipel_dynamic)
+{
+	VK_OBJECTS;
+	helper_create_device(NULL,
+			     &dbg_msg_ct,
+			     NULL,
+			     &instance,
+			     &phys_dev,
+			     &queue_fam,
+			     &device);
+
+	if (!dyn_render_supported(phys_dev)) return;
+
+	VkPipelineShaderStageCreateInfo shtages[2];
+	helper_create_shtage(device, "assets/testing/shaders/simple.vert.spv",
+			     VK_SHADER_STAGE_VERTEX_BIT, &shtages[0]);
+	helper_create_shtage(device, "assets/testing/shaders/simple.frag.spv",
+			     VK_SHADER_STAGE_FRAGMENT_BIT, &shtages[1]);
+
+	VkPipelineLayout layout;
+	create_layout(device, 0, NULL, 0, NULL, &layout);
+
+	VkPipeline pipel = NULL;
+	create_pipel_dynamic(device, VK_NULL_HANDLE, 2, shtages, layout,
+			     VERTEX_3_POS_COLOR_BINDING_CT,
+			     VERTEX_3_POS_COLOR_BINDINGS,
+			     VERTEX_3_POS_COLOR_ATTRIBUTE_CT,
+			     VERTEX_3_POS_COLOR_ATTRIBUTES,
+			     DEFAULT_FMT, VK_FORMAT_D32_SFLOAT,
+			     VK_SAMPLE_COUNT_1_BIT,
+			     &pipel);
+	ck_assert(pipel != NULL);
+
+	vkDestroyPipeline(device, pipel, NULL);
+	vkDestroyPipelineLayout(device, layout, NULL);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_dyn_render_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Dynamic rendering");
+
+	TCase *tc1 = tcase_create("Clear without a render pass");
+	tcase_add_test(tc1, ut_dyn_render_clear);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Create pipeline");
+	tcase_add_test(tc2, ut_create_pipel_dynamic);
+	suite_add_tcase(s, tc2);
+
+	return s;
+}
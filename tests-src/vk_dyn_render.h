@@ -0,0 +1,8 @@
+#ifndef T_VK_DYN_RENDER_H_
+#define T_VK_DYN_RENDER_H_
+
+#include <check.h>
+
+Suite *vk_dyn_render_suite(void);
+
+#endif // T_VK_DYN_RENDER_H_
@@ -0,0 +1,156 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_tools.h"
+#include "../src/vk_image.h"
+#include "../src/vk_rpass.h"
+#include "../src/vk_delete.h"
+#include "../src/vk_fb_cache.h"
+
+#include "helpers.h"
+
+#define TARGET_CT 3
+#define TARGET_FMT VK_FORMAT_B8G8R8A8_SRGB
+
+static void create_targets(VkPhysicalDevice phys_dev, VkDevice device,
+			   uint32_t queue_fam, struct Image *targets)
+{
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	for (int i = 0; i < TARGET_CT; i++) {
+		image_create(device, queue_fam, mem_props,
+			     TARGET_FMT,
+			     VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+			     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			     VK_IMAGE_ASPECT_COLOR_BIT,
+			     VK_SAMPLE_COUNT_1_BIT,
+			     64, 64,
+			     &targets[i]);
+	}
+}
+
+START_TEST (ut_fb_cache_get)
+{
+	VK_OBJECTS;
+	helper_create_device(NULL,
+			     &dbg_msg_ct,
+			     NULL,
+			     &instance,
+			     &phys_dev,
+			     &queue_fam,
+			     &device);
+
+	VkRenderPass rpass;
+	rpass_basic(device, TARGET_FMT, &rpass);
+
+	struct Image targets[TARGET_CT];
+	create_targets(phys_dev, device, queue_fam, targets);
+
+	struct FbCache cache;
+	fb_cache_create(FB_CACHE_DEFAULT_MAX, &cache);
+
+	VkFramebuffer a = fb_cache_get(device, &cache, NULL, 1, rpass,
+				       1, &targets[0].view, 64, 64, 0);
+	VkFramebuffer b = fb_cache_get(device, &cache, NULL, 1, rpass,
+				       1, &targets[1].view, 64, 64, 0);
+	ck_assert(a != VK_NULL_HANDLE);
+	ck_assert(a != b);
+
+	// Same key, same framebuffer
+	ck_assert(fb_cache_get(device, &cache, NULL, 2, rpass,
+			       1, &targets[0].view, 64, 64, 0) == a);
+	ck_assert(cache.hit_ct == 1);
+	ck_assert(cache.miss_ct == 2);
+
+	// The extent is part of the key
+	VkFramebuffer c = fb_cache_get(device, &cache, NULL, 2, rpass,
+				       1, &targets[0].view, 32, 32, 0);
+	ck_assert(c != a);
+	ck_assert(cache.ct == 3);
+
+	fb_cache_destroy(device, cache);
+	for (int i = 0; i < TARGET_CT; i++) {
+		image_destroy(device, targets[i]);
+	}
+	vkDestroyRenderPass(device, rpass, NULL);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_fb_cache_evict)
+{
+	VK_OBJECTS;
+	helper_create_device(NULL,
+			     &dbg_msg_ct,
+			     NULL,
+			     &instance,
+			     &phys_dev,
+			     &queue_fam,
+			     &device);
+
+	VkRenderPass rpass;
+	rpass_basic(device, TARGET_FMT, &rpass);
+
+	struct Image targets[TARGET_CT];
+	create_targets(phys_dev, device, queue_fam, targets);
+
+	struct DeletionQueue dq;
+	deletion_queue_create(&dq);
+
+	struct FbCache cache;
+	fb_cache_create(2, &cache);
+
+	// 0 is pinned, so 1 is the least recently used one left
+	fb_cache_get(device, &cache, &dq, 1, rpass,
+		     1, &targets[0].view, 64, 64, 1);
+	fb_cache_get(device, &cache, &dq, 2, rpass,
+		     1, &targets[1].view, 64, 64, 0);
+	fb_cache_get(device, &cache, &dq, 3, rpass,
+		     1, &targets[2].view, 64, 64, 0);
+
+	ck_assert(cache.ct == 2);
+	ck_assert(cache.evict_ct == 1);
+	ck_assert(dq.ct == 1);
+	ck_assert(dq.entries[0].value == 2);
+
+	// Getting 1 again misses
+	uint64_t miss_ct = cache.miss_ct;
+	fb_cache_get(device, &cache, &dq, 4, rpass,
+		     1, &targets[1].view, 64, 64, 0);
+	ck_assert(cache.miss_ct == miss_ct + 1);
+
+	// Pinned framebuffers still go with their views
+	ck_assert(fb_cache_evict_view(device, &cache, &dq, 5,
+				      targets[0].view) == 1);
+	ck_assert(cache.ct == 1);
+
+	deletion_queue_destroy(device, dq);
+	fb_cache_destroy(device, cache);
+	for (int i = 0; i < TARGET_CT; i++) {
+		image_destroy(device, targets[i]);
+	}
+	vkDestroyRenderPass(device, rpass, NULL);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_fb_cache_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Framebuffer cache");
+
+	TCase *tc1 = tcase_create("Get framebuffers");
+	tcase_add_test(tc1, ut_fb_cache_get);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Evict framebuffers");
+	tcase_add_test(tc2, ut_fb_cache_evict);
+	suite_add_tcase(s, tc2);
+
+	return s;
+}
@@ -0,0 +1,8 @@
+#ifndef T_VK_FB_CACHE_H_
+#define T_VK_FB_CACHE_H_
+
+#include <check.h>
+
+Suite *vk_fb_cache_suite(void);
+
+#endif // T_VK_FB_CACHE_H_
@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_tools.h"
+#include "../src/vk_cbuf.h"
+#include "../src/vk_sync.h"
+#include "../src/vk_frame.h"
+
+#include "helpers.h"
+
+#define FRAMES_IN_FLIGHT 3
+#define FRAME_CT 10
+
+START_TEST (ut_create_timeline_sem)
+{
+	VK_OBJECTS;
+	helper_create_device(NULL,
+			     &dbg_msg_ct,
+			     NULL,
+			     &instance,
+			     &phys_dev,
+			     &queue_fam,
+			     &device);
+
+	VkSemaphore sem = NULL;
+	create_timeline_sem(device, 5, &sem);
+	ck_assert(sem != NULL);
+
+	uint64_t value;
+	VkResult res = vkGetSemaphoreCounterValue(device, sem, &value);
+	ck_assert(res == VK_SUCCESS);
+	ck_assert(value == 5);
+
+	vkDestroySemaphore(device, sem, NULL);
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_frame_sched)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	VkCommandPool cpool;
+	create_cpool(device, queue_fam, &cpool);
+
+	struct FrameScheduler sched;
+	frame_sched_create(device, FRAMES_IN_FLIGHT, &sched);
+	ck_assert(frame_sched_completed(device, &sched) == 0);
+
+	VkCommandBuffer cbufs[FRAMES_IN_FLIGHT] = {NULL};
+
+	for (int i = 0; i < FRAME_CT; i++) {
+		uint32_t slot;
+		uint64_t frame = frame_sched_begin(device, &sched, &slot);
+		ck_assert(frame == i + 1);
+		ck_assert(slot < FRAMES_IN_FLIGHT);
+
+		// The frame that used this slot before must be done
+		if (frame > FRAMES_IN_FLIGHT) {
+			ck_assert(frame_sched_completed(device, &sched)
+				  >= frame - FRAMES_IN_FLIGHT);
+		}
+
+		if (cbufs[slot] != NULL) {
+			vkFreeCommandBuffers(device, cpool, 1, &cbufs[slot]);
+		}
+
+		// Every other frame is dropped, with nothing submitted
+		if (i % 2 == 0) {
+			cbuf_begin_one_time(device, cpool, &cbufs[slot]);
+			VkResult res = vkEndCommandBuffer(cbufs[slot]);
+			ck_assert(res == VK_SUCCESS);
+		} else {
+			cbufs[slot] = NULL;
+		}
+
+		frame_sched_submit(queue, &sched, VK_NULL_HANDLE,
+				   VK_NULL_HANDLE, cbufs[slot]);
+	}
+
+	frame_sched_wait_idle(device, &sched);
+	ck_assert(frame_sched_completed(device, &sched) == FRAME_CT);
+
+	for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
+		if (cbufs[i] != NULL) {
+			vkFreeCommandBuffers(device, cpool, 1, &cbufs[i]);
+		}
+	}
+
+	frame_sched_destroy(device, sched);
+	vkDestroyCommandPool(device, cpool, NULL);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_frame_suite(void) {
+	Suite *s;
+
+	s = suite_create("Frame scheduling");
+
+	TCase *tc1 = tcase_create("Create timeline semaphore");
+	tcase_add_test(tc1, ut_create_timeline_sem);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Schedule frames");
+	tcase_add_test(tc2, ut_frame_sched);
+	suite_add_tcase(s, tc2);
+
+	return s;
+}
@@ -0,0 +1,8 @@
+#ifndef T_VK_FRAME_H_
+#define T_VK_FRAME_H_
+
+#include <check.h>
+
+Suite *vk_frame_suite(void);
+
+#endif // T_VK_FRAME_H_
@@ -0,0 +1,318 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_tools.h"
+#include "../src/vk_image.h"
+#include "../src/vk_cbuf.h"
+#include "../src/vk_buffer.h"
+#include "../src/vk_dyn_render.h"
+#include "../src/vk_graph.h"
+
+#include "helpers.h"
+
+#define IM_SIZE 4
+
+START_TEST (ut_graph_barriers)
+{
+	struct RenderGraph graph;
+	graph_create(&graph);
+
+	VkClearValue clear = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+
+	uint32_t color = graph_import(&graph, NULL, NULL,
+				      VK_IMAGE_ASPECT_COLOR_BIT,
+				      IM_SIZE, IM_SIZE,
+				      VK_IMAGE_LAYOUT_UNDEFINED,
+				      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				      0);
+	uint32_t depth = graph_transient(&graph, VK_FORMAT_D32_SFLOAT,
+					 VK_IMAGE_ASPECT_DEPTH_BIT,
+					 IM_SIZE, IM_SIZE);
+
+	uint32_t draw = graph_pass(&graph, "draw", NULL, NULL);
+	graph_pass_color(&graph, draw, color, &clear);
+	graph_pass_depth(&graph, draw, depth, &clear);
+
+	uint32_t read = graph_pass(&graph, "read", NULL, NULL);
+	graph_pass_use(&graph, read, depth, GRAPH_USAGE_SAMPLED);
+
+	uint32_t present = graph_pass(&graph, "present", NULL, NULL);
+	graph_pass_use(&graph, present, color, GRAPH_USAGE_PRESENT);
+
+	graph_compile(&graph);
+
+	// Both attachments start out undefined, in one barrier call
+	struct GraphPass *p = &graph.passes[draw];
+	ck_assert(p->renders && !p->merged && p->ends_rendering);
+	ck_assert(p->barrier_ct == 2);
+	ck_assert(p->barriers[0].old_layout == VK_IMAGE_LAYOUT_UNDEFINED);
+	ck_assert(p->barriers[1].old_layout == VK_IMAGE_LAYOUT_UNDEFINED);
+	ck_assert(p->uses[0].load_op == VK_ATTACHMENT_LOAD_OP_CLEAR);
+	// The depth is read later, so it's kept
+	ck_assert(p->uses[1].store_op == VK_ATTACHMENT_STORE_OP_STORE);
+
+	p = &graph.passes[read];
+	ck_assert(!p->renders);
+	ck_assert(p->barrier_ct == 1);
+	ck_assert(p->barriers[0].res == depth);
+	ck_assert(p->barriers[0].old_layout
+		  == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+	ck_assert(p->barriers[0].new_layout
+		  == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+	ck_assert(p->barriers[0].src_access
+		  == VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+	ck_assert(p->barriers[0].dst_access == VK_ACCESS_SHADER_READ_BIT);
+
+	p = &graph.passes[present];
+	ck_assert(p->barrier_ct == 1);
+	ck_assert(p->barriers[0].new_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+	ck_assert(p->src_stages
+		  == VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+	ck_assert(graph.resources[depth].first_pass == draw);
+	ck_assert(graph.resources[depth].last_pass == read);
+	ck_assert(graph.resources[depth].usage
+		  == (VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+		      | VK_IMAGE_USAGE_SAMPLED_BIT));
+} END_TEST
+
+START_TEST (ut_graph_read_after_read)
+{
+	struct RenderGraph graph;
+	graph_create(&graph);
+
+	uint32_t tex = graph_import(&graph, NULL, NULL,
+				    VK_IMAGE_ASPECT_COLOR_BIT,
+				    IM_SIZE, IM_SIZE,
+				    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				    VK_PIPELINE_STAGE_TRANSFER_BIT,
+				    0);
+
+	for (int i = 0; i < 3; i++) {
+		uint32_t pass = graph_pass(&graph, "read", NULL, NULL);
+		graph_pass_use(&graph, pass, tex, GRAPH_USAGE_SAMPLED);
+	}
+
+	graph_compile(&graph);
+
+	// Already in the right layout, and nobody writes it
+	for (int i = 0; i < 3; i++) {
+		ck_assert(graph.passes[i].barrier_ct == 0);
+	}
+} END_TEST
+
+START_TEST (ut_graph_merge)
+{
+	struct RenderGraph graph;
+	graph_create(&graph);
+
+	VkClearValue clear = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+
+	uint32_t color = graph_transient(&graph, DEFAULT_FMT,
+					 VK_IMAGE_ASPECT_COLOR_BIT,
+					 IM_SIZE, IM_SIZE);
+	uint32_t depth = graph_transient(&graph, VK_FORMAT_D32_SFLOAT,
+					 VK_IMAGE_ASPECT_DEPTH_BIT,
+					 IM_SIZE, IM_SIZE);
+
+	uint32_t opaque = graph_pass(&graph, "opaque", NULL, NULL);
+	graph_pass_color(&graph, opaque, color, &clear);
+	graph_pass_depth(&graph, opaque, depth, &clear);
+
+	uint32_t blended = graph_pass(&graph, "blended", NULL, NULL);
+	graph_pass_color(&graph, blended, color, NULL);
+	graph_pass_depth(&graph, blended, depth, NULL);
+
+	// Clears, so it has to begin its own rendering
+	uint32_t overlay = graph_pass(&graph, "overlay", NULL, NULL);
+	graph_pass_color(&graph, overlay, color, &clear);
+
+	graph_compile(&graph);
+
+	ck_assert(!graph.passes[opaque].merged);
+	ck_assert(!graph.passes[opaque].ends_rendering);
+
+	ck_assert(graph.passes[blended].merged);
+	ck_assert(graph.passes[blended].ends_rendering);
+	ck_assert(graph.passes[blended].barrier_ct == 0);
+
+	ck_assert(!graph.passes[overlay].merged);
+	ck_assert(graph.passes[overlay].barrier_ct == 1);
+
+	// The depth dies with the merged scope, the color doesn't
+	ck_assert(graph.passes[opaque].uses[0].store_op
+		  == VK_ATTACHMENT_STORE_OP_STORE);
+	ck_assert(graph.passes[opaque].uses[1].store_op
+		  == VK_ATTACHMENT_STORE_OP_DONT_CARE);
+	ck_assert(graph.passes[overlay].uses[0].store_op
+		  == VK_ATTACHMENT_STORE_OP_DONT_CARE);
+} END_TEST
+
+START_TEST (ut_graph_alias_slots)
+{
+	uint32_t firsts[] = {0, 2, 1, 4};
+	uint32_t lasts[] = {1, 3, 2, 4};
+	uint32_t any_bits[] = {1, 1, 1, 1};
+	uint32_t slots[4];
+
+	uint32_t slot_ct = graph_alias_slots(4, firsts, lasts, any_bits, slots);
+	ck_assert(slot_ct == 2);
+	ck_assert(slots[0] == 0);
+	ck_assert(slots[2] == 1);
+	ck_assert(slots[1] == 0);
+	ck_assert(slots[3] == 0);
+
+	// The last one can't share memory types with either slot
+	uint32_t some_bits[] = {1, 1, 1, 2};
+	slot_ct = graph_alias_slots(4, firsts, lasts, some_bits, slots);
+	ck_assert(slot_ct == 3);
+	ck_assert(slots[3] == 2);
+} END_TEST
+
+// Copies a transient to a buffer so it can be checked
+struct Readback {
+	VkImage *image;
+	VkBuffer buf;
+};
+
+static void record_readback(VkCommandBuffer cbuf, void *data)
+{
+	struct Readback *readback = data;
+
+	VkBufferImageCopy region = {0};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent.width = IM_SIZE;
+	region.imageExtent.height = IM_SIZE;
+	region.imageExtent.depth = 1;
+
+	vkCmdCopyImageToBuffer(cbuf, *readback->image,
+			       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			       readback->buf, 1, &region);
+}
+
+START_TEST (ut_graph_execute)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	// Nothing to test on devices without it
+	struct DynRender dr;
+	if (dyn_render_load(phys_dev, device, &dr) != 0) return;
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	struct Buffer buf;
+	buffer_create(device, mem_props, 4 * IM_SIZE * IM_SIZE,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &buf);
+
+	// Two transients that are never alive at once, so they can share
+	// memory. The second is cleared to red and read back.
+	struct RenderGraph graph;
+	graph_create(&graph);
+
+	VkClearValue black = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+	VkClearValue red = {{{1.0f, 0.0f, 0.0f, 1.0f}}};
+
+	uint32_t a = graph_transient(&graph, DEFAULT_FMT,
+				     VK_IMAGE_ASPECT_COLOR_BIT,
+				     IM_SIZE, IM_SIZE);
+	uint32_t b = graph_transient(&graph, DEFAULT_FMT,
+				     VK_IMAGE_ASPECT_COLOR_BIT,
+				     IM_SIZE, IM_SIZE);
+
+	uint32_t pass = graph_pass(&graph, "clear a", NULL, NULL);
+	graph_pass_color(&graph, pass, a, &black);
+	pass = graph_pass(&graph, "sample a", NULL, NULL);
+	graph_pass_use(&graph, pass, a, GRAPH_USAGE_SAMPLED);
+
+	pass = graph_pass(&graph, "clear b", NULL, NULL);
+	graph_pass_color(&graph, pass, b, &red);
+
+	struct Readback readback;
+	readback.image = &graph.resources[b].image;
+	readback.buf = buf.handle;
+	pass = graph_pass(&graph, "read b", record_readback, &readback);
+	graph_pass_use(&graph, pass, b, GRAPH_USAGE_TRANSFER_SRC);
+
+	graph_compile(&graph);
+	graph_realize(device, mem_props, queue_fam, &graph);
+
+	ck_assert(graph.slot_ct >= 1);
+	ck_assert(graph.resources[a].view != VK_NULL_HANDLE);
+	ck_assert(graph.resources[b].view != VK_NULL_HANDLE);
+
+	VkCommandPool cpool;
+	create_cpool(device, queue_fam, &cpool);
+
+	VkCommandBuffer cbuf;
+	cbuf_begin_one_time(device, cpool, &cbuf);
+	graph_execute(&graph, &dr, cbuf);
+	VkResult res = vkEndCommandBuffer(cbuf);
+	ck_assert(res == VK_SUCCESS);
+	submit_syncless(device, queue, cpool, cbuf);
+
+	unsigned char *mapped;
+	res = vkMapMemory(device, buf.memory, 0, 4 * IM_SIZE * IM_SIZE, 0,
+			  (void **) &mapped);
+	ck_assert(res == VK_SUCCESS);
+
+	// BGRA
+	for (int i = 0; i < IM_SIZE * IM_SIZE; i++) {
+		ck_assert(mapped[4 * i + 0] == 0);
+		ck_assert(mapped[4 * i + 1] == 0);
+		ck_assert(mapped[4 * i + 2] == 255);
+		ck_assert(mapped[4 * i + 3] == 255);
+	}
+
+	vkUnmapMemory(device, buf.memory);
+
+	graph_destroy(device, graph);
+	buffer_destroy(buf);
+	vkDestroyCommandPool(device, cpool, NULL);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_graph_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Render graph");
+
+	TCase *tc1 = tcase_create("Barriers");
+	tcase_add_test(tc1, ut_graph_barriers);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("No barriers between reads");
+	tcase_add_test(tc2, ut_graph_read_after_read);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("Merge passes");
+	tcase_add_test(tc3, ut_graph_merge);
+	suite_add_tcase(s, tc3);
+
+	TCase *tc4 = tcase_create("Alias slots");
+	tcase_add_test(tc4, ut_graph_alias_slots);
+	suite_add_tcase(s, tc4);
+
+	TCase *tc5 = tcase_create("Execute");
+	tcase_add_test(tc5, ut_graph_execute);
+	suite_add_tcase(s, tc5);
+
+	return s;
+}
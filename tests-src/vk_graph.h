@@ -0,0 +1,8 @@
+#ifndef T_VK_GRAPH_H_
+#define T_VK_GRAPH_H_
+
+#include <check.h>
+
+Suite *vk_graph_suite(void);
+
+#endif // T_VK_GRAPH_H_
@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <check.h>
+
+#include <cglm/cglm.h>
+
+#include "../src/camera.h"
+#include "../src/vk_hiz.h"
+
+#define DEPTH_W 32
+#define DEPTH_H 24
+
+// Looks from (0, 0, 10) towards the origin
+static void test_view_proj(mat4 view_proj)
+{
+	vec3 eye = {0.0f, 0.0f, 10.0f};
+	vec3 center = {0.0f, 0.0f, 0.0f};
+	mat4 view, proj;
+	cam_looker(eye, center, view);
+	cam_projector(DEPTH_W, DEPTH_H, proj);
+	glm_mat4_mul(proj, view, view_proj);
+}
+
+// Depth of a point as it would end up in the depth buffer
+static float point_depth(mat4 view_proj, vec3 p)
+{
+	vec4 v = {p[0], p[1], p[2], 1.0f};
+	vec4 clip;
+	glm_mat4_mulv(view_proj, v, clip);
+
+	return clip[2] / clip[3];
+}
+
+START_TEST (ut_occluded)
+{
+	mat4 view_proj;
+	test_view_proj(view_proj);
+
+	// A wall covering the whole screen at z = 0
+	float wall = point_depth(view_proj, (vec3){0.0f, 0.0f, 0.0f});
+	float depths[DEPTH_W * DEPTH_H];
+	for (int i = 0; i < DEPTH_W * DEPTH_H; i++) depths[i] = wall;
+
+	// Behind the wall
+	ck_assert(hiz_is_occluded(depths, DEPTH_W, DEPTH_H, view_proj,
+				  (vec3){-1, -1, -5}, (vec3){1, 1, -3}));
+
+	// In front of it
+	ck_assert(!hiz_is_occluded(depths, DEPTH_W, DEPTH_H, view_proj,
+				   (vec3){-1, -1, 3}, (vec3){1, 1, 5}));
+
+	// Poking through it
+	ck_assert(!hiz_is_occluded(depths, DEPTH_W, DEPTH_H, view_proj,
+				   (vec3){-1, -1, -3}, (vec3){1, 1, 1}));
+
+	// Around the camera
+	ck_assert(!hiz_is_occluded(depths, DEPTH_W, DEPTH_H, view_proj,
+				   (vec3){-1, -1, 9}, (vec3){1, 1, 11}));
+} END_TEST
+
+START_TEST (ut_hole)
+{
+	mat4 view_proj;
+	test_view_proj(view_proj);
+
+	// Same wall, but with a hole in the middle of the screen
+	float wall = point_depth(view_proj, (vec3){0.0f, 0.0f, 0.0f});
+	float depths[DEPTH_W * DEPTH_H];
+	for (int y = 0; y < DEPTH_H; y++) {
+		for (int x = 0; x < DEPTH_W; x++) {
+			int in_hole = abs(x - DEPTH_W / 2) < 2
+				&& abs(y - DEPTH_H / 2) < 2;
+			depths[y * DEPTH_W + x] = in_hole ? 1.0f : wall;
+		}
+	}
+
+	// Right behind the hole
+	ck_assert(!hiz_is_occluded(depths, DEPTH_W, DEPTH_H, view_proj,
+				   (vec3){-0.1, -0.1, -5}, (vec3){0.1, 0.1, -3}));
+
+	// Behind the wall off to the side
+	ck_assert(hiz_is_occluded(depths, DEPTH_W, DEPTH_H, view_proj,
+				  (vec3){2.5, 1.5, -5}, (vec3){3, 2, -3}));
+} END_TEST
+
+START_TEST (ut_latest_readback)
+{
+	struct HiZ hiz = {0};
+	uint64_t frames[4] = {0};
+	hiz.readback_ct = 4;
+	hiz.readback_frames = frames;
+
+	// Nothing written yet
+	ck_assert(hiz_latest_readback(&hiz, 0) == 4);
+
+	// Frames 5 and 6 finished, 7 and 8 still executing
+	frames[0] = 5;
+	frames[1] = 6;
+	frames[2] = 7;
+	frames[3] = 8;
+	ck_assert(hiz_latest_readback(&hiz, 6) == 1);
+
+	// Frame 9 reuses the first buffer, then frame 7 finishes
+	frames[0] = 9;
+	ck_assert(hiz_latest_readback(&hiz, 7) == 2);
+	ck_assert(hiz_latest_readback(&hiz, 4) == 4);
+} END_TEST
+
+Suite *vk_hiz_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("HiZ Occlusion");
+
+	TCase *tc1 = tcase_create("Occlusion test");
+	tcase_add_test(tc1, ut_occluded);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Occlusion through a hole");
+	tcase_add_test(tc2, ut_hole);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("Latest finished readback");
+	tcase_add_test(tc3, ut_latest_readback);
+	suite_add_tcase(s, tc3);
+
+	return s;
+}
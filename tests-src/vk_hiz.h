@@ -0,0 +1,8 @@
+#ifndef T_VK_HIZ_H_
+#define T_VK_HIZ_H_
+
+#include <check.h>
+
+Suite *vk_hiz_suite(void);
+
+#endif // T_VK_HIZ_H_
@@ -167,6 +167,52 @@ START_TEST (ut_create_device)
 	ck_assert(dbg_msg_ct == 0);
 } END_TEST
 
+START_TEST (ut_create_device_queues)
+{
+	VK_OBJECTS;
+	helper_get_phys_dev(NULL, &dbg_msg_ct, NULL, &instance, &phys_dev);
+
+	struct QueueFams fams;
+	get_queue_fams(phys_dev, &fams);
+
+	// Each family can do what it's for (transfer may be a graphics or
+	// compute family, which always support transfers implicitly)
+	uint32_t queue_fam_ct;
+	vkGetPhysicalDeviceQueueFamilyProperties(phys_dev, &queue_fam_ct, NULL);
+	VkQueueFamilyProperties *queue_fam_props =
+		malloc(sizeof(VkQueueFamilyProperties) * queue_fam_ct);
+	vkGetPhysicalDeviceQueueFamilyProperties(
+		phys_dev, &queue_fam_ct, queue_fam_props);
+
+	ck_assert(fams.graphics < queue_fam_ct);
+	ck_assert(fams.transfer < queue_fam_ct);
+	ck_assert(fams.compute < queue_fam_ct);
+	ck_assert(queue_fam_props[fams.graphics].queueFlags
+		  & VK_QUEUE_GRAPHICS_BIT);
+	ck_assert(queue_fam_props[fams.transfer].queueFlags
+		  & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_GRAPHICS_BIT
+		     | VK_QUEUE_COMPUTE_BIT));
+	ck_assert(queue_fam_props[fams.compute].queueFlags
+		  & VK_QUEUE_COMPUTE_BIT);
+	free(queue_fam_props);
+
+	create_device_queues(phys_dev, fams, &device);
+	ck_assert(device != NULL);
+
+	struct Queues queues;
+	get_queues(device, fams, &queues);
+	ck_assert(queues.graphics != NULL);
+	ck_assert(queues.transfer != NULL);
+	ck_assert(queues.compute != NULL);
+
+	// Same family, same queue
+	if (fams.transfer == fams.graphics) {
+		ck_assert(queues.transfer == queues.graphics);
+	}
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
 START_TEST (ut_get_queue)
 {
 	// create queue
@@ -195,7 +241,7 @@ START_TEST (ut_get_queue)
 START_TEST(ut_init_debug)
 {
 	// create device
-	int dbg_msg_ct = 0;
+	atomic_int dbg_msg_ct = 0;
 	VkInstance instance;
 	VkPhysicalDevice phys_dev;
 	uint32_t queue_fam;
@@ -226,7 +272,7 @@ START_TEST(ut_init_debug)
 START_TEST (ut_destroy_dbg_msgr)
 {
 	// Create instance and debug messenger
-	int dbg_msg_ct = 0;
+	atomic_int dbg_msg_ct = 0;
 	VkInstance instance;
 	VkDebugUtilsMessengerEXT dbg_msgr;
 
@@ -291,6 +337,10 @@ Suite *vk_init_suite(void)
 	tcase_add_test(tc12, ut_destroy_dbg_msgr);
 	suite_add_tcase(s, tc12);
 
+	TCase *tc13 = tcase_create("Create device with separate queues");
+	tcase_add_test(tc13, ut_create_device_queues);
+	suite_add_tcase(s, tc13);
+
 	return s;
 }
 
@@ -0,0 +1,250 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_tools.h"
+#include "../src/vk_image.h"
+#include "../src/vk_buffer.h"
+#include "../src/vk_cbuf.h"
+#include "../src/vk_barrier.h"
+#include "../src/vk_mips.h"
+
+#include "helpers.h"
+
+// Level 1 is 4x3, so the odd row count has to be handled, and level 2 is
+// 2x1, which the 3 rows of level 1 collapse into
+#define IM_W 8
+#define IM_H 6
+#define IM_FMT VK_FORMAT_R8G8B8A8_UNORM
+
+// Level 1, each texel covering a 2x2 block of level 0. Red and blue change
+// across columns, green down rows, so the odd row count averages to the middle
+// row whether it's blitted or box filtered.
+static const unsigned char level1_r[4] = {40, 80, 120, 200};
+static const unsigned char level1_b[4] = {215, 175, 135, 55};
+static const unsigned char level1_g[3] = {64, 128, 192};
+
+static void expected_texel(uint32_t level, uint32_t x, uint32_t y,
+			   unsigned char texel[4])
+{
+	switch (level) {
+	case 0:
+		expected_texel(1, x / 2, y / 2, texel);
+		return;
+	case 1:
+		texel[0] = level1_r[x];
+		texel[1] = level1_g[y];
+		texel[2] = level1_b[x];
+		break;
+	case 2:
+		texel[0] = (level1_r[2 * x] + level1_r[2 * x + 1]) / 2;
+		texel[1] = level1_g[1];
+		texel[2] = (level1_b[2 * x] + level1_b[2 * x + 1]) / 2;
+		break;
+	default:
+		texel[0] = (level1_r[0] + level1_r[1]
+			    + level1_r[2] + level1_r[3]) / 4;
+		texel[1] = level1_g[1];
+		texel[2] = (level1_b[0] + level1_b[1]
+			    + level1_b[2] + level1_b[3]) / 4;
+		break;
+	}
+	texel[3] = 255;
+}
+
+static uint32_t level_size(uint32_t size, uint32_t level)
+{
+	size >>= level;
+	return size == 0 ? 1 : size;
+}
+
+START_TEST (ut_mip_ct)
+{
+	ck_assert(image_mip_ct(1, 1) == 1);
+	ck_assert(image_mip_ct(2, 1) == 2);
+	ck_assert(image_mip_ct(5, 3) == 3);
+	ck_assert(image_mip_ct(256, 64) == 9);
+	ck_assert(image_mip_ct(1024, 1024) == 11);
+} END_TEST
+
+static void check_mip_gen(enum MipMethod method)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	// R8G8B8A8_UNORM has to support blits, linear filtering and storage,
+	// so only the storage write without a format can be missing
+	ck_assert(mip_method_supported(phys_dev, IM_FMT, method));
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	uint32_t mip_ct = image_mip_ct(IM_W, IM_H);
+	ck_assert(mip_ct == 4);
+
+	unsigned char data[4 * IM_W * IM_H];
+	for (uint32_t y = 0; y < IM_H; y++) {
+		for (uint32_t x = 0; x < IM_W; x++) {
+			expected_texel(0, x, y, &data[4 * (y * IM_W + x)]);
+		}
+	}
+
+	struct Buffer src;
+	helper_create_buffer_with_data(phys_dev, device, sizeof(data), data,
+				       &src);
+
+	// Every level, one after another
+	VkBufferImageCopy regions[4] = {0};
+	VkDeviceSize dst_size = 0;
+	for (uint32_t i = 0; i < mip_ct; i++) {
+		regions[i].bufferOffset = dst_size;
+		regions[i].imageSubresource.aspectMask =
+			VK_IMAGE_ASPECT_COLOR_BIT;
+		regions[i].imageSubresource.mipLevel = i;
+		regions[i].imageSubresource.layerCount = 1;
+		regions[i].imageExtent.width = level_size(IM_W, i);
+		regions[i].imageExtent.height = level_size(IM_H, i);
+		regions[i].imageExtent.depth = 1;
+
+		dst_size += 4 * level_size(IM_W, i) * level_size(IM_H, i);
+	}
+
+	struct Buffer dst;
+	buffer_create(device, mem_props, dst_size,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &dst);
+
+	struct Image image;
+	image_create_mips(device, queue_fam, mem_props,
+			  IM_FMT,
+			  VK_IMAGE_USAGE_SAMPLED_BIT
+			  | VK_IMAGE_USAGE_STORAGE_BIT
+			  | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+			  | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			  VK_IMAGE_ASPECT_COLOR_BIT,
+			  VK_SAMPLE_COUNT_1_BIT,
+			  IM_W, IM_H,
+			  mip_ct,
+			  &image);
+
+	VkCommandPool cpool;
+	create_cpool(device, queue_fam, &cpool);
+
+	VkCommandBuffer cbuf;
+	cbuf_begin_one_time(device, cpool, &cbuf);
+
+	struct BarrierBatch batch;
+	barrier_batch_create(NULL, &batch);
+
+	barrier_batch_image(&batch, image.handle, VK_IMAGE_ASPECT_COLOR_BIT,
+			    0, 1,
+			    0, VK_ACCESS_TRANSFER_WRITE_BIT,
+			    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			    VK_PIPELINE_STAGE_TRANSFER_BIT,
+			    VK_IMAGE_LAYOUT_UNDEFINED,
+			    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	barrier_batch_record(&batch, cbuf);
+
+	copy_buffer_image_cmd(cbuf, VK_IMAGE_ASPECT_COLOR_BIT, IM_W, IM_H,
+			      src.handle, image.handle);
+
+	struct MipGen gen;
+	mip_gen_create(phys_dev, VK_NULL_HANDLE, &gen);
+	gen.forced = method;
+	mip_gen_record(device, &gen, cbuf,
+		       image.handle, IM_FMT,
+		       IM_W, IM_H, mip_ct,
+		       VK_ACCESS_TRANSFER_READ_BIT,
+		       VK_PIPELINE_STAGE_TRANSFER_BIT,
+		       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+	vkCmdCopyImageToBuffer(cbuf, image.handle,
+			       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			       dst.handle, mip_ct, regions);
+
+	barrier_batch_buffer(&batch, dst.handle, 0, VK_WHOLE_SIZE,
+			     VK_ACCESS_TRANSFER_WRITE_BIT,
+			     VK_ACCESS_HOST_READ_BIT,
+			     VK_PIPELINE_STAGE_TRANSFER_BIT,
+			     VK_PIPELINE_STAGE_HOST_BIT);
+	barrier_batch_record(&batch, cbuf);
+
+	VkResult res = vkEndCommandBuffer(cbuf);
+	ck_assert(res == VK_SUCCESS);
+	submit_syncless(device, queue, cpool, cbuf);
+
+	unsigned char *mapped;
+	res = vkMapMemory(device, dst.memory, 0, dst_size, 0,
+			  (void **) &mapped);
+	ck_assert(res == VK_SUCCESS);
+	for (uint32_t i = 0; i < mip_ct; i++) {
+		uint32_t w = level_size(IM_W, i);
+		uint32_t h = level_size(IM_H, i);
+		unsigned char *level = mapped + regions[i].bufferOffset;
+
+		for (uint32_t y = 0; y < h; y++) {
+			for (uint32_t x = 0; x < w; x++) {
+				unsigned char want[4];
+				expected_texel(i, x, y, want);
+				unsigned char *got = &level[4 * (y * w + x)];
+				for (int c = 0; c < 4; c++) {
+					// Allow for rounding in the filter
+					ck_assert(abs(got[c] - want[c]) <= 1);
+				}
+			}
+		}
+	}
+	vkUnmapMemory(device, dst.memory);
+
+	mip_gen_destroy(device, gen);
+	image_destroy(device, image);
+	buffer_destroy(src);
+	buffer_destroy(dst);
+	vkDestroyCommandPool(device, cpool, NULL);
+
+	ck_assert(dbg_msg_ct == 0);
+}
+
+START_TEST (ut_mip_gen_blit)
+{
+	check_mip_gen(MIP_METHOD_BLIT);
+} END_TEST
+
+START_TEST (ut_mip_gen_compute)
+{
+	check_mip_gen(MIP_METHOD_COMPUTE);
+} END_TEST
+
+Suite *vk_mips_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Mip generation");
+
+	TCase *tc1 = tcase_create("Mip count");
+	tcase_add_test(tc1, ut_mip_ct);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Generate mips by blitting");
+	tcase_add_test(tc2, ut_mip_gen_blit);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("Generate mips in a compute shader");
+	tcase_add_test(tc3, ut_mip_gen_compute);
+	suite_add_tcase(s, tc3);
+
+	return s;
+}
@@ -0,0 +1,8 @@
+#ifndef T_VK_MIPS_H_
+#define T_VK_MIPS_H_
+
+#include <check.h>
+
+Suite *vk_mips_suite(void);
+
+#endif // T_VK_MIPS_H_
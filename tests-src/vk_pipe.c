@@ -97,7 +97,7 @@ START_TEST (ut_create_layout) {
         &device
     );
 
-    create_layout(device, 0, NULL, &pipe_layout);
+    create_layout(device, 0, NULL, 0, NULL, &pipe_layout);
 
     // again, hard to test
     ck_assert(pipe_layout != NULL);
@@ -158,11 +158,12 @@ START_TEST(ut_create_pipel) {
     create_rpass(device, SW_FORMAT, &rpass);
 
     // layout
-    create_layout(device, 0, NULL, &pipe_layout);
+    create_layout(device, 0, NULL, 0, NULL, &pipe_layout);
 
     // pipeline!
     create_pipel(
         device,
+        VK_NULL_HANDLE,
         2,
         shtages,
         pipe_layout,
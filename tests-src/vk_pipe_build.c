@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_pipe_build.h"
+#include "../src/vk_pipe.h"
+#include "../src/vk_rpass.h"
+#include "../src/vk_vertex.h"
+
+#include "helpers.h"
+
+#define PIPEL_CT 8
+
+// Builds PIPEL_CT pipelines on <worker_ct> workers, waiting in reverse order
+static void build_all(VkDevice device, uint32_t worker_ct)
+{
+	VkRenderPass rpass;
+	rpass_basic(device, DEFAULT_FMT, &rpass);
+
+	VkPipelineLayout layout;
+	create_layout(device, 0, NULL, 0, NULL, &layout);
+
+	VkPipelineCacheCreateInfo cache_info = {0};
+	cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	VkPipelineCache pcache;
+	VkResult res = vkCreatePipelineCache(device, &cache_info, NULL,
+					     &pcache);
+	ck_assert(res == VK_SUCCESS);
+
+	struct PipeDesc desc = {0};
+	desc.shtage_ct = 2;
+	helper_create_shtage(device, "assets/testing/shaders/simple.vert.spv",
+			     VK_SHADER_STAGE_VERTEX_BIT, &desc.shtages[0]);
+	helper_create_shtage(device, "assets/testing/shaders/simple.frag.spv",
+			     VK_SHADER_STAGE_FRAGMENT_BIT, &desc.shtages[1]);
+	desc.layout = layout;
+	desc.binding_ct = VERTEX_3_POS_COLOR_BINDING_CT;
+	desc.binding_descs = VERTEX_3_POS_COLOR_BINDINGS;
+	desc.attr_ct = VERTEX_3_POS_COLOR_ATTRIBUTE_CT;
+	desc.attr_descs = VERTEX_3_POS_COLOR_ATTRIBUTES;
+	desc.rpass = rpass;
+	desc.has_depth = 0;
+	desc.samples = VK_SAMPLE_COUNT_1_BIT;
+
+	struct PipeBuild *build = malloc(sizeof(*build));
+	pipe_build_create(device, pcache, worker_ct, build);
+	ck_assert(build->worker_ct > 0);
+
+	uint32_t ids[PIPEL_CT];
+	for (uint32_t i = 0; i < PIPEL_CT; i++) {
+		ids[i] = pipe_build_submit(build, &desc);
+	}
+
+	VkPipeline pipels[PIPEL_CT];
+	for (int i = PIPEL_CT - 1; i >= 0; i--) {
+		pipels[i] = pipe_build_wait(build, ids[i]);
+		ck_assert(pipels[i] != VK_NULL_HANDLE);
+		ck_assert(pipe_build_ready(build, ids[i]));
+	}
+
+	pipe_build_destroy(build);
+	free(build);
+
+	for (uint32_t i = 0; i < PIPEL_CT; i++) {
+		vkDestroyPipeline(device, pipels[i], NULL);
+	}
+
+	vkDestroyShaderModule(device, desc.shtages[0].module, NULL);
+	vkDestroyShaderModule(device, desc.shtages[1].module, NULL);
+	vkDestroyPipelineCache(device, pcache, NULL);
+	vkDestroyPipelineLayout(device, layout, NULL);
+	vkDestroyRenderPass(device, rpass, NULL);
+}
+
+START_TEST (ut_build_cores)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	build_all(device, 0);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_build_one_worker)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	build_all(device, 1);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_stop_idle)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	// Nothing submitted, the workers must still stop
+	struct PipeBuild *build = malloc(sizeof(*build));
+	pipe_build_create(device, VK_NULL_HANDLE, 2, build);
+	pipe_build_destroy(build);
+	free(build);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_pipe_build_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Pipeline build service");
+
+	TCase *tc1 = tcase_create("Build on every core");
+	tcase_add_test(tc1, ut_build_cores);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Build on one worker");
+	tcase_add_test(tc2, ut_build_one_worker);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("Stop without any builds");
+	tcase_add_test(tc3, ut_stop_idle);
+	suite_add_tcase(s, tc3);
+
+	return s;
+}
@@ -0,0 +1,8 @@
+#ifndef T_VK_PIPE_BUILD_H_
+#define T_VK_PIPE_BUILD_H_
+
+#include <check.h>
+
+Suite *vk_pipe_build_suite(void);
+
+#endif // T_VK_PIPE_BUILD_H_
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_pipe_cache.h"
+#include "../src/vk_pipe.h"
+#include "../src/vk_rpass.h"
+#include "../src/vk_vertex.h"
+
+#include "helpers.h"
+
+#define CACHE_PATH "bin/test-pipelines.cache"
+
+// Creates a pipeline through <pcache>, then destroys it
+static void create_one(VkDevice device, VkPipelineCache pcache)
+{
+	VkRenderPass rpass;
+	rpass_basic(device, DEFAULT_FMT, &rpass);
+
+	VkPipelineShaderStageCreateInfo shtages[2];
+	helper_create_shtage(device, "assets/testing/shaders/simple.vert.spv",
+			     VK_SHADER_STAGE_VERTEX_BIT, &shtages[0]);
+	helper_create_shtage(device, "assets/testing/shaders/simple.frag.spv",
+			     VK_SHADER_STAGE_FRAGMENT_BIT, &shtages[1]);
+
+	VkPipelineLayout layout;
+	create_layout(device, 0, NULL, 0, NULL, &layout);
+
+	VkPipeline pipel = NULL;
+	create_pipel(device, pcache, 2, shtages, layout,
+		     VERTEX_3_POS_COLOR_BINDING_CT, VERTEX_3_POS_COLOR_BINDINGS,
+		     VERTEX_3_POS_COLOR_ATTRIBUTE_CT, VERTEX_3_POS_COLOR_ATTRIBUTES,
+		     rpass, 0, VK_SAMPLE_COUNT_1_BIT,
+		     &pipel);
+	ck_assert(pipel != NULL);
+
+	vkDestroyPipeline(device, pipel, NULL);
+	vkDestroyPipelineLayout(device, layout, NULL);
+	vkDestroyRenderPass(device, rpass, NULL);
+}
+
+START_TEST (ut_round_trip)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	remove(CACHE_PATH);
+
+	// Nothing on disk yet
+	struct PipeCache cache;
+	pipe_cache_create(phys_dev, device, CACHE_PATH, &cache);
+	ck_assert(cache.handle != VK_NULL_HANDLE);
+	ck_assert(cache.loaded_size == 0);
+
+	create_one(device, cache.handle);
+	ck_assert(pipe_cache_save(phys_dev, device, &cache) == 0);
+	pipe_cache_destroy(device, cache);
+
+	// Loaded back, and still usable
+	pipe_cache_create(phys_dev, device, CACHE_PATH, &cache);
+	ck_assert(cache.loaded_size > 0);
+
+	create_one(device, cache.handle);
+	pipe_cache_destroy(device, cache);
+
+	remove(CACHE_PATH);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_reject)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	VkPhysicalDeviceProperties props;
+	vkGetPhysicalDeviceProperties(phys_dev, &props);
+
+	remove(CACHE_PATH);
+
+	struct PipeCache cache;
+	pipe_cache_create(phys_dev, device, CACHE_PATH, &cache);
+	create_one(device, cache.handle);
+	ck_assert(pipe_cache_save(phys_dev, device, &cache) == 0);
+	pipe_cache_destroy(device, cache);
+
+	FILE *fp = fopen(CACHE_PATH, "rb");
+	ck_assert(fp != NULL);
+	fseek(fp, 0, SEEK_END);
+	size_t size = ftell(fp);
+	rewind(fp);
+	unsigned char *data = malloc(size);
+	ck_assert(fread(data, 1, size, fp) == size);
+	fclose(fp);
+
+	ck_assert(pipe_cache_valid(&props, data, size));
+
+	// Truncated
+	ck_assert(!pipe_cache_valid(&props, data, size - 1));
+	ck_assert(!pipe_cache_valid(&props, data, 4));
+
+	// Another driver version
+	struct PipeCacheFileHeader *file = (struct PipeCacheFileHeader *) data;
+	file->driver_version++;
+	ck_assert(!pipe_cache_valid(&props, data, size));
+	file->driver_version--;
+
+	// Another device
+	file->uuid[0] ^= 0xff;
+	ck_assert(!pipe_cache_valid(&props, data, size));
+	file->uuid[0] ^= 0xff;
+
+	// Damaged data
+	data[size - 1] ^= 0xff;
+	ck_assert(!pipe_cache_valid(&props, data, size));
+
+	// Which is ignored on load
+	fp = fopen(CACHE_PATH, "wb");
+	ck_assert(fp != NULL);
+	fwrite(data, 1, size, fp);
+	fclose(fp);
+
+	pipe_cache_create(phys_dev, device, CACHE_PATH, &cache);
+	ck_assert(cache.loaded_size == 0);
+	create_one(device, cache.handle);
+	pipe_cache_destroy(device, cache);
+
+	free(data);
+	remove(CACHE_PATH);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_pipe_cache_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Pipeline cache");
+
+	TCase *tc1 = tcase_create("Save and load back");
+	tcase_add_test(tc1, ut_round_trip);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Reject invalid files");
+	tcase_add_test(tc2, ut_reject);
+	suite_add_tcase(s, tc2);
+
+	return s;
+}
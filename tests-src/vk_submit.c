@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/vk_tools.h"
+#include "../src/vk_sync.h"
+#include "../src/vk_submit.h"
+
+#include "helpers.h"
+
+#define THREAD_CT 4
+#define JOBS_PER_THREAD 1000
+
+struct Worker {
+	struct SubmitService *svc;
+	VkSemaphore timeline;
+};
+
+// Each worker signals its own timeline, one value per job
+static void *work(void *data)
+{
+	struct Worker *worker = data;
+
+	for (int i = 0; i < JOBS_PER_THREAD; i++) {
+		struct SubmitJob job = {0};
+		submit_job_signal(&job, worker->timeline, i + 1);
+		submit_service_push(worker->svc, &job);
+	}
+
+	return NULL;
+}
+
+START_TEST (ut_submit_threads)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	struct SubmitService svc;
+	submit_service_create(queue, &svc);
+
+	pthread_t threads[THREAD_CT];
+	struct Worker workers[THREAD_CT];
+	for (int i = 0; i < THREAD_CT; i++) {
+		workers[i].svc = &svc;
+		create_timeline_sem(device, 0, &workers[i].timeline);
+		pthread_create(&threads[i], NULL, work, &workers[i]);
+	}
+
+	for (int i = 0; i < THREAD_CT; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	submit_service_destroy(&svc);
+
+	// Everything got submitted, in fewer calls than jobs
+	ck_assert(svc.job_ct == THREAD_CT * JOBS_PER_THREAD);
+	ck_assert(svc.batch_ct <= svc.job_ct);
+
+	VkResult res = vkQueueWaitIdle(queue);
+	ck_assert(res == VK_SUCCESS);
+
+	for (int i = 0; i < THREAD_CT; i++) {
+		uint64_t value;
+		res = vkGetSemaphoreCounterValue(device, workers[i].timeline,
+						 &value);
+		ck_assert(res == VK_SUCCESS);
+		ck_assert(value == JOBS_PER_THREAD);
+
+		vkDestroySemaphore(device, workers[i].timeline, NULL);
+	}
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_present_result)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	struct SubmitService svc;
+	submit_service_create(queue, &svc);
+
+	ck_assert(submit_service_present_result(&svc) == VK_SUCCESS);
+
+	// There's no swapchain to present to here, so stand in for the
+	// submit thread. A result is only reported once.
+	atomic_store(&svc.present_result, VK_ERROR_OUT_OF_DATE_KHR);
+	ck_assert(submit_service_present_result(&svc)
+		  == VK_ERROR_OUT_OF_DATE_KHR);
+	ck_assert(submit_service_present_result(&svc) == VK_SUCCESS);
+
+	submit_service_destroy(&svc);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_submit_suite(void) {
+	Suite *s;
+
+	s = suite_create("Submission service");
+
+	TCase *tc1 = tcase_create("Submit from several threads");
+	tcase_add_test(tc1, ut_submit_threads);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Report present results");
+	tcase_add_test(tc2, ut_present_result);
+	suite_add_tcase(s, tc2);
+
+	return s;
+}
@@ -0,0 +1,8 @@
+#ifndef T_VK_SUBMIT_H_
+#define T_VK_SUBMIT_H_
+
+#include <check.h>
+
+Suite *vk_submit_suite(void);
+
+#endif // T_VK_SUBMIT_H_
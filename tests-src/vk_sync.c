@@ -10,6 +10,7 @@
 #include "../src/vk_pipe.h"
 #include "../src/vk_cbuf.h"
 #include "../src/vk_sync.h"
+#include "../src/vk_sync_pool.h"
 
 #include "helpers.h"
 
@@ -57,6 +58,62 @@ START_TEST (ut_create_fence) {
     ck_assert(dbg_msg_ct == 0);
 }
 
+START_TEST (ut_sync_pool_try_acquire) {
+    VK_OBJECTS;
+    helper_create_device(
+        &gwin,
+        &dbg_msg_ct,
+        NULL,
+        &instance,
+        &phys_dev,
+        &queue_fam,
+        &device
+    );
+
+    struct SyncPool pool;
+    sync_pool_create(device, 2, &pool);
+
+    // Both fences start signalled
+    VkFence fence;
+    uint32_t idx;
+    ck_assert(sync_pool_try_acquire(device, &pool, &fence, &idx) == 0);
+    ck_assert(idx == 0);
+    ck_assert(sync_pool_try_acquire(device, &pool, &fence, &idx) == 0);
+    ck_assert(idx == 1);
+
+    // Nothing was submitted, so the first one never gets signalled again
+    ck_assert(sync_pool_try_acquire(device, &pool, &fence, &idx) == 1);
+    ck_assert(sync_pool_acquire_timeout(device, &pool, 1000000,
+                                        &fence, &idx) == 1);
+
+    // Stalls only count once the fence is acquired
+    ck_assert(pool.stats.acquire_ct == 2);
+    ck_assert(pool.stats.stall_ct == 0);
+    ck_assert(pool.stats.busy_ct == 2);
+    ck_assert(pool.stats.stall_secs == 0.0);
+
+    // Signal it with an empty submission
+    vkGetDeviceQueue(device, queue_fam, 0, &queue);
+    VkSubmitInfo submit = {0};
+    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    VkResult res = vkQueueSubmit(queue, 1, &submit,
+                                 pool.fences[pool.cur]);
+    ck_assert(res == VK_SUCCESS);
+
+    // Both failed attempts and this one are a single stall, and only the
+    // timeout variant actually blocked
+    ck_assert(sync_pool_acquire_timeout(device, &pool, UINT64_MAX,
+                                        &fence, &idx) == 0);
+    ck_assert(idx == 0);
+    ck_assert(pool.stats.acquire_ct == 3);
+    ck_assert(pool.stats.stall_ct == 1);
+    ck_assert(pool.stats.stall_secs > 0.0);
+    ck_assert(pool.stats.max_stall_secs == pool.stats.stall_secs);
+
+    sync_pool_destroy(device, pool);
+    ck_assert(dbg_msg_ct == 0);
+}
+
 Suite *vk_sync_suite(void) {
     Suite *s;
 
@@ -70,5 +127,9 @@ Suite *vk_sync_suite(void) {
     tcase_add_test(tc2, ut_create_fence);
     suite_add_tcase(s, tc2);
 
+    TCase *tc3 = tcase_create("Try acquiring from a SyncPool");
+    tcase_add_test(tc3, ut_sync_pool_try_acquire);
+    suite_add_tcase(s, tc3);
+
     return s;
 }
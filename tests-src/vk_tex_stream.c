@@ -0,0 +1,237 @@
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <check.h>
+#include <vulkan/vulkan.h>
+
+#include "../src/texture.h"
+#include "../src/vk_tex_stream.h"
+
+#include "helpers.h"
+
+#define SRC_PATH "assets/images/texture.png"
+
+// 1024x1024 RGBA8 with every mip level is a little over 5.5 MiB
+#define RING_SIZE (8 * 1024 * 1024)
+
+/*
+ * Updates until no texture is queued, decoding or uploading, and returns how
+ * many became resident.
+ */
+static uint32_t update_until_settled(struct TexStream *stream)
+{
+	uint32_t resident_ct = 0;
+
+	// Decoding a 1024x1024 PNG takes well under 10 seconds
+	for (int i = 0; i < 10000; i++) {
+		resident_ct += tex_stream_update(stream);
+
+		int busy = 0;
+		for (uint32_t id = 0; id < stream->tex_ct; id++) {
+			enum TexState state = tex_stream_state(stream, id);
+			if (state != TEX_STREAM_RESIDENT
+			    && state != TEX_STREAM_FAILED) {
+				busy = 1;
+			}
+		}
+		if (!busy) break;
+
+		usleep(1000);
+	}
+
+	return resident_ct;
+}
+
+START_TEST (ut_stream)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	struct TexStream stream;
+	tex_stream_create(device, queue_fam, queue, mem_props, RING_SIZE, NULL,
+			  &stream);
+
+	uint32_t tex = tex_stream_request(&stream, SRC_PATH,
+					  VK_FORMAT_R8G8B8A8_UNORM);
+	uint32_t missing = tex_stream_request(&stream, "assets/images/none.png",
+					      VK_FORMAT_R8G8B8A8_UNORM);
+
+	// Nothing can be resident before an update
+	ck_assert(tex_stream_view(&stream, tex) == stream.placeholder.view);
+
+	ck_assert(update_until_settled(&stream) == 1);
+
+	ck_assert(tex_stream_state(&stream, tex) == TEX_STREAM_RESIDENT);
+	ck_assert(tex_stream_view(&stream, tex) != stream.placeholder.view);
+	ck_assert(stream.textures[tex].level_ct == 11);
+
+	ck_assert(tex_stream_state(&stream, missing) == TEX_STREAM_FAILED);
+	ck_assert(tex_stream_view(&stream, missing) == stream.placeholder.view);
+
+	tex_stream_destroy(&stream);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_ring_full)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	struct TexStream stream;
+	tex_stream_create(device, queue_fam, queue, mem_props, RING_SIZE, NULL,
+			  &stream);
+
+	// Only one fits in the ring at a time, so each has to wait for the
+	// one before it, and most wrap around the end of the ring
+	uint32_t ids[3];
+	for (uint32_t i = 0; i < 3; i++) {
+		ids[i] = tex_stream_request(&stream, SRC_PATH,
+					    VK_FORMAT_R8G8B8A8_UNORM);
+	}
+
+	ck_assert(update_until_settled(&stream) == 3);
+
+	for (uint32_t i = 0; i < 3; i++) {
+		ck_assert(tex_stream_state(&stream, ids[i])
+			  == TEX_STREAM_RESIDENT);
+	}
+	ck_assert(stream.upload_ct == 0);
+	ck_assert(stream.ring_tail == stream.ring_head);
+
+	tex_stream_destroy(&stream);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_ring_wrap_empty)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	// 512x512 RGBA8 with every mip level, a little over 1.3 MiB
+	static unsigned char rgba[4 * 512 * 512];
+	for (size_t i = 0; i < sizeof(rgba); i++) rgba[i] = i * 7;
+
+	struct Texture small;
+	texture_encode(VK_FORMAT_R8G8B8A8_UNORM, 512, 512, rgba, &small);
+
+	char small_path[] = "/tmp/tex-stream-XXXXXX.ktx2";
+	int fd = mkstemps(small_path, 5);
+	ck_assert(fd >= 0);
+	FILE *fp = fdopen(fd, "wb");
+	ck_assert(fp != NULL);
+	texture_write_ktx2(fp, small);
+	ck_assert(fclose(fp) == 0);
+	texture_destroy(small);
+
+	// Room for the big one, but not after the small one
+	struct TexStream stream;
+	tex_stream_create(device, queue_fam, queue, mem_props,
+			  6 * 1024 * 1024, NULL, &stream);
+
+	uint32_t first = tex_stream_request(&stream, small_path,
+					    VK_FORMAT_UNDEFINED);
+	ck_assert(update_until_settled(&stream) == 1);
+	ck_assert(tex_stream_state(&stream, first) == TEX_STREAM_RESIDENT);
+	ck_assert(stream.ring_head % stream.ring_size != 0);
+
+	// The ring is empty, so it has to start again from the beginning
+	// rather than wait for space nothing will free
+	uint32_t second = tex_stream_request(&stream, SRC_PATH,
+					     VK_FORMAT_R8G8B8A8_UNORM);
+	ck_assert(update_until_settled(&stream) == 1);
+	ck_assert(tex_stream_state(&stream, second) == TEX_STREAM_RESIDENT);
+	ck_assert(stream.textures[second].level_ct == 11);
+
+	tex_stream_destroy(&stream);
+	ck_assert(remove(small_path) == 0);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_too_big)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	struct TexStream stream;
+	tex_stream_create(device, queue_fam, queue, mem_props, 1024 * 1024,
+			  NULL, &stream);
+
+	uint32_t tex = tex_stream_request(&stream, SRC_PATH,
+					  VK_FORMAT_R8G8B8A8_UNORM);
+
+	ck_assert(update_until_settled(&stream) == 0);
+	ck_assert(tex_stream_state(&stream, tex) == TEX_STREAM_FAILED);
+	ck_assert(tex_stream_view(&stream, tex) == stream.placeholder.view);
+
+	tex_stream_destroy(&stream);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+Suite *vk_tex_stream_suite(void)
+{
+	Suite *s;
+
+	s = suite_create("Texture streaming");
+
+	TCase *tc1 = tcase_create("Stream");
+	tcase_add_test(tc1, ut_stream);
+	suite_add_tcase(s, tc1);
+
+	TCase *tc2 = tcase_create("Ring full");
+	tcase_add_test(tc2, ut_ring_full);
+	suite_add_tcase(s, tc2);
+
+	TCase *tc3 = tcase_create("Too big for ring");
+	tcase_add_test(tc3, ut_too_big);
+	suite_add_tcase(s, tc3);
+
+	TCase *tc4 = tcase_create("Wrap when empty");
+	tcase_add_test(tc4, ut_ring_wrap_empty);
+	suite_add_tcase(s, tc4);
+
+	return s;
+}
@@ -0,0 +1,8 @@
+#ifndef T_VK_TEX_STREAM_H_
+#define T_VK_TEX_STREAM_H_
+
+#include <check.h>
+
+Suite *vk_tex_stream_suite(void);
+
+#endif // T_VK_TEX_STREAM_H_
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 
 #include <check.h>
 #include <vulkan/vulkan.h>
@@ -12,6 +13,7 @@
 #include "../src/vk_buffer.h"
 #include "../src/vk_cbuf.h"
 #include "../src/vk_vertex.h"
+#include "../src/vk_rpass.h"
 
 #include "helpers.h"
 
@@ -50,9 +52,10 @@ START_TEST (ut_create_descriptor_layout)
 	// format doesn't matter since we don't use a swapchain
 	create_rpass(device, DEFAULT_FMT, &rpass);
 
-	create_layout(device, 1, &desc_layout, &pipe_layout);
+	create_layout(device, 1, &desc_layout, 0, NULL, &pipe_layout);
 
 	create_pipel(device,
+		     VK_NULL_HANDLE,
 		     2,
 		     shtages,
 		     pipe_layout,
@@ -154,7 +157,7 @@ START_TEST (ut_allocate_descriptor_set)
 	VkCommandPool cpool;
 	create_cpool(device, queue_fam, &cpool);
 
-	create_layout(device, 1, &desc_layout, &pipe_layout);
+	create_layout(device, 1, &desc_layout, 0, NULL, &pipe_layout);
 	VkPipelineShaderStageCreateInfo shtage;
 	helper_create_shtage(device,
 			     "assets/testing/shaders/uniform.vert.spv",
@@ -164,6 +167,7 @@ START_TEST (ut_allocate_descriptor_set)
 	create_rpass(device, VK_FORMAT_B8G8R8A8_UNORM, &rpass);
 
 	create_pipel(device,
+		     VK_NULL_HANDLE,
 		     1,
 		     &shtage,
 		     pipe_layout,
@@ -377,9 +381,9 @@ START_TEST(ut_set_create)
 	uint32_t set_ct = ARRAY_SIZE(sets);
 	
 	VkPipelineLayout layout;
-	create_layout(device, set_layout_ct, set_layouts, &layout);
+	create_layout(device, set_layout_ct, set_layouts, 0, NULL, &layout);
 
-	create_pipel(device, 2, shader_stages, layout,
+	create_pipel(device, VK_NULL_HANDLE, 2, shader_stages, layout,
 		     VERTEX_2_POS_COLOR_BINDING_CT, VERTEX_2_POS_COLOR_BINDINGS,
 		     VERTEX_2_POS_COLOR_ATTRIBUTE_CT, VERTEX_2_POS_COLOR_ATTRIBUTES,
 		     rpass,
@@ -426,6 +430,380 @@ START_TEST(ut_set_create)
 	ck_assert(dbg_msg_ct == 0);
 } END_TEST
 
+// What sets.frag reads, in binding order: a uniform buffer and an image in
+// set 0, and an image and a uniform buffer in set 1. Each supplies one
+// channel, so a draw only comes out as SETS_PIXEL (ARGB) if every descriptor
+// was written.
+#define SETS_PIXEL 0xd0a0b0c0
+// Each uniform buffer is a vec4
+#define SETS_BUF_SIZE (4 * sizeof(float))
+
+static VkDescriptorType SETS_TYPES[2][2] = {
+	{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER},
+	{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	 VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}
+};
+
+// Unwritten sets of the layouts above, and what to write to them
+struct SetsInputs {
+	struct Buffer bufs[2];
+	struct Image imgs[2];
+	VkSampler sampler;
+
+	VkDescriptorSetLayout layouts[2];
+	VkDescriptorPool dpool;
+	VkDescriptorSet sets[2];
+};
+
+static void sets_inputs_create(VkPhysicalDevice phys_dev, VkDevice device,
+			       uint32_t queue_fam, VkQueue queue,
+			       VkCommandPool cpool,
+			       struct SetsInputs *in)
+{
+	// Red and alpha from the buffers, green and blue from the images
+	float buf_data[2][4] = {{0.626, 0.626, 0.626, 0.626},
+				{0.815, 0.815, 0.815, 0.815}};
+	unsigned char img_data[2][4] = {{0xb0, 0xb0, 0xb0, 0xb0},
+					{0xc0, 0xc0, 0xc0, 0xc0}};
+
+	for (uint32_t i = 0; i < 2; i++) {
+		helper_create_buffer_with_data(phys_dev, device,
+					       sizeof(buf_data[i]),
+					       buf_data[i], &in->bufs[i]);
+
+		helper_create_image_with_data(phys_dev, device,
+					      queue_fam, queue, cpool,
+					      DEFAULT_FMT,
+					      VK_IMAGE_USAGE_SAMPLED_BIT,
+					      VK_IMAGE_ASPECT_COLOR_BIT,
+					      1, 1,
+					      sizeof(img_data[i]), img_data[i],
+					      &in->imgs[i]);
+		image_transition(device, queue, cpool,
+				 in->imgs[i].handle, VK_IMAGE_ASPECT_COLOR_BIT,
+				 VK_ACCESS_TRANSFER_WRITE_BIT,
+				 VK_ACCESS_SHADER_READ_BIT,
+				 VK_PIPELINE_STAGE_TRANSFER_BIT,
+				 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+
+	VkSamplerCreateInfo sampler_info = {0};
+	sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_info.magFilter = VK_FILTER_NEAREST;
+	sampler_info.minFilter = VK_FILTER_NEAREST;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
+	sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+
+	VkResult res = vkCreateSampler(device, &sampler_info, NULL,
+				       &in->sampler);
+	ck_assert(res == VK_SUCCESS);
+
+	create_descriptor_pool(device, 4, 2, &in->dpool);
+
+	for (uint32_t i = 0; i < 2; i++) {
+		VkDescriptorSetLayoutBinding bindings[2];
+		for (uint32_t j = 0; j < 2; j++) {
+			create_descriptor_binding(j, SETS_TYPES[i][j],
+						  VK_SHADER_STAGE_FRAGMENT_BIT,
+						  &bindings[j]);
+		}
+		create_descriptor_layout(device, 2, bindings,
+					 &in->layouts[i]);
+
+		allocate_descriptor_set(device, in->dpool, in->layouts[i],
+					&in->sets[i]);
+	}
+}
+
+static void sets_inputs_destroy(VkDevice device, struct SetsInputs *in)
+{
+	vkDestroyDescriptorPool(device, in->dpool, NULL);
+	vkDestroySampler(device, in->sampler, NULL);
+	for (uint32_t i = 0; i < 2; i++) {
+		vkDestroyDescriptorSetLayout(device, in->layouts[i], NULL);
+		buffer_destroy(in->bufs[i]);
+		image_destroy(device, in->imgs[i]);
+	}
+}
+
+// Draws a 1x1 target with sets.frag reading <in>'s sets, and returns the
+// pixel
+static uint32_t sets_draw(VkPhysicalDevice phys_dev, VkDevice device,
+			  uint32_t queue_fam, VkQueue queue,
+			  VkCommandPool cpool,
+			  struct SetsInputs *in)
+{
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	struct Image target;
+	image_create(device, queue_fam, mem_props,
+		     DEFAULT_FMT,
+		     VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+		     | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		     VK_IMAGE_ASPECT_COLOR_BIT,
+		     VK_SAMPLE_COUNT_1_BIT,
+		     1, 1,
+		     &target);
+
+	VkRenderPass rpass;
+	rpass_basic(device, DEFAULT_FMT, &rpass);
+
+	VkFramebuffer fb;
+	create_framebuffer(device, 1, 1, rpass, 1, &target.view, &fb);
+
+	VkPipelineShaderStageCreateInfo shtages[2];
+	helper_create_shtage(device, "assets/testing/shaders/sets.vert.spv",
+			     VK_SHADER_STAGE_VERTEX_BIT, &shtages[0]);
+	helper_create_shtage(device, "assets/testing/shaders/sets.frag.spv",
+			     VK_SHADER_STAGE_FRAGMENT_BIT, &shtages[1]);
+
+	VkPipelineLayout layout;
+	create_layout(device, 2, in->layouts, 0, NULL, &layout);
+
+	VkPipeline pipel;
+	create_pipel(device, VK_NULL_HANDLE, 2, shtages, layout,
+		     VERTEX_2_POS_COLOR_BINDING_CT, VERTEX_2_POS_COLOR_BINDINGS,
+		     VERTEX_2_POS_COLOR_ATTRIBUTE_CT,
+		     VERTEX_2_POS_COLOR_ATTRIBUTES,
+		     rpass, 0, VK_SAMPLE_COUNT_1_BIT,
+		     &pipel);
+
+	// A square over the whole target
+	struct Vertex2PosColor vertices[] = {
+		{.pos = {-1.0, -1.0}, .color = {1.0, 0.0, 1.0}},
+		{.pos = {1.0, -1.0}, .color = {1.0, 0.0, 1.0}},
+		{.pos = {-1.0, 1.0}, .color = {1.0, 0.0, 1.0}},
+		{.pos = {1.0, 1.0}, .color = {1.0, 0.0, 1.0}}
+	};
+	uint32_t indices[] = {0, 1, 2, 1, 2, 3};
+
+	struct Buffer vbuf;
+	helper_create_buffer_with_data(phys_dev, device,
+				       sizeof(vertices), vertices, &vbuf);
+	struct Buffer ibuf;
+	helper_create_buffer_with_data(phys_dev, device,
+				       sizeof(indices), indices, &ibuf);
+
+	VkCommandBuffer cbuf;
+	cbuf_begin_one_time(device, cpool, &cbuf);
+
+	VkClearValue clear = {0};
+
+	VkRenderPassBeginInfo rpass_info = {0};
+	rpass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	rpass_info.renderPass = rpass;
+	rpass_info.framebuffer = fb;
+	rpass_info.renderArea.extent.width = 1;
+	rpass_info.renderArea.extent.height = 1;
+	rpass_info.clearValueCount = 1;
+	rpass_info.pClearValues = &clear;
+
+	vkCmdBeginRenderPass(cbuf, &rpass_info, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBindPipeline(cbuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipel);
+
+	VkViewport viewport = {0};
+	viewport.width = 1;
+	viewport.height = 1;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(cbuf, 0, 1, &viewport);
+
+	VkRect2D scissor = {0};
+	scissor.extent.width = 1;
+	scissor.extent.height = 1;
+	vkCmdSetScissor(cbuf, 0, 1, &scissor);
+
+	vkCmdBindDescriptorSets(cbuf, VK_PIPELINE_BIND_POINT_GRAPHICS, layout,
+				0, 2, in->sets, 0, NULL);
+
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(cbuf, 0, 1, &vbuf.handle, &offset);
+	vkCmdBindIndexBuffer(cbuf, ibuf.handle, 0, VK_INDEX_TYPE_UINT32);
+	vkCmdDrawIndexed(cbuf, ARRAY_SIZE(indices), 1, 0, 0, 0);
+
+	vkCmdEndRenderPass(cbuf);
+
+	VkResult res = vkEndCommandBuffer(cbuf);
+	ck_assert(res == VK_SUCCESS);
+	submit_syncless(device, queue, cpool, cbuf);
+
+	// Copy the pixel out
+	struct Buffer buf;
+	buffer_create(device, mem_props, 4,
+		      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		      | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		      &buf);
+
+	image_transition(device, queue, cpool,
+			 target.handle, VK_IMAGE_ASPECT_COLOR_BIT,
+			 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			 VK_ACCESS_TRANSFER_READ_BIT,
+			 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			 VK_PIPELINE_STAGE_TRANSFER_BIT,
+			 VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+			 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+	copy_image_buffer(device, queue, cpool,
+			  VK_IMAGE_ASPECT_COLOR_BIT, 1, 1,
+			  target.handle, buf.handle);
+
+	void *mapped;
+	uint32_t pixel;
+	res = vkMapMemory(device, buf.memory, 0, 4, 0, &mapped);
+	ck_assert(res == VK_SUCCESS);
+	memcpy(&pixel, mapped, 4);
+	vkUnmapMemory(device, buf.memory);
+
+	buffer_destroy(buf);
+	buffer_destroy(ibuf);
+	buffer_destroy(vbuf);
+	vkDestroyPipeline(device, pipel, NULL);
+	vkDestroyPipelineLayout(device, layout, NULL);
+	vkDestroyShaderModule(device, shtages[0].module, NULL);
+	vkDestroyShaderModule(device, shtages[1].module, NULL);
+	vkDestroyFramebuffer(device, fb, NULL);
+	vkDestroyRenderPass(device, rpass, NULL);
+	image_destroy(device, target);
+
+	return pixel;
+}
+
+START_TEST (ut_desc_writer)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	VkCommandPool cpool;
+	create_cpool(device, queue_fam, &cpool);
+
+	struct SetsInputs in;
+	sets_inputs_create(phys_dev, device, queue_fam, queue, cpool, &in);
+
+	// Every descriptor of both sets in one call
+	VkImageLayout img_lt = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	struct DescWriter writer;
+	desc_writer_create(&writer);
+
+	for (uint32_t i = 0; i < 2; i++) {
+		for (uint32_t j = 0; j < 2; j++) {
+			if (SETS_TYPES[i][j]
+			    == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+				desc_writer_buffer(&writer, in.sets[i], j,
+						   SETS_TYPES[i][j],
+						   in.bufs[i].handle,
+						   SETS_BUF_SIZE);
+			} else {
+				desc_writer_image(&writer, in.sets[i], j,
+						  in.sampler, in.imgs[i].view,
+						  img_lt);
+			}
+		}
+	}
+	ck_assert(writer.ct == 4);
+	ck_assert(writer.writes[0].pBufferInfo == &writer.buffers[0]);
+	ck_assert(writer.writes[1].pImageInfo == &writer.images[1]);
+
+	desc_writer_flush(device, &writer);
+	ck_assert(writer.ct == 0);
+
+	// Flushing nothing is fine
+	desc_writer_flush(device, &writer);
+
+	uint32_t pixel = sets_draw(phys_dev, device, queue_fam, queue, cpool,
+				   &in);
+	ck_assert(pixel == SETS_PIXEL);
+
+	sets_inputs_destroy(device, &in);
+	vkDestroyCommandPool(device, cpool, NULL);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+// Template data for each set, in sets.frag's binding order
+struct SetsData0 {
+	VkDescriptorBufferInfo buf;
+	VkDescriptorImageInfo img;
+};
+
+struct SetsData1 {
+	VkDescriptorImageInfo img;
+	VkDescriptorBufferInfo buf;
+};
+
+START_TEST (ut_desc_template)
+{
+	VK_OBJECTS;
+	helper_get_queue(NULL,
+			 &dbg_msg_ct,
+			 NULL,
+			 &instance,
+			 &phys_dev,
+			 &queue_fam,
+			 &device,
+			 &queue);
+
+	VkCommandPool cpool;
+	create_cpool(device, queue_fam, &cpool);
+
+	struct SetsInputs in;
+	sets_inputs_create(phys_dev, device, queue_fam, queue, cpool, &in);
+
+	size_t offsets0[] = {offsetof(struct SetsData0, buf),
+			     offsetof(struct SetsData0, img)};
+	size_t offsets1[] = {offsetof(struct SetsData1, img),
+			     offsetof(struct SetsData1, buf)};
+
+	VkDescriptorUpdateTemplate tmpls[2];
+	desc_template_create(device, in.layouts[0], 2, SETS_TYPES[0],
+			     offsets0, &tmpls[0]);
+	desc_template_create(device, in.layouts[1], 2, SETS_TYPES[1],
+			     offsets1, &tmpls[1]);
+
+	struct SetsData0 data0 = {0};
+	data0.buf.buffer = in.bufs[0].handle;
+	data0.buf.range = SETS_BUF_SIZE;
+	data0.img.sampler = in.sampler;
+	data0.img.imageView = in.imgs[0].view;
+	data0.img.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	struct SetsData1 data1 = {0};
+	data1.img.sampler = in.sampler;
+	data1.img.imageView = in.imgs[1].view;
+	data1.img.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	data1.buf.buffer = in.bufs[1].handle;
+	data1.buf.range = SETS_BUF_SIZE;
+
+	desc_template_write(device, tmpls[0], in.sets[0], &data0);
+	desc_template_write(device, tmpls[1], in.sets[1], &data1);
+
+	uint32_t pixel = sets_draw(phys_dev, device, queue_fam, queue, cpool,
+				   &in);
+	ck_assert(pixel == SETS_PIXEL);
+
+	vkDestroyDescriptorUpdateTemplate(device, tmpls[0], NULL);
+	vkDestroyDescriptorUpdateTemplate(device, tmpls[1], NULL);
+	sets_inputs_destroy(device, &in);
+	vkDestroyCommandPool(device, cpool, NULL);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
 Suite *vk_uniform_suite(void)
 {
 	Suite *s;
@@ -448,5 +826,13 @@ Suite *vk_uniform_suite(void)
 	tcase_add_test(tc4, ut_set_create);
 	suite_add_tcase(s, tc4);
 
+	TCase *tc5 = tcase_create("Batched writes");
+	tcase_add_test(tc5, ut_desc_writer);
+	suite_add_tcase(s, tc5);
+
+	TCase *tc6 = tcase_create("Update template");
+	tcase_add_test(tc6, ut_desc_template);
+	suite_add_tcase(s, tc6);
+
 	return s;
 }
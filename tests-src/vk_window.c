@@ -12,6 +12,8 @@
 #include "../src/vk_cbuf.h"
 #include "../src/vk_buffer.h"
 #include "../src/vk_vertex.h"
+#include "../src/vk_image.h"
+#include "../src/vk_delete.h"
 
 #include "helpers.h"
 
@@ -169,7 +171,7 @@ START_TEST (ut_create_framebuffer)
 
 START_TEST (ut_get_dims)
 {
-	int dbg_msg_ct = 0;
+	atomic_int dbg_msg_ct = 0;
 
 	uint32_t true_width = 800;
 	uint32_t true_height = 800;
@@ -268,6 +270,107 @@ START_TEST (ut_window_recreate)
 	ck_assert(dbg_msg_ct == 0);
 }
 
+START_TEST (ut_window_recreate_deferred)
+{
+	VK_OBJECTS;
+	helper_window_create(&gwin,
+			     &dbg_msg_ct,
+			     NULL,
+			     &instance,
+			     &phys_dev,
+			     &queue_fam,
+			     &device,
+			     &queue,
+			     &surface,
+			     &swidth,
+			     &sheight,
+			     &win);
+
+	struct DeletionQueue dq;
+	deletion_queue_create(&dq);
+
+	uint32_t old_image_ct = win.image_ct;
+	VkSwapchainKHR old_swapchain = win.swapchain;
+	window_recreate_swapchain_deferred(&win, &dq, 1, 0, NULL,
+					   swidth, sheight);
+
+	ck_assert(win.swapchain != old_swapchain);
+
+	// The old swapchain, plus a view and framebuffer per image
+	ck_assert(dq.ct == 1 + 2 * old_image_ct);
+
+	// verify the new one works
+	uint32_t image_idx;
+	VkFramebuffer fb;
+	VkSemaphore sem;
+	create_sem(device, &sem);
+	ck_assert(window_try_acquire(&win, sem, &image_idx, &fb) == 0);
+	ck_assert(fb == win.fbs[image_idx]);
+
+	vkDeviceWaitIdle(device);
+	ck_assert(deletion_queue_collect(device, &dq, 1) == 1 + 2 * old_image_ct);
+	deletion_queue_destroy(device, dq);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
+START_TEST (ut_window_recreate_evict_deferred)
+{
+	VK_OBJECTS;
+	helper_window_create(&gwin,
+			     &dbg_msg_ct,
+			     NULL,
+			     &instance,
+			     &phys_dev,
+			     &queue_fam,
+			     &device,
+			     &queue,
+			     &surface,
+			     &swidth,
+			     &sheight,
+			     &win);
+
+	VkPhysicalDeviceMemoryProperties mem_props;
+	vkGetPhysicalDeviceMemoryProperties(phys_dev, &mem_props);
+
+	// An unpinned framebuffer the last frame drew to
+	struct Image target;
+	image_create(device, queue_fam, mem_props,
+		     SW_FORMAT,
+		     VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+		     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		     VK_IMAGE_ASPECT_COLOR_BIT,
+		     VK_SAMPLE_COUNT_1_BIT,
+		     swidth, sheight,
+		     &target);
+	fb_cache_get(device, &win.fb_cache, NULL, 1, win.rpass,
+		     1, &target.view, swidth, sheight, 0);
+
+	// Only room for the swapchain's, so it's evicted on recreation
+	win.fb_cache.max_ct = win.image_ct;
+
+	struct DeletionQueue dq;
+	deletion_queue_create(&dq);
+
+	uint32_t old_image_ct = win.image_ct;
+	window_recreate_swapchain_deferred(&win, &dq, 1, 0, NULL,
+					   swidth, sheight);
+
+	// Every old swapchain framebuffer goes with its view, and the target's
+	// is evicted to make room for the new ones. They all wait for frame 1
+	// with the old swapchain instead of being destroyed right away.
+	ck_assert(win.fb_cache.evict_ct == old_image_ct + 1);
+	ck_assert(dq.ct == 2 + 2 * old_image_ct);
+
+	vkDeviceWaitIdle(device);
+	ck_assert(deletion_queue_collect(device, &dq, 1) == 2 + 2 * old_image_ct);
+	deletion_queue_destroy(device, dq);
+
+	image_destroy(device, target);
+
+	ck_assert(dbg_msg_ct == 0);
+} END_TEST
+
 START_TEST (ut_window_acquire)
 {
 	VK_OBJECTS;
@@ -373,6 +476,24 @@ START_TEST (ut_window_cleanup) {
 	ck_assert(dbg_msg_ct == 0);
 }
 
+START_TEST (ut_choose_image_ct) {
+	VkSurfaceCapabilitiesKHR caps = {0};
+	caps.minImageCount = 2;
+	caps.maxImageCount = 3;
+
+	// MAILBOX gets a spare image by default
+	ck_assert(choose_image_ct(caps, VK_PRESENT_MODE_FIFO_KHR, 0) == 2);
+	ck_assert(choose_image_ct(caps, VK_PRESENT_MODE_MAILBOX_KHR, 0) == 3);
+
+	// Requests are clamped
+	ck_assert(choose_image_ct(caps, VK_PRESENT_MODE_FIFO_KHR, 1) == 2);
+	ck_assert(choose_image_ct(caps, VK_PRESENT_MODE_FIFO_KHR, 5) == 3);
+
+	// No max
+	caps.maxImageCount = 0;
+	ck_assert(choose_image_ct(caps, VK_PRESENT_MODE_FIFO_KHR, 5) == 5);
+} END_TEST
+
 Suite *vk_window_suite(void) {
 	Suite *s;
 
@@ -418,5 +539,17 @@ Suite *vk_window_suite(void) {
 	tcase_add_test(tc11, ut_window_cleanup);
 	suite_add_tcase(s, tc11);
 
+	TCase *tc12 = tcase_create("Choose image count");
+	tcase_add_test(tc12, ut_choose_image_ct);
+	suite_add_tcase(s, tc12);
+
+	TCase *tc13 = tcase_create("Window: Recreate swapchain deferred");
+	tcase_add_test(tc13, ut_window_recreate_deferred);
+	suite_add_tcase(s, tc13);
+
+	TCase *tc14 = tcase_create("Window: Evict framebuffers deferred");
+	tcase_add_test(tc14, ut_window_recreate_evict_deferred);
+	suite_add_tcase(s, tc14);
+
 	return s;
 }